@@ -0,0 +1,274 @@
+// main_host.cpp
+// George Lake
+// Fall 2025
+//
+// Linux host entry point: the same start-up sequence as src/main.cpp
+// (minus Wi-Fi/NVS), so the reader can be run, profiled and debugged off-device.
+//
+// Usage:
+//      plc_reader_host [--plc IP[:PORT]] [--base WDG_BASE] [--poll MS] [--tz MIN]
+//                      [--ringlog DIR] [--collector IP[:PORT]] [--tcp] [--duration S]
+//                      [--sweep MS,MS,... [--sweep-trials N] [--sweep-ms MS]] [--config FILE]
+//                      [--standby] [--alert IP[:PORT]]
+//
+// Notes:
+//      Log output uses the ESP console layout, so serial_logger.py can post-process it.
+//      --duration 0 (default) runs until killed.
+//      --config reads a RuntimeConfig JSON file (same format as the device's
+//      /littlefs/config.json); keys in the file override the flags above.
+//      --sweep runs the poll-period sweep (PollSweep.hpp) after start-up and exits when done.
+//      --standby keeps a hot-standby ENIP session for failover (ConnectionHealth.hpp).
+//      --alert sends acknowledged alerts to tools/alert_receiver (AlertChannel.hpp).
+
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "EnipClient.hpp"
+#include "EpochTime.hpp"
+#include "AuditMonitor.hpp"
+#include "TagReads.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "FlashRingLog.hpp"
+#include "LogStream.hpp"
+#include "AlertChannel.hpp"
+#include "TimeSync.hpp"
+#include "CpuProfiler.hpp"
+#include "PollSweep.hpp"
+#include "RuntimeConfig.hpp"
+#include "MultiPlcMonitor.hpp"
+#include "ConnectionHealth.hpp"
+#include "Containment.hpp"
+
+namespace {
+    static const char* TAG = "MAIN_APP";
+
+    struct Options {
+        std::string plc_ip     = "127.0.0.1";
+        uint16_t    plc_port   = 44818;
+        std::string base       = "WDG_Status_Instance";
+        uint32_t    poll_ms    = 200;
+        int32_t     tz_minutes = 0;
+        std::string ringlog;                    // empty = no ring log
+        std::string collector_ip;               // empty = no network sink
+        uint16_t    collector_port = 5140;
+        bool        collector_tcp  = false;
+        uint32_t    duration_s     = 0;
+        std::string sweep;                      // empty = no poll-period sweep
+        uint32_t    sweep_trials   = 3;
+        uint32_t    sweep_ms       = 60000;
+        std::string config;                     // empty = built-in tags
+        bool        standby        = false;
+        std::string alert_ip;                   // empty = no alert channel
+        uint16_t    alert_port     = 5141;
+    };
+
+    void usage(const char* argv0) {
+        std::fprintf(stderr,
+            "usage: %s [--plc IP[:PORT]] [--base WDG_BASE] [--poll MS] [--tz MIN]\n"
+            "          [--ringlog DIR] [--collector IP[:PORT]] [--tcp] [--duration S]\n"
+            "          [--sweep MS,MS,... [--sweep-trials N] [--sweep-ms MS]] [--config FILE]\n"
+            "          [--standby] [--alert IP[:PORT]]\n", argv0);
+    }
+
+    // "ip[:port]" -> ip, port (port untouched if absent)
+    void split_host_port(const char* s, std::string& ip, uint16_t& port) {
+        const char* colon = std::strrchr(s, ':');
+        if (!colon) { ip = s; return; }
+        ip.assign(s, colon - s);
+        port = (uint16_t)std::atoi(colon + 1);
+    }
+
+    bool parse_args(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const char* a = argv[i];
+            const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!v) { usage(argv[0]); return false; } ++i; return true; };
+
+            if      (!std::strcmp(a, "--plc"))       { if (!need()) return false; split_host_port(v, o.plc_ip, o.plc_port); }
+            else if (!std::strcmp(a, "--base"))      { if (!need()) return false; o.base = v; }
+            else if (!std::strcmp(a, "--poll"))      { if (!need()) return false; o.poll_ms = (uint32_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--tz"))        { if (!need()) return false; o.tz_minutes = std::atoi(v); }
+            else if (!std::strcmp(a, "--ringlog"))   { if (!need()) return false; o.ringlog = v; }
+            else if (!std::strcmp(a, "--collector")) { if (!need()) return false; split_host_port(v, o.collector_ip, o.collector_port); }
+            else if (!std::strcmp(a, "--tcp"))       { o.collector_tcp = true; }
+            else if (!std::strcmp(a, "--duration"))  { if (!need()) return false; o.duration_s = (uint32_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--sweep"))     { if (!need()) return false; o.sweep = v; }
+            else if (!std::strcmp(a, "--sweep-trials")) { if (!need()) return false; o.sweep_trials = (uint32_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--sweep-ms"))  { if (!need()) return false; o.sweep_ms = (uint32_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--config"))    { if (!need()) return false; o.config = v; }
+            else if (!std::strcmp(a, "--standby"))   { o.standby = true; }
+            else if (!std::strcmp(a, "--alert"))     { if (!need()) return false; split_host_port(v, o.alert_ip, o.alert_port); }
+            else { usage(argv[0]); return false; }
+        }
+        return true;
+    }
+
+    FlashRingLog s_ring_log;
+    RuntimeConfig::Config s_cfg;
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 2;
+    std::signal(SIGPIPE, SIG_IGN);          // lwIP has no SIGPIPE: a dropped PLC is a send() error
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set(TAG, ESP_LOG_INFO);
+    esp_log_level_set("AUDIT_MON", ESP_LOG_INFO);
+    esp_log_level_set("POLL_SWEEP", ESP_LOG_INFO);
+    esp_log_level_set("MULTI_PLC", ESP_LOG_INFO);
+    esp_log_level_set("CONN_HEALTH", ESP_LOG_INFO);
+    esp_log_level_set("JSON", ESP_LOG_INFO);
+    esp_log_level_set("ALERT", ESP_LOG_INFO);
+
+    s_cfg = RuntimeConfig::defaults(opt.plc_ip.c_str(), opt.plc_port, opt.base.c_str(), opt.tz_minutes, opt.poll_ms);
+    s_cfg.scenario_id      = "HOST";
+    s_cfg.scenario_variant = "host_run";
+    s_cfg.change_expected  = false;
+    s_cfg.change_type      = "none";
+    if (!opt.config.empty() && !RuntimeConfig::load(opt.config.c_str(), s_cfg)) return 2;
+    RuntimeConfig::log(s_cfg, TAG);
+
+    // Start-up reads (must outlive TimeSync)
+    static std::string tag_ctrl, tag_dt;
+    tag_ctrl = s_cfg.base + ".ControllerStatus";
+    tag_dt   = s_cfg.base + ".DateTime";
+
+    Experiment::init(s_cfg.scenario_id.c_str(), s_cfg.scenario_variant.c_str(), s_cfg.trial_id,
+                     s_cfg.change_expected, s_cfg.change_type.c_str(), s_cfg.poll_ms);
+    Experiment::set_firmware_versions(s_cfg.esp_firmware_version.c_str(), s_cfg.plc_firmware_version.c_str());
+    Experiment::start_event_logger();
+
+    // Ring log ------------------------------------------------------------------------------
+    if (!opt.ringlog.empty() && FlashRingLog::mount_storage(opt.ringlog.c_str())) {
+        static std::string ring_path;
+        ring_path = opt.ringlog + "/ringlog";
+        FlashRingLog::Config rcfg;
+        rcfg.base_path = ring_path.c_str();
+        if (s_ring_log.open(rcfg)) {
+            FlashRingLog::Stats rs = s_ring_log.stats();
+            if (rs.newest_seq >= 0) set_poll_seq_start((long)(rs.newest_seq + 1));
+            Experiment::attach_flash_log(&s_ring_log);
+        }
+    }
+
+    static char device_id[40];
+    char hostname[24] = {0};
+    gethostname(hostname, sizeof(hostname) - 1);
+    std::snprintf(device_id, sizeof(device_id), "host-%s", hostname);
+
+    // Network log sink ----------------------------------------------------------------------
+    if (!opt.collector_ip.empty()) {
+        LogStream::Config lcfg;
+        lcfg.host      = opt.collector_ip.c_str();
+        lcfg.port      = opt.collector_port;
+        lcfg.transport = opt.collector_tcp ? LogStream::Transport::TCP : LogStream::Transport::UDP;
+        lcfg.device_id = device_id;
+        if (!LogStream::start(lcfg)) ESP_LOGW(TAG, "Network log sink not started");
+    }
+
+    // Alert fast path -----------------------------------------------------------------------
+    if (!opt.alert_ip.empty()) {
+        AlertChannel::Config acfg;
+        acfg.host      = opt.alert_ip.c_str();
+        acfg.port      = opt.alert_port;
+        acfg.device_id = device_id;
+        if (!AlertChannel::start(acfg)) ESP_LOGW(TAG, "Alert channel not started");
+    }
+
+    // ENIP session --------------------------------------------------------------------------
+    static EnipClient enip(s_cfg.plc_ip, s_cfg.plc_port);
+    if (!enip.connect_tcp())      { ESP_LOGE(TAG, "TCP connect failed"); return 1; }
+    if (!enip.register_session()) { ESP_LOGE(TAG, "RegisterSession failed"); enip.close(); return 1; }
+
+    int32_t ctrl = -1;
+    if (!read_dint(enip, tag_ctrl.c_str(), ctrl)) {
+        ESP_LOGE(TAG, "Read failed: %s", tag_ctrl.c_str());
+        enip.close(); return 1;
+    }
+    ESP_LOGI(TAG, "ControllerStatus = %ld", (long)ctrl);
+
+    std::array<int32_t,7> dt{};
+    if (!read_dint_array7(enip, tag_dt.c_str(), dt)) {
+        ESP_LOGE(TAG, "Read failed: %s (DINT[7])", tag_dt.c_str());
+        enip.close(); return 1;
+    }
+    const int64_t epoch = EpochTime::toEpochMs(EpochTime::fromArray(dt), s_cfg.tz_offset_minutes);
+    Experiment::set_time_sync(epoch, EpochTime::espNowMs());
+
+    TimeSync::Config tcfg;
+    tcfg.fallback_datetime_tag = tag_dt.c_str();
+    tcfg.tz_offset_minutes     = s_cfg.tz_offset_minutes;
+    TimeSync::start(&enip, tcfg);
+
+    // Keepalive probes, reconnect with backoff, comm-fault intervals
+    ConnectionHealth::Config hcfg;
+    hcfg.hot_standby = opt.standby;
+    ConnectionHealth::start(&enip, hcfg);
+
+    // Containment writes on unauthorized change (single-PLC mode: they go to this session)
+    if (!s_cfg.containment.empty()) {
+        Containment::Action acts[Containment::MAX_ACTIONS];
+        size_t n = RuntimeConfig::containment_actions(s_cfg, acts);
+        if (!s_cfg.plcs.empty()) {
+            ESP_LOGW(TAG, "containment ignored with 'plcs'");
+        } else if (!Containment::start(&enip, acts, n)) {
+            ESP_LOGE(TAG, "containment not armed");
+        }
+    }
+
+    if (s_cfg.plcs.empty()) {
+        start_audit_monitor(&enip, RuntimeConfig::audit_monitor_config(s_cfg));
+    } else {
+        // One scheduler task for every PLC in the file; enip above stays on the time-sync PLC
+        MultiPlcMonitor::Plc plcs[MultiPlcMonitor::MAX_PLCS];
+        for (size_t i = 0; i < s_cfg.plcs.size(); ++i) {
+            const RuntimeConfig::PlcSpec& p = s_cfg.plcs[i];
+            plcs[i] = {p.name.c_str(), p.ip.c_str(), p.port, RuntimeConfig::audit_monitor_config(s_cfg, i)};
+        }
+        MultiPlcMonitor::start(plcs, s_cfg.plcs.size());
+    }
+
+    CpuProfiler::start();
+
+    if (!opt.sweep.empty()) {
+        PollSweep::Config scfg;
+        if (!PollSweep::parse_periods(opt.sweep.c_str(), scfg)) std::_Exit(2);
+        scfg.trials     = opt.sweep_trials;
+        scfg.trial_ms   = opt.sweep_ms;
+        scfg.restore_ms = s_cfg.poll_ms;
+        PollSweep::run(scfg);
+        Experiment::dump_summary();
+        if (opt.ringlog.size()) s_ring_log.flush();
+        std::fflush(stdout);
+        std::_Exit(0);
+    }
+
+    // Summary every 10 s, as on the device
+    uint32_t elapsed_s = 0;
+    while (opt.duration_s == 0 || elapsed_s < opt.duration_s) {
+        uint32_t step = 10;
+        if (opt.duration_s && opt.duration_s - elapsed_s < step) step = opt.duration_s - elapsed_s;
+        vTaskDelay(pdMS_TO_TICKS(step * 1000));
+        elapsed_s += step;
+        Experiment::dump_summary();
+        enip.log_stats(TAG);
+        Containment::log_summary(TAG);
+        AlertChannel::log_summary(TAG);
+    }
+
+    if (opt.ringlog.size()) s_ring_log.flush();
+    // Background tasks still hold the session; exit without tearing it down
+    std::fflush(stdout);
+    std::_Exit(0);
+}
@@ -0,0 +1,112 @@
+// esp_port.cpp
+// George Lake
+// Fall 2025
+//
+// Host implementations of esp_timer, esp_random, esp_log, esp_err_to_name and heap_caps statistics
+
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <malloc.h>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace {
+    int64_t monotonic_us() {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    const int64_t g_start_us = monotonic_us();
+
+    std::mutex                             g_log_mu;     // one line at a time + level table
+    esp_log_level_t                        g_default_level = ESP_LOG_INFO;
+    std::map<std::string, esp_log_level_t> g_tag_levels;
+
+    esp_log_level_t level_for(const char* tag) {
+        auto it = g_tag_levels.find(tag);
+        return it == g_tag_levels.end() ? g_default_level : it->second;
+    }
+} // Anonymous Namespace
+
+int64_t esp_timer_get_time() {
+    return monotonic_us() - g_start_us;
+}
+
+uint32_t esp_random() {
+    static std::mutex   mu;
+    static std::mt19937 rng{std::random_device{}()};
+    std::lock_guard<std::mutex> lock(mu);
+    return (uint32_t)rng();
+}
+
+uint32_t esp_log_timestamp() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    std::lock_guard<std::mutex> lk(g_log_mu);
+    if (std::strcmp(tag, "*") == 0) {
+        g_default_level = level;
+        g_tag_levels.clear();
+    } else {
+        g_tag_levels[tag] = level;
+    }
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    std::lock_guard<std::mutex> lk(g_log_mu);
+    if (level > level_for(tag)) return;
+    va_list ap;
+    va_start(ap, format);
+    std::vfprintf(stdout, format, ap);
+    va_end(ap);
+    std::fflush(stdout);
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "UNKNOWN ERROR";
+    }
+}
+
+// ---- Heap statistics ----------------------------------------------------------------------
+
+size_t heap_caps_get_free_size(uint32_t) {
+    return mallinfo2().fordblks;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    // Low-water mark of the values seen by heap_caps_get_free_size
+    static std::atomic<size_t> s_min{SIZE_MAX};
+    size_t f = heap_caps_get_free_size(caps);
+    size_t m = s_min.load();
+    while (f < m && !s_min.compare_exchange_weak(m, f)) {}
+    return s_min.load();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t) {
+    // Top chunk: the largest block glibc can hand out without extending the heap
+    return mallinfo2().keepcost;
+}
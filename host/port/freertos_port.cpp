@@ -0,0 +1,358 @@
+// freertos_port.cpp
+// George Lake
+// Fall 2025
+//
+// Host implementations of the FreeRTOS subset the application uses:
+// tasks (std::thread), notifications, semaphores, event groups, message buffers.
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/message_buffer.h"
+
+#include "esp_timer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HostTask {
+    std::string             name;
+    TaskFunction_t          fn  = nullptr;
+    void*                   arg = nullptr;
+    std::mutex              mu;
+    std::condition_variable cv;
+    uint32_t                notify[configTASK_NOTIFICATION_ARRAY_ENTRIES] = {};
+    pthread_t               thread{};
+    UBaseType_t             priority = 0;
+    UBaseType_t             number   = 0;
+};
+
+struct HostSemaphore {
+    std::mutex              mu;
+    std::condition_variable cv;
+    UBaseType_t             count = 0;
+    UBaseType_t             max   = 1;
+};
+
+struct HostEventGroup {
+    std::mutex              mu;
+    std::condition_variable cv;
+    EventBits_t             bits = 0;
+};
+
+struct HostMessageBuffer {
+    std::mutex                        mu;
+    std::condition_variable           cv;
+    size_t                            capacity = 0;
+    size_t                            used     = 0;     // payload + per-message headers
+    std::deque<std::vector<uint8_t>>  msgs;
+};
+
+namespace {
+    thread_local HostTask* t_self = nullptr;
+
+    // Live tasks, for uxTaskGetSystemState; a task leaves before its thread ends
+    std::mutex             g_tasks_mu;
+    std::vector<HostTask*> g_tasks;
+    UBaseType_t            g_task_number = 0;
+
+    void register_self(HostTask* t) {
+        t->thread = pthread_self();
+        std::lock_guard<std::mutex> lk(g_tasks_mu);
+        t->number = ++g_task_number;
+        g_tasks.push_back(t);
+    }
+
+    void unregister_self(HostTask* t) {
+        std::lock_guard<std::mutex> lk(g_tasks_mu);
+        for (size_t i = 0; i < g_tasks.size(); ++i) {
+            if (g_tasks[i] == t) { g_tasks.erase(g_tasks.begin() + (long)i); break; }
+        }
+    }
+
+    // Threads not created through xTaskCreate (e.g. main) get a handle on first use
+    HostTask* self() {
+        if (!t_self) {
+            t_self = new HostTask();
+            t_self->name = "main";
+            register_self(t_self);
+        }
+        return t_self;
+    }
+
+    struct TaskExit {};     // unwinds the task's thread on vTaskDelete(nullptr)
+
+    void task_trampoline(HostTask* t) {
+        t_self = t;
+        register_self(t);
+        try {
+            t->fn(t->arg);
+        } catch (const TaskExit&) {
+        }
+        unregister_self(t);
+    }
+
+    // Wait on cv until pred() holds or ticks elapse; portMAX_DELAY waits forever
+    template <typename Lock, typename Pred>
+    bool wait_ticks(std::condition_variable& cv, Lock& lk, TickType_t ticks, Pred pred) {
+        if (ticks == portMAX_DELAY) { cv.wait(lk, pred); return true; }
+        return cv.wait_for(lk, std::chrono::milliseconds(pdTICKS_TO_MS(ticks)), pred);
+    }
+
+    constexpr size_t MB_HEADER = sizeof(size_t);
+} // Anonymous Namespace
+
+// ---- Critical sections --------------------------------------------------------------------
+
+void port_mux_enter(portMUX_TYPE* mux) {
+    while (__atomic_exchange_n(&mux->locked, 1, __ATOMIC_ACQUIRE)) sched_yield();
+}
+
+void port_mux_exit(portMUX_TYPE* mux) {
+    __atomic_store_n(&mux->locked, 0, __ATOMIC_RELEASE);
+}
+
+// ---- Tasks --------------------------------------------------------------------------------
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t, void* arg,
+                       UBaseType_t priority, TaskHandle_t* out_handle) {
+    HostTask* t = new HostTask();
+    t->name     = name ? name : "";
+    t->fn       = fn;
+    t->arg      = arg;
+    t->priority = priority;
+    if (out_handle) *out_handle = t;
+    std::thread(task_trampoline, t).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Only self-deletion is supported; the handle stays valid for late notifies
+    if (task == nullptr || task == t_self) throw TaskExit{};
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) { std::this_thread::yield(); return; }
+    std::this_thread::sleep_for(std::chrono::milliseconds(pdTICKS_TO_MS(ticks)));
+}
+
+void vTaskDelayUntil(TickType_t* previous_wake, TickType_t period) {
+    *previous_wake += period;
+    int32_t remaining = (int32_t)(*previous_wake - xTaskGetTickCount());
+    if (remaining > 0) vTaskDelay((TickType_t)remaining);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return self();
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    return (task ? task : self())->name.c_str();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks() {
+    self();
+    std::lock_guard<std::mutex> lk(g_tasks_mu);
+    return (UBaseType_t)g_tasks.size();
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* out, UBaseType_t max, uint32_t* total_run_time) {
+    self();
+    std::lock_guard<std::mutex> lk(g_tasks_mu);
+    if (max < g_tasks.size()) return 0;     // FreeRTOS fills nothing if the array is too small
+    UBaseType_t n = 0;
+    for (HostTask* t : g_tasks) {
+        uint64_t cpu_us = 0;
+        clockid_t cid;
+        timespec ts{};
+        if (pthread_getcpuclockid(t->thread, &cid) == 0 && clock_gettime(cid, &ts) == 0) {
+            cpu_us = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+        }
+        TaskStatus_t& s = out[n++];
+        s = TaskStatus_t{};
+        s.xHandle           = t;
+        s.pcTaskName        = t->name.c_str();
+        s.xTaskNumber       = t->number;
+        s.eCurrentState     = t == t_self ? eRunning : eBlocked;
+        s.uxCurrentPriority = t->priority;
+        s.uxBasePriority    = t->priority;
+        s.ulRunTimeCounter  = (uint32_t)cpu_us;
+    }
+    if (total_run_time) *total_run_time = (uint32_t)esp_timer_get_time();
+    return n;
+}
+
+void xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index) {
+    if (!task || index >= configTASK_NOTIFICATION_ARRAY_ENTRIES) return;
+    {
+        std::lock_guard<std::mutex> lk(task->mu);
+        ++task->notify[index];
+    }
+    task->cv.notify_all();      // one cv for every index: wake whichever wait is pending
+}
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    if (index >= configTASK_NOTIFICATION_ARRAY_ENTRIES) return 0;
+    HostTask* t = self();
+    std::unique_lock<std::mutex> lk(t->mu);
+    uint32_t& n = t->notify[index];
+    wait_ticks(t->cv, lk, ticks_to_wait, [&] { return n != 0; });
+    uint32_t v = n;
+    if (v) n = clear_on_exit ? 0 : v - 1;
+    return v;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) { xTaskNotifyGiveIndexed(task, 0); }
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    return ulTaskNotifyTakeIndexed(0, clear_on_exit, ticks_to_wait);
+}
+
+// ---- Semaphores ---------------------------------------------------------------------------
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    HostSemaphore* s = new HostSemaphore();
+    s->max   = max_count;
+    s->count = initial_count;
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lk(sem->mu);
+    if (!wait_ticks(sem->cv, lk, ticks_to_wait, [&] { return sem->count > 0; })) return pdFALSE;
+    --sem->count;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    {
+        std::lock_guard<std::mutex> lk(sem->mu);
+        if (sem->count >= sem->max) return pdFALSE;
+        ++sem->count;
+    }
+    sem->cv.notify_one();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete sem;
+}
+
+// ---- Event groups -------------------------------------------------------------------------
+
+EventGroupHandle_t xEventGroupCreate() {
+    return new HostEventGroup();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t now;
+    {
+        std::lock_guard<std::mutex> lk(group->mu);
+        group->bits |= bits;
+        now = group->bits;
+    }
+    group->cv.notify_all();
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lk(group->mu);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lk(group->mu);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lk(group->mu);
+    auto satisfied = [&] {
+        return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    bool ok = wait_ticks(group->cv, lk, ticks_to_wait, satisfied);
+    EventBits_t v = group->bits;
+    if (ok && clear_on_exit) group->bits &= ~bits;
+    return v;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    delete group;
+}
+
+// ---- Message buffers ----------------------------------------------------------------------
+
+MessageBufferHandle_t xMessageBufferCreate(size_t buffer_bytes) {
+    HostMessageBuffer* mb = new HostMessageBuffer();
+    mb->capacity = buffer_bytes;
+    return mb;
+}
+
+size_t xMessageBufferSend(MessageBufferHandle_t mb, const void* data, size_t len,
+                          TickType_t ticks_to_wait) {
+    const size_t need = len + MB_HEADER;
+    std::unique_lock<std::mutex> lk(mb->mu);
+    if (need > mb->capacity) return 0;
+    if (!wait_ticks(mb->cv, lk, ticks_to_wait, [&] { return mb->capacity - mb->used >= need; })) return 0;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    mb->msgs.emplace_back(p, p + len);
+    mb->used += need;
+    lk.unlock();
+    mb->cv.notify_all();
+    return len;
+}
+
+size_t xMessageBufferReceive(MessageBufferHandle_t mb, void* out, size_t out_len,
+                             TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lk(mb->mu);
+    if (!wait_ticks(mb->cv, lk, ticks_to_wait, [&] { return !mb->msgs.empty(); })) return 0;
+    std::vector<uint8_t>& m = mb->msgs.front();
+    if (m.size() > out_len) return 0;
+    size_t n = m.size();
+    std::memcpy(out, m.data(), n);
+    mb->used -= n + MB_HEADER;
+    mb->msgs.pop_front();
+    lk.unlock();
+    mb->cv.notify_all();
+    return n;
+}
+
+size_t xMessageBufferSpacesAvailable(MessageBufferHandle_t mb) {
+    std::lock_guard<std::mutex> lk(mb->mu);
+    return mb->capacity - mb->used;
+}
+
+void vMessageBufferDelete(MessageBufferHandle_t mb) {
+    delete mb;
+}
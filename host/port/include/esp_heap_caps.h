@@ -0,0 +1,18 @@
+// esp_heap_caps.h (host port)
+// George Lake
+// Fall 2025
+//
+// Heap statistics from glibc mallinfo2. The capability mask is ignored; largest free
+// block is the largest chunk malloc could serve without growing the heap.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
@@ -0,0 +1,11 @@
+// esp_random.h (host port)
+// George Lake
+// Fall 2025
+//
+// 32 random bits, like the hardware RNG on the ESP (not for key material on the host).
+
+
+#pragma once
+#include <cstdint>
+
+uint32_t esp_random();
@@ -0,0 +1,11 @@
+// esp_timer.h (host port)
+// George Lake
+// Fall 2025
+//
+// Microseconds since process start (CLOCK_MONOTONIC), like esp_timer since boot.
+
+
+#pragma once
+#include <cstdint>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,54 @@
+// FreeRTOS.h (host port)
+// George Lake
+// Fall 2025
+//
+// Base FreeRTOS types, tick conversion and critical sections for the Linux host build.
+//
+// Notes:
+//      1 tick = 1 ms (configTICK_RATE_HZ 1000).
+//      Run time stats count each thread's CPU time in microseconds; the total is wall time
+//      since start, so on a multi-core host the task shares can add up to more than 100%.
+//      portENTER_CRITICAL is a spinlock: it gives writers mutual exclusion, but unlike the
+//      C6 it cannot stop a reader thread from running mid-update. SeqLock readers already
+//      retry, so the published-snapshot behaviour is the same.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE  ((BaseType_t)0)
+#define pdTRUE   ((BaseType_t)1)
+#define pdFAIL   pdFALSE
+#define pdPASS   pdTRUE
+
+#define configTICK_RATE_HZ      1000
+#define configMAX_PRIORITIES    25
+#define configUSE_TRACE_FACILITY        1   // uxTaskGetSystemState
+#define configGENERATE_RUN_TIME_STATS   1   // run time = thread CPU time in us
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   2   // as sdkconfig.defaults
+#define portTICK_PERIOD_MS      ((TickType_t)(1000 / configTICK_RATE_HZ))
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+#define pdTICKS_TO_MS(t)        ((uint32_t)(((uint64_t)(t) * 1000U) / configTICK_RATE_HZ))
+
+typedef struct {
+    volatile int locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void port_mux_enter(portMUX_TYPE* mux);
+void port_mux_exit(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux)         port_mux_enter(mux)
+#define portEXIT_CRITICAL(mux)          port_mux_exit(mux)
+#define portENTER_CRITICAL_ISR(mux)     port_mux_enter(mux)
+#define portEXIT_CRITICAL_ISR(mux)      port_mux_exit(mux)
+#define taskENTER_CRITICAL(mux)         port_mux_enter(mux)
+#define taskEXIT_CRITICAL(mux)          port_mux_exit(mux)
@@ -0,0 +1,21 @@
+// event_groups.h (host port)
+// George Lake
+// Fall 2025
+//
+// FreeRTOS event groups (24 usable bits) on a mutex + condition variable.
+
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef uint32_t EventBits_t;
+typedef struct HostEventGroup* EventGroupHandle_t;
+
+EventGroupHandle_t xEventGroupCreate();
+EventBits_t        xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t        xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t        xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t        xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                       BaseType_t clear_on_exit, BaseType_t wait_for_all,
+                                       TickType_t ticks_to_wait);
+void               vEventGroupDelete(EventGroupHandle_t group);
@@ -0,0 +1,23 @@
+// message_buffer.h (host port)
+// George Lake
+// Fall 2025
+//
+// FreeRTOS message buffers: variable-length messages in a fixed byte budget.
+//
+// Notes:
+//      Each message costs its length plus a sizeof(size_t) header, as on the target.
+//      Receive with a buffer too small for the next message returns 0 and leaves it queued.
+
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct HostMessageBuffer* MessageBufferHandle_t;
+
+MessageBufferHandle_t xMessageBufferCreate(size_t buffer_bytes);
+size_t                xMessageBufferSend(MessageBufferHandle_t mb, const void* data, size_t len,
+                                         TickType_t ticks_to_wait);
+size_t                xMessageBufferReceive(MessageBufferHandle_t mb, void* out, size_t out_len,
+                                            TickType_t ticks_to_wait);
+size_t                xMessageBufferSpacesAvailable(MessageBufferHandle_t mb);
+void                  vMessageBufferDelete(MessageBufferHandle_t mb);
@@ -0,0 +1,19 @@
+// semphr.h (host port)
+// George Lake
+// Fall 2025
+//
+// Mutexes and binary/counting semaphores. A FreeRTOS mutex is a binary semaphore that
+// starts available; priority inheritance has no host equivalent and is not modelled.
+
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct HostSemaphore* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t sem);
+void              vSemaphoreDelete(SemaphoreHandle_t sem);
@@ -0,0 +1,45 @@
+// task.h (host port)
+// George Lake
+// Fall 2025
+//
+// FreeRTOS tasks on std::thread. Priorities and stack depths are accepted and ignored;
+// the host scheduler decides. Direct-to-task notifications are supported.
+
+
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct HostTask* TaskHandle_t;
+
+typedef enum { eRunning = 0, eReady, eBlocked, eSuspended, eDeleted, eInvalid } eTaskState;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char*  pcTaskName;
+    UBaseType_t  xTaskNumber;
+    eTaskState   eCurrentState;
+    UBaseType_t  uxCurrentPriority;
+    UBaseType_t  uxBasePriority;
+    uint32_t     ulRunTimeCounter;
+    uint32_t     usStackHighWaterMark;
+} TaskStatus_t;
+
+BaseType_t   xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                         void* arg, UBaseType_t priority, TaskHandle_t* out_handle);
+void         vTaskDelete(TaskHandle_t task);        // nullptr = calling task; does not return
+void         vTaskDelay(TickType_t ticks);
+void         vTaskDelayUntil(TickType_t* previous_wake, TickType_t period);
+TickType_t   xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+const char*  pcTaskGetName(TaskHandle_t task);      // nullptr = calling task
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t task);   // always 0: not measurable on the host
+UBaseType_t  uxTaskGetNumberOfTasks();
+UBaseType_t  uxTaskGetSystemState(TaskStatus_t* out, UBaseType_t max, uint32_t* total_run_time);
+
+void         xTaskNotifyGive(TaskHandle_t task);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+void         xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index);
+uint32_t     ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+#define taskYIELD() vTaskDelay(0)
@@ -0,0 +1,9 @@
+// inet.h (host port)
+// George Lake
+// Fall 2025
+//
+// Address conversion helpers (inet_addr, inet_ntoa, htons ...).
+
+
+#pragma once
+#include <arpa/inet.h>
@@ -0,0 +1,16 @@
+// sockets.h (host port)
+// George Lake
+// Fall 2025
+//
+// lwIP exposes the BSD socket API; on Linux that is the system one.
+
+
+#pragma once
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
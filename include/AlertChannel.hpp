@@ -0,0 +1,80 @@
+// AlertChannel.hpp
+// George Lake
+// Fall 2025
+//
+// Security alert fast path: one small acknowledged UDP datagram per unauthorized change,
+// sent by its own task the moment the change is classified, outside the log pipeline.
+//
+// Usage:
+//      1) Call AlertChannel::start after Wi-Fi is up
+//      2) Call AlertChannel::raise("UNAUTHORIZED_CHANGE", detail, esp_timer_get_time())
+//      3) Run tools/alert_receiver on the host; it prints, stores and acknowledges alerts
+//
+// Wire format (one line per datagram):
+//      device -> receiver:  #ESPALERT <device_id> <seq> <attempt> <t_ms> <kind> <detail>\n
+//      receiver -> device:  #ESPACK <seq>\n
+//      seq counts alerts from 1 since boot; attempt counts sends of the same alert from 1.
+//      t_ms is Experiment::timestamp_ms() at raise (PLC epoch ms once time sync ran).
+//
+// Notes:
+//      raise() copies the alert into a free slot (lock-free) and notifies the sender task;
+//      it never blocks and never touches a socket. With MAX_PENDING alerts unacknowledged
+//      a new one is dropped and counted.
+//      The sender task runs above the audit task and sends new alerts first; an alert
+//      raised while others await their ACK waits at most ACK_SLICE_MS.
+//      Unacknowledged alerts are resent with a doubling timeout (ack_timeout_ms, 2x, 4x,
+//      ...) up to max_attempts; the receiver drops duplicates by (device_id, seq).
+//      UDP with an application ACK instead of TCP: a TCP ACK only proves the peer's kernel
+//      has the bytes, and one lost segment would hold up every later alert.
+//      Each alert ends with a {"record_type":"alert"} record (through the normal sinks,
+//      after the fact) with detect_to_send_us, detect_to_ack_us, rtt_us and attempts.
+//      The sender task only queues the result and counts send() failures; a low-priority
+//      alert_log task builds the record, reports the failures and does the UART / log
+//      stream / flash I/O, so no sink can delay a send or retry. log_summary() reports the detect -> ack histogram.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace AlertChannel {
+    static constexpr size_t   MAX_PENDING   = 8;
+    static constexpr size_t   MAX_DETAIL    = 96;       // longer detail text is cut
+    static constexpr uint32_t ACK_SLICE_MS  = 10;
+    static constexpr uint32_t DONE_RING_LEN = 16;       // finished alerts awaiting their record
+
+    struct Config {
+        const char* host           = nullptr;   // receiver IPv4 address
+        uint16_t    port           = 5141;
+        const char* device_id      = "esp32";
+        uint32_t    ack_timeout_ms = 50;        // first retry; doubles per attempt
+        uint8_t     max_attempts   = 6;         // ~3 s of retries at the default timeout
+        uint8_t     priority       = 8;         // above audit_task and containment
+        uint8_t     log_priority   = 2;         // alert_log task (records, error lines)
+    };
+
+    struct Stats {
+        uint32_t raised    = 0;
+        uint32_t dropped   = 0;     // no free slot
+        uint32_t sends     = 0;     // datagrams, retries included
+        uint32_t retries   = 0;
+        uint32_t acked     = 0;
+        uint32_t expired   = 0;     // max_attempts without an ACK
+        uint32_t rec_dropped = 0;   // alert records lost: alert_log fell DONE_RING_LEN behind
+        uint32_t send_errors = 0;   // send() failures, retried like a lost datagram
+        uint32_t last_us   = 0;     // detection -> ACK of the last acked alert
+        uint32_t p50_us    = 0;
+        uint32_t p99_us    = 0;
+        uint32_t max_us    = 0;
+    };
+
+    // Starts the sender and record tasks. Returns false if already running or on socket / task failure.
+    bool start(const Config& cfg);
+    bool running();
+
+    // kind must be a literal (e.g. "UNAUTHORIZED_CHANGE"); detail is copied.
+    // detect_us is the esp_timer time of the classification. Returns false if dropped.
+    bool raise(const char* kind, const char* detail, int64_t detect_us);
+
+    Stats stats();
+    void log_summary(const char* log_tag);
+}
@@ -0,0 +1,71 @@
+// AuditDetector.hpp
+// George Lake
+// Fall 2025
+//
+// Baseline + compare logic of the audit monitor, without I/O.
+//
+// Usage:
+//      AuditDetector det;
+//      AuditDetector::Result r = det.update(sample);   // once per successful poll
+//
+// Notes:
+//      The first sample sets the baselines (no change reported). After that a change is
+//      any AuditValue difference, or a PID gain moving more than pid_epsilon; the
+//      baseline then follows the new value. AuthorizedUser at the same poll classifies it.
+//      Used by audit_task on the device and by tools/replay on the host, so a replayed
+//      trace runs exactly the firmware's decision logic.
+
+#pragma once
+#include <cstdint>
+
+struct AuditSample {
+    int64_t audit = 0;
+    int32_t auth  = 0;
+    float   kp    = 0.0f;
+    float   ki    = 0.0f;
+    float   kd    = 0.0f;
+};
+
+class AuditDetector {
+public:
+    struct Config {
+        float pid_epsilon = 1e-6f;
+        // Per-gain comparators; < 0 = use pid_epsilon, 0 = exact match
+        float kp_epsilon  = -1.0f;
+        float ki_epsilon  = -1.0f;
+        float kd_epsilon  = -1.0f;
+    };
+
+    struct Result {
+        bool audit_baseline_set = false;    // this poll set the AuditValue baseline
+        bool pid_baseline_set   = false;    // this poll set the PID baseline
+        bool baseline_complete  = false;    // both baselines exist after this poll
+
+        bool audit_changed = false;
+        bool kp_changed    = false;
+        bool ki_changed    = false;
+        bool kd_changed    = false;
+        bool authorized    = false;         // auth != 0 at this poll
+
+        AuditSample previous;               // baselines as they were before this poll
+
+        bool pid_changed() const { return kp_changed || ki_changed || kd_changed; }
+        bool any_change()  const { return audit_changed || pid_changed(); }
+    };
+
+    AuditDetector() = default;
+    explicit AuditDetector(const Config& cfg) : cfg_(cfg) {}
+
+    Result update(const AuditSample& s);
+    void   reset();
+
+    bool               has_audit_baseline() const { return have_audit_; }
+    bool               has_pid_baseline()   const { return have_pid_; }
+    const AuditSample& baseline()           const { return base_; }
+
+private:
+    Config      cfg_;
+    AuditSample base_;
+    bool        have_audit_ = false;
+    bool        have_pid_   = false;
+};
@@ -16,11 +16,45 @@
 //      AuthorizedUser == 0, not authorized
 //      AuthorizedUser == 1, authorized
 //      Threading: Create FreeRTOS task and logs with ESP_LOG
+//      Read requests are encoded once at start (PreparedRead); each poll only sends them.
+//      Replies are decoded by the typed decoder for the configured type (CipSchema.hpp).
+//      Failed reads are classified by Cip::retry_for (CipStatus.hpp): transient PLC errors
+//      are retried once within the poll, busy / unknown-tag replies stretch the poll delay
+//      (up to 5 s), and only lost sessions count toward a reconnect. Reconnecting is left
+//      to ConnectionHealth (start it first); the audit task never blocks on the link.
+//      Unauthorized changes raise an AlertChannel alert and fire Containment::trigger()
+//      (each a no-op unless started) before the change is logged.
 
 #pragma once
 #include <cstdint>
+#include "CipCodec.hpp"
 class EnipClient;
 
+// One watched tag. The read request is encoded once when the monitor starts.
+struct AuditWatch {
+    const char* tag   = nullptr;            // nullptr / "" = not read (ChangeStamp only)
+    Cip::Type   type  = Cip::Type::DINT;    // expected reply type
+    uint16_t    every = 1;                  // read every Nth poll; last value reused in between
+    float       epsilon = -1.0f;            // REAL gains: change threshold, < 0 = detector default
+};
+
+// Full monitor setup (RuntimeConfig::audit_monitor_config builds one from the config file)
+// AuditValue: SINT/INT/DINT/LINT. AuthorizedUser: BOOL/SINT/INT/DINT. Gains: REAL.
+// ChangeStamp: DINT[7] (type ignored).
+struct AuditMonitorConfig {
+    AuditWatch audit;
+    AuditWatch authorized;
+    AuditWatch kp;
+    AuditWatch ki;
+    AuditWatch kd;
+    AuditWatch change_stamp;
+    uint32_t   poll_ms = 200;
+    int32_t    tz_offset_minutes = 0;   // ChangeStamp is PLC local time
+};
+
+void start_audit_monitor(EnipClient* enip, const AuditMonitorConfig& cfg);
+
+// Fixed types (LINT, DINT, REAL x3, DINT[7]), every tag read on every poll
 void start_audit_monitor(EnipClient* enip, 
                             const char* audit_tag, 
                             const char* authorized_tag,
@@ -30,5 +64,13 @@ void start_audit_monitor(EnipClient* enip,
                             const char* change_stamp_tag,
                             uint32_t poll_ms);
 
+// Continue poll_seq numbering from a previous run (e.g. the flash ring log's newest record + 1)
+// Call before start_audit_monitor
+void set_poll_seq_start(long first_seq);
+
+// Change the delay between polls of a running monitor (takes effect after the current delay)
+void set_audit_poll_ms(uint32_t poll_ms);
+uint32_t audit_poll_ms();
+
 bool readAuditValue(int64_t& out_lint);
 bool readAuthorizedUser(int32_t& out_dint);
\ No newline at end of file
@@ -5,6 +5,8 @@
 // CIP helpers to read a symbol
 //      scalar
 //      fixed DINT[7]
+// and to write scalars, one by one or batched in a Multiple Service Packet.
+// Decode side for passive analysis: request paths, MSP / Unconnected Send unwrapping.
 
 
 #pragma once
@@ -12,6 +14,8 @@
 #include <string>
 #include <vector>
 
+#include "CipStatus.hpp"
+
 namespace Cip {
     enum class Type : uint8_t { BOOL, SINT, INT, DINT, LINT, REAL, UNSUPPORTED };
 
@@ -30,9 +34,21 @@ namespace Cip {
     // ------------ READ-------------------
     std::vector<uint8_t> build_read_request(const std::string& tag_name, uint16_t elements);
 
+    // Get_Attribute_List (0x03) for a single attribute of class/instance
+    std::vector<uint8_t> build_get_attribute_list(uint16_t class_id, uint16_t instance, uint16_t attribute);
+
     // ------------ WRITE -----------------
     std::vector<uint8_t> build_write_bool(const std::string& tag_name, bool value);
     std::vector<uint8_t> build_write_dint(const std::string& tag_name, int32_t value);
+    std::vector<uint8_t> build_write_lint(const std::string& tag_name, int64_t value);
+    std::vector<uint8_t> build_write_real(const std::string& tag_name, float value);
+    // Any scalar; v.type picks the CIP type. Empty for UNSUPPORTED
+    std::vector<uint8_t> build_write_value(const std::string& tag_name, const Value& v);
+
+    // ------------ Batching --------------
+    // Multiple Service Packet (0x0A) to the Message Router: the PLC runs the embedded
+    // requests in order and answers them in one reply
+    std::vector<uint8_t> build_multiple_service(const std::vector<std::vector<uint8_t>>& requests);
 
     // ------------ Encapsulation ---------
     std::vector<uint8_t> wrap_sendrr(const std::vector<uint8_t>& cip);
@@ -40,4 +56,55 @@ namespace Cip {
 
     // ------------ Parse -----------------
     bool parse_read_reply(const std::vector<uint8_t>& c, Value& out);
+
+    // Locates the value bytes of a read reply inside a SendRRData body without copying:
+    // off = offset of the data after the type ID. False on a CIP error, another type or
+    // fewer than min_bytes of data. Fixed-layout decoders are in CipSchema.hpp.
+    bool find_read_value(const std::vector<uint8_t>& rr, uint16_t type_id, size_t min_bytes, size_t& off);
+
+    // Integer types (BOOL..LINT) widened to int64; 0 for REAL / unsupported
+    int64_t as_int64(const Value& v);
+
+    // Bytes inside a caller-owned buffer (no copy)
+    struct Span {
+        const uint8_t* p = nullptr;
+        size_t         n = 0;
+    };
+
+    // Status of a single-service reply (e.g. Write Tag): OK or CIP with general / extended
+    bool parse_service_status(Span c, Status& out);
+    bool parse_service_status(const std::vector<uint8_t>& c, Status& out);
+    // One status per embedded reply of a Multiple Service Packet reply; false if malformed
+    // or the packet itself failed (general status other than 0 / 0x1E embedded error)
+    bool parse_multiple_service_reply(Span c, std::vector<Status>& out);
+    bool parse_multiple_service_reply(const std::vector<uint8_t>& c, std::vector<Status>& out);
+
+    // Reply to build_get_attribute_list: copies the attribute value bytes into out
+    bool parse_get_attribute_list_reply(const std::vector<uint8_t>& c, uint16_t attribute,
+                                        std::vector<uint8_t>& out);
+
+    // ------------ Decode requests -------
+    static constexpr uint32_t NO_ID = 0xFFFFFFFF;
+
+    // A request as sent by any client; data points into the caller's buffer
+    struct Request {
+        uint8_t     service  = 0;
+        uint32_t    class_id = NO_ID;       // logical segments; NO_ID if absent
+        uint32_t    instance = NO_ID;
+        std::string symbol;                 // "Program:Main.Tag[3]"; empty if no symbolic segment
+        Span        data;                   // request data after the path
+    };
+
+    // CIP bytes of a SendRRData / SendUnitData body: the 0xB2 (unconnected) item, or the
+    // 0xB1 (connected) item without its sequence count, which goes to seq
+    bool find_cpf_data(Span body, Span& cip, bool& connected, uint16_t& seq);
+
+    // Service and path of a request; false for replies and malformed paths
+    bool parse_request(Span c, Request& out);
+
+    // Embedded requests of a Multiple Service Packet (r.data of the 0x0A request)
+    bool split_multiple_service(Span data, std::vector<Span>& out);
+
+    // Message carried by an Unconnected Send (0x52 to the Connection Manager, class 0x06)
+    bool unwrap_unconnected_send(const Request& r, Span& msg);
 }
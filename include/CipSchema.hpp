@@ -0,0 +1,176 @@
+// CipSchema.hpp
+// George Lake
+// Fall 2025
+//
+// Compile-time typed tag reads: the C++ value type fixes the CIP type ID, the reply
+// length and the value offset at build time, so decoding a reply is one layout compare
+// plus a little-endian load. Used by read_dint / read_lint / read_real (TagReads.hpp).
+//
+// Usage:
+//      Cip::TypedRead<float> kp;                   // REAL
+//      kp.prepare(".WDG_Kp");                      // SendRRData body encoded once
+//      float v;
+//      if (Cip::TypedRead<float>::decode(rr_body, v)) ...
+//
+//      Cip::TypedRead<int32_t, 7> stamp;           // DINT[7], decodes into std::array<int32_t,7>
+//
+// Notes:
+//      Value types: bool BOOL, int8_t SINT, int16_t INT, int32_t DINT, int64_t LINT,
+//      float REAL. Anything else has no CipTraits and fails to compile.
+//      What the build checks is the C++ side only: read_dint() etc. cannot be handed the
+//      wrong C++ type. Whether the PLC tag really is a DINT is only known from the reply;
+//      a different type ID fails the read at run time.
+//      The fast path is the usual UCMM reply (Null address item + one Unconnected Data
+//      item, success, no additional status): every header byte is compared at once and
+//      the value sits at VALUE_OFF. Other layouts go through Cip::find_read_value, which
+//      walks the reply without allocating. A wrong type ID or short reply fails either way.
+//      Tags whose type comes from the config file keep Cip::Value; value_decoder(type)
+//      picks the typed decoder once at start so the poll path does not switch on the type.
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "CipCodec.hpp"
+
+namespace Cip {
+    namespace detail {
+        template<typename U>
+        inline U load_le(const uint8_t* p) {
+            U u = 0;
+            for (size_t i = 0; i < sizeof(U); ++i) u |= (U)((U)p[i] << (8 * i));
+            return u;
+        }
+    }
+
+    // ------------ Type table ------------
+    template<typename T> struct CipTraits;      // no definition: unsupported value type
+
+    template<> struct CipTraits<bool> {
+        static constexpr uint16_t id = 0x00C1;  static constexpr size_t size = 1;  static constexpr Type type = Type::BOOL;
+        static bool load(const uint8_t* p)      { return (p[0] & 1) != 0; }
+        static void store(Value& o, bool v)     { o.v.b = v; }
+    };
+    template<> struct CipTraits<int8_t> {
+        static constexpr uint16_t id = 0x00C2;  static constexpr size_t size = 1;  static constexpr Type type = Type::SINT;
+        static int8_t load(const uint8_t* p)    { return (int8_t)p[0]; }
+        static void store(Value& o, int8_t v)   { o.v.i8 = v; }
+    };
+    template<> struct CipTraits<int16_t> {
+        static constexpr uint16_t id = 0x00C3;  static constexpr size_t size = 2;  static constexpr Type type = Type::INT;
+        static int16_t load(const uint8_t* p)   { return (int16_t)detail::load_le<uint16_t>(p); }
+        static void store(Value& o, int16_t v)  { o.v.i16 = v; }
+    };
+    template<> struct CipTraits<int32_t> {
+        static constexpr uint16_t id = 0x00C4;  static constexpr size_t size = 4;  static constexpr Type type = Type::DINT;
+        static int32_t load(const uint8_t* p)   { return (int32_t)detail::load_le<uint32_t>(p); }
+        static void store(Value& o, int32_t v)  { o.v.i32 = v; }
+    };
+    template<> struct CipTraits<int64_t> {
+        static constexpr uint16_t id = 0x00C5;  static constexpr size_t size = 8;  static constexpr Type type = Type::LINT;
+        static int64_t load(const uint8_t* p)   { return (int64_t)detail::load_le<uint64_t>(p); }
+        static void store(Value& o, int64_t v)  { o.v.i64 = v; }
+    };
+    template<> struct CipTraits<float> {
+        static constexpr uint16_t id = 0x00CA;  static constexpr size_t size = 4;  static constexpr Type type = Type::REAL;
+        static float load(const uint8_t* p) {
+            uint32_t u = detail::load_le<uint32_t>(p);
+            float f;
+            std::memcpy(&f, &u, sizeof f);
+            return f;
+        }
+        static void store(Value& o, float v)    { o.v.f32 = v; }
+    };
+
+    static_assert(CipTraits<int8_t>::size  == sizeof(int8_t)  && CipTraits<int16_t>::size == sizeof(int16_t) &&
+                  CipTraits<int32_t>::size == sizeof(int32_t) && CipTraits<int64_t>::size == sizeof(int64_t),
+                  "CIP integer sizes");
+    static_assert(CipTraits<float>::size == sizeof(float) && std::numeric_limits<float>::is_iec559,
+                  "REAL needs a 32-bit IEEE 754 float");
+
+    // ------------ Reply layout ----------
+    // SendRRData reply body: if_handle(4) timeout(2) count(2) Null item(4) data item header(4)
+    static constexpr size_t RR_CIP_OFF = 16;
+    // CIP reply: service, reserved, general status, additional status size (words)
+    static constexpr size_t CIP_REPLY_HDR = 4;
+
+    template<typename T, uint16_t N = 1>
+    struct TypedRead {
+        using Traits     = CipTraits<T>;
+        using value_type = typename std::conditional<N == 1, T, std::array<T, N>>::type;
+
+        static_assert(N >= 1, "at least one element");
+
+        static constexpr size_t DATA_BYTES = Traits::size * N;
+        static constexpr size_t CIP_LEN    = CIP_REPLY_HDR + 2 + DATA_BYTES;   // + type ID
+        static constexpr size_t VALUE_OFF  = RR_CIP_OFF + CIP_REPLY_HDR + 2;
+        static constexpr size_t REPLY_LEN  = RR_CIP_OFF + CIP_LEN;
+        static_assert(CIP_LEN <= 0xFFFF, "reply does not fit one data item");
+
+        const char*          tag = nullptr;     // must outlive the request
+        std::vector<uint8_t> rr;
+
+        bool prepare(const char* name) {
+            tag = name;
+            rr.clear();
+            if (!name || name[0] == '\0') return false;
+            rr = wrap_sendrr(build_read_request(name, N));
+            return true;
+        }
+
+        // The usual reply, all fixed bytes compared in one expression
+        static bool fast_match(const std::vector<uint8_t>& r) {
+            if (r.size() != REPLY_LEN) return false;
+            const uint8_t* p = r.data();
+            const uint32_t diff = (p[6] ^ 0x02u) | p[7] | p[8] | p[9] | p[10] | p[11]
+                                | (p[12] ^ 0xB2u) | p[13]
+                                | (p[14] ^ (uint8_t)CIP_LEN) | (p[15] ^ (uint8_t)(CIP_LEN >> 8))
+                                | (p[16] ^ 0xCCu) | p[18] | p[19]
+                                | (p[20] ^ (uint8_t)Traits::id) | (p[21] ^ (uint8_t)(Traits::id >> 8));
+            return diff == 0;
+        }
+
+        static bool decode(const std::vector<uint8_t>& rr_body, value_type& out) {
+            size_t off = VALUE_OFF;
+            if (!fast_match(rr_body) && !find_read_value(rr_body, Traits::id, DATA_BYTES, off)) return false;
+            load(rr_body.data() + off, out);
+            return true;
+        }
+
+    private:
+        static void load(const uint8_t* p, T& out) { out = Traits::load(p); }
+        template<size_t M>
+        static void load(const uint8_t* p, std::array<T, M>& out) {
+            for (size_t i = 0; i < M; ++i) out[i] = Traits::load(p + i * Traits::size);
+        }
+    };
+
+    // ------------ Runtime-typed tags ----
+    using ValueDecoder = bool (*)(const std::vector<uint8_t>& rr_body, Value& out);
+
+    template<typename T>
+    bool decode_value(const std::vector<uint8_t>& rr_body, Value& out) {
+        T v;
+        if (!TypedRead<T>::decode(rr_body, v)) return false;
+        CipTraits<T>::store(out, v);
+        out.type = CipTraits<T>::type;
+        return true;
+    }
+
+    // Scalar decoder for a type chosen at run time; nullptr for UNSUPPORTED
+    inline ValueDecoder value_decoder(Type t) {
+        switch (t) {
+            case Type::BOOL: return &decode_value<bool>;
+            case Type::SINT: return &decode_value<int8_t>;
+            case Type::INT:  return &decode_value<int16_t>;
+            case Type::DINT: return &decode_value<int32_t>;
+            case Type::LINT: return &decode_value<int64_t>;
+            case Type::REAL: return &decode_value<float>;
+            default:         return nullptr;
+        }
+    }
+}
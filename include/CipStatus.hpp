@@ -0,0 +1,57 @@
+// CipStatus.hpp
+// George Lake
+// Fall 2025
+//
+// Structured outcome of one ENIP/CIP request and the retry policy that goes with it.
+//
+// Usage:
+//      Cip::Status st;
+//      if (!read_prepared(enip, req, v, prio, &st)) {
+//          switch (Cip::retry_for(st)) { ... }
+//          char buf[64]; Cip::describe(st, buf, sizeof buf);
+//      }
+//
+// Notes:
+//      The layer says where the request failed: the socket (TRANSPORT), the encapsulation
+//      header status (ENCAP), the CIP general status of the reply (CIP), or a reply with
+//      general status 0 that is still unusable, e.g. another type (REPLY).
+//      Retry classes, cheapest first:
+//          NONE       fail this read only; retrying will not help (bad type, size, service)
+//          NOW        transient inside the PLC (embedded service error): retry once at once
+//          BACKOFF    PLC busy / in a state change: keep the session, slow the next polls
+//          RESOLVE    the tag path is not (or no longer) known to the PLC: keep retrying on
+//                     the backoff schedule (symbolic paths are looked up again per request)
+//          RECONNECT  the session or socket is gone: only these count toward a teardown
+//                     (EnipClient drops an invalid session itself)
+//      A reply of any kind proves the link; only RECONNECT should be fed to
+//      ConnectionHealth::note_poll(false).
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Cip {
+    struct Status {
+        enum class Layer : uint8_t { OK, TRANSPORT, ENCAP, CIP, REPLY };
+        Layer    layer    = Layer::OK;
+        uint32_t encap    = 0;      // encapsulation header status
+        uint8_t  general  = 0;      // CIP general status
+        uint16_t extended = 0;      // first additional status word, 0 if none
+
+        bool ok() const { return layer == Layer::OK; }
+    };
+
+    enum class Retry : uint8_t { NONE, NOW, BACKOFF, RESOLVE, RECONNECT };
+
+    Retry retry_for(const Status& s);
+    const char* retry_name(Retry r);
+    const char* general_status_name(uint8_t general);
+
+    // Fills general / extended from a SendRRData reply body; REPLY if the CIP status is 0
+    // (the reply was unusable for another reason), CIP otherwise
+    void read_status(const std::vector<uint8_t>& rr_body, Status& out);
+
+    // "CIP 0x05/0x0000 path destination unknown", "ENCAP 0x00000064", "transport"
+    size_t describe(const Status& s, char* buf, size_t len);
+}
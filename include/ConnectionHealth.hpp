@@ -0,0 +1,78 @@
+// ConnectionHealth.hpp
+// George Lake
+// Fall 2025
+//
+// Owns the health of the shared EnipClient session: keepalive probes while the link is
+// idle, reconnect + session re-registration with jittered exponential backoff, and the
+// comm-fault intervals in the Experiment metrics.
+//
+// Usage:
+//      1) enip.connect_tcp() && enip.register_session()     // initial session, as before
+//      2) ConnectionHealth::start(&enip, cfg);
+//      3) consumers call ConnectionHealth::note_poll(ok) after each poll (audit_task does)
+//
+// Notes:
+//      The link is down when EnipClient closed the socket after a transport error, a
+//      ListIdentity probe failed, or fail_threshold polls in a row failed with the socket
+//      still open. That moment is record_comm_fault_start(); the successful re-registration
+//      is record_comm_fault_end(), so the fault interval is the blind period.
+//      Retries: first after first_retry_ms, then doubling up to max_backoff_ms, each
+//      +/- jitter_pct so several devices do not reconnect in lockstep after a switch reboot.
+//      Consumers never block on a reconnect: while the link is down send_rr_data() fails
+//      immediately, and the connect itself runs in this task.
+//      Probes are ENIP ListIdentity on the session socket, sent only when no reply has been
+//      received for idle_probe_ms (polls already prove the link while they run).
+//      hot_standby keeps a spare registered session (EnipClient::open_standby), probed every
+//      standby_probe_ms. A primary failure switches to it inside the failing request, so
+//      no outage is recorded and the next poll runs normally; this task then builds a new
+//      spare. Without a live spare the reconnect path above applies.
+//      Network link events (on_link, e.g. from WifiManager) short-cut the timeouts: link loss
+//      aborts the request in flight (EnipClient::abort) and opens the fault at the event's
+//      time; reconnect attempts pause until the link is back, then the first one runs at once.
+
+#pragma once
+#include <cstdint>
+
+class EnipClient;
+
+namespace ConnectionHealth {
+    struct Config {
+        uint32_t idle_probe_ms  = 2000;     // 0 = no probes
+        uint32_t first_retry_ms = 50;
+        uint32_t max_backoff_ms = 8000;
+        uint8_t  jitter_pct     = 25;
+        uint8_t  fail_threshold = 5;        // consecutive failed polls with the socket open
+        uint8_t  priority       = 6;
+        bool     hot_standby      = false;
+        uint32_t standby_probe_ms = 1000;
+    };
+
+    struct Status {
+        bool     up                 = false;
+        uint32_t outages            = 0;
+        uint32_t reconnect_attempts = 0;
+        uint32_t reconnects         = 0;
+        uint32_t probes             = 0;
+        uint32_t probe_failures     = 0;
+        uint32_t last_outage_ms     = 0;
+        uint32_t longest_outage_ms  = 0;
+        bool     standby_ready      = false;
+        uint32_t failovers          = 0;
+        uint32_t standby_opens      = 0;
+    };
+
+    bool start(EnipClient* enip, const Config& cfg = Config());
+    bool running();
+
+    // Poll outcome from a consumer; a failure wakes the manager at once
+    void note_poll(bool ok);
+
+    // Network link up/down at esp_timer time t_us; safe from the event loop task
+    void on_link(bool up, int64_t t_us);
+    // Same, with the WifiManager::LinkListener signature
+    void wifi_link_listener(bool up, int64_t t_us, void* arg);
+
+    Status status();
+    // One ESP_LOGI line
+    void log_summary(const char* log_tag);
+}
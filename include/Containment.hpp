@@ -0,0 +1,68 @@
+// Containment.hpp
+// George Lake
+// Fall 2025
+//
+// Automatic containment: on an unauthorized change, write a fixed set of tags in the PLC
+// (alarm BOOL, safe-mode DINT, ...) in one request, and measure detection -> write ack.
+//
+// Usage:
+//      Containment::Action acts[] = {{"WDG_Status_Instance.Alarm", v_true}, ...};
+//      Containment::start(&enip, acts, n);          // after the ENIP session is up
+//      Containment::trigger("unauthorized AuditValue change", esp_timer_get_time());
+//
+// Notes:
+//      The request is encoded once at start: a single Write Tag for one action, otherwise
+//      one Multiple Service Packet carrying every write, so the whole set costs one RTT.
+//      trigger() only records the detection time and wakes the containment task, so the
+//      detecting task never blocks. The task sends at EnipClient::Priority::URGENT: the
+//      write is next on the socket, behind at most the one transaction already in flight,
+//      never behind queued polls.
+//      Triggers that arrive while a batch is in flight are coalesced into one more batch,
+//      timed from the earliest of them. Writes are idempotent (fixed values).
+//      Each batch logs per-write CIP status and emits {"record_type":"containment"} with
+//      detect_to_ack_us, queue_us and rtt_us; log_summary() reports the latency histogram.
+//      A failed batch is not retried automatically: the next detection triggers it again.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "CipCodec.hpp"
+
+class EnipClient;
+
+namespace Containment {
+    static constexpr size_t MAX_ACTIONS = 8;
+
+    struct Action {
+        const char* tag;                    // full symbol; copied by start()
+        Cip::Value  value;                  // value.type selects the CIP type
+    };
+
+    struct Config {
+        uint8_t priority = 7;               // above audit_task so a trigger runs at once
+    };
+
+    struct Status {
+        uint32_t triggers   = 0;
+        uint32_t coalesced  = 0;            // triggers folded into a pending batch
+        uint32_t batches    = 0;
+        uint32_t acked      = 0;            // batches where every write succeeded
+        uint32_t failed     = 0;
+        uint32_t last_us    = 0;            // detection -> ack of the last acked batch
+        uint32_t p50_us     = 0;
+        uint32_t p99_us     = 0;
+        uint32_t max_us     = 0;
+    };
+
+    // false if already running, no / too many actions, an unsupported type or the packet
+    // would exceed the unconnected message size
+    bool start(EnipClient* enip, const Action* actions, size_t count, const Config& cfg = Config());
+    bool running();
+
+    // Detection at esp_timer time detect_us; returns immediately. reason must be a literal.
+    void trigger(const char* reason, int64_t detect_us);
+
+    Status status();
+    void log_summary(const char* log_tag);
+}
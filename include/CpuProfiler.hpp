@@ -0,0 +1,64 @@
+// CpuProfiler.hpp
+// George Lake
+// Fall 2025
+//
+// Per-task CPU utilisation from FreeRTOS run time stats, sampled by a low-priority task.
+//
+// Usage:
+//      1) CpuProfiler::start(cfg) once the application tasks are running
+//      2) Application loops call CpuProfiler::count_wake() once per unit of work
+//         (one poll, one log batch, ...)
+//      3) Experiment::dump_summary logs the latest window and emits a "cpu_profile" record
+//
+// Notes:
+//      Every period_ms the profiler reads uxTaskGetSystemState and reports, per task,
+//      the share of run time it used in that window (IDLE's share is the headroom).
+//      Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+//      (sdkconfig.defaults); start() returns false without them.
+//      FreeRTOS keeps no per-task context switch count, so switch rates are reported as
+//      wakeups/s for tasks that call count_wake(); Wi-Fi/lwIP tasks show CPU only.
+//      The run time counter is 32-bit microseconds: windows must be shorter than ~71 min.
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace CpuProfiler {
+    struct Config {
+        uint32_t period_ms = 5000;
+        uint8_t  priority  = 1;        // just above IDLE
+    };
+
+    struct TaskLoad {
+        char     name[16]     = {0};
+        uint8_t  priority     = 0;
+        float    cpu_pct      = 0.0f;  // share of the window's run time
+        float    wakes_per_s  = -1.0f; // -1 = task does not call count_wake()
+    };
+
+    static constexpr uint32_t MAX_TASKS = 24;
+
+    struct Window {
+        int64_t  end_ms      = 0;      // end of window, ms since boot
+        uint32_t window_ms   = 0;
+        uint32_t task_count  = 0;
+        float    idle_pct    = 0.0f;   // sum of IDLE tasks
+        bool     has_idle    = false;  // false on the host build: no load figure
+        TaskLoad tasks[MAX_TASKS];     // sorted by cpu_pct, highest first
+    };
+
+    bool start(const Config& cfg = Config());
+    bool running();
+
+    // Calling task completed one unit of work (lock-free, allocation-free)
+    void count_wake();
+
+    // Latest completed window; false if none yet
+    bool latest(Window& out);
+
+    // One ESP_LOGI line for the load, one per task above 0.1%
+    void log_summary(const char* log_tag);
+
+    // {"record_type":"cpu_profile",...} for the latest window ("" if none yet)
+    std::string export_json(int64_t t_ms);
+}
@@ -3,29 +3,144 @@
 // Fall2025
 //
 // Small EitherNet/IP UCMM Client (RegisterSession + SendRRData)
+//
+// Notes:
+//      One client can be shared by several tasks. Each send_rr_data() waits for the socket
+//      in a per-priority FIFO; when the socket frees up it is handed to the oldest waiter
+//      of the highest priority (URGENT = containment writes, HIGH = audit polls, NORMAL =
+//      setup reads, LOW = background such as time sync), whatever the FreeRTOS priorities
+//      of the calling tasks.
+//      The caller then runs its own request/reply, so the reply lands in its own buffer
+//      and there is no owner task or extra context switch per request.
+//      The handover uses task notification index 1 (HANDOFF_NOTIFY_INDEX); index 0 stays
+//      with the calling task's own wake-ups (Containment, ConnectionHealth), which a
+//      queued caller must not consume.
+//      A transaction in progress is never interrupted; a HIGH request waits at most one
+//      reply of another consumer (RrTiming::queue_us, Stats::max_queue_us).
+//      Sockets get TCP_NODELAY, TCP keepalive and send/receive timeouts (SocketConfig), so a
+//      silent PLC fails a request instead of blocking its caller. A transport error closes
+//      the socket (a late reply must not be read as the next request's); connected() turns
+//      false and ConnectionHealth re-registers with reconnect().
+//      Hot standby (optional): open_standby() keeps a second registered session idle next
+//      to the primary. On a transport error it is promoted inside the failing request and
+//      that request is sent once more on it (reads and the containment writes are safe to
+//      repeat); the caller rebuilds the spare afterwards.
+//      Costs one more PLC encapsulation session and socket.
 
 
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "CipStatus.hpp"
+#include "SeqLock.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
 class EnipClient {
 public:
+    enum class Priority : uint8_t { URGENT, HIGH, NORMAL, LOW, COUNT };
+
+    // Split of one send_rr_data round trip (esp_timer microseconds)
+    struct RrTiming {
+        int64_t  start_us{0};   // esp_timer_get_time() just before the first byte is sent
+        uint32_t queue_us{0};   // waiting for another consumer's transaction to finish
+        uint32_t send_us{0};    // request written to the socket
+        uint32_t wait_us{0};    // send complete -> full reply received
+    };
+
+    // Per-priority counters (snapshot; updated under the queue lock)
+    struct Stats {
+        uint32_t requests[(size_t)Priority::COUNT]     = {};
+        uint32_t queued[(size_t)Priority::COUNT]       = {};   // had to wait for the socket
+        uint32_t max_queue_us[(size_t)Priority::COUNT] = {};
+        uint32_t transport_errors = 0;      // socket closed by a failed send / receive
+        uint32_t failovers        = 0;      // ... and replaced by the standby session
+    };
+
+    struct SocketConfig {
+        uint32_t io_timeout_ms      = 2000; // connect, and each send / receive
+        uint32_t keepalive_idle_s   = 5;    // TCP keepalive, where the stack supports it
+        uint32_t keepalive_intvl_s  = 1;
+        uint32_t keepalive_count    = 3;
+    };
+
     EnipClient(const std::string& ip, uint16_t port);
     ~EnipClient();
 
+    // Applies to sockets opened after the call
+    void set_socket_config(const SocketConfig& cfg) { sock_cfg_ = cfg; }
+
     bool connect_tcp();
     bool register_session();
-    bool send_rr_data(const std::vector<uint8_t>& rr, std::vector<uint8_t>& rr_resp);
+    // Open and register a new session, then swap it in; requests queue only for the swap
+    bool reconnect();
+    // ListIdentity round trip (keepalive at the encapsulation layer), queued at LOW
+    bool probe();
+    bool connected() const { return up_.load(std::memory_order_relaxed); }
+
+    // Hot standby session (see Notes); probe_standby() closes it if the probe fails
+    bool open_standby();
+    bool probe_standby();
+    bool has_standby() const;
+    void close_standby();
+
+    // Link lost (e.g. Wi-Fi down): fail the request in flight now instead of at its timeout,
+    // drop the standby, and fail new requests until reconnect(). Safe from any task.
+    void abort();
+    // esp_timer time of the last reply received on this client; 0 = none yet
+    int64_t last_reply_us() const;
+
+    // One request/reply transaction, queued behind other consumers by priority.
+    // status (optional) says why it failed: TRANSPORT or ENCAP; OK on success
+    bool send_rr_data(const std::vector<uint8_t>& rr, std::vector<uint8_t>& rr_resp,
+                      RrTiming* timing = nullptr, Priority prio = Priority::NORMAL,
+                      Cip::Status* status = nullptr);
+    // Waits (HIGH) for a transaction in flight to finish, then closes the session socket
     void close();
 
+    Stats stats() const;
+    // One ESP_LOGI line per priority that has seen requests
+    void log_stats(const char* log_tag) const;
+
 private:
-    bool send_all(const void* data, size_t len);
-    bool recv_all(void* data, size_t len);
+    // Caller waiting for the socket (lives on the caller's stack)
+    struct Waiter {
+        TaskHandle_t  task;
+        Waiter*       next;
+        volatile bool granted;
+    };
+
+    uint32_t acquire(Priority prio);        // returns microseconds spent queued
+    void     release();
+
+    int  open_socket() const;               // connected fd with options applied; -1 on failure
+    bool register_on(int fd, uint32_t& session) const;
+    bool drop(const char* what);            // transport error while holding the socket; true = failed over
+    void note_reply(int64_t t_us);          // stores last_reply_us_
+
+    static bool list_identity(int fd);
+    static bool send_all(int fd, const void* data, size_t len);
+    static bool recv_all(int fd, void* data, size_t len);
 
     std::string ip_;
     uint16_t port_{0};
     int sock_{-1};
     uint32_t session_{0};
+    SocketConfig sock_cfg_;
+    int      standby_fd_{-1};
+    uint32_t standby_session_{0};
+    int      probing_fd_{-1};           // standby fd while probe_standby() has it out
+    SemaphoreHandle_t fd_lock_{nullptr};   // closing / swapping sock_, the standby fields
+    std::atomic<bool>    up_{false};
+    SeqLock              reply_lock_;      // last_reply_us_ is 64-bit: not lock-free on the C6
+    SeqLock::U64         last_reply_us_;
+    SemaphoreHandle_t io_lock_{nullptr};   // guards the fields below (held briefly, never across I/O)
+    bool    busy_{false};                  // a transaction owns the socket
+    Waiter* head_[(size_t)Priority::COUNT] = {};
+    Waiter* tail_[(size_t)Priority::COUNT] = {};
+    Stats   stats_;
 };
\ No newline at end of file
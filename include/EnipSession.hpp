@@ -0,0 +1,107 @@
+// EnipSession.hpp
+// George Lake
+// Fall 2025
+//
+// Non-blocking EtherNet/IP session (RegisterSession + SendRRData) driven by an external
+// select() loop, so one task can keep many PLC sessions busy at once.
+//
+// Usage:
+//      EnipSession s("10.0.0.11", 44818);
+//      loop:
+//          s.tick(now_us);                         // connect / timeouts / reconnect backoff
+//          if (s.ready()) s.submit(rr);            // one request in flight per session
+//          FD_SET(s.fd(), ...) per wants_read() / wants_write(); select(...)
+//          s.on_io(readable, writable, now_us);
+//          if (s.take_reply(body, ok)) ...         // reply (or failure) of the request
+//
+// Notes:
+//      States: IDLE -> CONNECTING -> REGISTERING -> READY <-> BUSY; any error closes the
+//      socket, fails the request in flight and waits reconnect_ms in BACKOFF.
+//      The encapsulation sender context carries a sequence number; replies to an older
+//      request (after a timeout) are discarded.
+//      Buffers are reused between requests; steady state does not allocate.
+//      Not thread-safe: one owner task.
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class EnipSession {
+public:
+    enum class State : uint8_t { IDLE, CONNECTING, REGISTERING, READY, BUSY, BACKOFF };
+
+    struct Stats {
+        uint32_t requests       = 0;
+        uint32_t replies        = 0;
+        uint32_t timeouts       = 0;
+        uint32_t errors         = 0;    // socket / encapsulation errors
+        uint32_t connects       = 0;    // sessions registered
+        uint32_t stale_replies  = 0;
+        uint32_t last_rtt_us    = 0;
+    };
+
+    EnipSession(const std::string& ip, uint16_t port,
+                uint32_t reply_timeout_ms = 1000, uint32_t reconnect_ms = 1000);
+    ~EnipSession();
+
+    EnipSession(const EnipSession&) = delete;
+    EnipSession& operator=(const EnipSession&) = delete;
+
+    // Start connecting if idle, expire deadlines, leave BACKOFF when due
+    void tick(int64_t now_us);
+
+    // Queue a SendRRData body (wrap_sendrr / PreparedRead::rr); false unless ready()
+    bool submit(const std::vector<uint8_t>& rr, int64_t now_us);
+
+    // select() interface
+    int  fd() const          { return sock_; }
+    bool wants_read() const;
+    bool wants_write() const;
+    void on_io(bool readable, bool writable, int64_t now_us);
+
+    // Earliest time tick() has something to do (deadline or end of backoff); 0 = none
+    int64_t next_deadline_us() const;
+
+    // Completion of the submitted request: true once per submit(); ok=false on failure
+    bool take_reply(std::vector<uint8_t>& rr_body, bool& ok);
+
+    bool  ready() const      { return state_ == State::READY && !done_; }
+    State state() const      { return state_; }
+    const Stats& stats() const { return stats_; }
+    const std::string& ip() const { return ip_; }
+
+    void close();
+
+private:
+    void start_connect(int64_t now_us);
+    void fail(const char* why, int64_t now_us);
+    void finish_request(bool ok);
+    void queue_packet(uint16_t command, const uint8_t* body, size_t len);
+    bool flush_tx();
+    bool read_rx(int64_t now_us);
+    void handle_packet(int64_t now_us);
+
+    std::string ip_;
+    uint16_t    port_;
+    uint32_t    reply_timeout_ms_;
+    uint32_t    reconnect_ms_;
+
+    int         sock_      = -1;
+    State       state_     = State::IDLE;
+    uint32_t    session_   = 0;
+    int64_t     deadline_us_ = 0;       // connect / register / reply deadline, or end of backoff
+
+    std::vector<uint8_t> tx_;
+    size_t               tx_off_ = 0;
+    std::vector<uint8_t> rx_;           // header + body of the packet being received
+    size_t               rx_have_ = 0;
+
+    uint64_t    seq_        = 0;        // sender context of the request in flight
+    int64_t     sent_us_    = 0;
+    bool        done_       = false;
+    bool        done_ok_    = false;
+    std::vector<uint8_t> reply_;
+
+    Stats       stats_;
+};
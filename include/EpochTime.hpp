@@ -12,6 +12,36 @@
 namespace EpochTime {
   struct PlcDateTime { int32_t year, month, day, hour, minute, second, usec; };
 
+  // Civil (proleptic Gregorian) date <-> days since 1970-01-01, constant time.
+  // Closed-form era/day-of-era algorithms (H. Hinnant, "chrono-Compatible
+  // Low-Level Date Algorithms"); valid for any year representable in int32.
+  constexpr int64_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+    y -= (m <= 2);
+    const int64_t  era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = (uint32_t)(y - era * 400);                          // [0, 399]
+    const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;    // [0, 365]
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;              // [0, 146096]
+    return era * 146097 + (int64_t)doe - 719468;
+  }
+
+  struct CivilDate { int32_t year; uint32_t month, day; };
+
+  constexpr CivilDate civilFromDays(int64_t z) {
+    z += 719468;
+    const int64_t  era = (z >= 0 ? z : z - 146096) / 146097;
+    const uint32_t doe = (uint32_t)(z - era * 146097);                       // [0, 146096]
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);            // [0, 365]
+    const uint32_t mp  = (5 * doy + 2) / 153;                                // [0, 11]
+    const uint32_t d   = doy - (153 * mp + 2) / 5 + 1;                       // [1, 31]
+    const uint32_t m   = mp < 10 ? mp + 3 : mp - 9;                          // [1, 12]
+    return CivilDate{(int32_t)((int64_t)yoe + era * 400 + (m <= 2)), m, d};
+  }
+
+  static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch");
+  static_assert(daysFromCivil(2000, 3, 1) == 11017, "leap century");
+  static_assert(civilFromDays(11016).day == 29, "2000-02-29");
+
   // Construct PlcDateTime from DateTime[0..6] DINTs.
   PlcDateTime fromArray(const std::array<int32_t,7>& a);
 
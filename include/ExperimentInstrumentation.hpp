@@ -10,12 +10,16 @@
 
 #include <cstdint>
 #include <stdint.h>
+#include <string>
 #include "json_log.hpp"
 
 struct LogEntry;
+class FlashRingLog;
 
 // Simple container for aggregated metrics.
 // Can extend later if more fields are needed.
+// This is a plain snapshot type: the live values are kept as atomics inside
+// ExperimentInstrumentation.cpp and copied out consistently by current().
 struct ExperimentMetrics {
     const char* scenario_id = nullptr;
     const char* scenario_variant;
@@ -41,6 +45,28 @@ struct ExperimentMetrics {
     int64_t total_comm_fault_dur_ms     = 0;
 };
 
+// Fixed-size binary event record pushed by the record_* calls.
+// Counters are a snapshot taken in the same update as the event itself.
+enum class ExperimentEventType : uint8_t {
+    BASELINE, AUDIT, PID, READ_FAIL, COMM_FAULT_START, COMM_FAULT_END
+};
+
+struct ExperimentEvent {
+    int64_t             t_ms;
+    uint32_t            seq;            // event number since boot
+    ExperimentEventType type;
+    int8_t              authorized;     // 1 / 0, -1 = not applicable
+    uint32_t            authorized_audit_changes;
+    uint32_t            unauthorized_audit_changes;
+    uint32_t            authorized_pid_changes;
+    uint32_t            unauthorized_pid_changes;
+    uint32_t            read_failures;
+    uint32_t            comm_fault_intervals;
+    int64_t             baseline_established_ms;
+    int64_t             first_detection_ms;
+    int64_t             total_comm_fault_dur_ms;
+};
+
 namespace Experiment {
 
     // Initialize metrics for a new run (scenario S1-S5)
@@ -58,10 +84,29 @@ namespace Experiment {
     // Reset counters for a fresh repetition of the same scenario
     void reset_metrics();
 
+    // Replace the placeholder firmware versions set by init() (strings must stay valid)
+    void set_firmware_versions(const char* esp_version, const char* plc_version);
+
+    // Relabel the run for the next trial (trial_id and poll_period_ms in every LogEntry)
+    void set_trial(int trial_id, uint32_t poll_period_ms);
+
     // Mark the moment the watchdog baselines are fully established
     // Call from AuditMonitor when both audit and PID baselines are set
     void mark_baseline_established();
 
+    // The record_* / mark_* calls below only update counters and push an
+    // ExperimentEvent into a preallocated ring; they never format or print.
+    // start_event_logger() starts the low-priority task that turns ring
+    // entries into the EVENT CSV lines on ESP_LOGI.
+    void start_event_logger();
+
+    // Copies up to max_n most recent events into out (oldest first).
+    // Returns the number copied.
+    size_t recent_events(ExperimentEvent* out, size_t max_n);
+
+    // Events overwritten in the ring before the logger task formatted them
+    uint32_t dropped_events();
+
     // Record an AuditValue change (authorized or unauthorized)
     void record_audit_change(bool authorized);
 
@@ -73,10 +118,12 @@ namespace Experiment {
 
     // Mark start/end of a "communication fault interval"
     // e.g., sustained read failures for N polls
-    void record_comm_fault_start();
-    void record_comm_fault_end();
+    // at_us: esp_timer time the fault actually began / ended, when known (-1 = now)
+    void record_comm_fault_start(int64_t at_us = -1);
+    void record_comm_fault_end(int64_t at_us = -1);
 
-    // Dump a summary to ESP_LOGI
+    // Dump a summary to ESP_LOGI, including read latency p50/p90/p99/max,
+    // and emit one "latency_histogram" JSONL record per stage / tag
     // Call at the end of a scenario run, or periodically for debugging
     void dump_summary();
 
@@ -87,6 +134,16 @@ namespace Experiment {
     // Emits a single JSONL record.
     void emit_log_entry(const LogEntry& entry);
 
-    // Optional accessor to inspect metrics directly:
-    const ExperimentMetrics& current();
+    // Also persist every emitted JSONL record to an opened flash ring log.
+    // Pass nullptr to detach.
+    void attach_flash_log(FlashRingLog* log);
+
+    // Consistent snapshot of all metrics (safe from any task, never blocks the writer)
+    ExperimentMetrics current();
+
+    // Timestamp used for every record: PLC epoch ms once synced, else ms since boot
+    int64_t timestamp_ms();
+
+    // Emits a non-poll JSONL record (record_type set by the caller) on the same sinks
+    void emit_record(const std::string& json, int64_t t_ms);
 } // namespace Experiment
\ No newline at end of file
@@ -0,0 +1,127 @@
+// FlashRingLog.hpp
+// George Lake
+// Fall 2025
+//
+// Persistent circular log store on flash (LittleFS on the ESP, a plain
+// directory on the host).
+//
+// Layout:
+//      <base>/seg_NN.bin   segment files, rotated round-robin
+//      each segment = 16 byte header + N fixed-size pages
+//      each page    = packed records, tail padded with 0xFF
+//      each record  = 24 byte header (magic, len, crc32, poll_seq, t_ms) + payload
+//
+// Notes:
+//      Records never span pages, so every page can be parsed on its own.
+//      Appends are batched in a RAM page buffer; a full page is written once and synced.
+//      The partial page is rewritten in place only every flush_interval_ms and by
+//      flush() at shutdown, so a reset loses at most that interval.
+//      The active segment stays open between page writes.
+//      When the active segment fills, the least recently written segment
+//      (lowest generation) is truncated and reused.
+//      A small RAM index (first poll_seq per page) lets read_by_seq jump straight to the
+//      page containing the start of a range; poll_seq continues across resets (main
+//      resumes it from newest_seq). t_ms counts from boot until time sync and restarts
+//      with each reset, so read_by_time scans the whole ring and filters.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+class FlashRingLog {
+public:
+    struct Config {
+        std::string base_path     = "/littlefs/ringlog";
+        uint32_t    segment_count = 8;
+        uint32_t    pages_per_seg = 16;
+        uint32_t    page_bytes    = 4096;   // matches the LittleFS block size
+        int64_t     flush_interval_ms = 60000; // rewrite the partial page at most this often
+    };
+
+    struct Stats {
+        uint32_t records_appended = 0;
+        uint32_t records_rejected = 0;   // too large or I/O error
+        uint32_t pages_written    = 0;
+        uint32_t segment_rotations= 0;
+        uint32_t crc_errors       = 0;   // seen while reading
+        int64_t  oldest_seq       = -1;
+        int64_t  newest_seq       = -1;
+    };
+
+    // Record as returned by the readers. data is only valid during the callback.
+    struct Record {
+        int64_t        poll_seq;
+        int64_t        t_ms;
+        const uint8_t* data;
+        size_t         len;
+    };
+    using RecordFn = std::function<void(const Record&)>;
+
+    // Mount the backing filesystem at mount_point.
+    // ESP: registers the LittleFS partition with VFS. Host: creates the directory.
+    static bool mount_storage(const char* mount_point, const char* partition_label = "littlefs");
+
+    FlashRingLog();
+    ~FlashRingLog();
+
+    // Opens (or creates) the ring in cfg.base_path and rebuilds the page index.
+    bool open(const Config& cfg);
+    void close();
+
+    // Queues a record into the RAM page buffer; writes the page when full.
+    bool append(int64_t poll_seq, int64_t t_ms, const void* data, size_t len);
+
+    // Writes the current partial page so it survives a reset (call at shutdown).
+    bool flush();
+
+    // Calls fn for every record with lo <= key <= hi, oldest first.
+    // Returns the number of records delivered.
+    size_t read_by_seq (int64_t lo, int64_t hi, const RecordFn& fn);
+    size_t read_by_time(int64_t lo_ms, int64_t hi_ms, const RecordFn& fn);
+
+    Stats stats() const;
+    bool  is_open() const { return open_; }
+
+private:
+    struct PageIndex {
+        int64_t first_seq{-1};
+    };
+    struct Segment {
+        uint32_t generation{0};     // 0 = unused
+        uint32_t pages_used{0};     // complete or partial pages on disk
+        int64_t  last_seq{-1};
+        std::vector<PageIndex> pages;
+    };
+
+    std::string seg_path(uint32_t idx) const;
+    bool scan_segment(uint32_t idx);
+    bool start_segment(uint32_t idx, uint32_t generation);
+    bool write_page(bool partial);
+    bool rotate();
+    size_t read_range(bool by_time, int64_t lo, int64_t hi, const RecordFn& fn);
+    std::vector<uint32_t> segments_oldest_first() const;
+
+    Config cfg_{};
+    bool   open_{false};
+    std::vector<Segment> segs_;
+    FILE*    seg_file_{nullptr};    // active segment, open between page writes
+    uint32_t active_{0};
+    uint32_t cur_page_{0};          // page of the active segment being filled
+    uint32_t next_generation_{1};
+
+    // RAM page buffer for batched appends
+    std::vector<uint8_t> page_;
+    size_t  page_fill_{0};
+    bool    page_dirty_{false};
+    int64_t page_first_unflushed_ms_{-1};
+
+    Stats stats_{};
+    SemaphoreHandle_t lock_{nullptr};
+};
@@ -0,0 +1,109 @@
+// LatencyHistogram.hpp
+// George Lake
+// Fall 2025
+//
+// Fixed-bucket log-linear histogram for microsecond latencies.
+//
+// Buckets:
+//      values < 8 us get one bucket each; above that every power of two is
+//      split into 8 linear sub-buckets (worst-case error 12.5%).
+//      Range: 0 .. 2^24 us (~16.7 s); larger values land in the top bucket.
+//
+// Notes:
+//      record() is a handful of integer ops and relaxed atomic increments, no allocation,
+//      so several tasks may record into one histogram while another reads or resets it.
+//      Readers may see a sample in count() before its bucket; percentiles tolerate that.
+//      The 64-bit sum is a SeqLock::U64 updated with count_ under the SeqLock, so mean()
+//      sees a matching pair; that is the only critical section on the record path.
+//      Percentiles report the upper edge of the bucket, clipped to the max seen.
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "SeqLock.hpp"
+
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BITS = 3;
+    static constexpr uint32_t SUB      = 1u << SUB_BITS;
+    static constexpr uint32_t MAX_EXP  = 24;
+    static constexpr uint32_t BUCKETS  = (MAX_EXP - SUB_BITS + 1) * SUB;
+    static constexpr uint32_t MAX_US   = (1u << MAX_EXP) - 1;
+
+    static uint32_t bucket_of(uint32_t us) {
+        if (us < SUB) return us;
+        if (us > MAX_US) us = MAX_US;
+        uint32_t e   = 31u - (uint32_t)__builtin_clz(us);
+        uint32_t sub = (us >> (e - SUB_BITS)) & (SUB - 1);
+        return (e - SUB_BITS + 1) * SUB + sub;
+    }
+
+    static uint32_t bucket_upper(uint32_t idx) {
+        if (idx < SUB) return idx;
+        uint32_t e   = idx / SUB + SUB_BITS - 1;
+        uint32_t sub = idx % SUB;
+        uint32_t width = 1u << (e - SUB_BITS);
+        return ((SUB + sub) << (e - SUB_BITS)) + width - 1;
+    }
+
+    void record(uint32_t us) {
+        counts_[bucket_of(us)].fetch_add(1, RELAXED);
+        totals_.write([&] {
+            count_.store(count_.load(RELAXED) + 1, RELAXED);
+            sum_.store(sum_.load() + us);
+        });
+        uint32_t m = max_.load(RELAXED);
+        while (us > m && !max_.compare_exchange_weak(m, us, RELAXED)) {}
+    }
+
+    void reset() {
+        for (auto& c : counts_) c.store(0, RELAXED);
+        totals_.write([&] {
+            count_.store(0, RELAXED);
+            sum_.store(0);
+        });
+        max_.store(0, RELAXED);
+    }
+
+    uint32_t count() const { return count_.load(RELAXED); }
+    uint32_t max()   const { return max_.load(RELAXED); }
+    uint32_t mean()  const {
+        uint32_t n;
+        int64_t  s;
+        totals_.read([&] {
+            n = count_.load(RELAXED);
+            s = sum_.load();
+        });
+        return n ? (uint32_t)((uint64_t)s / n) : 0;
+    }
+    uint32_t bucket_count(uint32_t idx) const { return counts_[idx].load(RELAXED); }
+
+    // p in [0, 100]
+    uint32_t percentile(double p) const {
+        uint32_t n  = count();
+        uint32_t mx = max();
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * n + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > n) rank = n;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKETS; ++i) {
+            seen += bucket_count(i);
+            if (seen >= rank) {
+                uint32_t up = bucket_upper(i);
+                return up < mx ? up : mx;
+            }
+        }
+        return mx;
+    }
+
+private:
+    static constexpr auto RELAXED = std::memory_order_relaxed;
+
+    std::atomic<uint32_t> counts_[BUCKETS]{};
+    SeqLock               totals_;          // guards count_ + sum_ together
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> max_{0};
+    SeqLock::U64          sum_;
+};
@@ -0,0 +1,60 @@
+// LatencyStats.hpp
+// George Lake
+// Fall 2025
+//
+// Per-stage and per-tag latency histograms for the polling path (RQ2).
+//
+// Stages of one tag read / poll:
+//      ENCODE   build_read_request + wrap_sendrr
+//      SEND     encapsulation header + body written to the socket
+//      WAIT     send complete -> full reply received (PLC + network)
+//      PARSE    extract_cip_from_rr + parse_read_reply
+//      COMPARE  baseline comparison / classification for one poll
+//      LOG      LogEntry build + emit for one poll
+//
+// Usage:
+//      int64_t t0 = LatencyStats::now_us();
+//      ...
+//      LatencyStats::record_stage(LatencyStats::Stage::PARSE, t0);
+//
+// Notes:
+//      Recording is lock-free (relaxed atomics, CAS to claim a new tag slot) and
+//      allocation-free, so any task may record; readers (dump_summary) may see a
+//      histogram that is one sample behind, which is fine for percentiles.
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp_timer.h"
+
+class LatencyHistogram;
+
+namespace LatencyStats {
+    enum class Stage : uint8_t { ENCODE, SEND, WAIT, PARSE, COMPARE, LOG, COUNT };
+
+    inline int64_t now_us() { return esp_timer_get_time(); }
+
+    const char* stage_name(Stage s);
+
+    // Record a duration that started at start_us (now_us() timestamp)
+    void record_stage(Stage s, int64_t start_us);
+    void record_stage_us(Stage s, uint32_t us);
+
+    // Record one full read round-trip for a tag (string literal; keyed by pointer first)
+    void record_tag(const char* tag, uint32_t us);
+
+    void reset();
+
+    // One ESP_LOGI line per stage and per tag with n/p50/p90/p99/max
+    void log_summary(const char* log_tag);
+
+    // One {"record_type":"latency_histogram","kind":"stage"|"tag","name":...} record per
+    // non-empty histogram, with non-empty buckets only
+    std::vector<std::string> export_json(int64_t t_ms);
+
+    // Access for other reporters (nullptr if unknown)
+    const LatencyHistogram* stage_histogram(Stage s);
+    const LatencyHistogram* tag_histogram(const char* tag);
+}
@@ -0,0 +1,67 @@
+// LogStream.hpp
+// George Lake
+// Fall 2025
+//
+// Network log sink: streams JSONL records to a collector over the Wi-Fi link.
+//
+// Usage:
+//      1) Call LogStream::start after Wi-Fi is up
+//      2) Call LogStream::submit for each record (never waits on the network)
+//      3) Run tools/log_collector on the host to write per-device JSONL files
+//
+// Wire format:
+//      Every UDP datagram (or TCP write) is one batch:
+//          #ESPLOG <device_id> <batch_seq> <dropped_total>\n
+//          <record>\n
+//          <record>\n ...
+//      Batches are capped at mtu_payload bytes so a datagram never fragments.
+//      A record that does not fit what is left of the batch (up to max_record bytes) is
+//      sent as continuation lines, in order, filling this batch and the next ones:
+//          +<record_id> <offset> <total> <bytes offset..offset+n of the record>\n
+//      The collector joins them and writes the record once offset + n == total.
+//
+// Notes:
+//      Records are queued in a FreeRTOS message buffer and sent by a background task.
+//      If the buffer is full (collector slow, link down, TCP blocked) new records
+//      are dropped and counted; the polling task is never held up by the link. Concurrent
+//      submitters take turns on a writer lock (one memcpy each), waiting at most a tick.
+//      The first drop of each kind (buffer full, writer busy, over max_record) is logged.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace LogStream {
+    enum class Transport : uint8_t { UDP, TCP };
+
+    struct Config {
+        const char* host        = nullptr;      // collector IPv4 address
+        uint16_t    port        = 5140;
+        Transport   transport   = Transport::UDP;
+        const char* device_id   = "esp32";
+        size_t      queue_bytes = 16 * 1024;    // message buffer size
+        size_t      mtu_payload = 1472;         // max batch bytes (1500 MTU - IPv4 - UDP)
+        size_t      max_record  = 4096;         // larger records are dropped
+        uint32_t    max_batch_ms= 100;          // send a partial batch after this long
+    };
+
+    struct Stats {
+        uint32_t submitted    = 0;
+        uint32_t dropped      = 0;     // queue full, writer busy or record over max_record
+        uint32_t oversize     = 0;     // of dropped: over max_record
+        uint32_t split        = 0;     // records sent as continuation lines
+        uint32_t batches_sent = 0;
+        uint32_t bytes_sent   = 0;
+        uint32_t send_errors  = 0;
+        uint32_t connects     = 0;     // TCP connections established
+    };
+
+    // Starts the sender task. Returns false if already running or on allocation failure.
+    bool start(const Config& cfg);
+
+    // Queues one record (without trailing newline). Returns false if it was dropped.
+    bool submit(const char* data, size_t len);
+
+    bool  running();
+    Stats stats();
+}
@@ -0,0 +1,65 @@
+// MemStats.hpp
+// George Lake
+// Fall 2025
+//
+// Heap and stack instrumentation for memory-sizing decisions.
+//
+// Usage:
+//      1) MemStats::watch_task(handle, stack_bytes) after each xTaskCreate
+//      2) In a polling loop:
+//              MemStats::AllocCount a0 = MemStats::task_allocs();
+//              ... one poll ...
+//              MemStats::record_poll(a0);
+//      3) Experiment::dump_summary calls sample_heap / log_summary / export_json
+//
+// Notes:
+//      Allocation counts come from the ESP-IDF heap hooks (CONFIG_HEAP_USE_HOOKS=y, set in
+//      sdkconfig.defaults). Each allocation is attributed to the watched task that made it;
+//      the free hook has no size, so frees are counted but not sized.
+//      Without the hooks (or on the host build) only heap and stack figures are reported.
+//      Fragmentation = 100 - largest free block * 100 / free bytes (8-bit capable heap).
+//      Stack figures are bytes of the task's stack never used (ESP-IDF's high-water mark).
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace MemStats {
+    struct AllocCount {
+        uint32_t allocs = 0;
+        uint32_t bytes  = 0;
+    };
+
+    struct HeapSample {
+        int64_t  t_ms               = 0;
+        uint32_t free_bytes         = 0;
+        uint32_t min_free_bytes     = 0;    // low-water mark since boot
+        uint32_t largest_free_block = 0;
+        uint8_t  fragmentation_pct  = 0;
+    };
+
+    // True if allocations are being counted (heap hooks compiled in)
+    bool hooks_enabled();
+
+    // Track a task's stack high-water mark and attribute its allocations to it (max 16 tasks;
+    // later ones are logged and not tracked)
+    void watch_task(TaskHandle_t task, uint32_t stack_bytes);
+
+    // Allocations made by the calling task since it was watched (zero if not watched)
+    AllocCount task_allocs();
+
+    // Add one poll cycle (task_allocs() now minus at_start) to the per-poll statistics
+    void record_poll(const AllocCount& at_start);
+
+    // Take a heap snapshot into the history ring; returns it
+    HeapSample sample_heap(int64_t t_ms);
+
+    // ESP_LOGI lines: heap, per-poll churn, one per watched task
+    void log_summary(const char* log_tag);
+
+    // {"record_type":"memory",...}: heap now + history, per-poll churn, tasks
+    std::string export_json(int64_t t_ms);
+}
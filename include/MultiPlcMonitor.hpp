@@ -0,0 +1,52 @@
+// MultiPlcMonitor.hpp
+// George Lake
+// Fall 2025
+//
+// Audit monitoring of several PLCs from one task: one non-blocking EnipSession per PLC,
+// multiplexed with select(), each with its own watchlist, schedule and baselines.
+//
+// Usage:
+//      MultiPlcMonitor::Plc plcs[] = {{"cell-1", "10.0.0.11", 44818, mc1}, ...};
+//      MultiPlcMonitor::start(plcs, n, cfg);   // after Wi-Fi is up; copies everything
+//      Experiment::dump_summary() logs one line per PLC while it runs
+//
+// Notes:
+//      Each PLC has at most one request in flight; a poll cycle walks its due tags in
+//      order, so all PLCs are read concurrently without a task (and stack) per PLC.
+//      Memory per PLC is the session buffers plus the prepared requests; CPU follows
+//      the request rate.
+//      Detection is the same AuditDetector as audit_task. Changes are logged with the PLC
+//      name, counted in the Experiment metrics and emitted as {"record_type":"plc_change"};
+//      per-poll LogEntry records are not written (N PLCs x poll rate would flood the sinks).
+//      Read failures count as Experiment read failures; sessions reconnect on their own
+//      after reconnect_ms.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "AuditMonitor.hpp"
+
+namespace MultiPlcMonitor {
+    static constexpr size_t MAX_PLCS = 8;
+
+    struct Plc {
+        const char*        name;
+        const char*        ip;
+        uint16_t           port;
+        AuditMonitorConfig tags;        // poll_ms / tz_offset_minutes per PLC
+    };
+
+    struct Config {
+        uint32_t reply_timeout_ms = 1000;
+        uint32_t reconnect_ms     = 1000;
+        uint8_t  priority         = 5;
+    };
+
+    // Copies plcs (tag strings must outlive the monitor); false if already running / too many
+    bool start(const Plc* plcs, size_t count, const Config& cfg = Config());
+    bool running();
+
+    // One ESP_LOGI line per PLC: session state, polls, failures, changes, RTT
+    void log_summary(const char* log_tag);
+}
@@ -0,0 +1,63 @@
+// PollSweep.hpp
+// George Lake
+// Fall 2025
+//
+// Poll-period sweep: steps the running audit task through a list of poll periods and
+// reports one summary record per trial, so the RQ2 latency / reliability curve comes
+// from one unattended run instead of one reflash per point.
+//
+// Usage:
+//      1) start_audit_monitor(...) as usual
+//      2) PollSweep::Config cfg;
+//         PollSweep::parse_periods("50,100,200,500,1000", cfg);
+//         cfg.trials = 3; cfg.trial_ms = 60000;
+//         PollSweep::run(cfg);            // blocks the calling task until the sweep is done
+//      3) AuditMonitor calls note_poll() / note_detection() on every poll
+//
+// Notes:
+//      Each trial: set the poll period, let the old delay run out (settle), reset the
+//      experiment counters and latency histograms, run for trial_ms, then log one line and
+//      emit {"record_type":"poll_sweep_step",...} with
+//          polls / read failures / success rate,
+//          read RTT (WAIT stage) p50/p95/p99/max,
+//          detection latency (detection time - ChangeStamp, both on the PLC clock),
+//          CPU load and audit_task share (latest profiler window inside the trial),
+//          heap free / low-water / fragmentation at the end of the trial.
+//      Detection latency needs stamped changes during the trial: a PLC test routine on
+//      the rig, or tools/plc_sim/poll_sweep.script on the host. Its resolution is the
+//      PLC clock sync error (TimeSync), so trials should run after the first resync.
+//      Trials are numbered trial_id = 1..N across the sweep, so the JSONL splits per step.
+//      The audit task is put back on restore_ms afterwards.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace PollSweep {
+    static constexpr size_t MAX_PERIODS = 16;
+
+    struct Config {
+        uint32_t periods_ms[MAX_PERIODS] = {0};
+        size_t   period_count = 0;
+        uint32_t trials       = 3;        // per period
+        uint32_t trial_ms     = 60000;    // measured part of each trial
+        uint32_t settle_ms    = 2000;     // before each trial; at least 2 old poll periods
+        uint32_t restore_ms   = 200;      // poll period once the sweep is done
+    };
+
+    // "50,100,200" -> cfg.periods_ms; false on an empty, zero or overlong list
+    bool parse_periods(const char* list, Config& cfg);
+
+    // Runs every period x trial in order; returns when the sweep is done
+    void run(const Config& cfg);
+
+    // True while run() is measuring or settling
+    bool active();
+
+    // One poll cycle finished (all reads ok, or not); lock-free
+    void note_poll(bool ok);
+
+    // A change was classified at detect_ms; change_ms is the ChangeStamp it carried.
+    // Only the first detection per stamp is counted.
+    void note_detection(int64_t detect_ms, int64_t change_ms);
+}
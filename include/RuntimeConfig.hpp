@@ -0,0 +1,129 @@
+// RuntimeConfig.hpp
+// George Lake
+// Fall 2025
+//
+// Tag and scenario configuration read once at boot from a JSON file, so a trial change
+// (tags, rates, comparators, scenario labels) is a file upload instead of a rebuild.
+//
+// Usage:
+//      1) RuntimeConfig::Config cfg = RuntimeConfig::defaults(PLC_IP, PLC_PORT, WDG_BASE, ...);
+//      2) RuntimeConfig::load("/littlefs/config.json", cfg);    // keys in the file override
+//      3) Experiment::init(cfg.scenario_id.c_str(), ...); Experiment::set_firmware_versions(...)
+//      4) start_audit_monitor(&enip, RuntimeConfig::audit_monitor_config(cfg));
+//
+// File (every key optional; see data/config.json):
+//      {
+//        "plc":      {"ip": "10.100.10.185", "port": 44818, "tz_offset_minutes": 0},
+//        "base":     "WDG_Status_Instance",
+//        "poll_ms":  200,
+//        "scenario": {"id": "S3", "variant": "unauthorized_change", "trial_id": 1,
+//                     "change_expected": true, "change_type": "auditvalue",
+//                     "esp_firmware_version": "v11.11.11", "plc_firmware_version": "37.11.11"},
+//        "tags": {
+//          "audit":        {"name": ".AuditValue", "type": "LINT"},
+//          "authorized":   {"name": ".AuthorizedUser", "type": "DINT"},
+//          "kp":           {"name": ".WDG_Kp", "type": "REAL", "compare": "epsilon", "epsilon": 1e-6},
+//          "ki":           {...}, "kd": {...},
+//          "change_stamp": {"name": ".ChangeStamp", "type": "DINT[7]", "every": 5}
+//        },
+//        "plcs": [{"name": "cell-1", "ip": "10.100.10.185", "port": 44818, "base": "WDG_A"}, ...],
+//        "containment": [{"name": ".Alarm", "type": "BOOL", "value": 1},
+//                        {"name": ".SafeMode", "type": "DINT", "value": 2}]
+//      }
+//
+// Notes:
+//      A tag name starting with '.' is appended to "base". "every": N reads the tag on
+//      every Nth poll only. "compare": "exact" | "epsilon" applies to the REAL gains.
+//      change_stamp may be disabled with "name": "".
+//      The roles are fixed by AuditDetector / LogEntry; the file picks the symbol, type
+//      (within the types each role accepts, see AuditMonitor.hpp), comparator and rate.
+//      Requests are encoded once by start_audit_monitor; nothing is parsed per poll.
+//      On the ESP the file lives on the LittleFS partition (pio run -t uploadfs writes
+//      data/, which also erases the ring log); on the host it is an ordinary file.
+//      load() leaves cfg untouched and returns false if the file is missing or invalid.
+//      "plcs" (optional, up to MultiPlcMonitor::MAX_PLCS) switches to multi-PLC monitoring:
+//      every entry uses the "tags" watchlist, with '.' names resolved against its own
+//      "base" (default: the top-level base). "plc" stays the time-sync PLC.
+//      "containment" (optional, up to Containment::MAX_ACTIONS) lists the scalar writes sent
+//      as one batch when the audit monitor sees an unauthorized change; '.' names resolve
+//      against the top-level base.
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AuditMonitor.hpp"
+#include "CipCodec.hpp"
+#include "Containment.hpp"
+
+namespace RuntimeConfig {
+    enum class Role : uint8_t { AUDIT, AUTHORIZED, KP, KI, KD, CHANGE_STAMP, COUNT };
+
+    const char* role_name(Role r);
+
+    struct TagSpec {
+        std::string name;                   // as configured; ".Member" = relative to base
+        std::string symbol;                 // resolved symbol; empty = not read
+        Cip::Type   type     = Cip::Type::DINT;
+        uint16_t    elements = 1;           // 7 for DINT[7]
+        uint16_t    every    = 1;
+        float       epsilon  = -1.0f;       // REAL: < 0 = detector default, 0 = exact
+    };
+
+    struct PlcSpec {
+        std::string name;
+        std::string ip;
+        uint16_t    port = 44818;
+        std::string base;
+        std::string symbols[(size_t)Role::COUNT];     // tags[] resolved against base
+    };
+
+    struct WriteSpec {
+        std::string name;                   // as configured; ".Member" = relative to base
+        std::string symbol;
+        Cip::Value  value;                  // value.type = the tag's CIP type
+    };
+
+    struct Config {
+        std::string plc_ip;
+        uint16_t    plc_port          = 44818;
+        int32_t     tz_offset_minutes = 0;
+        std::string base;
+        uint32_t    poll_ms           = 200;
+
+        std::string scenario_id       = "S3";
+        std::string scenario_variant  = "unauthorized_change";
+        int         trial_id          = 1;
+        bool        change_expected   = true;
+        std::string change_type       = "auditvalue";
+        std::string esp_firmware_version = "v11.11.11";
+        std::string plc_firmware_version = "37.11.11";
+
+        TagSpec     tags[(size_t)Role::COUNT];
+        std::vector<PlcSpec> plcs;          // empty = single PLC (plc_ip)
+        std::vector<WriteSpec> containment; // empty = no automatic containment
+
+        const TagSpec& tag(Role r) const { return tags[(size_t)r]; }
+    };
+
+    // The built-in setup (the WDG_Status_Instance members with their PLC types)
+    Config defaults(const char* plc_ip, uint16_t plc_port, const char* base,
+                    int32_t tz_offset_minutes, uint32_t poll_ms);
+
+    // Overlay a JSON document / file onto cfg; on error cfg is unchanged
+    bool parse(const char* json, Config& cfg);
+    bool load(const char* path, Config& cfg);
+
+    // One ESP_LOGI line per setting group and per tag
+    void log(const Config& cfg, const char* log_tag);
+
+    // Monitor setup pointing into cfg (cfg must outlive the monitor)
+    AuditMonitorConfig audit_monitor_config(const Config& cfg);
+
+    // Same for cfg.plcs[plc_index], with that PLC's resolved symbols
+    AuditMonitorConfig audit_monitor_config(const Config& cfg, size_t plc_index);
+
+    // Containment::start() arguments pointing into cfg; returns the number of actions
+    size_t containment_actions(const Config& cfg, Containment::Action (&out)[Containment::MAX_ACTIONS]);
+}
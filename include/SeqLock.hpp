@@ -0,0 +1,67 @@
+// SeqLock.hpp
+// George Lake
+// Fall 2025
+//
+// Sequence lock for small multi-field snapshots shared between tasks.
+//
+// Usage:
+//      Protected fields must themselves be std::atomic (relaxed) so concurrent
+//      reads are well defined; 64-bit values use SeqLock::U64 (two 32-bit halves,
+//      since 64-bit atomics are not lock-free on the 32-bit RISC-V core).
+//
+//      lock.write([&]{ field.store(v, std::memory_order_relaxed); ... });
+//      lock.read ([&]{ copy = field.load(std::memory_order_relaxed); ... });
+//
+// Notes:
+//      Writers run inside a short critical section, so on the single-core C6 a
+//      reader can never observe a writer preempted half-way. Readers take no lock
+//      and simply retry if a write overlapped; writers never wait on readers.
+//      Do not log or block inside write().
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+
+class SeqLock {
+public:
+    struct U64 {
+        std::atomic<uint32_t> lo{0}, hi{0};
+
+        void store(int64_t v) {
+            lo.store((uint32_t)(uint64_t)v, std::memory_order_relaxed);
+            hi.store((uint32_t)((uint64_t)v >> 32), std::memory_order_relaxed);
+        }
+        int64_t load() const {
+            return (int64_t)(((uint64_t)hi.load(std::memory_order_relaxed) << 32) |
+                             lo.load(std::memory_order_relaxed));
+        }
+    };
+
+    template <typename Fn>
+    void write(Fn&& fn) {
+        portENTER_CRITICAL(&mux_);
+        uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);       // odd: update in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        fn();
+        seq_.store(s + 2, std::memory_order_release);
+        portEXIT_CRITICAL(&mux_);
+    }
+
+    template <typename Fn>
+    void read(Fn&& fn) const {
+        for (;;) {
+            uint32_t s1 = seq_.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            fn();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1) return;
+        }
+    }
+
+private:
+    std::atomic<uint32_t> seq_{0};
+    portMUX_TYPE          mux_ = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -8,13 +8,48 @@
 #pragma once
 #include <cstdint>
 #include <array>
+#include <vector>
 
-class EnipClient;
-namespace Cip { struct Value; }
+#include "EnipClient.hpp"
+#include "CipSchema.hpp"
 
 bool read_tag_scalar(EnipClient& enip, const char* tag, Cip::Value& out);
+// Typed one-shot reads (Cip::TypedRead): the reply must carry the C++ type's CIP type
 bool read_dint(EnipClient& enip, const char* tag, int32_t& out);
 bool read_lint(EnipClient& enip, const char* tag, int64_t& out);
 bool read_real(EnipClient& enip, const char* tag, float& out);
-bool read_dint_array7(EnipClient& enip, const char* base, std::array<int32_t,7>& out);
+// timing (optional) receives the transport timing of the request, e.g. for clock sampling.
+bool read_dint_array7(EnipClient& enip, const char* base, std::array<int32_t,7>& out,
+                      EnipClient::RrTiming* timing = nullptr,
+                      EnipClient::Priority prio = EnipClient::Priority::NORMAL);
 
+
+// Pre-encoded read: the SendRRData body is built once (start-up / config load) and
+// reused on every poll, so the hot path skips build_read_request + wrap_sendrr.
+// tag must outlive the request (it keys the per-tag latency histogram).
+// With an expected type the reply is decoded by the fixed-layout Cip::TypedRead decoder
+// for that type; without one (UNSUPPORTED) any scalar type is accepted.
+struct PreparedRead {
+    const char*          tag      = nullptr;
+    uint16_t             elements = 1;
+    std::vector<uint8_t> rr;
+    Cip::ValueDecoder    decode   = nullptr;
+};
+
+bool prepare_read(PreparedRead& req, const char* tag, uint16_t elements = 1,
+                  Cip::Type expect = Cip::Type::UNSUPPORTED);
+// prio orders the request against other tasks sharing enip (audit polls use HIGH).
+// status (optional) says why a read failed, for Cip::retry_for (CipStatus.hpp).
+bool read_prepared(EnipClient& enip, const PreparedRead& req, Cip::Value& out,
+                   EnipClient::Priority prio = EnipClient::Priority::NORMAL,
+                   Cip::Status* status = nullptr);
+bool read_prepared_dint_array7(EnipClient& enip, const PreparedRead& req, std::array<int32_t,7>& out,
+                               EnipClient::RrTiming* timing = nullptr,
+                               EnipClient::Priority prio = EnipClient::Priority::NORMAL,
+                               Cip::Status* status = nullptr);
+
+// Reply parsing only (SendRRData body in, value out), for callers that own the transport
+bool parse_scalar_rr(const std::vector<uint8_t>& rr_body, Cip::Value& out);
+// req.decode when set, else parse_scalar_rr
+bool parse_prepared_rr(const PreparedRead& req, const std::vector<uint8_t>& rr_body, Cip::Value& out);
+bool parse_dint_array7_rr(const std::vector<uint8_t>& rr_body, std::array<int32_t,7>& out);
@@ -0,0 +1,70 @@
+// TimeSync.hpp
+// George Lake
+// Fall 2025
+//
+// Background PLC clock synchronization with offset + skew (drift) estimation.
+//
+// Usage:
+//      1) Call TimeSync::start after the ENIP session is up
+//      2) Use TimeSync::plc_now_ms (Experiment::now_ms does this automatically)
+//
+// How it works:
+//      Every period_ms the task reads the PLC Wall Clock Time object
+//      (class 0x8B, instance 1, attribute 11: microseconds since 1970, UTC).
+//      If the controller rejects that request, the DateTime DINT[7] tag is used.
+//      Each sample pairs the PLC time with the midpoint of the request RTT.
+//      Samples whose RTT is well above the recent minimum are rejected, since
+//      the PLC timestamp could sit anywhere inside a long round trip.
+//      A least-squares line over the last `window` samples gives offset and skew.
+//
+//      The applied clock never jumps backwards: after the first sync, corrections
+//      are slewed over slew_ms with the rate change limited to max_slew_ppm.
+//      Only an error larger than step_threshold_ms is stepped, and only forwards.
+
+#pragma once
+#include <cstdint>
+
+class EnipClient;
+
+namespace TimeSync {
+    struct Config {
+        uint32_t    period_ms          = 30000;
+        uint8_t     window             = 16;       // samples in the linear fit (<= 32)
+        float       rtt_outlier_factor = 1.5f;     // reject if rtt > factor * min recent rtt ...
+        uint32_t    rtt_outlier_slack_us = 2000;   // ... and more than min + slack
+        uint32_t    max_rtt_us         = 100000;   // hard limit
+        uint32_t    slew_ms            = 10000;    // spread a correction over this long
+        uint32_t    max_slew_ppm       = 2000;     // max applied rate change
+        uint32_t    step_threshold_ms  = 1000;     // larger forward errors are stepped
+        const char* fallback_datetime_tag = nullptr;   // e.g. WDG_BASE ".DateTime"
+        int32_t     tz_offset_minutes  = 0;        // for the DateTime fallback only
+    };
+
+    struct Status {
+        bool     synced        = false;
+        bool     wall_clock_ok = false;    // false = using the DateTime fallback
+        int64_t  offset_us     = 0;        // PLC - ESP at the last fit
+        double   skew_ppm      = 0.0;      // PLC clock rate relative to the ESP
+        uint32_t samples       = 0;
+        uint32_t rejected      = 0;
+        uint32_t failures      = 0;
+        uint32_t last_rtt_us   = 0;
+        uint32_t min_rtt_us    = 0;
+        int64_t  last_error_us = 0;        // fit - applied, before the correction
+    };
+
+    // Starts the background task (takes the first sample before returning).
+    // false if already started or the task could not be created.
+    bool start(EnipClient* enip, const Config& cfg);
+
+    // Takes one sample now; true if it was accepted.
+    bool sample_now();
+
+    // Current PLC epoch time in ms. False (out untouched) until the first sync.
+    bool plc_now_ms(int64_t& out);
+
+    // Maps an esp_timer_get_time() value to PLC epoch microseconds.
+    bool plc_us_at(int64_t esp_us, int64_t& out);
+
+    Status status();
+}
@@ -3,13 +3,27 @@
 // Fall 2025
 // 
 // Helper to bring up ESP32 station mode WiFi
+//
+// Notes:
+//      Link listeners hear every up/down transition: down on STA_DISCONNECTED / STA_LOST_IP
+//      (once per outage, not per reconnect attempt), up on STA_GOT_IP. They run in the
+//      default event loop task, so they must be short and must not block.
 
 
 #pragma once
+#include <cstdint>
+
 #include "esp_err.h"
 
 namespace WifiManager {
   // Brings up STA and blocks until IP or timeout.
   // Returns ESP_OK on success, ESP_ERR_TIMEOUT on timeout, or other ESP-IDF error.
   esp_err_t init_sta(const char* ssid, const char* pass, int timeout_ms = 15000);
+
+  // t_us is the esp_timer time of the event
+  using LinkListener = void (*)(bool up, int64_t t_us, void* arg);
+
+  // Up to 4 listeners, registered before or after init_sta; false when full
+  bool add_link_listener(LinkListener fn, void* arg = nullptr);
+  bool link_up();
 }
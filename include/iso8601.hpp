@@ -4,6 +4,15 @@
 
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
-std::string make_iso8601_from_millis(uint64_t ms);
\ No newline at end of file
+// Length of "YYYY-MM-DDTHH:MM:SS.mmmZ" (without the terminating NUL)
+constexpr size_t ISO8601_MS_LEN = 24;
+
+// Formats ms since Unix epoch into out (NUL-terminated, no allocation).
+// Returns the number of characters written, or 0 if out_len is too small.
+size_t format_iso8601_from_millis(uint64_t ms, char* out, size_t out_len);
+
+std::string make_iso8601_from_millis(uint64_t ms);
@@ -0,0 +1,391 @@
+// AlertChannel.cpp
+// George Lake
+// Fall 2025
+//
+// Acknowledged UDP alert sender
+// Refer to AlertChannel.hpp for the wire format
+
+
+#include "AlertChannel.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "LatencyHistogram.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+    static const char* TAG = "ALERT";
+
+    constexpr uint32_t STACK_BYTES     = 4096;
+    constexpr uint32_t LOG_STACK_BYTES = 4096;    // cJSON + Experiment::emit_record
+    static_assert((AlertChannel::DONE_RING_LEN & (AlertChannel::DONE_RING_LEN - 1)) == 0,
+                  "DONE_RING_LEN must be a power of two");
+    constexpr size_t   MAX_DEVICE_ID = 48;
+    constexpr auto     RELAXED       = std::memory_order_relaxed;
+
+    // FREE -> FILLING (raise) -> READY -> SENT (sender task) -> FREE
+    enum SlotState : uint8_t { FREE, FILLING, READY, SENT };
+
+    struct Slot {
+        std::atomic<uint8_t> state{FREE};
+        uint32_t    seq       = 0;
+        const char* kind      = "";
+        char        detail[AlertChannel::MAX_DETAIL + 1] = {};
+        int64_t     detect_us = 0;
+        int64_t     t_ms      = 0;
+        // Sender task only
+        uint8_t     attempts  = 0;
+        uint32_t    timeout_ms= 0;
+        int64_t     first_send_us = 0;
+        int64_t     last_send_us  = 0;
+        int64_t     next_us   = 0;
+    };
+
+    // Finished alert, queued by the sender task for alert_log (one producer, one consumer)
+    struct Done {
+        uint32_t    seq        = 0;
+        const char* kind       = "";
+        char        detail[AlertChannel::MAX_DETAIL + 1] = {};
+        bool        acked      = false;
+        uint8_t     attempts   = 0;
+        uint32_t    to_send_us = 0;
+        uint32_t    to_ack_us  = 0;
+        uint32_t    rtt_us     = 0;
+        int64_t     t_ms       = 0;
+    };
+
+    AlertChannel::Config g_cfg{};
+    std::string          g_host;
+    std::string          g_device;
+    TaskHandle_t         g_task = nullptr;
+    TaskHandle_t         g_log_task = nullptr;
+    int                  g_sock = -1;
+    Slot                 g_slots[AlertChannel::MAX_PENDING];
+
+    std::atomic<uint32_t> g_seq{0};
+    std::atomic<uint32_t> g_raised{0}, g_dropped{0}, g_sends{0}, g_retries{0},
+                          g_acked{0}, g_expired{0}, g_last_us{0}, g_rec_dropped{0};
+    std::atomic<uint32_t> g_send_errors{0}; // counted on alert_tx, reported by alert_log
+    std::atomic<int>      g_send_errno{0};  // errno of the latest failure
+    LatencyHistogram      g_latency;        // written by the sender task only
+
+    Done                  g_done[AlertChannel::DONE_RING_LEN];
+    std::atomic<uint32_t> g_done_head{0};   // written by the sender task
+    std::atomic<uint32_t> g_done_tail{0};   // written by alert_log
+
+    void send_slot(Slot& s, int64_t now_us) {
+        //
+        //
+        //
+        char buf[64 + MAX_DEVICE_ID + AlertChannel::MAX_DETAIL];
+        int n = std::snprintf(buf, sizeof(buf), "#ESPALERT %s %lu %u %lld %s %s\n", g_device.c_str(),
+                              (unsigned long)s.seq, (unsigned)(s.attempts + 1), (long long)s.t_ms,
+                              s.kind, s.detail);
+        if (n <= 0) return;
+        if ((size_t)n >= sizeof(buf)) n = (int)sizeof(buf) - 1;
+        if (::send(g_sock, buf, (size_t)n, 0) != n) {
+            // No logging on the sender path: alert_log reports it
+            g_send_errno.store(errno, RELAXED);
+            g_send_errors.fetch_add(1, RELAXED);
+            xTaskNotifyGive(g_log_task);
+        }
+        g_sends.fetch_add(1, RELAXED);
+        if (s.attempts) g_retries.fetch_add(1, RELAXED);
+        if (!s.attempts) s.first_send_us = now_us;
+        s.last_send_us = now_us;
+        s.attempts++;
+        s.next_us = now_us + (int64_t)s.timeout_ms * 1000;
+        s.timeout_ms *= 2;
+    }
+
+    void finish_slot(Slot& s, bool acked, int64_t now_us) {
+        //
+        // Instrument, queue the result for alert_log, then hand the slot back to raise()
+        //
+        const uint32_t to_ack = (uint32_t)(now_us - s.detect_us);
+        if (acked) {
+            g_acked.fetch_add(1, RELAXED);
+            g_last_us.store(to_ack, RELAXED);
+            g_latency.record(to_ack);
+        } else {
+            g_expired.fetch_add(1, RELAXED);
+        }
+
+        const uint32_t head = g_done_head.load(RELAXED);
+        if (head - g_done_tail.load(std::memory_order_acquire) < AlertChannel::DONE_RING_LEN) {
+            Done& d = g_done[head & (AlertChannel::DONE_RING_LEN - 1)];
+            d.seq        = s.seq;
+            d.kind       = s.kind;
+            std::memcpy(d.detail, s.detail, sizeof(d.detail));
+            d.acked      = acked;
+            d.attempts   = s.attempts;
+            d.to_send_us = (uint32_t)(s.first_send_us - s.detect_us);
+            d.to_ack_us  = to_ack;
+            d.rtt_us     = (uint32_t)(now_us - s.last_send_us);
+            d.t_ms       = Experiment::timestamp_ms();
+            g_done_head.store(head + 1, std::memory_order_release);
+            xTaskNotifyGive(g_log_task);
+        } else {
+            g_rec_dropped.fetch_add(1, RELAXED);
+        }
+        s.state.store(FREE, std::memory_order_release);
+    }
+
+    void emit_done(const Done& d) {
+        //
+        //
+        //
+        if (!d.acked) {
+            ESP_LOGE(TAG, "seq=%lu %s not acknowledged after %u attempts",
+                     (unsigned long)d.seq, d.kind, (unsigned)d.attempts);
+        }
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "alert");
+        cJSON_AddNumberToObject(root, "t_ms", (double)d.t_ms);
+        cJSON_AddNumberToObject(root, "seq", d.seq);
+        cJSON_AddStringToObject(root, "kind", d.kind);
+        cJSON_AddStringToObject(root, "detail", d.detail);
+        cJSON_AddBoolToObject(root, "acked", d.acked);
+        cJSON_AddNumberToObject(root, "attempts", d.attempts);
+        cJSON_AddNumberToObject(root, "detect_to_send_us", d.to_send_us);
+        if (d.acked) {
+            cJSON_AddNumberToObject(root, "detect_to_ack_us", d.to_ack_us);
+            cJSON_AddNumberToObject(root, "rtt_us", d.rtt_us);
+        }
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        Experiment::emit_record(json, d.t_ms);
+    }
+
+    void log_task(void*) {
+        //
+        // All sink I/O for finished alerts happens here, below the audit task
+        //
+        uint32_t reported_errors = 0;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            CpuProfiler::count_wake();
+            const uint32_t errors = g_send_errors.load(RELAXED);
+            if (errors != reported_errors) {
+                ESP_LOGW(TAG, "%lu alert send(s) failed (%lu total, last errno=%d)",
+                         (unsigned long)(errors - reported_errors), (unsigned long)errors,
+                         g_send_errno.load(RELAXED));
+                reported_errors = errors;
+            }
+            uint32_t tail = g_done_tail.load(RELAXED);
+            while (tail != g_done_head.load(std::memory_order_acquire)) {
+                emit_done(g_done[tail & (AlertChannel::DONE_RING_LEN - 1)]);
+                g_done_tail.store(++tail, std::memory_order_release);
+            }
+        }
+    }
+
+    // New alerts, oldest first; returns true if any slot is waiting for an ACK
+    bool send_ready(int64_t now_us) {
+        bool waiting = false;
+        for (;;) {
+            Slot* next = nullptr;
+            for (Slot& s : g_slots) {
+                uint8_t st = s.state.load(std::memory_order_acquire);
+                if (st == SENT) waiting = true;
+                if (st == READY && (!next || s.seq < next->seq)) next = &s;
+            }
+            if (!next) return waiting;
+            next->attempts   = 0;
+            next->timeout_ms = g_cfg.ack_timeout_ms;
+            send_slot(*next, now_us);
+            next->state.store(SENT, RELAXED);
+            waiting = true;
+        }
+    }
+
+    void drain_acks() {
+        char buf[64];
+        for (;;) {
+            int n = ::recv(g_sock, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+            if (n <= 0) return;
+            buf[n] = '\0';
+            unsigned long seq = 0;
+            if (std::sscanf(buf, "#ESPACK %lu", &seq) != 1) continue;
+            const int64_t now = esp_timer_get_time();
+            for (Slot& s : g_slots) {
+                if (s.state.load(RELAXED) == SENT && s.seq == seq) finish_slot(s, true, now);
+            }
+        }
+    }
+
+    // Resends what is due; returns the earliest pending deadline (0 = none)
+    int64_t resend_due(int64_t now_us) {
+        int64_t earliest = 0;
+        for (Slot& s : g_slots) {
+            if (s.state.load(RELAXED) != SENT) continue;
+            if (now_us >= s.next_us) {
+                if (s.attempts >= g_cfg.max_attempts) { finish_slot(s, false, now_us); continue; }
+                send_slot(s, now_us);
+            }
+            if (!earliest || s.next_us < earliest) earliest = s.next_us;
+        }
+        return earliest;
+    }
+
+    void sender_task(void*) {
+        //
+        // Idle: sleep on the notification. ACKs pending: select() in ACK_SLICE_MS steps so a
+        // new alert is never held up for a whole retry timeout
+        //
+        for (;;) {
+            int64_t now = esp_timer_get_time();
+            if (!send_ready(now)) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                CpuProfiler::count_wake();
+                continue;
+            }
+
+            int64_t deadline = resend_due(now);
+            if (!deadline) continue;
+            int64_t wait_us = deadline - now;
+            if (wait_us > (int64_t)AlertChannel::ACK_SLICE_MS * 1000) wait_us = AlertChannel::ACK_SLICE_MS * 1000;
+            if (wait_us < 0) wait_us = 0;
+
+            fd_set rd;
+            FD_ZERO(&rd);
+            FD_SET(g_sock, &rd);
+            timeval tv{(long)(wait_us / 1000000), (long)(wait_us % 1000000)};
+            int r = ::select(g_sock + 1, &rd, nullptr, nullptr, &tv);
+            ulTaskNotifyTake(pdTRUE, 0);
+            CpuProfiler::count_wake();
+            if (r > 0) drain_acks();
+        }
+    }
+} // Anonymous Namespace
+
+namespace AlertChannel {
+    bool start(const Config& cfg) {
+        //
+        //
+        //
+        if (g_task) return false;
+        if (!cfg.host || !cfg.host[0] || cfg.max_attempts == 0 || cfg.ack_timeout_ms == 0) return false;
+
+        g_cfg    = cfg;
+        g_host   = cfg.host;
+        g_device = (cfg.device_id && cfg.device_id[0]) ? cfg.device_id : "esp32";
+        if (g_device.size() > MAX_DEVICE_ID) g_device.resize(MAX_DEVICE_ID);
+        g_cfg.host      = g_host.c_str();
+        g_cfg.device_id = g_device.c_str();
+
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(cfg.port);
+        addr.sin_addr.s_addr = inet_addr(g_host.c_str());
+
+        // Connected UDP socket: send() without an address, recv() only from the receiver
+        g_sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (g_sock < 0 || ::connect(g_sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            ESP_LOGE(TAG, "socket/connect %s:%u errno=%d", g_host.c_str(), (unsigned)cfg.port, errno);
+            if (g_sock >= 0) { ::close(g_sock); g_sock = -1; }
+            return false;
+        }
+        g_latency.reset();
+
+        if (!g_log_task &&
+            xTaskCreate(log_task, "alert_log", LOG_STACK_BYTES, nullptr, cfg.log_priority, &g_log_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create record task");
+            g_log_task = nullptr;
+            ::close(g_sock);
+            g_sock = -1;
+            return false;
+        }
+        MemStats::watch_task(g_log_task, LOG_STACK_BYTES);
+        if (xTaskCreate(sender_task, "alert_tx", STACK_BYTES, nullptr, cfg.priority, &g_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create sender task");
+            g_task = nullptr;
+            ::close(g_sock);
+            g_sock = -1;
+            return false;
+        }
+        MemStats::watch_task(g_task, STACK_BYTES);
+        ESP_LOGI(TAG, "Alerts to %s:%u as '%s' (ack timeout %lums, %u attempts)", g_host.c_str(),
+                 (unsigned)cfg.port, g_device.c_str(), (unsigned long)cfg.ack_timeout_ms,
+                 (unsigned)cfg.max_attempts);
+        return true;
+    }
+
+    bool running() { return g_task != nullptr; }
+
+    bool raise(const char* kind, const char* detail, int64_t detect_us) {
+        //
+        // Sequence first so a dropped alert shows up as a gap at the receiver
+        //
+        if (!g_task) return false;
+        const int64_t t_ms = Experiment::timestamp_ms();
+        const uint32_t seq = g_seq.fetch_add(1, RELAXED) + 1;
+        g_raised.fetch_add(1, RELAXED);
+
+        for (Slot& s : g_slots) {
+            uint8_t expected = FREE;
+            if (!s.state.compare_exchange_strong(expected, FILLING, std::memory_order_acquire)) continue;
+            s.seq       = seq;
+            s.kind      = kind ? kind : "ALERT";
+            s.detect_us = detect_us;
+            s.t_ms      = t_ms;
+            size_t i = 0;
+            for (; detail && detail[i] && i < MAX_DETAIL; ++i) {
+                s.detail[i] = (detail[i] == '\n' || detail[i] == '\r') ? ' ' : detail[i];
+            }
+            s.detail[i] = '\0';
+            s.state.store(READY, std::memory_order_release);
+            xTaskNotifyGive(g_task);
+            return true;
+        }
+        g_dropped.fetch_add(1, RELAXED);
+        ESP_LOGE(TAG, "seq=%lu %s dropped: %u alerts unacknowledged", (unsigned long)seq,
+                 kind ? kind : "ALERT", (unsigned)MAX_PENDING);
+        return false;
+    }
+
+    Stats stats() {
+        Stats s;
+        s.raised  = g_raised.load(RELAXED);
+        s.dropped = g_dropped.load(RELAXED);
+        s.sends   = g_sends.load(RELAXED);
+        s.retries = g_retries.load(RELAXED);
+        s.acked   = g_acked.load(RELAXED);
+        s.expired = g_expired.load(RELAXED);
+        s.rec_dropped = g_rec_dropped.load(RELAXED);
+        s.send_errors = g_send_errors.load(RELAXED);
+        s.last_us = g_last_us.load(RELAXED);
+        s.p50_us  = g_latency.percentile(50);
+        s.p99_us  = g_latency.percentile(99);
+        s.max_us  = g_latency.max();
+        return s;
+    }
+
+    void log_summary(const char* log_tag) {
+        if (!g_task) return;
+        Stats s = stats();
+        ESP_LOGI(log_tag, "ALERT raised=%lu dropped=%lu sends=%lu retries=%lu acked=%lu expired=%lu "
+                          "rec_dropped=%lu send_errors=%lu detect->ack last=%luus p50=%luus p99=%luus max=%luus",
+                 (unsigned long)s.raised, (unsigned long)s.dropped, (unsigned long)s.sends,
+                 (unsigned long)s.retries, (unsigned long)s.acked, (unsigned long)s.expired,
+                 (unsigned long)s.rec_dropped, (unsigned long)s.send_errors,
+                 (unsigned long)s.last_us, (unsigned long)s.p50_us, (unsigned long)s.p99_us,
+                 (unsigned long)s.max_us);
+    }
+}
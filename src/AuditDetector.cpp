@@ -0,0 +1,66 @@
+// AuditDetector.cpp
+// George Lake
+// Fall 2025
+//
+// Baseline + compare logic
+// Refer to AuditDetector.hpp for notes
+
+
+#include "AuditDetector.hpp"
+
+namespace {
+    bool nearly_equal(float a, float b, float eps) {
+        float diff = a - b;
+        if (diff < 0) diff = -diff;
+        return diff <= eps;
+    }
+} // Anonymous Namespace
+
+AuditDetector::Result AuditDetector::update(const AuditSample& s) {
+    //
+    //
+    //
+    auto eps = [this](float e) { return e < 0 ? cfg_.pid_epsilon : e; };
+
+    Result r;
+    r.previous   = base_;
+    r.authorized = s.auth != 0;
+
+    // AuditValue baseline / change detection
+    if (!have_audit_) {
+        base_.audit = s.audit;
+        have_audit_ = true;
+        r.audit_baseline_set = true;
+    } else if (s.audit != base_.audit) {
+        r.audit_changed = true;
+        base_.audit = s.audit;
+    }
+
+    // PID baseline / change detection
+    if (!have_pid_) {
+        base_.kp = s.kp;
+        base_.ki = s.ki;
+        base_.kd = s.kd;
+        have_pid_ = true;
+        r.pid_baseline_set = true;
+    } else {
+        r.kp_changed = !nearly_equal(s.kp, base_.kp, eps(cfg_.kp_epsilon));
+        r.ki_changed = !nearly_equal(s.ki, base_.ki, eps(cfg_.ki_epsilon));
+        r.kd_changed = !nearly_equal(s.kd, base_.kd, eps(cfg_.kd_epsilon));
+        if (r.pid_changed()) {
+            base_.kp = s.kp;
+            base_.ki = s.ki;
+            base_.kd = s.kd;
+        }
+    }
+
+    base_.auth = s.auth;
+    r.baseline_complete = have_audit_ && have_pid_;
+    return r;
+}
+
+void AuditDetector::reset() {
+    base_       = AuditSample{};
+    have_audit_ = false;
+    have_pid_   = false;
+}
@@ -7,206 +7,277 @@
 
 
 #include "AuditMonitor.hpp"
+#include "AuditDetector.hpp"
 #include "TagReads.hpp"
+#include "CipCodec.hpp"
+#include "CipStatus.hpp"
 #include "ExperimentInstrumentation.hpp"
 #include "EnipClient.hpp"
 #include "json_log.hpp"
 #include "EpochTime.hpp"
 #include "iso8601.hpp"
+#include "LatencyStats.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+#include "PollSweep.hpp"
+#include "ConnectionHealth.hpp"
+#include "Containment.hpp"
+#include "AlertChannel.hpp"
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <atomic>
+#include <cstdio>
+
 #ifndef PLC_TZ_OFFSET_MINUTES      // NEW (matches main.cpp default)
 #define PLC_TZ_OFFSET_MINUTES 0
 #endif
 
 static const char* TAG = "AUDIT_MON";
 
+static constexpr uint32_t AUDIT_TASK_STACK = 4096;
+
+// Poll delay cap while the PLC reports busy / unknown tags (Retry::BACKOFF / RESOLVE)
+static constexpr uint32_t CIP_BACKOFF_MAX_MS = 5000;
+
 // Global poll sequence counter
 static long g_poll_seq = 0;
 
+// Delay between polls; read every cycle so it can be changed while the task runs
+static std::atomic<uint32_t> g_poll_ms{200};
+
+// One watched tag: pre-encoded request, read rate and the last value read
+struct WatchedRead {
+    PreparedRead req;
+    Cip::Type    type  = Cip::Type::DINT;
+    uint16_t     every = 1;
+    bool         have  = false;             // a value has been read since start
+    Cip::Value   last{};
+    Cip::Status  status;                    // why the last read failed
+
+    bool due(uint32_t poll) const { return !have || every <= 1 || poll % every == 0; }
+};
+
 struct AuditCfg {
-    EnipClient* enip;
-    const char* audit_tag;
-    const char* auth_tag;
-    const char* kp_tag;
-    const char* ki_tag;
-    const char* kd_tag;
-    const char* change_stamp_tag;
-    uint32_t poll_ms;
+    EnipClient*   enip;
+    WatchedRead   audit, auth, kp, ki, kd;
+    WatchedRead   stamp;                    // DINT[7]; req.rr empty = not read
+    std::array<int32_t,7> stamp_value{};
+    uint16_t      retries = 0;              // immediate retries (Retry::NOW) this poll
+    AuditDetector::Config detector;
+    int32_t       tz_offset_minutes;
 };
 
-static bool reconnect_enip(EnipClient& enip) {
-    enip.close();
-    for (;;) {
-        ESP_LOGW(TAG, "Attempting ENIP reconnect...");
-        if (enip.connect_tcp() && enip.register_session()) {
-            ESP_LOGI(TAG, "ENIP reconnect successful");
-            return true;
-        }
-        ESP_LOGW(TAG, "ENIP reconnect failed; retrying in 1s");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+static void init_watch(WatchedRead& w, const AuditWatch& spec, uint16_t elements) {
+    prepare_read(w.req, spec.tag, elements, spec.type);
+    w.type  = spec.type;
+    w.every = spec.every ? spec.every : 1;
+}
+
+static bool read_watch(EnipClient& enip, WatchedRead& w, Cip::Value& v) {
+    if (!read_prepared(enip, w.req, v, EnipClient::Priority::HIGH, &w.status)) return false;
+    if (v.type == w.type) return true;
+    w.status = Cip::Status{Cip::Status::Layer::REPLY};
+    return false;
+}
+
+// Reads the tag if it is due this poll; otherwise keeps the last value.
+// A transient PLC-side error (Retry::NOW) is retried once at once.
+static bool poll_tag(EnipClient& enip, AuditCfg& cfg, WatchedRead& w, uint32_t poll) {
+    if (!w.due(poll)) return true;
+    Cip::Value v{};
+    if (!read_watch(enip, w, v)) {
+        if (Cip::retry_for(w.status) != Cip::Retry::NOW) return false;
+        ++cfg.retries;
+        if (!read_watch(enip, w, v)) return false;
     }
+    w.last = v;
+    w.have = true;
+    return true;
 }
 
-static bool nearly_equal(float a, float b, float eps = 1e-6f) {
-    //
-    //
-    //
-    float diff = a - b;
-    if (diff < 0) diff = -diff;
-    return diff <= eps;
+static bool poll_stamp(EnipClient& enip, AuditCfg& cfg, uint32_t poll) {
+    WatchedRead& w = cfg.stamp;
+    if (w.req.rr.empty()) return false;
+    if (!w.due(poll)) return true;
+    auto read = [&] {
+        return read_prepared_dint_array7(enip, w.req, cfg.stamp_value, nullptr, EnipClient::Priority::HIGH, &w.status);
+    };
+    if (!read()) {
+        if (Cip::retry_for(w.status) != Cip::Retry::NOW) return false;
+        ++cfg.retries;
+        if (!read()) return false;
+    }
+    w.have = true;
+    return true;
+}
+
+// Worst retry class over the failed reads of one poll
+static Cip::Retry classify_failures(WatchedRead* const* watches, const bool* oks, size_t n,
+                                    const WatchedRead*& first) {
+    Cip::Retry worst = Cip::Retry::NONE;
+    first = nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        if (oks[i]) continue;
+        WatchedRead& w = *watches[i];
+        Cip::Retry r = Cip::retry_for(w.status);
+        if (r > worst) worst = r;
+        if (!first) first = &w;
+    }
+    return worst;
 }
 
 static void audit_task(void* arg) {
     //
     //
     //
-    AuditCfg cfg = *static_cast<AuditCfg*>(arg);
-    delete static_cast<AuditCfg*>(arg); // free the heap copy
-
-    // Baselines --------------------------------------------------------------------------------------------
-    int64_t last_audit = 0;
-    float last_kp = 0.0f, last_ki = 0.0f, last_kd = 0.0f;
+    AuditCfg& cfg = *static_cast<AuditCfg*>(arg);    // owned by this task for its lifetime
 
-    bool have_audit_baseline = false;
-    bool have_pid_baseline = false;
+    AuditDetector detector(cfg.detector);
     bool baseline_marked = false;
 
-    int consecutive_failures = 0;
+    int consecutive_failures = 0;           // link-class failures (Retry::RECONNECT) in a row
+    uint32_t backoff_ms = 0;                // extra poll delay while the PLC is busy
+    uint32_t poll = 0;
 
     for (;;) {
-        int64_t audit = 0;
-        int32_t auth = 0;
-        float kp = 0.0f, ki = 0.0f, kd = 0.0f;
-
-        // Snapshot baselines as they were before this poll
-        int64_t baseline_audit_for_log = last_audit;
-        float   baseline_kp_for_log    = last_kp;
-        float   baseline_ki_for_log    = last_ki;
-        float   baseline_kd_for_log    = last_kd;
-
-        // Change flags for this poll
-        bool audit_changed_for_log = false;
-        bool kp_changed_for_log    = false;
-        bool ki_changed_for_log    = false;
-        bool kd_changed_for_log    = false;
-
-        bool ok_audit   = read_lint(*cfg.enip, cfg.audit_tag,   audit);
-        bool ok_auth    = read_dint(*cfg.enip, cfg.auth_tag,    auth);
-        bool ok_kp      = read_real(*cfg.enip, cfg.kp_tag,      kp);
-        bool ok_ki      = read_real(*cfg.enip, cfg.ki_tag,      ki);
-        bool ok_kd      = read_real(*cfg.enip, cfg.kd_tag,      kd);
-
-        std::array<int32_t,7> change_stamp{};
-        bool ok_stamp = false;
-        if (cfg.change_stamp_tag && cfg.change_stamp_tag[0] != '\0') {
-            ok_stamp = read_dint_array7(*cfg.enip, cfg.change_stamp_tag, change_stamp);
-        }
+        CpuProfiler::count_wake();
+        MemStats::AllocCount poll_allocs = MemStats::task_allocs();
+        const uint32_t n = poll++;
+        cfg.retries = 0;
+
+        bool ok_audit   = poll_tag(*cfg.enip, cfg, cfg.audit, n);
+        bool ok_auth    = poll_tag(*cfg.enip, cfg, cfg.auth,  n);
+        bool ok_kp      = poll_tag(*cfg.enip, cfg, cfg.kp,    n);
+        bool ok_ki      = poll_tag(*cfg.enip, cfg, cfg.ki,    n);
+        bool ok_kd      = poll_tag(*cfg.enip, cfg, cfg.kd,    n);
+        bool ok_stamp   = poll_stamp(*cfg.enip, cfg, n);
+        const std::array<int32_t,7>& change_stamp = cfg.stamp_value;
 
         if (!ok_audit || !ok_auth || !ok_kp || !ok_ki || !ok_kd) {
             Experiment::record_read_failure();
+            PollSweep::note_poll(false);
+
+            WatchedRead* const watches[] = {&cfg.audit, &cfg.auth, &cfg.kp, &cfg.ki, &cfg.kd};
+            const bool oks[] = {ok_audit, ok_auth, ok_kp, ok_ki, ok_kd};
+            const WatchedRead* first = nullptr;
+            const Cip::Retry action = classify_failures(watches, oks, 5, first);
+            const bool link_fault = action == Cip::Retry::RECONNECT;
 
-            ++consecutive_failures;
+            if (link_fault) ++consecutive_failures;
+            else consecutive_failures = 0;
 
-            ESP_LOGW(TAG,
-                     "Read error (audit_ok=%d auth_ok=%d kp=%d ki=%d kd=%d). "
-                     "Fail count=%d",
-                     ok_audit, ok_auth, ok_kp, ok_ki, ok_kd, consecutive_failures);
+            // While the link is down every poll fails fast; log the first one only
+            if (consecutive_failures <= 1 || cfg.enip->connected()) {
+                char why[64];
+                Cip::describe(first->status, why, sizeof(why));
+                ESP_LOGW(TAG,
+                         "Read error (audit_ok=%d auth_ok=%d kp=%d ki=%d kd=%d): %s -> %s. "
+                         "Link fail count=%d",
+                         ok_audit, ok_auth, ok_kp, ok_ki, ok_kd, why, Cip::retry_name(action),
+                         consecutive_failures);
+            }
 
-            // After N consecutive failures, attempt a full ENIP reconnect
-            if (consecutive_failures >= 5) {
-                ESP_LOGW(TAG, "Persistent failures; attempting ENIP reconnect.");
-                reconnect_enip(*cfg.enip);
-                consecutive_failures = 0;
+            // Only a lost session is worth a reconnect, and only ConnectionHealth reconnects
+            // (with its backoff). Any CIP reply (busy, unknown tag, wrong type) proves the link.
+            ConnectionHealth::note_poll(!link_fault);
+            if (link_fault && consecutive_failures == 1 && !ConnectionHealth::running()) {
+                ESP_LOGE(TAG, "Session lost and ConnectionHealth is not running: no reconnect");
             }
 
-            vTaskDelay(pdMS_TO_TICKS(cfg.poll_ms));
+            uint32_t delay_ms = g_poll_ms.load(std::memory_order_relaxed);
+            if (action == Cip::Retry::BACKOFF || action == Cip::Retry::RESOLVE) {
+                backoff_ms = backoff_ms ? backoff_ms * 2 : delay_ms * 2;
+                if (backoff_ms > CIP_BACKOFF_MAX_MS) backoff_ms = CIP_BACKOFF_MAX_MS;
+                if (backoff_ms > delay_ms) delay_ms = backoff_ms;
+            }
+            vTaskDelay(pdMS_TO_TICKS(delay_ms));
             continue;
         }
         // Successful read: reset failure counter
         consecutive_failures = 0;
+        backoff_ms = 0;
+        ConnectionHealth::note_poll(true);
+        PollSweep::note_poll(true);
+
+        int64_t t_compare = LatencyStats::now_us();
+
+        const int64_t audit = Cip::as_int64(cfg.audit.last);
+        const int32_t auth  = (int32_t)Cip::as_int64(cfg.auth.last);
+        const float   kp    = cfg.kp.last.v.f32;
+        const float   ki    = cfg.ki.last.v.f32;
+        const float   kd    = cfg.kd.last.v.f32;
+
+        AuditDetector::Result r = detector.update(AuditSample{audit, auth, kp, ki, kd});
+        const AuditSample& prev = r.previous;
 
         // AuditValue baseline / change detection
-        if (!have_audit_baseline) {
-            last_audit = audit;
-            have_audit_baseline = true;
+        if (r.audit_baseline_set) {
             ESP_LOGI(TAG, "Baseline AuditValue = %lld (0x%016llx)",
                      (long long)audit, (unsigned long long)audit);
-        } else if (audit != last_audit) {
-            // Record that *this poll* saw a change versus the prior baseline
-            audit_changed_for_log = true;
-            baseline_audit_for_log = last_audit;  // previous value
-
+        } else if (r.audit_changed) {
             if (auth == 0) {
+                // Alert and containment first: the log line below can wait on the UART
+                const int64_t t_detect = LatencyStats::now_us();
+                char detail[160];      // raise() cuts it to MAX_DETAIL
+                std::snprintf(detail, sizeof(detail), "AuditValue %lld->%lld auth=%d",
+                              (long long)prev.audit, (long long)audit, (int)auth);
+                AlertChannel::raise("UNAUTHORIZED_CHANGE", detail, t_detect);
+                Containment::trigger("unauthorized AuditValue change", t_detect);
                 ESP_LOGW(TAG,
                     "UNAUTHORIZED_CHANGE: AuditValue %lld->%lld (0x%016llx->0x%016llx), auth=%d",
-                    (long long)last_audit, (long long)audit,
-                    (unsigned long long)last_audit, (unsigned long long)audit,
+                    (long long)prev.audit, (long long)audit,
+                    (unsigned long long)prev.audit, (unsigned long long)audit,
                     (int)auth);
             } else {
                 ESP_LOGI(TAG,
                     "AUTHORIZED_CHANGE: AuditValue %lld->%lld (auth=%d).",
-                    (long long)last_audit, (long long)audit, (int)auth);
+                    (long long)prev.audit, (long long)audit, (int)auth);
             }
 
             // Instrumentation: record classification
             Experiment::record_audit_change(auth != 0);
-
-            // Update baseline to the new value for subsequent polls
-            last_audit = audit;
         }
 
         // PID Baseline / change detection
-        if (!have_pid_baseline) {
-            last_kp = kp;
-            last_ki = ki;
-            last_kd = kd;
-            have_pid_baseline = true;
-            ESP_LOGI(TAG, "Baseline PID: Kp=%.6f Ki=%.6f Kd=%.6f", last_kp, last_ki, last_kd);
-        } else {
-            // Compare against previous baseline
-            kp_changed_for_log = !nearly_equal(kp, last_kp);
-            ki_changed_for_log = !nearly_equal(ki, last_ki);
-            kd_changed_for_log = !nearly_equal(kd, last_kd);
-
-            if (kp_changed_for_log || ki_changed_for_log || kd_changed_for_log) {
-                baseline_kp_for_log = last_kp;
-                baseline_ki_for_log = last_ki;
-                baseline_kd_for_log = last_kd;
-
-                if (auth == 0) {
-                    ESP_LOGW(TAG,
-                        "UNAUTHORIZED_PID_CHANGE: "
-                        "Kp %.6f->%.6f, Ki %.6f->%.6f, Kd %.6f->%.6f (auth=%d)",
-                        last_kp, kp, last_ki, ki, last_kd, kd, (int)auth);
-                } else {
-                    ESP_LOGI(TAG,
-                        "AUTHORIZED_PID_CHANGE: "
-                        "Kp %.6f->%.6f, Ki %.6f->%.6f, Kd %.6f->%.6f (auth=%d)",
-                        last_kp, kp, last_ki, ki, last_kd, kd, (int)auth);
-                }
-                // Instrumentation: record classification
-                Experiment::record_pid_change(auth != 0);
-
-                // Update baselines for future polls
-                last_kp = kp;
-                last_ki = ki;
-                last_kd = kd;
+        if (r.pid_baseline_set) {
+            ESP_LOGI(TAG, "Baseline PID: Kp=%.6f Ki=%.6f Kd=%.6f", kp, ki, kd);
+        } else if (r.pid_changed()) {
+            if (auth == 0) {
+                const int64_t t_detect = LatencyStats::now_us();
+                char detail[160];      // raise() cuts it to MAX_DETAIL
+                std::snprintf(detail, sizeof(detail), "Kp %g->%g Ki %g->%g Kd %g->%g auth=%d",
+                              prev.kp, kp, prev.ki, ki, prev.kd, kd, (int)auth);
+                AlertChannel::raise("UNAUTHORIZED_PID_CHANGE", detail, t_detect);
+                Containment::trigger("unauthorized PID change", t_detect);
+                ESP_LOGW(TAG,
+                    "UNAUTHORIZED_PID_CHANGE: "
+                    "Kp %.6f->%.6f, Ki %.6f->%.6f, Kd %.6f->%.6f (auth=%d)",
+                    prev.kp, kp, prev.ki, ki, prev.kd, kd, (int)auth);
+            } else {
+                ESP_LOGI(TAG,
+                    "AUTHORIZED_PID_CHANGE: "
+                    "Kp %.6f->%.6f, Ki %.6f->%.6f, Kd %.6f->%.6f (auth=%d)",
+                    prev.kp, kp, prev.ki, ki, prev.kd, kd, (int)auth);
             }
+            // Instrumentation: record classification
+            Experiment::record_pid_change(auth != 0);
         }
 
+        LatencyStats::record_stage(LatencyStats::Stage::COMPARE, t_compare);
+
         // ----------------------------------------------------------------------------------------------------
         // If both baselines are set and it has not been marked yet, mark baseline time
-        if (!baseline_marked && have_audit_baseline && have_pid_baseline) {
+        if (!baseline_marked && r.baseline_complete) {
             Experiment::mark_baseline_established();
             baseline_marked = true;
         }
 
         // ----------------------------------------------------------------------------------------------------
         // JSON logging: emit one LogEntry per successful poll
+        int64_t t_log = LatencyStats::now_us();
         {
             LogEntry log;
 
@@ -225,29 +296,18 @@ static void audit_task(void* arg) {
             log.current.ExperimentMarker = "NA";
 
             // Baseline values (snapshot from start of this poll)
-            if (have_audit_baseline) {
-                log.baseline.AuditValue = std::to_string(static_cast<long long>(baseline_audit_for_log));
-            } else {
-                log.baseline.AuditValue = "NA";
-            }
+            log.baseline.AuditValue = std::to_string(static_cast<long long>(prev.audit));
             log.baseline.AuthorizedUser = "NA";
 
-            if (have_pid_baseline) {
-                log.baseline.Kp = baseline_kp_for_log;
-                log.baseline.Ki = baseline_ki_for_log;
-                log.baseline.Kd = baseline_kd_for_log;
-            } else {
-                log.baseline.Kp = 0.0;
-                log.baseline.Ki = 0.0;
-                log.baseline.Kd = 0.0;
-            }
+            log.baseline.Kp = prev.kp;
+            log.baseline.Ki = prev.ki;
+            log.baseline.Kd = prev.kd;
 
             log.baseline.ControllerStatus = "NA";
             log.baseline.AuxStatus        = "NA";
 
             // Comparison data
-            log.comparison.any_change =
-                audit_changed_for_log || kp_changed_for_log || ki_changed_for_log || kd_changed_for_log;
+            log.comparison.any_change = r.any_change();
 
             log.comparison.authorized_change =
                 log.comparison.any_change && (auth != 0);
@@ -256,49 +316,92 @@ static void audit_task(void* arg) {
                 log.comparison.any_change && (auth == 0);
 
             log.comparison.changed_fields.clear();
-            if (audit_changed_for_log) log.comparison.changed_fields.push_back("AuditValue");
-            if (kp_changed_for_log)    log.comparison.changed_fields.push_back("Kp");
-            if (ki_changed_for_log)    log.comparison.changed_fields.push_back("Ki");
-            if (kd_changed_for_log)    log.comparison.changed_fields.push_back("Kd");
+            if (r.audit_changed) log.comparison.changed_fields.push_back("AuditValue");
+            if (r.kp_changed)    log.comparison.changed_fields.push_back("Kp");
+            if (r.ki_changed)    log.comparison.changed_fields.push_back("Ki");
+            if (r.kd_changed)    log.comparison.changed_fields.push_back("Kd");
 
-            log.comparison.chg_AuditValue       = audit_changed_for_log;
+            log.comparison.chg_AuditValue       = r.audit_changed;
             log.comparison.chg_AuthorizedUser   = false;
-            log.comparison.chg_Kp               = kp_changed_for_log;
-            log.comparison.chg_Ki               = ki_changed_for_log;
-            log.comparison.chg_Kd               = kd_changed_for_log;
+            log.comparison.chg_Kp               = r.kp_changed;
+            log.comparison.chg_Ki               = r.ki_changed;
+            log.comparison.chg_Kd               = r.kd_changed;
             log.comparison.chg_ControllerStatus = false;
             log.comparison.chg_AuxStatus        = false;
 
             // Deltas using baseline snapshots
-            log.comparison.delta_Kp = kp_changed_for_log ? (kp - baseline_kp_for_log) : 0.0f;
-            log.comparison.delta_Ki = ki_changed_for_log ? (ki - baseline_ki_for_log) : 0.0f;
-            log.comparison.delta_Kd = kd_changed_for_log ? (kd - baseline_kd_for_log) : 0.0f;
+            log.comparison.delta_Kp = r.kp_changed ? (kp - prev.kp) : 0.0f;
+            log.comparison.delta_Ki = r.ki_changed ? (ki - prev.ki) : 0.0f;
+            log.comparison.delta_Kd = r.kd_changed ? (kd - prev.kd) : 0.0f;
 
             // Comm + groundtruth as before
             log.comm.comm_status = "OK";
             log.comm.read_ok     = true;
-            log.comm.retry_count = 0;
+            log.comm.retry_count = cfg.retries;
 
             log.groundtruth.t_change_groundtruth_iso = "NA";
             log.groundtruth.t_change_marker_seen     = "NA";
 
             if (ok_stamp && change_stamp[0] >= 2000) {  
                 auto plc_dt = EpochTime::fromArray(change_stamp);
-                int64_t plc_epoch_ms = EpochTime::toEpochMs(plc_dt, PLC_TZ_OFFSET_MINUTES);
+                int64_t plc_epoch_ms = EpochTime::toEpochMs(plc_dt, cfg.tz_offset_minutes);
                 if (plc_epoch_ms >= 0) {
                     log.plc_time.plc_timestamp_ms  = plc_epoch_ms;
-                    log.plc_time.plc_timestamp_iso = make_iso8601_from_millis(static_cast<uint64_t>(plc_epoch_ms));
+                    char iso[ISO8601_MS_LEN + 1];
+                    log.plc_time.plc_timestamp_iso.assign(
+                        iso, format_iso8601_from_millis(static_cast<uint64_t>(plc_epoch_ms), iso, sizeof(iso)));
+
+                    // Detection latency against the PLC's own change time (both on the PLC clock)
+                    if (r.any_change()) PollSweep::note_detection(Experiment::timestamp_ms(), plc_epoch_ms);
                 }
             }
 
             Experiment::emit_log_entry(log);
         }
+        LatencyStats::record_stage(LatencyStats::Stage::LOG, t_log);
+        MemStats::record_poll(poll_allocs);
 
         
-        vTaskDelay(pdMS_TO_TICKS(cfg.poll_ms));
+        vTaskDelay(pdMS_TO_TICKS(g_poll_ms.load(std::memory_order_relaxed)));
     }
 }
 
+void set_poll_seq_start(long first_seq) {
+    g_poll_seq = first_seq;
+}
+
+void set_audit_poll_ms(uint32_t poll_ms) {
+    if (poll_ms == 0) poll_ms = 1;
+    g_poll_ms.store(poll_ms, std::memory_order_relaxed);
+}
+
+uint32_t audit_poll_ms() {
+    return g_poll_ms.load(std::memory_order_relaxed);
+}
+
+void start_audit_monitor(EnipClient* enip, const AuditMonitorConfig& mc) {
+    //
+    //
+    //
+    auto* cfg = new AuditCfg{};
+    cfg->enip = enip;
+    init_watch(cfg->audit, mc.audit,        1);
+    init_watch(cfg->auth,  mc.authorized,   1);
+    init_watch(cfg->kp,    mc.kp,           1);
+    init_watch(cfg->ki,    mc.ki,           1);
+    init_watch(cfg->kd,    mc.kd,           1);
+    init_watch(cfg->stamp, mc.change_stamp, 7);
+    cfg->detector.kp_epsilon = mc.kp.epsilon;
+    cfg->detector.ki_epsilon = mc.ki.epsilon;
+    cfg->detector.kd_epsilon = mc.kd.epsilon;
+    cfg->tz_offset_minutes   = mc.tz_offset_minutes;
+    set_audit_poll_ms(mc.poll_ms);
+
+    TaskHandle_t task = nullptr;
+    xTaskCreate(audit_task, "audit_task", AUDIT_TASK_STACK, cfg, 5, &task);
+    MemStats::watch_task(task, AUDIT_TASK_STACK);
+}
+
 void start_audit_monitor(EnipClient* enip,
                          const char* audit_tag,
                          const char* authorized_tag,
@@ -310,6 +413,14 @@ void start_audit_monitor(EnipClient* enip,
     //
     //
     //
-    auto* cfg = new AuditCfg{enip, audit_tag, authorized_tag, kp_tag, ki_tag, kd_tag, change_stamp_tag, poll_ms};
-    xTaskCreate(audit_task, "audit_task", 4096, cfg, 5, nullptr);
+    AuditMonitorConfig mc;
+    mc.audit        = AuditWatch{audit_tag,        Cip::Type::LINT};
+    mc.authorized   = AuditWatch{authorized_tag,   Cip::Type::DINT};
+    mc.kp           = AuditWatch{kp_tag,           Cip::Type::REAL};
+    mc.ki           = AuditWatch{ki_tag,           Cip::Type::REAL};
+    mc.kd           = AuditWatch{kd_tag,           Cip::Type::REAL};
+    mc.change_stamp = AuditWatch{change_stamp_tag, Cip::Type::DINT};
+    mc.poll_ms      = poll_ms;
+    mc.tz_offset_minutes = PLC_TZ_OFFSET_MINUTES;
+    start_audit_monitor(enip, mc);
 }
@@ -6,12 +6,19 @@
 
 
 #include "CipCodec.hpp"
+#include <cstdio>
 #include <cstring>
 
 namespace {
     // CIP type IDs 
     constexpr uint16_t CIP_BOOL = 0x00C1;
+    constexpr uint16_t CIP_SINT = 0x00C2;
+    constexpr uint16_t CIP_INT  = 0x00C3;
     constexpr uint16_t CIP_DINT = 0x00C4;
+    constexpr uint16_t CIP_LINT = 0x00C5;
+    constexpr uint16_t CIP_REAL = 0x00CA;
+
+    constexpr uint8_t SVC_MULTIPLE = 0x0A;
 
     static void emit_one_symbol(std::vector<uint8_t>& buf, const std::string& s) {
         //
@@ -85,6 +92,24 @@ namespace Cip {
         return c;
     }
 
+    std::vector<uint8_t> build_get_attribute_list(uint16_t class_id, uint16_t instance, uint16_t attribute) {
+        //
+        // Logical segment path: class, instance (8 or 16 bit), then attribute count + IDs
+        //
+        std::vector<uint8_t> c;
+        c.push_back(0x03);            // Service: Get_Attribute_List
+        c.push_back(0x00);            // Path size (words) — to be filled
+        size_t path_start = c.size();
+        if (class_id <= 0xFF) { c.push_back(0x20); c.push_back((uint8_t)class_id); }
+        else { c.push_back(0x21); c.push_back(0x00); c.push_back((uint8_t)class_id); c.push_back((uint8_t)(class_id >> 8)); }
+        if (instance <= 0xFF) { c.push_back(0x24); c.push_back((uint8_t)instance); }
+        else { c.push_back(0x25); c.push_back(0x00); c.push_back((uint8_t)instance); c.push_back((uint8_t)(instance >> 8)); }
+        c[1] = (uint8_t)((c.size() - path_start)/2);
+        c.push_back(0x01); c.push_back(0x00);                               // attribute count
+        c.push_back((uint8_t)attribute); c.push_back((uint8_t)(attribute >> 8));
+        return c;
+    }
+
     std::vector<uint8_t> build_write_bool(const std::string& tag_name, bool value) {
         //
         //
@@ -107,6 +132,64 @@ namespace Cip {
         return build_write_scalar(tag_name, CIP_DINT, buf, 4);
     }
 
+    std::vector<uint8_t> build_write_lint(const std::string& tag_name, int64_t value) {
+        Value v;
+        v.type    = Type::LINT;
+        v.v.i64   = value;
+        return build_write_value(tag_name, v);
+    }
+
+    std::vector<uint8_t> build_write_real(const std::string& tag_name, float value) {
+        Value v;
+        v.type    = Type::REAL;
+        v.v.f32   = value;
+        return build_write_value(tag_name, v);
+    }
+
+    std::vector<uint8_t> build_write_value(const std::string& tag_name, const Value& v) {
+        //
+        // Little-endian value bytes for the type, then the common Write Tag layout
+        //
+        uint64_t u = 0;
+        size_t   n = 0;
+        uint16_t type_id = 0;
+        switch (v.type) {
+            case Type::BOOL: u = v.v.b ? 1 : 0;          n = 1; type_id = CIP_BOOL; break;
+            case Type::SINT: u = (uint8_t)v.v.i8;        n = 1; type_id = CIP_SINT; break;
+            case Type::INT:  u = (uint16_t)v.v.i16;      n = 2; type_id = CIP_INT;  break;
+            case Type::DINT: u = (uint32_t)v.v.i32;      n = 4; type_id = CIP_DINT; break;
+            case Type::LINT: u = (uint64_t)v.v.i64;      n = 8; type_id = CIP_LINT; break;
+            case Type::REAL: {
+                uint32_t f;
+                std::memcpy(&f, &v.v.f32, sizeof f);
+                u = f; n = 4; type_id = CIP_REAL;
+                break;
+            }
+            default: return {};
+        }
+        uint8_t buf[8];
+        for (size_t i = 0; i < n; ++i) buf[i] = (uint8_t)(u >> (8 * i));
+        return build_write_scalar(tag_name, type_id, buf, n);
+    }
+
+    std::vector<uint8_t> build_multiple_service(const std::vector<std::vector<uint8_t>>& requests) {
+        //
+        // service | path size | class 0x02 instance 1 | count | offsets (from count) | requests
+        //
+        std::vector<uint8_t> c{SVC_MULTIPLE, 0x02, 0x20, 0x02, 0x24, 0x01};
+        const uint16_t count = (uint16_t)requests.size();
+        c.push_back((uint8_t)count);
+        c.push_back((uint8_t)(count >> 8));
+        size_t off = 2 + 2 * (size_t)count;
+        for (const auto& r : requests) {
+            c.push_back((uint8_t)off);
+            c.push_back((uint8_t)(off >> 8));
+            off += r.size();
+        }
+        for (const auto& r : requests) c.insert(c.end(), r.begin(), r.end());
+        return c;
+    }
+
     std::vector<uint8_t> wrap_sendrr(const std::vector<uint8_t>& cip) {
         //
         //
@@ -222,4 +305,213 @@ namespace Cip {
         out.type = Type::UNSUPPORTED;
         return false;
     }
+
+    bool find_read_value(const std::vector<uint8_t>& rr, uint16_t type_id, size_t min_bytes, size_t& off) {
+        //
+        // Same walk as extract_cip_from_rr + parse_read_reply, on offsets only
+        //
+        if (rr.size() < 8) return false;
+        uint16_t item_count = rr[6] | (rr[7] << 8);
+        size_t o = 8;
+        for (uint16_t i = 0; i < item_count; ++i) {
+            if (rr.size() < o + 4) return false;
+            uint16_t type = rr[o] | (rr[o+1] << 8);
+            uint16_t len  = rr[o+2] | (rr[o+3] << 8);
+            o += 4;
+            if (rr.size() < o + len) return false;
+            if (type != 0x00B2) { o += len; continue; }
+
+            const uint8_t* c = rr.data() + o;
+            if (len < 4 || (c[0] & 0x80) == 0 || c[2] != 0) return false;
+            size_t data_off = 4 + c[3] * 2;
+            if (len < data_off + 2 + min_bytes) return false;
+            if ((uint16_t)(c[data_off] | (c[data_off+1] << 8)) != type_id) return false;
+            off = o + data_off + 2;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_service_status(Span c, Status& out) {
+        //
+        //
+        //
+        out = Status{};
+        if (c.n < 4 || (c.p[0] & 0x80) == 0) return false;
+        out.general = c.p[2];
+        if (c.p[3] >= 1 && c.n >= 6) out.extended = (uint16_t)(c.p[4] | (c.p[5] << 8));
+        out.layer = out.general ? Status::Layer::CIP : Status::Layer::OK;
+        return true;
+    }
+
+    bool parse_service_status(const std::vector<uint8_t>& c, Status& out) {
+        return parse_service_status(Span{c.data(), c.size()}, out);
+    }
+
+    bool parse_multiple_service_reply(Span r, std::vector<Status>& out) {
+        //
+        // Reply header, then count | offsets (from count) | embedded replies
+        //
+        out.clear();
+        const uint8_t* c = r.p;
+        if (r.n < 4 || c[0] != (SVC_MULTIPLE | 0x80)) return false;
+        if (c[2] != 0 && c[2] != 0x1E) return false;
+        const size_t base = 4 + c[3] * 2;
+        if (r.n < base + 2) return false;
+        const uint16_t count = c[base] | (c[base+1] << 8);
+        if (r.n < base + 2 + 2 * (size_t)count) return false;
+        for (uint16_t i = 0; i < count; ++i) {
+            const size_t p = base + (size_t)(c[base + 2 + 2*i] | (c[base + 3 + 2*i] << 8));
+            if (r.n < p + 4 || (c[p] & 0x80) == 0) return false;
+            Status st;
+            st.general = c[p+2];
+            if (c[p+3] >= 1 && r.n >= p + 6) st.extended = (uint16_t)(c[p+4] | (c[p+5] << 8));
+            st.layer = st.general ? Status::Layer::CIP : Status::Layer::OK;
+            out.push_back(st);
+        }
+        return true;
+    }
+
+    bool parse_multiple_service_reply(const std::vector<uint8_t>& c, std::vector<Status>& out) {
+        return parse_multiple_service_reply(Span{c.data(), c.size()}, out);
+    }
+
+    int64_t as_int64(const Value& v) {
+        switch (v.type) {
+            case Type::BOOL: return v.v.b ? 1 : 0;
+            case Type::SINT: return v.v.i8;
+            case Type::INT:  return v.v.i16;
+            case Type::DINT: return v.v.i32;
+            case Type::LINT: return v.v.i64;
+            default:         return 0;
+        }
+    }
+
+    bool parse_get_attribute_list_reply(const std::vector<uint8_t>& c, uint16_t attribute,
+                                        std::vector<uint8_t>& out) {
+        //
+        // count(2) | attr id(2) | attr status(2) | value...
+        //
+        if (c.size() < 4) return false;
+        if (c[0] != (0x03 | 0x80)) return false;
+        uint8_t gen = c[2], add = c[3];
+        if (gen != 0) return false;
+        size_t off = 4 + add * 2;
+        if (c.size() < off + 6) return false;
+        uint16_t count  = c[off]   | (c[off+1] << 8);
+        uint16_t id     = c[off+2] | (c[off+3] << 8);
+        uint16_t status = c[off+4] | (c[off+5] << 8);
+        if (count < 1 || id != attribute || status != 0) return false;
+        out.assign(c.begin() + off + 6, c.end());
+        return true;
+    }
+
+    bool find_cpf_data(Span body, Span& cip, bool& connected, uint16_t& seq) {
+        //
+        // if_handle(4) timeout(2) count(2), then type(2) len(2) items
+        //
+        if (body.n < 8) return false;
+        const uint8_t* b = body.p;
+        uint16_t item_count = b[6] | (b[7] << 8);
+        size_t off = 8;
+        for (uint16_t i = 0; i < item_count; ++i) {
+            if (body.n < off + 4) return false;
+            uint16_t type = b[off] | (b[off+1] << 8);
+            uint16_t len  = b[off+2] | (b[off+3] << 8);
+            off += 4;
+            if (body.n < off + len) return false;
+            if (type == 0x00B2) {
+                cip = Span{b + off, len};
+                connected = false;
+                return true;
+            }
+            if (type == 0x00B1 && len >= 2) {
+                seq = (uint16_t)(b[off] | (b[off+1] << 8));
+                cip = Span{b + off + 2, (size_t)len - 2};
+                connected = true;
+                return true;
+            }
+            off += len;
+        }
+        return false;
+    }
+
+    bool parse_request(Span c, Request& out) {
+        //
+        // Symbolic (0x91), member (0x28/0x29/0x2A) and logical class / instance / attribute
+        // segments; anything else in a request path is treated as malformed
+        //
+        if (c.n < 2 || (c.p[0] & 0x80)) return false;
+        out.service  = c.p[0];
+        out.class_id = NO_ID;
+        out.instance = NO_ID;
+        out.symbol.clear();
+        const size_t end = 2 + (size_t)c.p[1] * 2;
+        if (c.n < end) return false;
+
+        size_t o = 2;
+        auto u16 = [&](size_t i) { return (uint32_t)(c.p[i] | (c.p[i+1] << 8)); };
+        auto u32 = [&](size_t i) { return u16(i) | (u16(i+2) << 16); };
+        auto element = [&](uint32_t e) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "[%lu]", (unsigned long)e);
+            out.symbol += buf;
+        };
+        while (o < end) {
+            const uint8_t seg = c.p[o];
+            if (seg == 0x91) {
+                if (o + 2 > end) return false;
+                const size_t len = c.p[o+1];
+                if (o + 2 + len > end) return false;
+                if (!out.symbol.empty()) out.symbol.push_back('.');
+                out.symbol.append((const char*)c.p + o + 2, len);
+                o += 2 + len + (len & 1);
+                continue;
+            }
+            // Logical segments: 8-bit value, or pad + 16 / 32-bit value
+            const uint8_t fmt = seg & 0x03;
+            const size_t  sz  = fmt == 0 ? 2 : fmt == 1 ? 4 : fmt == 2 ? 6 : 0;
+            if ((seg & 0xE0) != 0x20 || sz == 0 || o + sz > end) return false;
+            const uint32_t v = fmt == 0 ? c.p[o+1] : fmt == 1 ? u16(o+2) : u32(o+2);
+            switch (seg & 0x1C) {
+                case 0x00: out.class_id = v; break;           // 0x20 class
+                case 0x04: out.instance = v; break;           // 0x24 instance
+                case 0x08: element(v); break;                 // 0x28 member / element
+                case 0x0C: break;                             // 0x2C connection point
+                case 0x10: break;                             // 0x30 attribute
+                default:   return false;
+            }
+            o += sz;
+        }
+        out.data = Span{c.p + end, c.n - end};
+        return true;
+    }
+
+    bool split_multiple_service(Span data, std::vector<Span>& out) {
+        //
+        // count | offsets (from count) | requests; each ends where the next begins
+        //
+        out.clear();
+        if (data.n < 2) return false;
+        const uint16_t count = data.p[0] | (data.p[1] << 8);
+        if (data.n < 2 + 2 * (size_t)count) return false;
+        for (uint16_t i = 0; i < count; ++i) {
+            const size_t from = data.p[2 + 2*i] | (data.p[3 + 2*i] << 8);
+            const size_t to   = (i + 1 < count) ? (size_t)(data.p[4 + 2*i] | (data.p[5 + 2*i] << 8)) : data.n;
+            if (from < 2 + 2 * (size_t)count || to < from || to > data.n) return false;
+            out.push_back(Span{data.p + from, to - from});
+        }
+        return true;
+    }
+
+    bool unwrap_unconnected_send(const Request& r, Span& msg) {
+        //
+        // priority/tick(1) timeout ticks(1) message size(2) message [pad] route path...
+        //
+        if (r.service != 0x52 || r.class_id != 0x06 || r.data.n < 4) return false;
+        const size_t len = r.data.p[2] | (r.data.p[3] << 8);
+        if (r.data.n < 4 + len) return false;
+        msg = Span{r.data.p + 4, len};
+        return true;
+    }
 } // Namespace CIP
@@ -0,0 +1,140 @@
+// CipStatus.cpp
+// George Lake
+// Fall 2025
+//
+// Status decoding and retry classes
+// Refer to CipStatus.hpp for notes
+
+
+#include "CipStatus.hpp"
+
+#include <cstdio>
+
+namespace {
+    // Encapsulation status codes (EtherNet/IP spec, table 2-3.3)
+    constexpr uint32_t ENCAP_INSUFFICIENT_MEMORY = 0x0002;
+    constexpr uint32_t ENCAP_INVALID_SESSION     = 0x0064;
+
+    struct GeneralInfo {
+        uint8_t     code;
+        Cip::Retry  retry;
+        const char* name;
+    };
+
+    // CIP general status codes (CIP Vol 1, appendix B) that a tag read can plausibly see
+    const GeneralInfo GENERAL[] = {
+        {0x01, Cip::Retry::RECONNECT, "connection failure"},
+        {0x02, Cip::Retry::BACKOFF,   "resource unavailable"},
+        {0x03, Cip::Retry::NONE,      "invalid parameter value"},
+        {0x04, Cip::Retry::RESOLVE,   "path segment error"},
+        {0x05, Cip::Retry::RESOLVE,   "path destination unknown"},
+        {0x06, Cip::Retry::NONE,      "partial transfer"},
+        {0x07, Cip::Retry::RECONNECT, "connection lost"},
+        {0x08, Cip::Retry::NONE,      "service not supported"},
+        {0x09, Cip::Retry::NONE,      "invalid attribute value"},
+        {0x0A, Cip::Retry::NONE,      "attribute list error"},
+        {0x0C, Cip::Retry::BACKOFF,   "object state conflict"},
+        {0x0E, Cip::Retry::NONE,      "attribute not settable"},
+        {0x0F, Cip::Retry::NONE,      "privilege violation"},
+        {0x10, Cip::Retry::BACKOFF,   "device state conflict"},
+        {0x11, Cip::Retry::NONE,      "reply data too large"},
+        {0x13, Cip::Retry::NONE,      "not enough data"},
+        {0x14, Cip::Retry::NONE,      "attribute not supported"},
+        {0x15, Cip::Retry::NONE,      "too much data"},
+        {0x16, Cip::Retry::RESOLVE,   "object does not exist"},
+        {0x1E, Cip::Retry::NOW,       "embedded service error"},
+        {0x20, Cip::Retry::NONE,      "invalid parameter"},
+        {0x26, Cip::Retry::NONE,      "path size invalid"},
+        {0xFF, Cip::Retry::NONE,      "general error"},
+    };
+
+    const GeneralInfo* find_general(uint8_t code) {
+        for (const GeneralInfo& g : GENERAL) if (g.code == code) return &g;
+        return nullptr;
+    }
+} // Anonymous Namespace
+
+namespace Cip {
+    Retry retry_for(const Status& s) {
+        //
+        //
+        //
+        switch (s.layer) {
+            case Status::Layer::OK:        return Retry::NONE;
+            case Status::Layer::TRANSPORT: return Retry::RECONNECT;
+            case Status::Layer::REPLY:     return Retry::NONE;
+            case Status::Layer::ENCAP:
+                if (s.encap == ENCAP_INVALID_SESSION)     return Retry::RECONNECT;
+                if (s.encap == ENCAP_INSUFFICIENT_MEMORY) return Retry::BACKOFF;
+                return Retry::NONE;
+            case Status::Layer::CIP: {
+                const GeneralInfo* g = find_general(s.general);
+                return g ? g->retry : Retry::NONE;
+            }
+        }
+        return Retry::NONE;
+    }
+
+    const char* retry_name(Retry r) {
+        switch (r) {
+            case Retry::NONE:      return "none";
+            case Retry::NOW:       return "retry";
+            case Retry::BACKOFF:   return "backoff";
+            case Retry::RESOLVE:   return "resolve";
+            case Retry::RECONNECT: return "reconnect";
+        }
+        return "?";
+    }
+
+    const char* general_status_name(uint8_t general) {
+        if (general == 0) return "success";
+        const GeneralInfo* g = find_general(general);
+        return g ? g->name : "unknown";
+    }
+
+    void read_status(const std::vector<uint8_t>& rr, Status& out) {
+        //
+        // Item walk as in extract_cip_from_rr; no B2 item or a short one = unusable reply
+        //
+        out.layer    = Status::Layer::REPLY;
+        out.general  = 0;
+        out.extended = 0;
+        if (rr.size() < 8) return;
+        uint16_t item_count = rr[6] | (rr[7] << 8);
+        size_t off = 8;
+        for (uint16_t i = 0; i < item_count; ++i) {
+            if (rr.size() < off + 4) return;
+            uint16_t type = rr[off] | (rr[off+1] << 8);
+            uint16_t len  = rr[off+2] | (rr[off+3] << 8);
+            off += 4;
+            if (rr.size() < off + len) return;
+            if (type != 0x00B2) { off += len; continue; }
+
+            if (len < 4) return;
+            const uint8_t* c = rr.data() + off;
+            out.general = c[2];
+            if (c[3] >= 1 && len >= 6) out.extended = (uint16_t)(c[4] | (c[5] << 8));
+            if (out.general != 0) out.layer = Status::Layer::CIP;
+            return;
+        }
+    }
+
+    size_t describe(const Status& s, char* buf, size_t len) {
+        //
+        //
+        //
+        int n = 0;
+        switch (s.layer) {
+            case Status::Layer::OK:        n = std::snprintf(buf, len, "ok"); break;
+            case Status::Layer::TRANSPORT: n = std::snprintf(buf, len, "transport"); break;
+            case Status::Layer::ENCAP:     n = std::snprintf(buf, len, "ENCAP 0x%08lx", (unsigned long)s.encap); break;
+            case Status::Layer::REPLY:     n = std::snprintf(buf, len, "unusable reply"); break;
+            case Status::Layer::CIP:
+                n = std::snprintf(buf, len, "CIP 0x%02x/0x%04x %s", (unsigned)s.general, (unsigned)s.extended,
+                                  general_status_name(s.general));
+                break;
+        }
+        if (n < 0) return 0;
+        return (size_t)n < len ? (size_t)n : (len ? len - 1 : 0);
+    }
+}
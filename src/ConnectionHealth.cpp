@@ -0,0 +1,273 @@
+// ConnectionHealth.cpp
+// George Lake
+// Fall 2025
+//
+// Keepalive / reconnect task for the shared EnipClient
+// Refer to ConnectionHealth.hpp for notes
+
+
+#include "ConnectionHealth.hpp"
+#include "EnipClient.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+#include "SeqLock.hpp"
+
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <atomic>
+
+namespace {
+    static const char* TAG = "CONN_HEALTH";
+
+    constexpr uint32_t STACK_BYTES   = 4096;
+    constexpr uint32_t MAX_SLEEP_MS  = 1000;
+
+    EnipClient*                  g_enip = nullptr;
+    ConnectionHealth::Config     g_cfg;
+    TaskHandle_t                 g_task = nullptr;
+
+    std::atomic<uint32_t>        g_consecutive_fail{0};
+    SeqLock                      g_net_lock;            // guards the link state pair below
+    std::atomic<bool>            g_net_down{false};     // on_link(false) until on_link(true)
+    SeqLock::U64                 g_net_change_us;
+    std::atomic<bool>            g_up{false};
+    std::atomic<uint32_t>        g_outages{0};
+    std::atomic<uint32_t>        g_attempts{0};
+    std::atomic<uint32_t>        g_reconnects{0};
+    std::atomic<uint32_t>        g_probes{0};
+    std::atomic<uint32_t>        g_probe_failures{0};
+    std::atomic<uint32_t>        g_last_outage_ms{0};
+    std::atomic<uint32_t>        g_longest_outage_ms{0};
+    std::atomic<uint32_t>        g_standby_opens{0};
+
+    constexpr auto RELAXED = std::memory_order_relaxed;
+
+    uint32_t backoff_ms(uint32_t attempt) {
+        //
+        // first_retry_ms * 2^attempt, capped, +/- jitter_pct
+        //
+        uint64_t d = g_cfg.first_retry_ms ? g_cfg.first_retry_ms : 1;
+        for (uint32_t i = 0; i < attempt && d < g_cfg.max_backoff_ms; ++i) d *= 2;
+        if (d > g_cfg.max_backoff_ms) d = g_cfg.max_backoff_ms;
+
+        uint32_t span = (uint32_t)(d * g_cfg.jitter_pct / 100);
+        if (span) d = d - span + esp_random() % (2 * span + 1);
+        return (uint32_t)d;
+    }
+
+    void link_down(const char* why, int64_t at_us) {
+        ESP_LOGW(TAG, "Link down (%s)", why);
+        g_up.store(false, RELAXED);
+        g_outages.fetch_add(1, RELAXED);
+        Experiment::record_comm_fault_start(at_us);
+    }
+
+    void link_up(int64_t down_since_us) {
+        uint32_t ms = (uint32_t)((esp_timer_get_time() - down_since_us) / 1000);
+        g_last_outage_ms.store(ms, RELAXED);
+        if (ms > g_longest_outage_ms.load(RELAXED)) g_longest_outage_ms.store(ms, RELAXED);
+        g_reconnects.fetch_add(1, RELAXED);
+        g_consecutive_fail.store(0, RELAXED);
+        g_up.store(true, RELAXED);
+        Experiment::record_comm_fault_end();
+        ESP_LOGI(TAG, "Link up after %lu ms", (unsigned long)ms);
+    }
+
+    // Hot standby upkeep while the link is up; returns ms until it needs the task again
+    uint32_t tend_standby(int64_t now) {
+        //
+        //
+        //
+        static int64_t  next_open_us  = 0;
+        static int64_t  next_probe_us = 0;
+        static uint32_t attempt       = 0;
+
+        if (!g_enip->has_standby()) {
+            if (now < next_open_us) return (uint32_t)((next_open_us - now + 999) / 1000);
+            if (g_enip->open_standby()) {
+                g_standby_opens.fetch_add(1, RELAXED);
+                ESP_LOGI(TAG, "Standby session ready");
+                attempt       = 0;
+                next_probe_us = now + (int64_t)g_cfg.standby_probe_ms * 1000;
+                return g_cfg.standby_probe_ms;
+            }
+            uint32_t d = backoff_ms(++attempt);
+            next_open_us = now + (int64_t)d * 1000;
+            return d;
+        }
+        if (now < next_probe_us) return (uint32_t)((next_probe_us - now + 999) / 1000);
+        if (!g_enip->probe_standby()) return 0;     // closed; reopen on the next pass
+        next_probe_us = now + (int64_t)g_cfg.standby_probe_ms * 1000;
+        return g_cfg.standby_probe_ms;
+    }
+
+    void health_task(void*) {
+        //
+        //
+        //
+        int64_t  down_since_us = 0;
+        int64_t  next_try_us   = 0;
+        uint32_t attempt       = 0;
+        bool     net_was_down  = false;
+
+        if (!g_enip->connected()) {
+            down_since_us = esp_timer_get_time();
+            link_down("not connected at start", down_since_us);
+        }
+
+        for (;;) {
+            int64_t now = esp_timer_get_time();
+            uint32_t sleep_ms = MAX_SLEEP_MS;
+            bool    net_down;
+            int64_t net_change_us;
+            g_net_lock.read([&] {
+                net_down      = g_net_down.load(RELAXED);
+                net_change_us = g_net_change_us.load();
+            });
+
+            if (g_up.load(RELAXED)) {
+                const char* why = nullptr;
+                int64_t at_us = now;
+                if (net_down) {
+                    why   = "network link lost";
+                    at_us = net_change_us;
+                } else if (!g_enip->connected()) {
+                    why = "transport error";
+                } else if (g_consecutive_fail.load(RELAXED) >= g_cfg.fail_threshold) {
+                    why = "consecutive poll failures";
+                } else if (g_cfg.idle_probe_ms) {
+                    int64_t idle_ms = (now - g_enip->last_reply_us()) / 1000;
+                    if (idle_ms >= (int64_t)g_cfg.idle_probe_ms) {
+                        g_probes.fetch_add(1, RELAXED);
+                        if (!g_enip->probe()) {
+                            g_probe_failures.fetch_add(1, RELAXED);
+                            why = "keepalive probe failed";
+                        }
+                        idle_ms = 0;
+                    }
+                    sleep_ms = g_cfg.idle_probe_ms - (uint32_t)idle_ms;
+                }
+                if (!why && g_cfg.hot_standby) {
+                    uint32_t d = tend_standby(now);
+                    if (d < sleep_ms) sleep_ms = d;
+                }
+                if (why) {
+                    link_down(why, at_us);
+                    down_since_us = at_us;
+                    attempt       = 0;
+                    next_try_us   = now + (int64_t)backoff_ms(0) * 1000;
+                    sleep_ms      = 0;
+                }
+            } else if (net_down) {
+                // Nothing to reach until the network is back; on_link(true) wakes the task
+            } else if (net_was_down) {
+                ESP_LOGI(TAG, "Network back; reconnecting now");
+                attempt     = 0;
+                next_try_us = now;
+                sleep_ms    = 0;
+            } else if (now >= next_try_us) {
+                g_attempts.fetch_add(1, RELAXED);
+                if (g_enip->reconnect()) {
+                    link_up(down_since_us);
+                    attempt = 0;
+                    continue;
+                }
+                uint32_t d = backoff_ms(++attempt);
+                ESP_LOGW(TAG, "Reconnect attempt %lu failed; next in %lu ms",
+                         (unsigned long)attempt, (unsigned long)d);
+                next_try_us = esp_timer_get_time() + (int64_t)d * 1000;
+                sleep_ms = d;
+            } else {
+                sleep_ms = (uint32_t)((next_try_us - now + 999) / 1000);
+            }
+
+            net_was_down = net_down;
+            if (sleep_ms > MAX_SLEEP_MS) sleep_ms = MAX_SLEEP_MS;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleep_ms));
+            CpuProfiler::count_wake();
+        }
+    }
+} // Anonymous Namespace
+
+namespace ConnectionHealth {
+    bool start(EnipClient* enip, const Config& cfg) {
+        //
+        //
+        //
+        if (g_task || !enip) return false;
+        g_enip = enip;
+        g_cfg  = cfg;
+        g_up.store(enip->connected(), RELAXED);
+        if (xTaskCreate(health_task, "conn_health", STACK_BYTES, nullptr, cfg.priority, &g_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task");
+            g_task = nullptr;
+            return false;
+        }
+        MemStats::watch_task(g_task, STACK_BYTES);
+        return true;
+    }
+
+    bool running() {
+        return g_task != nullptr;
+    }
+
+    void note_poll(bool ok) {
+        if (ok) {
+            g_consecutive_fail.store(0, RELAXED);
+            return;
+        }
+        g_consecutive_fail.fetch_add(1, RELAXED);
+        // Closed socket, failover (spare to rebuild) or threshold: the task sorts it out now
+        if (g_task) xTaskNotifyGive(g_task);
+    }
+
+    void on_link(bool up, int64_t t_us) {
+        //
+        // Event loop context: flag, abort, wake; the task does the rest
+        //
+        g_net_lock.write([&] {
+            g_net_change_us.store(t_us);
+            g_net_down.store(!up, RELAXED);
+        });
+        if (!g_task) return;
+        if (!up) g_enip->abort();
+        xTaskNotifyGive(g_task);
+    }
+
+    void wifi_link_listener(bool up, int64_t t_us, void*) {
+        on_link(up, t_us);
+    }
+
+    Status status() {
+        Status s;
+        s.up                 = g_up.load(RELAXED);
+        s.outages            = g_outages.load(RELAXED);
+        s.reconnect_attempts = g_attempts.load(RELAXED);
+        s.reconnects         = g_reconnects.load(RELAXED);
+        s.probes             = g_probes.load(RELAXED);
+        s.probe_failures     = g_probe_failures.load(RELAXED);
+        s.last_outage_ms     = g_last_outage_ms.load(RELAXED);
+        s.longest_outage_ms  = g_longest_outage_ms.load(RELAXED);
+        s.standby_ready      = g_enip && g_cfg.hot_standby && g_enip->has_standby();
+        s.failovers          = g_enip ? g_enip->stats().failovers : 0;
+        s.standby_opens      = g_standby_opens.load(RELAXED);
+        return s;
+    }
+
+    void log_summary(const char* log_tag) {
+        Status s = status();
+        ESP_LOGI(log_tag, "LINK %s outages=%lu attempts=%lu reconnects=%lu probes=%lu (failed %lu) last=%lums longest=%lums",
+                 s.up ? "up" : "down", (unsigned long)s.outages, (unsigned long)s.reconnect_attempts,
+                 (unsigned long)s.reconnects, (unsigned long)s.probes, (unsigned long)s.probe_failures,
+                 (unsigned long)s.last_outage_ms, (unsigned long)s.longest_outage_ms);
+        if (g_cfg.hot_standby) {
+            ESP_LOGI(log_tag, "LINK standby=%s failovers=%lu opened=%lu", s.standby_ready ? "ready" : "none",
+                     (unsigned long)s.failovers, (unsigned long)s.standby_opens);
+        }
+    }
+}
@@ -0,0 +1,252 @@
+// Containment.cpp
+// George Lake
+// Fall 2025
+//
+// Containment write task
+// Refer to Containment.hpp for notes
+
+
+#include "Containment.hpp"
+#include "CipStatus.hpp"
+#include "EnipClient.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "LatencyHistogram.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+    static const char* TAG = "CONTAIN";
+
+    constexpr uint32_t STACK_BYTES   = 4096;
+    constexpr size_t   MAX_CIP_BYTES = 500;     // unconnected message limit, with headroom
+
+    EnipClient*              g_enip = nullptr;
+    TaskHandle_t             g_task = nullptr;
+    std::string              g_tags[Containment::MAX_ACTIONS];
+    size_t                   g_count = 0;
+    std::vector<uint8_t>     g_rr;              // pre-encoded SendRRData body
+
+    // Earliest untreated detection and its reason, taken together under g_pending_mux
+    // (a 64-bit atomic is not lock-free on the C6, and the pair must never be seen split)
+    portMUX_TYPE             g_pending_mux = portMUX_INITIALIZER_UNLOCKED;
+    int64_t                  g_pending_us  = 0; // 0 = none
+    const char*              g_reason      = nullptr;
+
+    std::atomic<uint32_t>    g_triggers{0};
+    std::atomic<uint32_t>    g_coalesced{0};
+    std::atomic<uint32_t>    g_batches{0};
+    std::atomic<uint32_t>    g_acked{0};
+    std::atomic<uint32_t>    g_failed{0};
+    std::atomic<uint32_t>    g_last_us{0};
+    LatencyHistogram         g_latency;         // written by the task only
+
+    constexpr auto RELAXED = std::memory_order_relaxed;
+
+    // Take the pending detection, if any, and clear it
+    bool take_pending(int64_t& detect_us, const char*& reason) {
+        portENTER_CRITICAL(&g_pending_mux);
+        detect_us = g_pending_us;
+        reason    = g_reason;
+        g_pending_us = 0;
+        portEXIT_CRITICAL(&g_pending_mux);
+        return detect_us != 0;
+    }
+
+    // Per-write status from the reply; false if there is no usable reply at all
+    bool write_statuses(const std::vector<uint8_t>& rr_body, std::vector<Cip::Status>& out) {
+        std::vector<uint8_t> c;
+        if (!Cip::extract_cip_from_rr(rr_body, c)) return false;
+        if (g_count > 1) return Cip::parse_multiple_service_reply(c, out) && out.size() == g_count;
+        out.assign(1, Cip::Status{});
+        return Cip::parse_service_status(c, out[0]);
+    }
+
+    void emit_batch(const char* reason, uint32_t detect_to_ack_us, const EnipClient::RrTiming& t,
+                    bool ok, const std::vector<Cip::Status>& st) {
+        //
+        //
+        //
+        int64_t now = Experiment::timestamp_ms();
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "containment");
+        cJSON_AddNumberToObject(root, "t_ms", (double)now);
+        cJSON_AddStringToObject(root, "reason", reason ? reason : "");
+        cJSON_AddBoolToObject(root, "ok", ok);
+        cJSON_AddNumberToObject(root, "detect_to_ack_us", detect_to_ack_us);
+        cJSON_AddNumberToObject(root, "queue_us", t.queue_us);
+        cJSON_AddNumberToObject(root, "rtt_us", t.send_us + t.wait_us);
+
+        cJSON* writes = cJSON_AddArrayToObject(root, "writes");
+        for (size_t i = 0; i < g_count; ++i) {
+            cJSON* w = cJSON_CreateObject();
+            cJSON_AddStringToObject(w, "tag", g_tags[i].c_str());
+            if (i < st.size()) {
+                char buf[64];
+                Cip::describe(st[i], buf, sizeof(buf));
+                cJSON_AddBoolToObject(w, "ok", st[i].ok());
+                cJSON_AddStringToObject(w, "status", buf);
+            } else {
+                cJSON_AddBoolToObject(w, "ok", false);
+                cJSON_AddStringToObject(w, "status", "no reply");
+            }
+            cJSON_AddItemToArray(writes, w);
+        }
+
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        Experiment::emit_record(json, now);
+    }
+
+    void run_batch(int64_t detect_us, const char* reason) {
+        //
+        //
+        //
+        std::vector<uint8_t>     rr_body;
+        EnipClient::RrTiming     timing;
+        Cip::Status              transport;
+        std::vector<Cip::Status> st;
+
+        bool ok = g_enip->send_rr_data(g_rr, rr_body, &timing, EnipClient::Priority::URGENT, &transport);
+        const int64_t ack_us = esp_timer_get_time();
+        ok = ok && write_statuses(rr_body, st);
+        for (const Cip::Status& s : st) ok = ok && s.ok();
+
+        const uint32_t us = (uint32_t)(ack_us - detect_us);
+        g_batches.fetch_add(1, RELAXED);
+        if (ok) {
+            g_acked.fetch_add(1, RELAXED);
+            g_last_us.store(us, RELAXED);
+            g_latency.record(us);
+            ESP_LOGW(TAG, "Contained (%s): %u writes acked %lu us after detection (queue %lu us)",
+                     reason ? reason : "?", (unsigned)g_count, (unsigned long)us, (unsigned long)timing.queue_us);
+        } else {
+            g_failed.fetch_add(1, RELAXED);
+            char buf[64];
+            Cip::describe(transport, buf, sizeof(buf));
+            ESP_LOGE(TAG, "Containment writes failed (%s): %s", reason ? reason : "?",
+                     transport.ok() ? "see per-write status" : buf);
+            for (size_t i = 0; i < st.size(); ++i) {
+                if (st[i].ok()) continue;
+                Cip::describe(st[i], buf, sizeof(buf));
+                ESP_LOGE(TAG, "  %s: %s", g_tags[i].c_str(), buf);
+            }
+        }
+        emit_batch(reason, us, timing, ok, st);
+    }
+
+    void containment_task(void*) {
+        //
+        //
+        //
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            CpuProfiler::count_wake();
+            // Drain before blocking again: a trigger during the batch is served even if its
+            // wake-up was already consumed
+            int64_t     detect_us;
+            const char* reason;
+            while (take_pending(detect_us, reason)) {
+                run_batch(detect_us, reason);
+            }
+        }
+    }
+} // Anonymous Namespace
+
+namespace Containment {
+    bool start(EnipClient* enip, const Action* actions, size_t count, const Config& cfg) {
+        //
+        // Encode once; the trigger path only sends
+        //
+        if (g_task || !enip || !actions || count == 0 || count > MAX_ACTIONS) return false;
+
+        std::vector<std::vector<uint8_t>> writes;
+        for (size_t i = 0; i < count; ++i) {
+            if (!actions[i].tag || !actions[i].tag[0]) { ESP_LOGE(TAG, "Action %u: no tag", (unsigned)i); return false; }
+            writes.push_back(Cip::build_write_value(actions[i].tag, actions[i].value));
+            if (writes.back().empty()) {
+                ESP_LOGE(TAG, "Action %u (%s): unsupported type", (unsigned)i, actions[i].tag);
+                return false;
+            }
+        }
+        std::vector<uint8_t> cip = count == 1 ? writes[0] : Cip::build_multiple_service(writes);
+        if (cip.size() > MAX_CIP_BYTES) {
+            ESP_LOGE(TAG, "%u writes need %u bytes (max %u)", (unsigned)count, (unsigned)cip.size(),
+                     (unsigned)MAX_CIP_BYTES);
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i) g_tags[i] = actions[i].tag;
+        g_count = count;
+        g_rr    = Cip::wrap_sendrr(cip);
+        g_enip  = enip;
+        g_latency.reset();
+
+        if (xTaskCreate(containment_task, "containment", STACK_BYTES, nullptr, cfg.priority, &g_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task");
+            g_task = nullptr;
+            return false;
+        }
+        MemStats::watch_task(g_task, STACK_BYTES);
+        ESP_LOGI(TAG, "Armed: %u writes in %u bytes", (unsigned)count, (unsigned)cip.size());
+        return true;
+    }
+
+    bool running() {
+        return g_task != nullptr;
+    }
+
+    void trigger(const char* reason, int64_t detect_us) {
+        //
+        // Keep the earliest pending detection; a later one rides on the same batch
+        //
+        if (!g_task) return;
+        if (detect_us <= 0) detect_us = 1;
+        g_triggers.fetch_add(1, RELAXED);
+        portENTER_CRITICAL(&g_pending_mux);
+        const bool coalesced = g_pending_us != 0;
+        if (!coalesced) {
+            g_pending_us = detect_us;
+            g_reason     = reason;
+        }
+        portEXIT_CRITICAL(&g_pending_mux);
+        if (coalesced) g_coalesced.fetch_add(1, RELAXED);
+        xTaskNotifyGive(g_task);
+    }
+
+    Status status() {
+        Status s;
+        s.triggers  = g_triggers.load(RELAXED);
+        s.coalesced = g_coalesced.load(RELAXED);
+        s.batches   = g_batches.load(RELAXED);
+        s.acked     = g_acked.load(RELAXED);
+        s.failed    = g_failed.load(RELAXED);
+        s.last_us   = g_last_us.load(RELAXED);
+        s.p50_us    = g_latency.percentile(50);
+        s.p99_us    = g_latency.percentile(99);
+        s.max_us    = g_latency.max();
+        return s;
+    }
+
+    void log_summary(const char* log_tag) {
+        if (!g_task) return;
+        Status s = status();
+        ESP_LOGI(log_tag, "CONTAIN triggers=%lu (coalesced %lu) batches=%lu acked=%lu failed=%lu "
+                          "detect->ack last=%luus p50=%luus p99=%luus max=%luus",
+                 (unsigned long)s.triggers, (unsigned long)s.coalesced, (unsigned long)s.batches,
+                 (unsigned long)s.acked, (unsigned long)s.failed, (unsigned long)s.last_us,
+                 (unsigned long)s.p50_us, (unsigned long)s.p99_us, (unsigned long)s.max_us);
+    }
+}
@@ -0,0 +1,264 @@
+// CpuProfiler.cpp
+// George Lake
+// Fall 2025
+//
+// Run time stats sampling task and reporting
+// Refer to CpuProfiler.hpp for notes
+
+
+#include "CpuProfiler.hpp"
+#include "MemStats.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "cJSON.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(configUSE_TRACE_FACILITY) && configUSE_TRACE_FACILITY && \
+    defined(configGENERATE_RUN_TIME_STATS) && configGENERATE_RUN_TIME_STATS
+#define CPU_PROFILER_AVAILABLE 1
+#else
+#define CPU_PROFILER_AVAILABLE 0
+#endif
+
+namespace {
+    static const char* TAG = "CPU_PROF";
+
+    constexpr uint32_t MAX_WAKE_SLOTS = 12;
+    constexpr uint32_t STACK_BYTES    = 4096;
+
+    // count_wake() counters, one per calling task (append-only, read without locking)
+    struct WakeSlot {
+        TaskHandle_t          task = nullptr;
+        std::atomic<uint32_t> wakes{0};
+    };
+    WakeSlot              g_wake[MAX_WAKE_SLOTS];
+    std::atomic<uint32_t> g_wake_count{0};
+    portMUX_TYPE          g_wake_mux = portMUX_INITIALIZER_UNLOCKED;
+
+    CpuProfiler::Config   g_cfg{};
+    SemaphoreHandle_t     g_lock = nullptr;     // g_latest
+    CpuProfiler::Window   g_latest{};
+    bool                  g_have_latest = false;
+    std::atomic<bool>     g_running{false};
+
+    double round2(float v) { return (double)(int64_t)(v * 100.0f + 0.5f) / 100.0; }
+
+    WakeSlot* find_wake(TaskHandle_t t) {
+        uint32_t n = g_wake_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (g_wake[i].task == t) return &g_wake[i];
+        }
+        return nullptr;
+    }
+
+#if CPU_PROFILER_AVAILABLE
+    // Previous sample, matched by handle
+    struct Prev {
+        TaskHandle_t task;
+        uint32_t     run_time;
+        uint32_t     wakes;
+    };
+    Prev         g_prev[CpuProfiler::MAX_TASKS];
+    uint32_t     g_prev_count = 0;
+    uint32_t     g_prev_total = 0;
+    int64_t      g_prev_us    = 0;
+    TaskStatus_t g_status[CpuProfiler::MAX_TASKS];
+
+    const Prev* find_prev(TaskHandle_t t) {
+        for (uint32_t i = 0; i < g_prev_count; ++i) {
+            if (g_prev[i].task == t) return &g_prev[i];
+        }
+        return nullptr;
+    }
+
+    bool take_window(CpuProfiler::Window& w) {
+        //
+        // Deltas of each task's run time counter against the previous sample
+        //
+        uint32_t total = 0;
+        UBaseType_t n = uxTaskGetSystemState(g_status, CpuProfiler::MAX_TASKS, &total);
+        int64_t now_us = esp_timer_get_time();
+        if (n == 0) {
+            ESP_LOGW(TAG, "More than %u tasks; window skipped", (unsigned)CpuProfiler::MAX_TASKS);
+            return false;
+        }
+
+        const bool first = g_prev_us == 0;
+        const uint32_t d_total = total - g_prev_total;
+        const float window_s = (float)(now_us - g_prev_us) / 1e6f;
+
+        static const CpuProfiler::Window EMPTY;
+        w = EMPTY;
+        w.end_ms     = now_us / 1000;
+        w.window_ms  = (uint32_t)((now_us - g_prev_us) / 1000);
+        w.task_count = (uint32_t)n;
+
+        Prev next[CpuProfiler::MAX_TASKS];
+        for (UBaseType_t i = 0; i < n; ++i) {
+            const TaskStatus_t& s = g_status[i];
+            const WakeSlot* ws = find_wake(s.xHandle);
+            const uint32_t wakes = ws ? ws->wakes.load(std::memory_order_relaxed) : 0;
+            next[i] = Prev{s.xHandle, (uint32_t)s.ulRunTimeCounter, wakes};
+
+            // A task created during the window started its counters at zero
+            const Prev* p = find_prev(s.xHandle);
+            uint32_t d_run   = (uint32_t)s.ulRunTimeCounter - (p ? p->run_time : 0);
+            uint32_t d_wakes = wakes - (p ? p->wakes : 0);
+
+            CpuProfiler::TaskLoad& t = w.tasks[i];
+            std::strncpy(t.name, s.pcTaskName ? s.pcTaskName : "?", sizeof(t.name) - 1);
+            t.priority    = (uint8_t)s.uxCurrentPriority;
+            t.cpu_pct     = d_total ? 100.0f * (float)d_run / (float)d_total : 0.0f;
+            t.wakes_per_s = ws ? (window_s > 0 ? (float)d_wakes / window_s : 0.0f) : -1.0f;
+            if (std::strncmp(t.name, "IDLE", 4) == 0) { w.idle_pct += t.cpu_pct; w.has_idle = true; }
+        }
+        std::memcpy(g_prev, next, sizeof(Prev) * n);
+        g_prev_count = (uint32_t)n;
+        g_prev_total = total;
+        g_prev_us    = now_us;
+
+        std::sort(w.tasks, w.tasks + n, [](const CpuProfiler::TaskLoad& a, const CpuProfiler::TaskLoad& b) {
+            return a.cpu_pct > b.cpu_pct;
+        });
+        return !first;
+    }
+
+    void profiler_task(void*) {
+        static CpuProfiler::Window w;
+        take_window(w);     // reference sample
+        TickType_t wake = xTaskGetTickCount();
+        for (;;) {
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(g_cfg.period_ms));
+            if (!take_window(w)) continue;
+            xSemaphoreTake(g_lock, portMAX_DELAY);
+            g_latest      = w;
+            g_have_latest = true;
+            xSemaphoreGive(g_lock);
+        }
+    }
+#endif
+} // Anonymous Namespace
+
+namespace CpuProfiler {
+    bool start(const Config& cfg) {
+        //
+        //
+        //
+#if CPU_PROFILER_AVAILABLE
+        if (g_running.load()) return true;
+        g_cfg  = cfg;
+        if (g_cfg.period_ms < 100) g_cfg.period_ms = 100;
+        g_lock = xSemaphoreCreateMutex();
+        if (!g_lock) return false;
+
+        TaskHandle_t task = nullptr;
+        if (xTaskCreate(profiler_task, "cpu_prof", STACK_BYTES, nullptr, g_cfg.priority, &task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create profiler task");
+            return false;
+        }
+        MemStats::watch_task(task, STACK_BYTES);
+        g_running.store(true);
+        ESP_LOGI(TAG, "Sampling run time stats every %lu ms", (unsigned long)g_cfg.period_ms);
+        return true;
+#else
+        (void)cfg;
+        ESP_LOGW(TAG, "Run time stats disabled (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS); profiler off");
+        return false;
+#endif
+    }
+
+    bool running() {
+        return g_running.load();
+    }
+
+    void count_wake() {
+        TaskHandle_t self = xTaskGetCurrentTaskHandle();
+        WakeSlot* s = find_wake(self);
+        if (!s) {
+            portENTER_CRITICAL(&g_wake_mux);
+            s = find_wake(self);
+            uint32_t n = g_wake_count.load(std::memory_order_relaxed);
+            if (!s && n < MAX_WAKE_SLOTS) {
+                g_wake[n].task = self;
+                s = &g_wake[n];
+                g_wake_count.store(n + 1, std::memory_order_release);
+            }
+            portEXIT_CRITICAL(&g_wake_mux);
+            if (!s) return;
+        }
+        s->wakes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool latest(Window& out) {
+        if (!g_lock) return false;
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+        bool ok = g_have_latest;
+        if (ok) out = g_latest;
+        xSemaphoreGive(g_lock);
+        return ok;
+    }
+
+    void log_summary(const char* log_tag) {
+        static Window w;    // ~1 KB; only dump_summary calls this
+        if (!latest(w)) return;
+        if (w.has_idle) {
+            ESP_LOGI(log_tag, "CPU window=%lums tasks=%lu load=%.1f%% idle=%.1f%%",
+                     (unsigned long)w.window_ms, (unsigned long)w.task_count,
+                     100.0f - w.idle_pct, w.idle_pct);
+        } else {
+            ESP_LOGI(log_tag, "CPU window=%lums tasks=%lu", (unsigned long)w.window_ms, (unsigned long)w.task_count);
+        }
+        for (uint32_t i = 0; i < w.task_count; ++i) {
+            const TaskLoad& t = w.tasks[i];
+            if (t.cpu_pct < 0.1f) continue;
+            if (t.wakes_per_s >= 0) {
+                ESP_LOGI(log_tag, "CPU task=%s prio=%u cpu=%.2f%% wakes=%.1f/s",
+                         t.name, (unsigned)t.priority, t.cpu_pct, t.wakes_per_s);
+            } else {
+                ESP_LOGI(log_tag, "CPU task=%s prio=%u cpu=%.2f%%", t.name, (unsigned)t.priority, t.cpu_pct);
+            }
+        }
+    }
+
+    std::string export_json(int64_t t_ms) {
+        //
+        //
+        //
+        static Window w;
+        if (!latest(w)) return std::string();
+
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "cpu_profile");
+        cJSON_AddNumberToObject(root, "t_ms", (double)t_ms);
+        cJSON_AddNumberToObject(root, "window_ms", w.window_ms);
+        if (w.has_idle) {
+            cJSON_AddNumberToObject(root, "load_pct", round2(100.0f - w.idle_pct));
+            cJSON_AddNumberToObject(root, "idle_pct", round2(w.idle_pct));
+        }
+
+        cJSON* tasks = cJSON_AddArrayToObject(root, "tasks");
+        for (uint32_t i = 0; i < w.task_count; ++i) {
+            const TaskLoad& t = w.tasks[i];
+            cJSON* o = cJSON_CreateObject();
+            cJSON_AddStringToObject(o, "name", t.name);
+            cJSON_AddNumberToObject(o, "prio", t.priority);
+            cJSON_AddNumberToObject(o, "cpu_pct", round2(t.cpu_pct));
+            if (t.wakes_per_s >= 0) cJSON_AddNumberToObject(o, "wakes_per_s", round2(t.wakes_per_s));
+            cJSON_AddItemToArray(tasks, o);
+        }
+
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        return json;
+    }
+}
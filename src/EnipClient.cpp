@@ -8,6 +8,7 @@
 #include "lwip/inet.h"
 #include "lwip/sockets.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include <cstring>
 #include <vector>
@@ -18,6 +19,17 @@
 
 namespace {
     static const char* TAG = "ENIP";
+
+    const char* const PRIORITY_NAMES[] = {"urgent", "high", "normal", "low"};
+
+    constexpr uint32_t ENCAP_INVALID_SESSION = 0x0064;
+
+    // Notification index for the socket handover; needs
+    // CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2 (sdkconfig.defaults)
+    constexpr UBaseType_t HANDOFF_NOTIFY_INDEX = 1;
+    static_assert(HANDOFF_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+                  "socket handover needs its own task notification index");
+
     #pragma pack(push, 1)
     
     struct EncapsulationHeader {
@@ -31,34 +43,81 @@ namespace {
     #pragma pack(pop)
 }
 
-EnipClient::EnipClient(const std::string& ip, uint16_t port) : ip_(ip), port_(port) {}
-EnipClient::~EnipClient() {close(); }
+EnipClient::EnipClient(const std::string& ip, uint16_t port)
+    : ip_(ip), port_(port), fd_lock_(xSemaphoreCreateMutex()), io_lock_(xSemaphoreCreateMutex()) {}
+EnipClient::~EnipClient() {
+    close();
+    close_standby();
+    if (fd_lock_) vSemaphoreDelete(fd_lock_);
+    if (io_lock_) vSemaphoreDelete(io_lock_);
+}
 
-bool EnipClient::connect_tcp() {
-    //
+int EnipClient::open_socket() const {
     //
+    // Non-blocking connect bounded by io_timeout_ms, then back to blocking I/O with timeouts
     //
-    sock_ = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (sock_ < 0) { ESP_LOGE(TAG, "socket() failed"); return false; }
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) { ESP_LOGE(TAG, "socket() failed"); return -1; }
+
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+#if defined(TCP_KEEPIDLE) && defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+    int idle = (int)sock_cfg_.keepalive_idle_s, intvl = (int)sock_cfg_.keepalive_intvl_s;
+    int cnt  = (int)sock_cfg_.keepalive_count;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE,  &idle,  sizeof(idle));
+    ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+    ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT,   &cnt,   sizeof(cnt));
+#endif
+    timeval tv;
+    tv.tv_sec  = (long)(sock_cfg_.io_timeout_ms / 1000);
+    tv.tv_usec = (long)(sock_cfg_.io_timeout_ms % 1000) * 1000;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
 
     sockaddr_in a{}; a.sin_family = AF_INET;
     a.sin_port = htons(port_);
     a.sin_addr.s_addr = inet_addr(ip_.c_str());
 
-    if (::connect(sock_, (sockaddr*)&a, sizeof(a)) != 0) {
-        ESP_LOGE(TAG, "connect() errno=%d", errno);
-        close();
-        return false;
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int err = 0;
+    if (::connect(fd, (sockaddr*)&a, sizeof(a)) != 0) {
+        err = errno;
+        if (err == EINPROGRESS) {
+            fd_set wr;
+            FD_ZERO(&wr);
+            FD_SET(fd, &wr);
+            timeval ctv = tv;
+            if (::select(fd + 1, nullptr, &wr, nullptr, &ctv) == 1) {
+                socklen_t len = sizeof(err);
+                ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            } else {
+                err = ETIMEDOUT;
+            }
+        }
     }
-    return true;
+    if (err != 0) {
+        ESP_LOGE(TAG, "connect() errno=%d", err);
+        ::close(fd);
+        return -1;
+    }
+    ::fcntl(fd, F_SETFL, flags);
+    return fd;
 }
 
-bool EnipClient::register_session() {
+bool EnipClient::connect_tcp() {
     //
     //
     //
-    if (sock_ < 0) return false;
+    sock_ = open_socket();
+    return sock_ >= 0;
+}
 
+bool EnipClient::register_on(int fd, uint32_t& session) const {
+    //
+    //
+    //
     EncapsulationHeader hdr{};
     hdr.command = 0x0065;
     hdr.length = 4;
@@ -67,72 +126,361 @@ bool EnipClient::register_session() {
     std::vector<uint8_t> pkt(sizeof(hdr)+sizeof(body));
     std::memcpy(pkt.data(), &hdr, sizeof(hdr));
     std::memcpy(pkt.data()+sizeof(hdr), body, sizeof(body));
-    if (!send_all(pkt.data(), pkt.size())) return false;
+    if (!send_all(fd, pkt.data(), pkt.size())) return false;
 
     EncapsulationHeader rh{};
-    if (!recv_all(&rh, sizeof(rh))) return false;
+    if (!recv_all(fd, &rh, sizeof(rh))) return false;
 
     uint16_t len = rh.length;
     std::vector<uint8_t> rbody(len);
-    if (len && !recv_all(rbody.data(), len)) return false;
+    if (len && !recv_all(fd, rbody.data(), len)) return false;
 
     if (rh.command != 0x0065 || rh.status != 0) {
         ESP_LOGE(TAG, "RegisterSession failed: status=0x%08" PRIX32, (uint32_t)rh.status);
         return false;
     }
 
-    session_ = rh.session;
-    ESP_LOGI(TAG, "Session=0x%08" PRIX32, (uint32_t)session_);
+    session = rh.session;
+    ESP_LOGI(TAG, "Session=0x%08" PRIX32, (uint32_t)session);
+    return true;
+}
+
+bool EnipClient::register_session() {
+    if (sock_ < 0 || !register_on(sock_, session_)) return false;
+    note_reply(esp_timer_get_time());
+    up_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool EnipClient::reconnect() {
+    //
+    // The slow part (connect + register) runs on a new fd while consumers keep failing fast
+    // on the old state; only the swap waits for the socket
+    //
+    int fd = open_socket();
+    uint32_t session = 0;
+    if (fd < 0) return false;
+    if (!register_on(fd, session)) { ::close(fd); return false; }
+
+    acquire(Priority::HIGH);
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    if (sock_ >= 0) ::close(sock_);
+    sock_    = fd;
+    session_ = session;
+    xSemaphoreGive(fd_lock_);
+    note_reply(esp_timer_get_time());
+    up_.store(true, std::memory_order_relaxed);
+    release();
     return true;
 }
 
-bool EnipClient::send_rr_data(const std::vector<uint8_t>& rr, std::vector<uint8_t>& rr_resp) {
+bool EnipClient::list_identity(int fd) {
     //
+    // ListIdentity needs no session and always answers, so a reply proves the path end to end
+    //
+    EncapsulationHeader hdr{};
+    hdr.command = 0x0063;
+    EncapsulationHeader rh{};
+    if (!send_all(fd, &hdr, sizeof(hdr)) || !recv_all(fd, &rh, sizeof(rh))) return false;
+    std::vector<uint8_t> body(rh.length);
+    if (!body.empty() && !recv_all(fd, body.data(), body.size())) return false;
+    return rh.command == 0x0063;
+}
+
+bool EnipClient::probe() {
     //
     //
-    if (sock_ < 0 || session_ == 0) return false;
+    //
+    acquire(Priority::LOW);
+    bool ok = sock_ >= 0 && list_identity(sock_);
+    if (ok)                note_reply(esp_timer_get_time());
+    else if (sock_ >= 0)   drop("ListIdentity");
+    release();
+    return ok;
+}
+
+bool EnipClient::open_standby() {
+    //
+    // Registered up front so failover costs no round trip
+    //
+    if (has_standby()) return true;
+    int fd = open_socket();
+    uint32_t session = 0;
+    if (fd < 0) return false;
+    if (!register_on(fd, session)) { ::close(fd); return false; }
+
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    standby_fd_      = fd;
+    standby_session_ = session;
+    xSemaphoreGive(fd_lock_);
+    return true;
+}
+
+bool EnipClient::probe_standby() {
+    //
+    // The fd is taken out of the standby slot for the round trip so drop() cannot promote
+    // it mid-probe; abort() still reaches it through probing_fd_
+    //
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    int fd = standby_fd_;
+    uint32_t session = standby_session_;
+    standby_fd_ = -1;
+    probing_fd_ = fd;
+    xSemaphoreGive(fd_lock_);
+    if (fd < 0) return false;
+
+    bool ok = list_identity(fd);
+    const int err = errno;
+
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    probing_fd_ = -1;
+    if (ok && standby_fd_ < 0) {
+        standby_fd_      = fd;
+        standby_session_ = session;
+    } else {
+        // standby_fd_ >= 0: open_standby() installed a new session meanwhile; keep it
+        ::close(fd);
+        if (!ok && standby_fd_ < 0) standby_session_ = 0;
+    }
+    xSemaphoreGive(fd_lock_);
+    if (!ok) ESP_LOGW(TAG, "Standby session lost (errno=%d)", err);
+    return ok;
+}
+
+bool EnipClient::has_standby() const {
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    bool have = standby_fd_ >= 0;
+    xSemaphoreGive(fd_lock_);
+    return have;
+}
+
+void EnipClient::close_standby() {
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    if (standby_fd_ >= 0) ::close(standby_fd_);
+    standby_fd_      = -1;
+    standby_session_ = 0;
+    xSemaphoreGive(fd_lock_);
+}
+
+bool EnipClient::drop(const char* what) {
+    //
+    // Caller holds the socket (acquire). With a standby session it becomes the primary at
+    // once (returns true); otherwise the next request fails fast until reconnect()
+    //
+    const int err = errno;
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    if (sock_ >= 0) ::close(sock_);
+    sock_    = -1;
+    session_ = 0;
+
+    bool failover = standby_fd_ >= 0;
+    if (failover) {
+        sock_            = standby_fd_;
+        session_         = standby_session_;
+        standby_fd_      = -1;
+        standby_session_ = 0;
+    }
+    xSemaphoreGive(fd_lock_);
+
+    up_.store(failover, std::memory_order_relaxed);
+    xSemaphoreTake(io_lock_, portMAX_DELAY);
+    ++stats_.transport_errors;
+    if (failover) ++stats_.failovers;
+    xSemaphoreGive(io_lock_);
+
+    if (failover) {
+        ESP_LOGW(TAG, "%s: transport error (errno=%d); switched to standby session=0x%08" PRIX32,
+                 what, err, session_);
+    } else {
+        ESP_LOGW(TAG, "%s: transport error (errno=%d); closing session", what, err);
+    }
+    return failover;
+}
+
+uint32_t EnipClient::acquire(Priority prio) {
+    //
+    // Take the socket now, or queue and sleep until release() hands it over
+    //
+    const size_t p = (size_t)prio;
+    xSemaphoreTake(io_lock_, portMAX_DELAY);
+    ++stats_.requests[p];
+    if (!busy_) {
+        busy_ = true;
+        xSemaphoreGive(io_lock_);
+        return 0;
+    }
+    Waiter w{xTaskGetCurrentTaskHandle(), nullptr, false};
+    if (tail_[p]) tail_[p]->next = &w; else head_[p] = &w;
+    tail_[p] = &w;
+    ++stats_.queued[p];
+    xSemaphoreGive(io_lock_);
+
+    int64_t t0 = esp_timer_get_time();
+    while (!w.granted) ulTaskNotifyTakeIndexed(HANDOFF_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    uint32_t waited = (uint32_t)(esp_timer_get_time() - t0);
+
+    xSemaphoreTake(io_lock_, portMAX_DELAY);
+    if (waited > stats_.max_queue_us[p]) stats_.max_queue_us[p] = waited;
+    xSemaphoreGive(io_lock_);
+    return waited;
+}
+
+void EnipClient::release() {
+    //
+    // Hand the socket to the oldest waiter of the highest priority (busy_ stays set)
+    //
+    xSemaphoreTake(io_lock_, portMAX_DELAY);
+    Waiter* next = nullptr;
+    for (size_t p = 0; p < (size_t)Priority::COUNT && !next; ++p) {
+        next = head_[p];
+        if (next) {
+            head_[p] = next->next;
+            if (!head_[p]) tail_[p] = nullptr;
+        }
+    }
+    if (!next) busy_ = false;
+    TaskHandle_t task = next ? next->task : nullptr;
+    if (next) next->granted = true;         // next may return (and its frame vanish) from here on
+    xSemaphoreGive(io_lock_);
+    if (task) xTaskNotifyGiveIndexed(task, HANDOFF_NOTIFY_INDEX);
+}
+
+EnipClient::Stats EnipClient::stats() const {
+    xSemaphoreTake(io_lock_, portMAX_DELAY);
+    Stats s = stats_;
+    xSemaphoreGive(io_lock_);
+    return s;
+}
+
+void EnipClient::log_stats(const char* log_tag) const {
+    Stats s = stats();
+    for (size_t p = 0; p < (size_t)Priority::COUNT; ++p) {
+        if (!s.requests[p]) continue;
+        ESP_LOGI(log_tag, "ENIP %s:%u %s requests=%lu queued=%lu max_queue=%luus", ip_.c_str(), (unsigned)port_,
+                 PRIORITY_NAMES[p], (unsigned long)s.requests[p], (unsigned long)s.queued[p],
+                 (unsigned long)s.max_queue_us[p]);
+    }
+    if (s.transport_errors) {
+        ESP_LOGI(log_tag, "ENIP %s:%u transport_errors=%lu failovers=%lu", ip_.c_str(), (unsigned)port_,
+                 (unsigned long)s.transport_errors, (unsigned long)s.failovers);
+    }
+}
+
+bool EnipClient::send_rr_data(const std::vector<uint8_t>& rr, std::vector<uint8_t>& rr_resp, RrTiming* timing,
+                              Priority prio, Cip::Status* status) {
+    //
+    //
+    //
+    Cip::Status st_local;
+    Cip::Status& st = status ? *status : st_local;
+    st = Cip::Status{};
+    st.layer = Cip::Status::Layer::TRANSPORT;
+    if (!connected()) return false;         // fail fast while ConnectionHealth reconnects
+
+    uint32_t queued = acquire(prio);
+    if (sock_ < 0 || session_ == 0) { release(); return false; }
 
     EncapsulationHeader hdr{};
     hdr.command = 0x006F;
     hdr.length = (uint16_t)rr.size();
-    hdr.session = session_;
 
     std::vector<uint8_t> pkt(sizeof(hdr)+rr.size());
-    std::memcpy(pkt.data(), &hdr, sizeof(hdr));
     std::memcpy(pkt.data()+sizeof(hdr), rr.data(), rr.size());
-    if (!send_all(pkt.data(), pkt.size())) return false;
 
     EncapsulationHeader rh{};
-    if (!recv_all(&rh, sizeof(rh))) return false;
-    uint16_t len = rh.length;
-    rr_resp.resize(len);
-    if (len && !recv_all(rr_resp.data(), len)) return false;
+    int64_t t0 = 0, t1 = 0, t2 = 0;
+    bool ok = false;
+    for (int attempt = 0; ; ++attempt) {
+        hdr.session = session_;             // read under the socket: reconnect() or drop() may have swapped it
+        std::memcpy(pkt.data(), &hdr, sizeof(hdr));
+
+        t0 = esp_timer_get_time();
+        ok = send_all(sock_, pkt.data(), pkt.size());
+        t1 = esp_timer_get_time();
+
+        ok = ok && recv_all(sock_, &rh, sizeof(rh));
+        uint16_t len = ok ? rh.length : 0;
+        rr_resp.resize(len);
+        ok = ok && (!len || recv_all(sock_, rr_resp.data(), len));
+        t2 = esp_timer_get_time();
+        if (ok && rh.command == 0x006F && rh.status == ENCAP_INVALID_SESSION) {
+            // The PLC no longer knows this session: close it now rather than after N polls
+            if (drop("SendRRData (invalid session)") && !attempt) continue;
+            break;
+        }
+        if (ok) { note_reply(t2); break; }
+        // A promoted standby gets this request once more; without one (or twice) it fails
+        if (!drop("SendRRData") || attempt) break;
+    }
+    release();
+    if (!ok) return false;
+
+    if (timing) {
+        timing->start_us = t0;
+        timing->queue_us = queued;
+        timing->send_us  = (uint32_t)(t1 - t0);
+        timing->wait_us  = (uint32_t)(t2 - t1);
+    }
 
     if (rh.command != 0x006F || rh.status != 0) {
         ESP_LOGE(TAG, "SendRRData failed: status=0x%08" PRIX32, (uint32_t)rh.status);
+        if (rh.command == 0x006F) st.layer = Cip::Status::Layer::ENCAP;     // else out of step: TRANSPORT
+        st.encap = rh.status;
         return false;
     }
+    st.layer = Cip::Status::Layer::OK;
     return true;
 }
 
 void EnipClient::close() {
     //
+    // Queue like reconnect() so a transaction in flight finishes on its fd before it goes
     //
-    //
+    up_.store(false, std::memory_order_relaxed);
+    acquire(Priority::HIGH);
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
     if (sock_ >= 0) {
         ::close(sock_);
         sock_ = -1;
         session_ = 0;
     }
+    xSemaphoreGive(fd_lock_);
+    release();
+}
+
+int64_t EnipClient::last_reply_us() const {
+    int64_t t;
+    reply_lock_.read([&] { t = last_reply_us_.load(); });
+    return t;
+}
+
+void EnipClient::note_reply(int64_t t_us) {
+    reply_lock_.write([&] { last_reply_us_.store(t_us); });
+}
+
+void EnipClient::abort() {
+    //
+    // shutdown() wakes a send/recv blocked on the socket without freeing the fd under its
+    // owner; the owner's drop() closes it. The standby rode the same dead link: closed.
+    //
+    up_.store(false, std::memory_order_relaxed);
+    xSemaphoreTake(fd_lock_, portMAX_DELAY);
+    if (sock_ >= 0)       ::shutdown(sock_, SHUT_RDWR);
+    if (probing_fd_ >= 0) ::shutdown(probing_fd_, SHUT_RDWR);
+    if (standby_fd_ >= 0) ::close(standby_fd_);
+    standby_fd_      = -1;
+    standby_session_ = 0;
+    xSemaphoreGive(fd_lock_);
+    ESP_LOGW(TAG, "%s:%u session aborted (link down)", ip_.c_str(), (unsigned)port_);
 }
 
-bool EnipClient::send_all(const void* data, size_t len) {
+bool EnipClient::send_all(int fd, const void* data, size_t len) {
     //
     //
     //
     const uint8_t* p = static_cast<const uint8_t*>(data);
     while (len) {
-        int n = ::send(sock_, p, len, 0);
+        int n = ::send(fd, p, len, 0);
         if (n <= 0) return false;
         p   += n;
         len -= (size_t)n;
@@ -140,13 +488,13 @@ bool EnipClient::send_all(const void* data, size_t len) {
     return true;
 }
 
-bool EnipClient::recv_all(void* data, size_t len) {
+bool EnipClient::recv_all(int fd, void* data, size_t len) {
     //
     //
     //
     uint8_t* p = static_cast<uint8_t*>(data);
     while (len) {
-        int n = ::recv(sock_, p, len, 0);
+        int n = ::recv(fd, p, len, 0);
         if (n <= 0) return false;
         p   += n;
         len -= (size_t)n;
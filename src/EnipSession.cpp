@@ -0,0 +1,262 @@
+// EnipSession.cpp
+// George Lake
+// Fall 2025
+//
+// Non-blocking ENIP session state machine
+// Refer to EnipSession.hpp for notes
+
+
+#include "EnipSession.hpp"
+
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+#include "esp_log.h"
+
+#include <cstring>
+#include <errno.h>
+#include <inttypes.h>
+
+namespace {
+    static const char* TAG = "ENIP_SESS";
+
+    constexpr size_t   HDR_LEN      = 24;
+    constexpr uint16_t CMD_REGISTER = 0x0065;
+    constexpr uint16_t CMD_SENDRR   = 0x006F;
+
+    uint16_t rd16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    uint32_t rd32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+    void wr16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+    void wr32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+} // Anonymous Namespace
+
+EnipSession::EnipSession(const std::string& ip, uint16_t port,
+                         uint32_t reply_timeout_ms, uint32_t reconnect_ms)
+    : ip_(ip), port_(port), reply_timeout_ms_(reply_timeout_ms), reconnect_ms_(reconnect_ms) {
+    rx_.resize(HDR_LEN);
+}
+
+EnipSession::~EnipSession() {
+    close();
+}
+
+void EnipSession::close() {
+    if (sock_ >= 0) ::close(sock_);
+    sock_    = -1;
+    session_ = 0;
+    tx_.clear();
+    tx_off_  = 0;
+    rx_have_ = 0;
+    if (state_ == State::BUSY) finish_request(false);
+    state_ = State::IDLE;
+}
+
+void EnipSession::start_connect(int64_t now_us) {
+    //
+    //
+    //
+    sock_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (sock_ < 0) { fail("socket() failed", now_us); return; }
+
+    int flags = ::fcntl(sock_, F_GETFL, 0);
+    ::fcntl(sock_, F_SETFL, flags | O_NONBLOCK);
+    int one = 1;
+    ::setsockopt(sock_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    sockaddr_in a{};
+    a.sin_family      = AF_INET;
+    a.sin_port        = htons(port_);
+    a.sin_addr.s_addr = inet_addr(ip_.c_str());
+
+    state_       = State::CONNECTING;
+    deadline_us_ = now_us + (int64_t)reply_timeout_ms_ * 1000;
+    if (::connect(sock_, (sockaddr*)&a, sizeof(a)) != 0 && errno != EINPROGRESS) {
+        fail("connect() failed", now_us);
+    }
+}
+
+void EnipSession::fail(const char* why, int64_t now_us) {
+    ESP_LOGW(TAG, "%s:%u %s (errno=%d); retry in %lu ms",
+             ip_.c_str(), (unsigned)port_, why, errno, (unsigned long)reconnect_ms_);
+    ++stats_.errors;
+    close();
+    state_       = State::BACKOFF;
+    deadline_us_ = now_us + (int64_t)reconnect_ms_ * 1000;
+}
+
+void EnipSession::finish_request(bool ok) {
+    done_    = true;
+    done_ok_ = ok;
+    if (state_ == State::BUSY) state_ = State::READY;
+}
+
+void EnipSession::queue_packet(uint16_t command, const uint8_t* body, size_t len) {
+    //
+    // Header + body appended to the transmit buffer (capacity is kept between requests)
+    //
+    size_t at = tx_.size();
+    tx_.resize(at + HDR_LEN + len);
+    uint8_t* h = &tx_[at];
+    std::memset(h, 0, HDR_LEN);
+    wr16(h + 0, command);
+    wr16(h + 2, (uint16_t)len);
+    wr32(h + 4, session_);
+    wr32(h + 12, (uint32_t)seq_);            // sender context
+    wr32(h + 16, (uint32_t)(seq_ >> 32));
+    if (len) std::memcpy(h + HDR_LEN, body, len);
+}
+
+bool EnipSession::flush_tx() {
+    while (tx_off_ < tx_.size()) {
+        ssize_t n = ::send(sock_, tx_.data() + tx_off_, tx_.size() - tx_off_, 0);
+        if (n > 0) { tx_off_ += (size_t)n; continue; }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    tx_.clear();
+    tx_off_ = 0;
+    return true;
+}
+
+bool EnipSession::read_rx(int64_t now_us) {
+    //
+    // Drain the socket; each complete packet is handled as it arrives
+    //
+    for (;;) {
+        size_t need = HDR_LEN;
+        if (rx_have_ >= HDR_LEN) need += rd16(&rx_[2]);
+        if (rx_.size() < need) rx_.resize(need);
+
+        ssize_t n = ::recv(sock_, &rx_[rx_have_], need - rx_have_, 0);
+        if (n == 0) return false;                   // peer closed
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        rx_have_ += (size_t)n;
+
+        if (rx_have_ == HDR_LEN && rd16(&rx_[2]) != 0) continue;   // body follows
+        if (rx_have_ == need) {
+            handle_packet(now_us);
+            rx_have_ = 0;
+            if (sock_ < 0) return true;             // handler failed the session
+        }
+    }
+}
+
+void EnipSession::handle_packet(int64_t now_us) {
+    //
+    //
+    //
+    const uint8_t* h    = rx_.data();
+    const uint16_t cmd  = rd16(h + 0);
+    const uint16_t len  = rd16(h + 2);
+    const uint32_t stat = rd32(h + 8);
+    const uint64_t ctx  = (uint64_t)rd32(h + 12) | ((uint64_t)rd32(h + 16) << 32);
+
+    if (state_ == State::REGISTERING) {
+        if (cmd != CMD_REGISTER || stat != 0) { fail("RegisterSession rejected", now_us); return; }
+        session_     = rd32(h + 4);
+        state_       = State::READY;
+        deadline_us_ = 0;
+        ++stats_.connects;
+        ESP_LOGI(TAG, "%s:%u session=0x%08" PRIX32, ip_.c_str(), (unsigned)port_, session_);
+        return;
+    }
+
+    if (state_ != State::BUSY || cmd != CMD_SENDRR || ctx != seq_) {
+        ++stats_.stale_replies;
+        return;
+    }
+    stats_.last_rtt_us = (uint32_t)(now_us - sent_us_);
+    deadline_us_ = 0;
+    if (stat != 0) {
+        ESP_LOGW(TAG, "%s:%u SendRRData status=0x%08" PRIX32, ip_.c_str(), (unsigned)port_, stat);
+        finish_request(false);
+        return;
+    }
+    reply_.assign(h + HDR_LEN, h + HDR_LEN + len);
+    ++stats_.replies;
+    finish_request(true);
+}
+
+void EnipSession::tick(int64_t now_us) {
+    //
+    //
+    //
+    switch (state_) {
+        case State::IDLE:
+            start_connect(now_us);
+            break;
+        case State::BACKOFF:
+            if (now_us >= deadline_us_) { state_ = State::IDLE; start_connect(now_us); }
+            break;
+        case State::CONNECTING:
+        case State::REGISTERING:
+            if (now_us >= deadline_us_) fail("connect timeout", now_us);
+            break;
+        case State::BUSY:
+            if (now_us >= deadline_us_) {
+                ++stats_.timeouts;
+                fail("reply timeout", now_us);
+            }
+            break;
+        case State::READY:
+            break;
+    }
+}
+
+bool EnipSession::submit(const std::vector<uint8_t>& rr, int64_t now_us) {
+    //
+    //
+    //
+    if (!ready()) return false;
+    ++seq_;
+    queue_packet(CMD_SENDRR, rr.data(), rr.size());
+    state_       = State::BUSY;
+    sent_us_     = now_us;
+    deadline_us_ = now_us + (int64_t)reply_timeout_ms_ * 1000;
+    ++stats_.requests;
+    if (!flush_tx()) fail("send() failed", now_us);
+    return true;
+}
+
+bool EnipSession::wants_read() const {
+    return sock_ >= 0 && (state_ == State::REGISTERING || state_ == State::READY || state_ == State::BUSY);
+}
+
+bool EnipSession::wants_write() const {
+    return sock_ >= 0 && (state_ == State::CONNECTING || tx_off_ < tx_.size());
+}
+
+void EnipSession::on_io(bool readable, bool writable, int64_t now_us) {
+    //
+    //
+    //
+    if (sock_ < 0) return;
+
+    if (state_ == State::CONNECTING && writable) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ::getsockopt(sock_, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0) { errno = err; fail("connect() failed", now_us); return; }
+
+        // RegisterSession: protocol version 1, no options
+        const uint8_t body[4] = {0x01, 0x00, 0x00, 0x00};
+        queue_packet(CMD_REGISTER, body, sizeof(body));
+        state_       = State::REGISTERING;
+        deadline_us_ = now_us + (int64_t)reply_timeout_ms_ * 1000;
+    }
+    if (writable || state_ == State::REGISTERING) {
+        if (!flush_tx()) { fail("send() failed", now_us); return; }
+    }
+    if (readable && !read_rx(now_us)) fail("connection closed", now_us);
+}
+
+int64_t EnipSession::next_deadline_us() const {
+    return state_ == State::READY ? 0 : deadline_us_;
+}
+
+bool EnipSession::take_reply(std::vector<uint8_t>& rr_body, bool& ok) {
+    if (!done_) return false;
+    done_ = false;
+    ok    = done_ok_;
+    if (ok) rr_body.swap(reply_);
+    return true;
+}
@@ -7,8 +7,22 @@
 #include "json_log.hpp"
 #include "json_encode.hpp"
 #include "iso8601.hpp"
+#include "FlashRingLog.hpp"
+#include "LogStream.hpp"
+#include "LatencyStats.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+#include "TimeSync.hpp"
+#include "MultiPlcMonitor.hpp"
+#include "ConnectionHealth.hpp"
+
+#include "SeqLock.hpp"
 
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
 #include <stdio.h>
 #include <string>
 #include <inttypes.h>
@@ -16,29 +30,261 @@
 namespace {
     static const char* TAG = "EXPERIMENT";
 
+    constexpr auto RELAXED = std::memory_order_relaxed;
+
+    // Metrics shared between audit_task (writer) and app_main / reporters (readers).
+    // Every field is a relaxed atomic; multi-field consistency comes from g_metrics_lock.
+    struct MetricsStore {
+        std::atomic<const char*> scenario_id{nullptr};
+        std::atomic<const char*> scenario_variant{nullptr};
+        std::atomic<int32_t>     trial_id{0};
+        std::atomic<bool>        change_expected{false};
+        std::atomic<const char*> change_type{nullptr};
+        std::atomic<uint32_t>    poll_period_ms{0};
+        std::atomic<const char*> esp_firmware_version{nullptr};
+        std::atomic<const char*> plc_firmware_version{nullptr};
+
+        std::atomic<uint32_t> authorized_audit_changes{0};
+        std::atomic<uint32_t> unauthorized_audit_changes{0};
+        std::atomic<uint32_t> authorized_pid_changes{0};
+        std::atomic<uint32_t> unauthorized_pid_changes{0};
+        std::atomic<uint32_t> read_failures{0};
+        std::atomic<uint32_t> comm_fault_intervals{0};
+
+        SeqLock::U64 baseline_established_ms;
+        SeqLock::U64 first_detection_ms;
+        SeqLock::U64 total_comm_fault_dur_ms;
+
+        // Comm fault interval state (only touched inside write sections)
+        bool    comm_fault_active   = false;
+        int64_t comm_fault_start_ms = 0;
+    };
+
     // Single global metrics instance for this firmware
-    ExperimentMetrics g_metrics;
+    MetricsStore g_store;
+    SeqLock      g_metrics_lock;
+
+    // Time sync state: PLC epoch at sync and ESP monotonic at sync
+    SeqLock::U64 g_plc_epoch_at_sync_ms;
+    SeqLock::U64 g_esp_ms_at_sync;
+    SeqLock      g_sync_lock;
+
+    inline void bump(std::atomic<uint32_t>& c) { c.store(c.load(RELAXED) + 1, RELAXED); }
+
+    void clear_counters(MetricsStore& m) {
+        m.authorized_audit_changes.store(0, RELAXED);
+        m.unauthorized_audit_changes.store(0, RELAXED);
+        m.authorized_pid_changes.store(0, RELAXED);
+        m.unauthorized_pid_changes.store(0, RELAXED);
+        m.read_failures.store(0, RELAXED);
+        m.comm_fault_intervals.store(0, RELAXED);
+        m.baseline_established_ms.store(-1);
+        m.first_detection_ms.store(-1);
+        m.total_comm_fault_dur_ms.store(0);
+        m.comm_fault_active   = false;
+        m.comm_fault_start_ms = 0;
+    }
+
+    ExperimentMetrics snapshot() {
+        ExperimentMetrics out;
+        g_metrics_lock.read([&] {
+            out.scenario_id                = g_store.scenario_id.load(RELAXED);
+            out.scenario_variant           = g_store.scenario_variant.load(RELAXED);
+            out.trial_id                   = g_store.trial_id.load(RELAXED);
+            out.change_expected            = g_store.change_expected.load(RELAXED);
+            out.change_type                = g_store.change_type.load(RELAXED);
+            out.poll_period_ms             = g_store.poll_period_ms.load(RELAXED);
+            out.esp_firmware_version       = g_store.esp_firmware_version.load(RELAXED);
+            out.plc_firmware_version       = g_store.plc_firmware_version.load(RELAXED);
+            out.authorized_audit_changes   = g_store.authorized_audit_changes.load(RELAXED);
+            out.unauthorized_audit_changes = g_store.unauthorized_audit_changes.load(RELAXED);
+            out.authorized_pid_changes     = g_store.authorized_pid_changes.load(RELAXED);
+            out.unauthorized_pid_changes   = g_store.unauthorized_pid_changes.load(RELAXED);
+            out.read_failures              = g_store.read_failures.load(RELAXED);
+            out.comm_fault_intervals       = g_store.comm_fault_intervals.load(RELAXED);
+            out.baseline_established_ms    = g_store.baseline_established_ms.load();
+            out.first_detection_ms         = g_store.first_detection_ms.load();
+            out.total_comm_fault_dur_ms    = g_store.total_comm_fault_dur_ms.load();
+        });
+        return out;
+    }
 
-    // Track whether currently in a "comm fault" interval
-    bool g_comm_fault_active = false;
-    int64_t g_comm_fault_start_ms = 0;
+    // Optional persistent copy of the JSONL stream
+    FlashRingLog* g_flash_log = nullptr;
 
-    // Time synce state: PLC epoch at sync and ESP monotonic at sync
-    int64_t g_plc_epoch_at_sync_ms  = -1;
-    int64_t g_esp_ms_at_sync        = 0;
+    // poll_seq of the last emitted poll record; auxiliary records reuse it so
+    // the flash ring index stays monotonic. Written by audit_task, read by every
+    // task that emits an auxiliary record. Same type as LogEntry::poll_seq (32 bits on
+    // the C6), so it stays lock-free where a 64-bit atomic would not (SeqLock.hpp).
+    std::atomic<long> g_last_poll_seq{0};
+
+    // Sends a non-poll JSONL record down the same sinks as emit_log_entry
+    void emit_aux_record(const std::string& json, int64_t t_ms) {
+        ESP_LOGI("JSON", "%s", json.c_str());
+        if (LogStream::running()) LogStream::submit(json.data(), json.size());
+        if (g_flash_log) g_flash_log->append(g_last_poll_seq.load(RELAXED), t_ms, json.data(), json.size());
+    }
 
     inline int64_t now_ms() {
+        int64_t synced_ms = 0;
+        if (TimeSync::plc_now_ms(synced_ms)) return synced_ms;
+
         int64_t esp_ms = EpochTime::espNowMs();
-        if (g_plc_epoch_at_sync_ms >= 0) {
-            return g_plc_epoch_at_sync_ms + (esp_ms - g_esp_ms_at_sync);
+        int64_t plc_at_sync = -1, esp_at_sync = 0;
+        g_sync_lock.read([&] {
+            plc_at_sync = g_plc_epoch_at_sync_ms.load();
+            esp_at_sync = g_esp_ms_at_sync.load();
+        });
+        if (plc_at_sync >= 0) {
+            return plc_at_sync + (esp_ms - esp_at_sync);
         }
         return esp_ms;
     }
 
-    // Helper: set first_detection_ms if not set yet
-    void mark_first_detection_if_needed() {
-        if (g_metrics.first_detection_ms < 0) {
-            g_metrics.first_detection_ms = now_ms();
+    // Experiment time of an earlier esp_timer instant
+    int64_t ms_at(int64_t at_us) {
+        int64_t t = now_ms();
+        if (at_us >= 0) t -= (esp_timer_get_time() - at_us) / 1000;
+        return t;
+    }
+
+    // CSV line from the live metrics (same column layout as the EVENT lines)
+    void log_event_csv(const char* kind, const char* event, int authorized, int64_t t) {
+        ExperimentMetrics m = snapshot();
+        ESP_LOGI(TAG,
+                "%s,%lld,%s,%s,%d,"
+                "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
+                kind,
+                (long long)t,
+                m.scenario_id ? m.scenario_id : "(null)",
+                event,
+                authorized,
+                m.authorized_audit_changes,
+                m.unauthorized_audit_changes,
+                m.authorized_pid_changes,
+                m.unauthorized_pid_changes,
+                m.read_failures,
+                m.comm_fault_intervals,
+                (long long)m.baseline_established_ms,
+                (long long)m.first_detection_ms,
+                (long long)m.total_comm_fault_dur_ms);
+    }
+
+    // ------------------------------------------------------------------------------------------
+    // Event ring: record_* push here and return; event_logger_task formats off the polling path
+    constexpr uint32_t EVENT_RING_LEN = 64;     // power of two
+
+    ExperimentEvent       g_events[EVENT_RING_LEN];
+    std::atomic<uint32_t> g_event_head{0};      // total events pushed
+    std::atomic<uint32_t> g_events_dropped{0};
+    portMUX_TYPE          g_event_mux = portMUX_INITIALIZER_UNLOCKED;
+    TaskHandle_t          g_event_task = nullptr;
+
+    const char* event_name(ExperimentEventType t) {
+        switch (t) {
+        case ExperimentEventType::BASELINE:         return "BASELINE";
+        case ExperimentEventType::AUDIT:            return "AUDIT";
+        case ExperimentEventType::PID:              return "PID";
+        case ExperimentEventType::READ_FAIL:        return "READ_FAIL";
+        case ExperimentEventType::COMM_FAULT_START: return "COMM_FAULT_START";
+        case ExperimentEventType::COMM_FAULT_END:   return "COMM_FAULT_END";
+        }
+        return "?";
+    }
+
+    // Fills the counter snapshot; call inside g_metrics_lock.write()
+    void fill_event_counters(ExperimentEvent& e) {
+        e.authorized_audit_changes   = g_store.authorized_audit_changes.load(RELAXED);
+        e.unauthorized_audit_changes = g_store.unauthorized_audit_changes.load(RELAXED);
+        e.authorized_pid_changes     = g_store.authorized_pid_changes.load(RELAXED);
+        e.unauthorized_pid_changes   = g_store.unauthorized_pid_changes.load(RELAXED);
+        e.read_failures              = g_store.read_failures.load(RELAXED);
+        e.comm_fault_intervals       = g_store.comm_fault_intervals.load(RELAXED);
+        e.baseline_established_ms    = g_store.baseline_established_ms.load();
+        e.first_detection_ms         = g_store.first_detection_ms.load();
+        e.total_comm_fault_dur_ms    = g_store.total_comm_fault_dur_ms.load();
+    }
+
+    void push_event(ExperimentEvent& e) {
+        portENTER_CRITICAL(&g_event_mux);
+        uint32_t head = g_event_head.load(RELAXED);
+        e.seq = head;
+        g_events[head & (EVENT_RING_LEN - 1)] = e;
+        g_event_head.store(head + 1, std::memory_order_release);
+        portEXIT_CRITICAL(&g_event_mux);
+        if (g_event_task) xTaskNotifyGive(g_event_task);
+    }
+
+    // Updates metrics via fn (inside the write section) and queues the resulting event
+    template <typename Fn>
+    void record_event(ExperimentEventType type, int authorized, int64_t t, Fn&& fn) {
+        ExperimentEvent e{};
+        e.t_ms       = t;
+        e.type       = type;
+        e.authorized = (int8_t)authorized;
+        bool emit = true;
+        g_metrics_lock.write([&] {
+            emit = fn();
+            fill_event_counters(e);
+        });
+        if (emit) push_event(e);
+    }
+
+    void format_event(const ExperimentEvent& e) {
+        const char* scenario = g_store.scenario_id.load(RELAXED);
+        switch (e.type) {
+        case ExperimentEventType::BASELINE:
+            ESP_LOGI(TAG, "Baselines established at t=%lld ms", (long long)e.t_ms);
+            break;
+        case ExperimentEventType::COMM_FAULT_START:
+            ESP_LOGW(TAG, "COMM_FAULT_START at t = %lld ms", (long long)e.t_ms);
+            break;
+        case ExperimentEventType::COMM_FAULT_END:
+            ESP_LOGW(TAG, "COMM_FAULT_END at t=%lld ms (total=%lld ms)",
+                     (long long)e.t_ms, (long long)e.total_comm_fault_dur_ms);
+            break;
+        default:
+            break;
+        }
+        ESP_LOGI(TAG,
+                "EVENT,%lld,%s,%s,%d,"
+                "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
+                (long long)e.t_ms,
+                scenario ? scenario : "(null)",
+                event_name(e.type),
+                (int)e.authorized,
+                e.authorized_audit_changes,
+                e.unauthorized_audit_changes,
+                e.authorized_pid_changes,
+                e.unauthorized_pid_changes,
+                e.read_failures,
+                e.comm_fault_intervals,
+                (long long)e.baseline_established_ms,
+                (long long)e.first_detection_ms,
+                (long long)e.total_comm_fault_dur_ms);
+    }
+
+    void event_logger_task(void*) {
+        uint32_t tail = g_event_head.load(std::memory_order_acquire);
+        tail = tail > EVENT_RING_LEN ? tail - EVENT_RING_LEN : 0;   // backlog from before start
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+            CpuProfiler::count_wake();
+            for (;;) {
+                ExperimentEvent e;
+                portENTER_CRITICAL(&g_event_mux);
+                uint32_t head = g_event_head.load(RELAXED);
+                if (head - tail > EVENT_RING_LEN) {
+                    g_events_dropped.fetch_add(head - tail - EVENT_RING_LEN, RELAXED);
+                    tail = head - EVENT_RING_LEN;
+                }
+                bool have = tail != head;
+                if (have) e = g_events[tail & (EVENT_RING_LEN - 1)];
+                portEXIT_CRITICAL(&g_event_mux);
+                if (!have) break;
+                ++tail;
+                format_event(e);
+            }
         }
     }
 } // anonymous namespace
@@ -51,19 +297,23 @@ namespace Experiment {
                     const char* change_type,
                     uint32_t    poll_period_ms) {
             // Initialize metrics and scenario label
-            g_metrics = ExperimentMetrics{};
-            g_metrics.scenario_id           = scenario_id;
-            g_comm_fault_active             = false;
-            g_comm_fault_start_ms           = 0;
-            g_metrics.scenario_variant      = scenario_variant;
-            g_metrics.trial_id              = trial_id;
-            g_metrics.change_expected       = change_expected;
-            g_metrics.change_type           = change_type;
-            g_metrics.poll_period_ms        = poll_period_ms;
-
-            // Firmware version (UPDATE WITH ACTUAL)
-            g_metrics.esp_firmware_version = "v11.11.11";
-            g_metrics.plc_firmware_version = "37.11.11";
+            g_metrics_lock.write([&] {
+                clear_counters(g_store);
+                g_store.scenario_id.store(scenario_id, RELAXED);
+                g_store.scenario_variant.store(scenario_variant, RELAXED);
+                g_store.trial_id.store(trial_id, RELAXED);
+                g_store.change_expected.store(change_expected, RELAXED);
+                g_store.change_type.store(change_type, RELAXED);
+                g_store.poll_period_ms.store(poll_period_ms, RELAXED);
+
+                // Firmware version (UPDATE WITH ACTUAL)
+                g_store.esp_firmware_version.store("v11.11.11", RELAXED);
+                g_store.plc_firmware_version.store("37.11.11", RELAXED);
+            });
+            g_sync_lock.write([] {
+                g_plc_epoch_at_sync_ms.store(-1);
+                g_esp_ms_at_sync.store(0);
+            });
 
             ESP_LOGI(TAG, "Experiment initialized (scenario='%s')", scenario_id ? scenario_id : "(null)");
 
@@ -75,18 +325,33 @@ namespace Experiment {
         }
 
         void reset_metrics() {
-            const char* id = g_metrics.scenario_id;
-            g_metrics = ExperimentMetrics{};
-            g_metrics.scenario_id = id;
-            g_comm_fault_active = false;
-            g_comm_fault_start_ms = 0;
+            // Counters and timings only; the scenario labels stay as set by init()
+            g_metrics_lock.write([] { clear_counters(g_store); });
+            LatencyStats::reset();
 
+            const char* id = g_store.scenario_id.load(RELAXED);
             ESP_LOGI(TAG, "Experiment metrics reset (scenario='%s')", id ? id : "(null)");
         }
 
+        void set_firmware_versions(const char* esp_version, const char* plc_version) {
+            g_metrics_lock.write([&] {
+                if (esp_version) g_store.esp_firmware_version.store(esp_version, RELAXED);
+                if (plc_version) g_store.plc_firmware_version.store(plc_version, RELAXED);
+            });
+        }
+
+        void set_trial(int trial_id, uint32_t poll_period_ms) {
+            g_metrics_lock.write([&] {
+                g_store.trial_id.store(trial_id, RELAXED);
+                g_store.poll_period_ms.store(poll_period_ms, RELAXED);
+            });
+        }
+
         void set_time_sync(int64_t plc_epoch_ms_at_sync, int64_t esp_ms_at_sync) {
-            g_plc_epoch_at_sync_ms  = plc_epoch_ms_at_sync;
-            g_esp_ms_at_sync        = esp_ms_at_sync;
+            g_sync_lock.write([&] {
+                g_plc_epoch_at_sync_ms.store(plc_epoch_ms_at_sync);
+                g_esp_ms_at_sync.store(esp_ms_at_sync);
+            });
 
             ESP_LOGI(TAG,
                         "Time sync set: plc_epoch_ms=%lld esp_ms=%lld",
@@ -95,178 +360,133 @@ namespace Experiment {
         }
 
         void mark_baseline_established() {
-            g_metrics.baseline_established_ms = now_ms();
-            ESP_LOGI(TAG, "Baselines established at t=%lld ms",
-                    (long long)g_metrics.baseline_established_ms);
-
-            ESP_LOGI(TAG,
-                    "EVENT,%lld,%s,BASELINE,-1,"
-                    "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                    (long long)g_metrics.baseline_established_ms,
-                    g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                    g_metrics.authorized_audit_changes,
-                    g_metrics.unauthorized_audit_changes,
-                    g_metrics.authorized_pid_changes,
-                    g_metrics.unauthorized_pid_changes,
-                    g_metrics.read_failures,
-                    g_metrics.comm_fault_intervals,
-                    (long long)g_metrics.baseline_established_ms,
-                    (long long)g_metrics.first_detection_ms,
-                    (long long)g_metrics.total_comm_fault_dur_ms);
+            int64_t t = now_ms();
+            record_event(ExperimentEventType::BASELINE, -1, t, [&] {
+                g_store.baseline_established_ms.store(t);
+                return true;
+            });
         }
 
         void record_audit_change(bool authorized) {
-            if (authorized) {
-                ++g_metrics.authorized_audit_changes;
-            } else {
-                ++g_metrics.unauthorized_audit_changes;
-            }
-            mark_first_detection_if_needed();
-
             int64_t t = now_ms();
-            ESP_LOGI(TAG,
-                    "EVENT,%lld,%s,AUDIT,%d,"
-                    "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                    (long long)t,
-                    g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                    authorized ? 1 : 0,
-                    g_metrics.authorized_audit_changes,
-                    g_metrics.unauthorized_audit_changes,
-                    g_metrics.authorized_pid_changes,
-                    g_metrics.unauthorized_pid_changes,
-                    g_metrics.read_failures,
-                    g_metrics.comm_fault_intervals,
-                    (long long)g_metrics.baseline_established_ms,
-                    (long long)g_metrics.first_detection_ms,
-                    (long long)g_metrics.total_comm_fault_dur_ms);
+            record_event(ExperimentEventType::AUDIT, authorized ? 1 : 0, t, [&] {
+                bump(authorized ? g_store.authorized_audit_changes : g_store.unauthorized_audit_changes);
+                if (g_store.first_detection_ms.load() < 0) g_store.first_detection_ms.store(t);
+                return true;
+            });
         }
 
         void record_pid_change(bool authorized) {
-            if (authorized) {
-                ++g_metrics.authorized_pid_changes;
-            } else {
-                ++g_metrics.unauthorized_pid_changes;
-            }
-            mark_first_detection_if_needed();
-
             int64_t t = now_ms();
-            ESP_LOGI(TAG,
-                    "EVENT,%lld,%s,PID,%d,"
-                    "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                    (long long)t,
-                    g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                    authorized ? 1 : 0,
-                    g_metrics.authorized_audit_changes,
-                    g_metrics.unauthorized_audit_changes,
-                    g_metrics.authorized_pid_changes,
-                    g_metrics.unauthorized_pid_changes,
-                    g_metrics.read_failures,
-                    g_metrics.comm_fault_intervals,
-                    (long long)g_metrics.baseline_established_ms,
-                    (long long)g_metrics.first_detection_ms,
-                    (long long)g_metrics.total_comm_fault_dur_ms);
+            record_event(ExperimentEventType::PID, authorized ? 1 : 0, t, [&] {
+                bump(authorized ? g_store.authorized_pid_changes : g_store.unauthorized_pid_changes);
+                if (g_store.first_detection_ms.load() < 0) g_store.first_detection_ms.store(t);
+                return true;
+            });
         }
 
         void record_read_failure() {
-            ++g_metrics.read_failures;
-
             int64_t t = now_ms();
-            ESP_LOGI(TAG,
-                "EVENT,%lld,%s,READ_FAIL,-1,"
-                "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                (long long)t,
-                g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                g_metrics.authorized_audit_changes,
-                g_metrics.unauthorized_audit_changes,
-                g_metrics.authorized_pid_changes,
-                g_metrics.unauthorized_pid_changes,
-                g_metrics.read_failures,
-                g_metrics.comm_fault_intervals,
-                (long long)g_metrics.baseline_established_ms,
-                (long long)g_metrics.first_detection_ms,
-                (long long)g_metrics.total_comm_fault_dur_ms);
+            record_event(ExperimentEventType::READ_FAIL, -1, t, [] {
+                bump(g_store.read_failures);
+                return true;
+            });
         }
 
-        void record_comm_fault_start() {
-            if (g_comm_fault_active) return; // already in fault
-            g_comm_fault_active = true;
-            g_comm_fault_start_ms = now_ms();
-            ++g_metrics.comm_fault_intervals;
-            ESP_LOGW(TAG, "COMM_FAULT_START at t = %lld ms", (long long)g_comm_fault_start_ms);
+        void record_comm_fault_start(int64_t at_us) {
+            int64_t t = ms_at(at_us);
+            record_event(ExperimentEventType::COMM_FAULT_START, -1, t, [&] {
+                if (g_store.comm_fault_active) return false;  // already in fault
+                g_store.comm_fault_active   = true;
+                g_store.comm_fault_start_ms = t;
+                bump(g_store.comm_fault_intervals);
+                return true;
+            });
+        }
 
-            ESP_LOGI(TAG,
-                "EVENT,%lld,%s,COMM_FAULT_START,-1,"
-                "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                (long long)g_comm_fault_start_ms,
-                g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                g_metrics.authorized_audit_changes,
-                g_metrics.unauthorized_audit_changes,
-                g_metrics.authorized_pid_changes,
-                g_metrics.unauthorized_pid_changes,
-                g_metrics.read_failures,
-                g_metrics.comm_fault_intervals,
-                (long long)g_metrics.baseline_established_ms,
-                (long long)g_metrics.first_detection_ms,
-                (long long)g_metrics.total_comm_fault_dur_ms);
+        void record_comm_fault_end(int64_t at_us) {
+            int64_t end_ms = ms_at(at_us);
+            record_event(ExperimentEventType::COMM_FAULT_END, -1, end_ms, [&] {
+                if (!g_store.comm_fault_active) return false;
+                g_store.comm_fault_active = false;
+                int64_t start_ms = g_store.comm_fault_start_ms;
+                if (end_ms > start_ms) {
+                    g_store.total_comm_fault_dur_ms.store(
+                        g_store.total_comm_fault_dur_ms.load() + (end_ms - start_ms));
+                }
+                return true;
+            });
         }
 
-        void record_comm_fault_end() {
-            if (!g_comm_fault_active) return;
-            int64_t end_ms = now_ms();
-            g_comm_fault_active = false;
+        void start_event_logger() {
+            if (g_event_task) return;
+            xTaskCreate(event_logger_task, "exp_events", 3072, nullptr, 2, &g_event_task);
+            MemStats::watch_task(g_event_task, 3072);
+        }
 
-            if (end_ms > g_comm_fault_start_ms) {
-                g_metrics.total_comm_fault_dur_ms += (end_ms - g_comm_fault_start_ms);
+        size_t recent_events(ExperimentEvent* out, size_t max_n) {
+            portENTER_CRITICAL(&g_event_mux);
+            uint32_t head = g_event_head.load(RELAXED);
+            uint32_t n = head < EVENT_RING_LEN ? head : EVENT_RING_LEN;
+            if (max_n < n) n = (uint32_t)max_n;
+            for (uint32_t i = 0; i < n; ++i) {
+                out[i] = g_events[(head - n + i) & (EVENT_RING_LEN - 1)];
             }
-            ESP_LOGW(TAG, "COMM_FAULT_END at t=%lld ms (interval=%lld ms)", (long long)end_ms, (long long)(end_ms - g_comm_fault_start_ms));
+            portEXIT_CRITICAL(&g_event_mux);
+            return n;
+        }
 
-            ESP_LOGI(TAG,
-                "EVENT,%lld,%s,COMM_FAULT_END,-1,"
-                "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                (long long)end_ms,
-                g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                g_metrics.authorized_audit_changes,
-                g_metrics.unauthorized_audit_changes,
-                g_metrics.authorized_pid_changes,
-                g_metrics.unauthorized_pid_changes,
-                g_metrics.read_failures,
-                g_metrics.comm_fault_intervals,
-                (long long)g_metrics.baseline_established_ms,
-                (long long)g_metrics.first_detection_ms,
-                (long long)g_metrics.total_comm_fault_dur_ms);
+        uint32_t dropped_events() {
+            return g_events_dropped.load(RELAXED);
         }
 
         void fill_log_entry_context(LogEntry& entry) {
+            const ExperimentMetrics m = snapshot();
+
             // Scenario context
-            entry.scenario_id      = g_metrics.scenario_id      ? g_metrics.scenario_id : "";
-            entry.scenario_variant = g_metrics.scenario_variant ? g_metrics.scenario_variant : "";
-            entry.trial_id         = std::to_string(g_metrics.trial_id);
-            entry.change_expected  = g_metrics.change_expected;
-            entry.change_type      = g_metrics.change_type      ? g_metrics.change_type : "";
+            entry.scenario_id      = m.scenario_id      ? m.scenario_id : "";
+            entry.scenario_variant = m.scenario_variant ? m.scenario_variant : "";
+            entry.trial_id         = std::to_string(m.trial_id);
+            entry.change_expected  = m.change_expected;
+            entry.change_type      = m.change_type      ? m.change_type : "";
 
             // Timing: poll_seq will be set by the caller; timestamps here
             int64_t ms = now_ms();
             entry.esp32_timestamp_ms  = static_cast<long>(ms);
-            entry.esp32_timestamp_iso = make_iso8601_from_millis(ms);
+            char iso[ISO8601_MS_LEN + 1];
+            entry.esp32_timestamp_iso.assign(iso, format_iso8601_from_millis(ms, iso, sizeof(iso)));
 
             // PLC time – not yet wired per-poll; mark as NA for now
             entry.plc_time.plc_timestamp_ms  = -1;
             entry.plc_time.plc_timestamp_iso = "NA";
 
             // Metadata
-            entry.metadata.poll_period_ms       = g_metrics.poll_period_ms;
-            entry.metadata.esp_firmware_version = g_metrics.esp_firmware_version ? g_metrics.esp_firmware_version : "";
-            entry.metadata.plc_firmware_version = g_metrics.plc_firmware_version ? g_metrics.plc_firmware_version : "";
+            entry.metadata.poll_period_ms       = m.poll_period_ms;
+            entry.metadata.esp_firmware_version = m.esp_firmware_version ? m.esp_firmware_version : "";
+            entry.metadata.plc_firmware_version = m.plc_firmware_version ? m.plc_firmware_version : "";
         }
 
         void emit_log_entry(const LogEntry& entry) {
             std::string json = encode_log_to_json(entry);
             ESP_LOGI("JSON", "%s", json.c_str());
+
+            g_last_poll_seq.store(entry.poll_seq, RELAXED);
+            if (LogStream::running()) {
+                LogStream::submit(json.data(), json.size());
+            }
+            if (g_flash_log) {
+                g_flash_log->append(entry.poll_seq, entry.esp32_timestamp_ms, json.data(), json.size());
+            }
+        }
+
+        void attach_flash_log(FlashRingLog* log) {
+            g_flash_log = log;
         }
 
         void dump_summary() {
             int64_t t = now_ms();
-            
+            const ExperimentMetrics m = snapshot();
+
             ESP_LOGI(TAG,
                 "Scenario='%s' Metrics: "
                 "auth_audit=%" PRIu32 " unauth_audit=%" PRIu32 " "
@@ -274,37 +494,80 @@ namespace Experiment {
                 "read_fail=%" PRIu32 " comm_faults=%" PRIu32 " "
                 "baseline_ms=%lld first_det_ms=%lld "
                 "comm_fault_total_ms=%lld",
-                g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                g_metrics.authorized_audit_changes,
-                g_metrics.unauthorized_audit_changes,
-                g_metrics.authorized_pid_changes,
-                g_metrics.unauthorized_pid_changes,
-                g_metrics.read_failures,
-                g_metrics.comm_fault_intervals,
-                (long long)g_metrics.baseline_established_ms,
-                (long long)g_metrics.first_detection_ms,
-                (long long)g_metrics.total_comm_fault_dur_ms);
-
-                
+                m.scenario_id ? m.scenario_id : "(null)",
+                m.authorized_audit_changes,
+                m.unauthorized_audit_changes,
+                m.authorized_pid_changes,
+                m.unauthorized_pid_changes,
+                m.read_failures,
+                m.comm_fault_intervals,
+                (long long)m.baseline_established_ms,
+                (long long)m.first_detection_ms,
+                (long long)m.total_comm_fault_dur_ms);
+
             // CSV summary line
-            ESP_LOGI(TAG,
-                "SUMMARY,%lld,%s,-1,-1,"
-                "%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%lld,%lld,%lld",
-                (long long)t,
-                g_metrics.scenario_id ? g_metrics.scenario_id : "(null)",
-                g_metrics.authorized_audit_changes,
-                g_metrics.unauthorized_audit_changes,
-                g_metrics.authorized_pid_changes,
-                g_metrics.unauthorized_pid_changes,
-                g_metrics.read_failures,
-                g_metrics.comm_fault_intervals,
-                (long long)g_metrics.baseline_established_ms,
-                (long long)g_metrics.first_detection_ms,
-                (long long)g_metrics.total_comm_fault_dur_ms);
+            log_event_csv("SUMMARY", "-1", -1, t);
+
+            uint32_t dropped = dropped_events();
+            if (dropped) ESP_LOGW(TAG, "Event ring overflow: %" PRIu32 " events not logged", dropped);
+
+            // Per-stage / per-tag read latency (RQ2)
+            LatencyStats::log_summary(TAG);
+            TimeSync::Status ts = TimeSync::status();
+            if (ts.synced) {
+                ESP_LOGI(TAG, "TIME offset=%lldus skew=%.2fppm err=%lldus samples=%lu rejected=%lu fail=%lu rtt=%lu/%luus src=%s",
+                         (long long)ts.offset_us, ts.skew_ppm, (long long)ts.last_error_us,
+                         (unsigned long)ts.samples, (unsigned long)ts.rejected, (unsigned long)ts.failures,
+                         (unsigned long)ts.last_rtt_us, (unsigned long)ts.min_rtt_us,
+                         ts.wall_clock_ok ? "wallclock" : "datetime");
+            }
+            for (const std::string& rec : LatencyStats::export_json(t)) emit_aux_record(rec, t);
+            if (MultiPlcMonitor::running()) MultiPlcMonitor::log_summary(TAG);
+            if (ConnectionHealth::running()) ConnectionHealth::log_summary(TAG);
+
+            // Heap / stack headroom (sizing evidence)
+            MemStats::sample_heap(t);
+            MemStats::log_summary(TAG);
+            emit_aux_record(MemStats::export_json(t), t);
+
+            // Per-task CPU share over the profiler's last window
+            if (CpuProfiler::running()) {
+                CpuProfiler::log_summary(TAG);
+                std::string cpu = CpuProfiler::export_json(t);
+                if (!cpu.empty()) emit_aux_record(cpu, t);
+            }
+
+            // The ring writes its partial page on its own flush_interval_ms, not per summary
+            if (g_flash_log) {
+                FlashRingLog::Stats fs = g_flash_log->stats();
+                ESP_LOGI(TAG,
+                    "Ring log: appended=%" PRIu32 " rejected=%" PRIu32 " pages=%" PRIu32 " "
+                    "rotations=%" PRIu32 " crc_err=%" PRIu32 " seq=[%lld..%lld]",
+                    fs.records_appended, fs.records_rejected, fs.pages_written,
+                    fs.segment_rotations, fs.crc_errors,
+                    (long long)fs.oldest_seq, (long long)fs.newest_seq);
+            }
+
+            if (LogStream::running()) {
+                LogStream::Stats ls = LogStream::stats();
+                ESP_LOGI(TAG,
+                    "Log stream: submitted=%" PRIu32 " dropped=%" PRIu32 " batches=%" PRIu32 " "
+                    "bytes=%" PRIu32 " send_err=%" PRIu32 " connects=%" PRIu32 " oversize=%" PRIu32 " split=%" PRIu32,
+                    ls.submitted, ls.dropped, ls.batches_sent,
+                    ls.bytes_sent, ls.send_errors, ls.connects, ls.oversize, ls.split);
+            }
+        }
+
+        ExperimentMetrics current() {
+            return snapshot();
+        }
+
+        int64_t timestamp_ms() {
+            return now_ms();
         }
 
-        const ExperimentMetrics& current() {
-            return g_metrics;
+        void emit_record(const std::string& json, int64_t t_ms) {
+            if (!json.empty()) emit_aux_record(json, t_ms);
         }
 
 } // namespace Experiment
\ No newline at end of file
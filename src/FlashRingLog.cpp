@@ -0,0 +1,439 @@
+// FlashRingLog.cpp
+// George Lake
+// Fall 2025
+//
+// Segmented, CRC-protected ring log on flash
+// Refer to FlashRingLog.hpp for the on-disk layout
+
+
+#include "FlashRingLog.hpp"
+#include "EpochTime.hpp"
+
+#include "esp_log.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_littlefs.h"
+#endif
+
+namespace {
+    static const char* TAG = "RINGLOG";
+
+    constexpr uint32_t SEG_MAGIC    = 0x534C5246;  // "FRLS"
+    constexpr uint16_t SEG_VERSION  = 1;
+    constexpr size_t   SEG_HDR_LEN  = 16;
+    constexpr uint16_t REC_MAGIC    = 0xA55A;
+    constexpr size_t   REC_HDR_LEN  = 24;
+
+    // CRC-32 (IEEE 802.3, reflected), table generated at compile time
+    constexpr std::array<uint32_t, 256> make_crc_table() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            t[i] = c;
+        }
+        return t;
+    }
+    constexpr std::array<uint32_t, 256> CRC_TABLE = make_crc_table();
+
+    uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+        crc = ~crc;
+        while (n--) crc = CRC_TABLE[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    template <typename T> inline void put(uint8_t* p, T v) { std::memcpy(p, &v, sizeof(T)); }
+    template <typename T> inline T    get(const uint8_t* p) { T v; std::memcpy(&v, p, sizeof(T)); return v; }
+
+    // Walks the valid records of one page; fn returns false to stop early.
+    // Returns false if a CRC mismatch ended the walk.
+    template <typename Fn>
+    bool for_each_record(const uint8_t* page, size_t page_bytes, Fn&& fn) {
+        size_t off = 0;
+        while (off + REC_HDR_LEN <= page_bytes) {
+            const uint8_t* r = page + off;
+            if (get<uint16_t>(r) != REC_MAGIC) return true;        // padding: end of page
+            uint16_t len = get<uint16_t>(r + 2);
+            if (off + REC_HDR_LEN + len > page_bytes) return true;
+            if (crc32(r + 8, 16 + len) != get<uint32_t>(r + 4)) return false;
+            FlashRingLog::Record rec{get<int64_t>(r + 8), get<int64_t>(r + 16), r + REC_HDR_LEN, len};
+            if (!fn(rec)) return true;
+            off += REC_HDR_LEN + len;
+        }
+        return true;
+    }
+
+    struct Lock {
+        explicit Lock(SemaphoreHandle_t m) : m_(m) { xSemaphoreTake(m_, portMAX_DELAY); }
+        ~Lock() { xSemaphoreGive(m_); }
+        SemaphoreHandle_t m_;
+    };
+} // Anonymous Namespace
+
+bool FlashRingLog::mount_storage(const char* mount_point, const char* partition_label) {
+    //
+    // ESP: LittleFS via VFS. Host: ordinary directory.
+    //
+#ifdef ESP_PLATFORM
+    esp_vfs_littlefs_conf_t conf{};
+    conf.base_path              = mount_point;
+    conf.partition_label        = partition_label;
+    conf.format_if_mount_failed = true;
+    conf.dont_mount             = false;
+    esp_err_t err = esp_vfs_littlefs_register(&conf);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "LittleFS mount failed (%s)", esp_err_to_name(err));
+        return false;
+    }
+    size_t total = 0, used = 0;
+    if (esp_littlefs_info(partition_label, &total, &used) == ESP_OK) {
+        ESP_LOGI(TAG, "LittleFS mounted at %s: %u/%u bytes used",
+                 mount_point, (unsigned)used, (unsigned)total);
+    }
+    return true;
+#else
+    (void)partition_label;
+    if (::mkdir(mount_point, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "mkdir(%s) errno=%d", mount_point, errno);
+        return false;
+    }
+    return true;
+#endif
+}
+
+FlashRingLog::FlashRingLog() : lock_(xSemaphoreCreateMutex()) {}
+
+FlashRingLog::~FlashRingLog() {
+    close();
+    if (lock_) vSemaphoreDelete(lock_);
+}
+
+std::string FlashRingLog::seg_path(uint32_t idx) const {
+    char name[16];
+    std::snprintf(name, sizeof(name), "/seg_%02u.bin", (unsigned)idx);
+    return cfg_.base_path + name;
+}
+
+bool FlashRingLog::open(const Config& cfg) {
+    //
+    // Scan every segment, rebuild the page index, pick the newest as active
+    //
+    close();
+    Lock l(lock_);
+
+    if (cfg.segment_count < 2 || cfg.pages_per_seg == 0 ||
+        cfg.page_bytes <= REC_HDR_LEN || cfg.page_bytes > 0xFFFF) {
+        ESP_LOGE(TAG, "Invalid ring config");
+        return false;
+    }
+    cfg_ = cfg;
+    stats_ = Stats{};
+
+    if (::mkdir(cfg_.base_path.c_str(), 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "mkdir(%s) errno=%d", cfg_.base_path.c_str(), errno);
+        return false;
+    }
+
+    segs_.assign(cfg_.segment_count, Segment{});
+    page_.assign(cfg_.page_bytes, 0xFF);
+    page_fill_ = 0;
+    page_dirty_ = false;
+    page_first_unflushed_ms_ = -1;
+
+    uint32_t newest_gen = 0;
+    next_generation_ = 1;
+    for (uint32_t i = 0; i < cfg_.segment_count; ++i) {
+        scan_segment(i);
+        if (segs_[i].generation > newest_gen) {
+            newest_gen = segs_[i].generation;
+            active_ = i;
+        }
+    }
+
+    if (newest_gen == 0) {
+        if (!start_segment(0, next_generation_++)) return false;
+    } else {
+        next_generation_ = newest_gen + 1;
+        seg_file_ = std::fopen(seg_path(active_).c_str(), "r+b");
+        if (!seg_file_) {
+            ESP_LOGE(TAG, "Cannot open %s", seg_path(active_).c_str());
+            return false;
+        }
+    }
+
+    // Continue on a fresh page after whatever the active segment already holds
+    cur_page_ = segs_[active_].pages_used;
+    open_ = true;
+
+    ESP_LOGI(TAG, "Ring opened: %u segs x %u pages x %u B, active=%u page=%u",
+             (unsigned)cfg_.segment_count, (unsigned)cfg_.pages_per_seg,
+             (unsigned)cfg_.page_bytes, (unsigned)active_, (unsigned)cur_page_);
+    return true;
+}
+
+void FlashRingLog::close() {
+    if (!open_) return;
+    flush();
+    Lock l(lock_);
+    open_ = false;
+    if (seg_file_) std::fclose(seg_file_);
+    seg_file_ = nullptr;
+    segs_.clear();
+    page_.clear();
+}
+
+bool FlashRingLog::scan_segment(uint32_t idx) {
+    //
+    // Validate the header, then index every page holding at least one good record
+    //
+    Segment& s = segs_[idx];
+    s = Segment{};
+    s.pages.assign(cfg_.pages_per_seg, PageIndex{});
+
+    FILE* f = std::fopen(seg_path(idx).c_str(), "rb");
+    if (!f) return false;
+
+    uint8_t hdr[SEG_HDR_LEN];
+    if (std::fread(hdr, 1, SEG_HDR_LEN, f) != SEG_HDR_LEN ||
+        get<uint32_t>(hdr) != SEG_MAGIC ||
+        get<uint16_t>(hdr + 4) != SEG_VERSION ||
+        get<uint16_t>(hdr + 6) != cfg_.page_bytes ||
+        crc32(hdr, 12) != get<uint32_t>(hdr + 12)) {
+        std::fclose(f);
+        return false;   // foreign or stale layout: treated as unused
+    }
+    s.generation = get<uint32_t>(hdr + 8);
+
+    std::vector<uint8_t> buf(cfg_.page_bytes);
+    for (uint32_t p = 0; p < cfg_.pages_per_seg; ++p) {
+        if (std::fread(buf.data(), 1, buf.size(), f) != buf.size()) break;
+        bool any = false;
+        bool crc_ok = for_each_record(buf.data(), buf.size(), [&](const Record& r) {
+            if (!any) { s.pages[p] = PageIndex{r.poll_seq}; any = true; }
+            s.last_seq = r.poll_seq;
+            return true;
+        });
+        if (!crc_ok) ++stats_.crc_errors;
+        if (!any) break;
+        s.pages_used = p + 1;
+    }
+    std::fclose(f);
+    return true;
+}
+
+bool FlashRingLog::start_segment(uint32_t idx, uint32_t generation) {
+    //
+    // Truncate the segment, stamp a fresh header and keep it open for the page writes
+    //
+    if (seg_file_) std::fclose(seg_file_);
+    seg_file_ = std::fopen(seg_path(idx).c_str(), "w+b");
+    FILE* f = seg_file_;
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot create %s", seg_path(idx).c_str());
+        return false;
+    }
+    uint8_t hdr[SEG_HDR_LEN];
+    put<uint32_t>(hdr,      SEG_MAGIC);
+    put<uint16_t>(hdr + 4,  SEG_VERSION);
+    put<uint16_t>(hdr + 6,  (uint16_t)cfg_.page_bytes);
+    put<uint32_t>(hdr + 8,  generation);
+    put<uint32_t>(hdr + 12, crc32(hdr, 12));
+    bool ok = std::fwrite(hdr, 1, SEG_HDR_LEN, f) == SEG_HDR_LEN;
+    ok = (std::fflush(f) == 0) && ok;
+
+    Segment& s = segs_[idx];
+    s = Segment{};
+    s.generation = generation;
+    s.pages.assign(cfg_.pages_per_seg, PageIndex{});
+    active_   = idx;
+    cur_page_ = 0;
+    return ok;
+}
+
+bool FlashRingLog::rotate() {
+    //
+    // Reuse the least recently written segment (unused ones have generation 0)
+    //
+    uint32_t victim = active_;
+    uint32_t oldest = UINT32_MAX;
+    for (uint32_t i = 0; i < cfg_.segment_count; ++i) {
+        if (i == active_) continue;
+        if (segs_[i].generation < oldest) { oldest = segs_[i].generation; victim = i; }
+    }
+    ++stats_.segment_rotations;
+    return start_segment(victim, next_generation_++);
+}
+
+bool FlashRingLog::write_page(bool partial) {
+    //
+    // One page-sized write at a page-aligned offset, synced so it survives a reset
+    //
+    bool ok = false;
+    if (FILE* f = seg_file_) {
+        long off = (long)(SEG_HDR_LEN + (size_t)cur_page_ * cfg_.page_bytes);
+        ok = std::fseek(f, off, SEEK_SET) == 0 &&
+             std::fwrite(page_.data(), 1, page_.size(), f) == page_.size() &&
+             std::fflush(f) == 0 &&
+             ::fsync(fileno(f)) == 0;
+    }
+    if (!ok) ESP_LOGW(TAG, "Page write failed (seg=%u page=%u)", (unsigned)active_, (unsigned)cur_page_);
+    ++stats_.pages_written;
+
+    page_dirty_ = false;
+    page_first_unflushed_ms_ = -1;
+
+    if (!partial) {
+        ++cur_page_;
+        std::fill(page_.begin(), page_.end(), 0xFF);
+        page_fill_ = 0;
+    }
+    return ok;
+}
+
+bool FlashRingLog::append(int64_t poll_seq, int64_t t_ms, const void* data, size_t len) {
+    //
+    //
+    //
+    if (!open_) return false;
+    const size_t need = REC_HDR_LEN + len;
+    Lock l(lock_);
+
+    if (need > cfg_.page_bytes) { ++stats_.records_rejected; return false; }
+
+    if (page_fill_ + need > cfg_.page_bytes) {
+        if (!write_page(false)) { ++stats_.records_rejected; }
+    }
+    if (cur_page_ >= cfg_.pages_per_seg) {
+        if (!rotate()) { ++stats_.records_rejected; return false; }
+    }
+
+    uint8_t* r = page_.data() + page_fill_;
+    put<uint16_t>(r,      REC_MAGIC);
+    put<uint16_t>(r + 2,  (uint16_t)len);
+    put<int64_t> (r + 8,  poll_seq);
+    put<int64_t> (r + 16, t_ms);
+    std::memcpy(r + REC_HDR_LEN, data, len);
+    put<uint32_t>(r + 4,  crc32(r + 8, 16 + len));
+
+    Segment& s = segs_[active_];
+    if (page_fill_ == 0) {
+        s.pages[cur_page_] = PageIndex{poll_seq};
+        s.pages_used = cur_page_ + 1;
+    }
+    s.last_seq = poll_seq;
+    page_fill_ += need;
+    ++stats_.records_appended;
+
+    int64_t now = EpochTime::espNowMs();
+    if (!page_dirty_) { page_dirty_ = true; page_first_unflushed_ms_ = now; }
+    if (now - page_first_unflushed_ms_ >= cfg_.flush_interval_ms) write_page(true);
+    return true;
+}
+
+bool FlashRingLog::flush() {
+    if (!open_) return false;
+    Lock l(lock_);
+    if (!page_dirty_) return true;
+    return write_page(true);
+}
+
+std::vector<uint32_t> FlashRingLog::segments_oldest_first() const {
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < segs_.size(); ++i) {
+        if (segs_[i].generation && segs_[i].pages_used) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return segs_[a].generation < segs_[b].generation;
+    });
+    return order;
+}
+
+size_t FlashRingLog::read_range(bool by_time, int64_t lo, int64_t hi, const RecordFn& fn) {
+    //
+    // By seq: segment-level skip, binary search on the page index, then a linear page scan.
+    // By time: every page, filtered (t_ms is not monotonic across resets)
+    //
+    if (!open_ || lo > hi) return 0;
+    Lock l(lock_);
+
+    const bool indexed = !by_time;
+    auto first_key = [](const PageIndex& p) { return p.first_seq; };
+    auto rec_key   = [by_time](const Record& r) { return by_time ? r.t_ms : r.poll_seq; };
+
+    size_t delivered = 0;
+    bool   done = false;
+    std::vector<uint8_t> buf(cfg_.page_bytes);
+
+    for (uint32_t idx : segments_oldest_first()) {
+        const Segment& s = segs_[idx];
+        uint32_t start = 0;
+        if (indexed) {
+            if (s.last_seq < lo) continue;
+            if (first_key(s.pages[0]) > hi) break;
+
+            // Last page whose first key is <= lo
+            uint32_t a = 0, b = s.pages_used;
+            while (a < b) {
+                uint32_t mid = (a + b) / 2;
+                if (first_key(s.pages[mid]) <= lo) { start = mid; a = mid + 1; } else { b = mid; }
+            }
+        }
+
+        FILE* f = nullptr;
+        for (uint32_t p = start; p < s.pages_used && !done; ++p) {
+            if (indexed && first_key(s.pages[p]) > hi) { done = true; break; }
+
+            const uint8_t* page = nullptr;
+            if (idx == active_ && p == cur_page_) {
+                page = page_.data();     // still in the RAM batch
+            } else {
+                if (!f) f = std::fopen(seg_path(idx).c_str(), "rb");
+                if (!f || std::fseek(f, (long)(SEG_HDR_LEN + (size_t)p * cfg_.page_bytes), SEEK_SET) != 0 ||
+                    std::fread(buf.data(), 1, buf.size(), f) != buf.size()) {
+                    break;
+                }
+                page = buf.data();
+            }
+
+            bool crc_ok = for_each_record(page, cfg_.page_bytes, [&](const Record& r) {
+                int64_t k = rec_key(r);
+                if (indexed && k > hi) { done = true; return false; }
+                if (k >= lo && k <= hi) { fn(r); ++delivered; }
+                return true;
+            });
+            if (!crc_ok) ++stats_.crc_errors;
+        }
+        if (f) std::fclose(f);
+        if (done) break;
+    }
+    return delivered;
+}
+
+size_t FlashRingLog::read_by_seq(int64_t lo, int64_t hi, const RecordFn& fn) {
+    return read_range(false, lo, hi, fn);
+}
+
+size_t FlashRingLog::read_by_time(int64_t lo_ms, int64_t hi_ms, const RecordFn& fn) {
+    return read_range(true, lo_ms, hi_ms, fn);
+}
+
+FlashRingLog::Stats FlashRingLog::stats() const {
+    Lock l(lock_);
+    Stats s = stats_;
+    if (open_) {
+        auto order = segments_oldest_first();
+        if (!order.empty()) {
+            s.oldest_seq = segs_[order.front()].pages[0].first_seq;
+            s.newest_seq = segs_[order.back()].last_seq;
+        }
+    }
+    return s;
+}
@@ -0,0 +1,156 @@
+// LatencyStats.cpp
+// George Lake
+// Fall 2025
+//
+// Histogram registry and reporting for LatencyStats.hpp
+
+
+#include "LatencyStats.hpp"
+#include "LatencyHistogram.hpp"
+
+#include "esp_log.h"
+#include "cJSON.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr size_t STAGES   = (size_t)LatencyStats::Stage::COUNT;
+    constexpr size_t MAX_TAGS = 12;
+
+    const char* const STAGE_NAMES[STAGES] = {"encode", "send", "wait", "parse", "compare", "log"};
+
+    LatencyHistogram g_stage[STAGES];
+
+    struct TagSlot {
+        std::atomic<const char*> tag{nullptr};     // set once, after the slot is claimed
+        LatencyHistogram         hist;
+    };
+    TagSlot               g_tags[MAX_TAGS];
+    std::atomic<uint32_t> g_tag_count{0};   // slots [0, count) are claimed; skip tag == nullptr
+
+    // audit_task and the MultiPlcMonitor tasks record tags concurrently: a new slot is
+    // claimed by CAS on g_tag_count. Two tasks creating the same tag at once may claim
+    // two slots; lookups return the first, so the second only holds the racing sample.
+    TagSlot* find_tag(const char* tag, bool create) {
+        uint32_t n = g_tag_count.load(std::memory_order_acquire);
+        for (;;) {
+            for (uint32_t i = 0; i < n; ++i) {
+                if (g_tags[i].tag.load(std::memory_order_acquire) == tag) return &g_tags[i];
+            }
+            for (uint32_t i = 0; i < n; ++i) {
+                const char* t = g_tags[i].tag.load(std::memory_order_acquire);
+                if (t && std::strcmp(t, tag) == 0) return &g_tags[i];
+            }
+            if (!create || n >= MAX_TAGS) return nullptr;
+            if (g_tag_count.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel)) break;
+            // Lost the race (n reloaded): the winner may have added this tag
+        }
+        g_tags[n].tag.store(tag, std::memory_order_release);
+        return &g_tags[n];
+    }
+
+    const char* tag_name(uint32_t i) { return g_tags[i].tag.load(std::memory_order_acquire); }
+
+    void log_line(const char* log_tag, const char* kind, const char* name, const LatencyHistogram& h) {
+        if (h.count() == 0) return;
+        ESP_LOGI(log_tag,
+                 "LAT %s=%s n=%lu mean=%luus p50=%luus p90=%luus p99=%luus max=%luus",
+                 kind, name, (unsigned long)h.count(), (unsigned long)h.mean(),
+                 (unsigned long)h.percentile(50), (unsigned long)h.percentile(90),
+                 (unsigned long)h.percentile(99), (unsigned long)h.max());
+    }
+
+    // One record per histogram keeps each well under LogStream's max_record
+    std::string hist_record(const char* kind, const char* name, const LatencyHistogram& h, int64_t t_ms) {
+        cJSON* o = cJSON_CreateObject();
+        cJSON_AddStringToObject(o, "record_type", "latency_histogram");
+        cJSON_AddNumberToObject(o, "t_ms", (double)t_ms);
+        cJSON_AddStringToObject(o, "kind", kind);
+        cJSON_AddStringToObject(o, "name", name);
+        cJSON_AddNumberToObject(o, "sub_buckets", LatencyHistogram::SUB);
+        cJSON_AddNumberToObject(o, "count", h.count());
+        cJSON_AddNumberToObject(o, "mean_us", h.mean());
+        cJSON_AddNumberToObject(o, "p50_us", h.percentile(50));
+        cJSON_AddNumberToObject(o, "p90_us", h.percentile(90));
+        cJSON_AddNumberToObject(o, "p99_us", h.percentile(99));
+        cJSON_AddNumberToObject(o, "max_us", h.max());
+        // Sparse buckets: [[upper_edge_us, count], ...]
+        cJSON* b = cJSON_AddArrayToObject(o, "buckets");
+        for (uint32_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            uint32_t c = h.bucket_count(i);
+            if (!c) continue;
+            cJSON* pair = cJSON_CreateArray();
+            cJSON_AddItemToArray(pair, cJSON_CreateNumber(LatencyHistogram::bucket_upper(i)));
+            cJSON_AddItemToArray(pair, cJSON_CreateNumber(c));
+            cJSON_AddItemToArray(b, pair);
+        }
+        char* raw = cJSON_PrintUnformatted(o);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(o);
+        return json;
+    }
+} // Anonymous Namespace
+
+namespace LatencyStats {
+    const char* stage_name(Stage s) {
+        size_t i = (size_t)s;
+        return i < STAGES ? STAGE_NAMES[i] : "?";
+    }
+
+    void record_stage_us(Stage s, uint32_t us) {
+        size_t i = (size_t)s;
+        if (i < STAGES) g_stage[i].record(us);
+    }
+
+    void record_stage(Stage s, int64_t start_us) {
+        int64_t d = now_us() - start_us;
+        record_stage_us(s, d > 0 ? (uint32_t)d : 0u);
+    }
+
+    void record_tag(const char* tag, uint32_t us) {
+        if (!tag) return;
+        if (TagSlot* slot = find_tag(tag, true)) slot->hist.record(us);
+    }
+
+    void reset() {
+        for (auto& h : g_stage) h.reset();
+        uint32_t n = g_tag_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) g_tags[i].hist.reset();
+    }
+
+    void log_summary(const char* log_tag) {
+        for (size_t i = 0; i < STAGES; ++i) log_line(log_tag, "stage", STAGE_NAMES[i], g_stage[i]);
+        uint32_t n = g_tag_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (const char* t = tag_name(i)) log_line(log_tag, "tag", t, g_tags[i].hist);
+        }
+    }
+
+    std::vector<std::string> export_json(int64_t t_ms) {
+        std::vector<std::string> out;
+        for (size_t i = 0; i < STAGES; ++i) {
+            if (g_stage[i].count()) out.push_back(hist_record("stage", STAGE_NAMES[i], g_stage[i], t_ms));
+        }
+        uint32_t n = g_tag_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            const char* t = tag_name(i);
+            if (t && g_tags[i].hist.count()) out.push_back(hist_record("tag", t, g_tags[i].hist, t_ms));
+        }
+        return out;
+    }
+
+    const LatencyHistogram* stage_histogram(Stage s) {
+        size_t i = (size_t)s;
+        return i < STAGES ? &g_stage[i] : nullptr;
+    }
+
+    const LatencyHistogram* tag_histogram(const char* tag) {
+        if (!tag) return nullptr;
+        TagSlot* slot = find_tag(tag, false);
+        return slot ? &slot->hist : nullptr;
+    }
+}
@@ -0,0 +1,268 @@
+// LogStream.cpp
+// George Lake
+// Fall 2025
+//
+// Batched UDP/TCP log sender
+// Refer to LogStream.hpp for the wire format
+
+
+#include "LogStream.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+
+#include "lwip/inet.h"
+#include "lwip/sockets.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/message_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    static const char* TAG = "LOGSTREAM";
+
+    // Room reserved for the "#ESPLOG ..." batch header
+    constexpr size_t MAX_HEADER = 96;
+    constexpr size_t MAX_DEVICE_ID = 48;
+    // "+<record_id> <offset> <total> " continuation prefix, and the least payload worth
+    // starting a continuation line for at the end of a batch
+    constexpr size_t MAX_FRAG_HEADER = 40;
+    constexpr size_t MIN_FRAG_BYTES  = 64;
+    // Another writer holds the lock only for one memcpy into the buffer; wait that out
+    // rather than drop, but never longer than a tick
+    constexpr uint32_t SUBMIT_WAIT_MS = 2;
+
+    enum Drop : uint8_t { DROP_FULL, DROP_BUSY, DROP_OVERSIZE, DROP_KINDS };
+    const char* const DROP_NAMES[DROP_KINDS] = {"buffer full", "writer busy", "record over max_record"};
+
+    LogStream::Config       g_cfg{};
+    std::string             g_host;
+    std::string             g_device;
+    MessageBufferHandle_t   g_buf       = nullptr;
+    SemaphoreHandle_t       g_submit_mx = nullptr;   // message buffers allow one writer at a time
+    int                     g_sock      = -1;
+    sockaddr_in             g_addr{};
+
+    std::atomic<uint32_t> g_submitted{0}, g_dropped{0}, g_batches{0},
+                          g_bytes{0}, g_send_errors{0}, g_connects{0},
+                          g_oversize{0}, g_split{0};
+    std::atomic<bool>     g_drop_logged[DROP_KINDS]{};
+
+    void note_drop(Drop kind, size_t len) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        if (kind == DROP_OVERSIZE) g_oversize.fetch_add(1, std::memory_order_relaxed);
+        if (!g_drop_logged[kind].exchange(true, std::memory_order_relaxed)) {
+            ESP_LOGW(TAG, "Dropping records: %s (first one %u bytes); see dropped= in the summary",
+                     DROP_NAMES[kind], (unsigned)len);
+        }
+    }
+
+    void close_sock() {
+        if (g_sock >= 0) { ::close(g_sock); g_sock = -1; }
+    }
+
+    bool open_sock() {
+        //
+        // UDP: unconnected datagram socket. TCP: blocking connect to the collector.
+        //
+        if (g_sock >= 0) return true;
+        bool tcp = g_cfg.transport == LogStream::Transport::TCP;
+        g_sock = ::socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+        if (g_sock < 0) return false;
+        if (tcp) {
+            int one = 1;
+            ::setsockopt(g_sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (::connect(g_sock, (sockaddr*)&g_addr, sizeof(g_addr)) != 0) {
+                ESP_LOGW(TAG, "connect(%s:%u) errno=%d", g_host.c_str(), (unsigned)g_cfg.port, errno);
+                close_sock();
+                return false;
+            }
+            g_connects.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool send_batch(const char* data, size_t len) {
+        //
+        //
+        //
+        if (!open_sock()) return false;
+        if (g_cfg.transport == LogStream::Transport::UDP) {
+            int n = ::sendto(g_sock, data, len, 0, (sockaddr*)&g_addr, sizeof(g_addr));
+            return n == (int)len;
+        }
+        while (len) {
+            int n = ::send(g_sock, data, len, 0);
+            if (n <= 0) { close_sock(); return false; }
+            data += n;
+            len  -= (size_t)n;
+        }
+        return true;
+    }
+
+    void sender_task(void*) {
+        //
+        // Drain the message buffer into MTU-sized batches (submit guarantees a record fits
+        // in rec; one that does not fit what is left of the batch goes out as continuation
+        // lines, so datagrams stay full even when records are close to the MTU)
+        //
+        std::vector<char> batch(g_cfg.mtu_payload);
+        std::vector<char> rec(g_cfg.max_record);
+        uint32_t batch_seq = 0;
+        uint32_t record_id = 0;
+        size_t   fill = 0;
+        size_t   header_len = 0;
+        TickType_t batch_started = 0;
+
+        auto begin_batch = [&]() {
+            int n = std::snprintf(batch.data(), batch.size(), "#ESPLOG %s %lu %lu\n",
+                                  g_device.c_str(), (unsigned long)batch_seq,
+                                  (unsigned long)g_dropped.load(std::memory_order_relaxed));
+            header_len = fill = (n > 0) ? (size_t)n : 0;
+            batch_started = xTaskGetTickCount();
+        };
+        auto flush_batch = [&]() {
+            if (fill <= header_len) return;
+            if (send_batch(batch.data(), fill)) {
+                g_batches.fetch_add(1, std::memory_order_relaxed);
+                g_bytes.fetch_add((uint32_t)fill, std::memory_order_relaxed);
+            } else {
+                g_send_errors.fetch_add(1, std::memory_order_relaxed);
+                vTaskDelay(pdMS_TO_TICKS(500));     // link or collector down; let the buffer absorb
+            }
+            ++batch_seq;
+            begin_batch();
+        };
+
+        begin_batch();
+        for (;;) {
+            TickType_t wait = pdMS_TO_TICKS(g_cfg.max_batch_ms);
+            if (fill > header_len) {
+                TickType_t age = xTaskGetTickCount() - batch_started;
+                wait = (age >= wait) ? 0 : wait - age;
+            }
+
+            size_t n = xMessageBufferReceive(g_buf, rec.data(), rec.size(), wait);
+            CpuProfiler::count_wake();
+            if (n == 0) {           // batch timer expired
+                flush_batch();
+                continue;
+            }
+            if (fill == header_len) batch_started = xTaskGetTickCount();   // age counts from the first record
+            if (fill + n + 1 <= batch.size()) {
+                std::memcpy(batch.data() + fill, rec.data(), n);
+                fill += n;
+                batch[fill++] = '\n';
+                continue;
+            }
+
+            ++record_id;
+            g_split.fetch_add(1, std::memory_order_relaxed);
+            for (size_t off = 0; off < n; ) {
+                if (fill + MAX_FRAG_HEADER + MIN_FRAG_BYTES + 1 > batch.size()) {
+                    flush_batch();
+                    batch_started = xTaskGetTickCount();
+                }
+                int h = std::snprintf(batch.data() + fill, MAX_FRAG_HEADER, "+%lu %u %u ",
+                                      (unsigned long)record_id, (unsigned)off, (unsigned)n);
+                fill += (h > 0) ? (size_t)h : 0;
+                size_t chunk = std::min(n - off, batch.size() - fill - 1);
+                std::memcpy(batch.data() + fill, rec.data() + off, chunk);
+                fill += chunk;
+                batch[fill++] = '\n';
+                off += chunk;
+            }
+        }
+    }
+} // Anonymous Namespace
+
+namespace LogStream {
+    bool start(const Config& cfg) {
+        //
+        //
+        //
+        if (g_buf) return false;
+        if (!cfg.host || !cfg.host[0] || cfg.mtu_payload < 2 * MAX_HEADER + MAX_FRAG_HEADER + MIN_FRAG_BYTES) return false;
+        if (cfg.max_record == 0 || cfg.max_record + sizeof(size_t) > cfg.queue_bytes) {
+            ESP_LOGE(TAG, "max_record %u does not fit the %u byte buffer",
+                     (unsigned)cfg.max_record, (unsigned)cfg.queue_bytes);
+            return false;
+        }
+
+        g_cfg    = cfg;
+        g_host   = cfg.host;
+        g_device = (cfg.device_id && cfg.device_id[0]) ? cfg.device_id : "esp32";
+        if (g_device.size() > MAX_DEVICE_ID) g_device.resize(MAX_DEVICE_ID);
+        g_cfg.host = g_host.c_str();
+        g_cfg.device_id = g_device.c_str();
+
+        g_addr = sockaddr_in{};
+        g_addr.sin_family      = AF_INET;
+        g_addr.sin_port        = htons(cfg.port);
+        g_addr.sin_addr.s_addr = inet_addr(g_host.c_str());
+
+        g_submit_mx = xSemaphoreCreateMutex();
+        g_buf = xMessageBufferCreate(cfg.queue_bytes);
+        auto cleanup = [] {
+            if (g_buf)       vMessageBufferDelete(g_buf);
+            if (g_submit_mx) vSemaphoreDelete(g_submit_mx);
+            g_buf       = nullptr;      // running() and submit() key off g_buf
+            g_submit_mx = nullptr;
+        };
+        if (!g_buf || !g_submit_mx) {
+            ESP_LOGE(TAG, "Out of memory for %u byte log buffer", (unsigned)cfg.queue_bytes);
+            cleanup();
+            return false;
+        }
+        TaskHandle_t task = nullptr;
+        if (xTaskCreate(sender_task, "log_stream", 4096, nullptr, 3, &task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create sender task");
+            cleanup();
+            return false;
+        }
+        MemStats::watch_task(task, 4096);
+        ESP_LOGI(TAG, "Streaming logs to %s:%u over %s as '%s'",
+                 g_host.c_str(), (unsigned)cfg.port,
+                 cfg.transport == Transport::TCP ? "TCP" : "UDP", g_device.c_str());
+        return true;
+    }
+
+    bool submit(const char* data, size_t len) {
+        //
+        // Never waits for the network: a full buffer is a drop. A concurrent writer is
+        // waited out (bounded); only one stuck past SUBMIT_WAIT_MS is a drop
+        //
+        if (!g_buf) return false;
+        g_submitted.fetch_add(1, std::memory_order_relaxed);
+        if (len > g_cfg.max_record) { note_drop(DROP_OVERSIZE, len); return false; }
+        static const TickType_t wait = pdMS_TO_TICKS(SUBMIT_WAIT_MS) ? pdMS_TO_TICKS(SUBMIT_WAIT_MS) : 1;
+        if (xSemaphoreTake(g_submit_mx, wait) != pdTRUE) { note_drop(DROP_BUSY, len); return false; }
+        size_t sent = xMessageBufferSend(g_buf, data, len, 0);
+        xSemaphoreGive(g_submit_mx);
+        if (sent != len) { note_drop(DROP_FULL, len); return false; }
+        return true;
+    }
+
+    bool running() { return g_buf != nullptr; }
+
+    Stats stats() {
+        Stats s;
+        s.submitted    = g_submitted.load(std::memory_order_relaxed);
+        s.dropped      = g_dropped.load(std::memory_order_relaxed);
+        s.batches_sent = g_batches.load(std::memory_order_relaxed);
+        s.bytes_sent   = g_bytes.load(std::memory_order_relaxed);
+        s.send_errors  = g_send_errors.load(std::memory_order_relaxed);
+        s.connects     = g_connects.load(std::memory_order_relaxed);
+        s.oversize     = g_oversize.load(std::memory_order_relaxed);
+        s.split        = g_split.load(std::memory_order_relaxed);
+        return s;
+    }
+}
@@ -0,0 +1,295 @@
+// MemStats.cpp
+// George Lake
+// Fall 2025
+//
+// Heap hooks, per-task allocation counters, heap history and reporting
+// Refer to MemStats.hpp for notes
+
+
+#include "MemStats.hpp"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+#include <atomic>
+#include <cstdlib>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#endif
+
+#ifndef CONFIG_HEAP_USE_HOOKS
+#define CONFIG_HEAP_USE_HOOKS 0
+#endif
+
+namespace {
+    static const char* TAG = "MEM";
+
+    constexpr uint32_t MAX_TASKS   = 16;
+    constexpr uint32_t HISTORY_LEN = 16;
+    constexpr auto     RELAXED     = std::memory_order_relaxed;
+
+    struct TaskSlot {
+        TaskHandle_t          task        = nullptr;
+        uint32_t              stack_bytes = 0;
+        std::atomic<uint32_t> allocs{0};
+        std::atomic<uint32_t> bytes{0};
+        std::atomic<uint32_t> frees{0};
+    };
+    TaskSlot              g_tasks[MAX_TASKS];
+    std::atomic<uint32_t> g_task_count{0};    // slots [0, count) are published
+
+    std::atomic<uint32_t> g_total_allocs{0};
+    std::atomic<uint32_t> g_total_bytes{0};
+    std::atomic<uint32_t> g_total_frees{0};
+
+    // Per-poll churn and heap history (written by polling tasks / dump_summary)
+    portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+    struct PollStats {
+        uint32_t polls       = 0;
+        uint64_t allocs_sum  = 0;
+        uint64_t bytes_sum   = 0;
+        uint32_t allocs_max  = 0;
+        uint32_t bytes_max   = 0;
+        uint32_t allocs_last = 0;
+        uint32_t bytes_last  = 0;
+    };
+    PollStats g_poll;
+
+    MemStats::HeapSample g_history[HISTORY_LEN];
+    uint32_t   g_history_head = 0;     // total samples taken
+    uint32_t   g_min_largest_block = UINT32_MAX;
+    uint8_t    g_max_fragmentation = 0;
+
+    TaskSlot* find_slot(TaskHandle_t t) {
+        uint32_t n = g_task_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (g_tasks[i].task == t) return &g_tasks[i];
+        }
+        return nullptr;
+    }
+
+    uint32_t stack_free_bytes(const TaskSlot& s) {
+        return (uint32_t)uxTaskGetStackHighWaterMark(s.task);
+    }
+} // Anonymous Namespace
+
+#if CONFIG_HEAP_USE_HOOKS
+// Called by the IDF heap for every successful allocation / free (any task or ISR)
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    (void)ptr; (void)caps;
+    g_total_allocs.fetch_add(1, RELAXED);
+    g_total_bytes.fetch_add((uint32_t)size, RELAXED);
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t n = g_task_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (g_tasks[i].task == self) {
+            g_tasks[i].allocs.fetch_add(1, RELAXED);
+            g_tasks[i].bytes.fetch_add((uint32_t)size, RELAXED);
+            return;
+        }
+    }
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    if (!ptr) return;
+    g_total_frees.fetch_add(1, RELAXED);
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t n = g_task_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (g_tasks[i].task == self) { g_tasks[i].frees.fetch_add(1, RELAXED); return; }
+    }
+}
+#endif
+
+namespace MemStats {
+    bool hooks_enabled() {
+        return CONFIG_HEAP_USE_HOOKS != 0;
+    }
+
+    void watch_task(TaskHandle_t task, uint32_t stack_bytes) {
+        //
+        // Slots are append-only; the hooks read them without locking
+        //
+        if (!task) return;
+        bool full = false;
+        portENTER_CRITICAL(&g_mux);
+        uint32_t n = g_task_count.load(RELAXED);
+        if (!find_slot(task)) {
+            if (n < MAX_TASKS) {
+                g_tasks[n].task        = task;
+                g_tasks[n].stack_bytes = stack_bytes;
+                g_task_count.store(n + 1, std::memory_order_release);
+            } else {
+                full = true;
+            }
+        }
+        portEXIT_CRITICAL(&g_mux);
+        if (full) {
+            ESP_LOGW(TAG, "Not watching task '%s': all %u slots taken (raise MAX_TASKS)",
+                     pcTaskGetName(task), (unsigned)MAX_TASKS);
+        }
+    }
+
+    AllocCount task_allocs() {
+        AllocCount c;
+        if (const TaskSlot* s = find_slot(xTaskGetCurrentTaskHandle())) {
+            c.allocs = s->allocs.load(RELAXED);
+            c.bytes  = s->bytes.load(RELAXED);
+        }
+        return c;
+    }
+
+    void record_poll(const AllocCount& at_start) {
+        if (!hooks_enabled()) return;
+        AllocCount now = task_allocs();
+        uint32_t allocs = now.allocs - at_start.allocs;
+        uint32_t bytes  = now.bytes  - at_start.bytes;
+
+        portENTER_CRITICAL(&g_mux);
+        ++g_poll.polls;
+        g_poll.allocs_sum += allocs;
+        g_poll.bytes_sum  += bytes;
+        if (allocs > g_poll.allocs_max) g_poll.allocs_max = allocs;
+        if (bytes  > g_poll.bytes_max)  g_poll.bytes_max  = bytes;
+        g_poll.allocs_last = allocs;
+        g_poll.bytes_last  = bytes;
+        portEXIT_CRITICAL(&g_mux);
+    }
+
+    HeapSample sample_heap(int64_t t_ms) {
+        HeapSample h;
+        h.t_ms               = t_ms;
+        h.free_bytes         = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        h.min_free_bytes     = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+        h.largest_free_block = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        h.fragmentation_pct  = h.free_bytes
+            ? (uint8_t)(100 - (uint64_t)h.largest_free_block * 100 / h.free_bytes) : 0;
+
+        portENTER_CRITICAL(&g_mux);
+        g_history[g_history_head % HISTORY_LEN] = h;
+        ++g_history_head;
+        if (h.largest_free_block < g_min_largest_block) g_min_largest_block = h.largest_free_block;
+        if (h.fragmentation_pct > g_max_fragmentation) g_max_fragmentation = h.fragmentation_pct;
+        portEXIT_CRITICAL(&g_mux);
+        return h;
+    }
+
+    void log_summary(const char* log_tag) {
+        //
+        //
+        //
+        HeapSample h;
+        PollStats p;
+        uint32_t min_largest = 0, max_frag = 0;
+        portENTER_CRITICAL(&g_mux);
+        if (g_history_head) h = g_history[(g_history_head - 1) % HISTORY_LEN];
+        p           = g_poll;
+        min_largest = g_min_largest_block == UINT32_MAX ? 0 : g_min_largest_block;
+        max_frag    = g_max_fragmentation;
+        portEXIT_CRITICAL(&g_mux);
+
+        ESP_LOGI(log_tag, "MEM heap free=%lu min_free=%lu largest=%lu (min %lu) frag=%u%% (max %lu%%)",
+                 (unsigned long)h.free_bytes, (unsigned long)h.min_free_bytes,
+                 (unsigned long)h.largest_free_block, (unsigned long)min_largest,
+                 (unsigned)h.fragmentation_pct, (unsigned long)max_frag);
+
+        if (hooks_enabled() && p.polls) {
+            ESP_LOGI(log_tag, "MEM poll n=%lu allocs mean=%.1f max=%lu last=%lu bytes mean=%.0f max=%lu last=%lu",
+                     (unsigned long)p.polls,
+                     (double)p.allocs_sum / p.polls, (unsigned long)p.allocs_max, (unsigned long)p.allocs_last,
+                     (double)p.bytes_sum / p.polls, (unsigned long)p.bytes_max, (unsigned long)p.bytes_last);
+        }
+
+        uint32_t n = g_task_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            const TaskSlot& s = g_tasks[i];
+            ESP_LOGI(log_tag, "MEM task=%s stack=%lu unused=%lu allocs=%lu bytes=%lu frees=%lu",
+                     pcTaskGetName(s.task), (unsigned long)s.stack_bytes,
+                     (unsigned long)stack_free_bytes(s),
+                     (unsigned long)s.allocs.load(RELAXED), (unsigned long)s.bytes.load(RELAXED),
+                     (unsigned long)s.frees.load(RELAXED));
+        }
+    }
+
+    std::string export_json(int64_t t_ms) {
+        //
+        //
+        //
+        HeapSample hist[HISTORY_LEN];
+        uint32_t count = 0, head = 0, min_largest = 0, max_frag = 0;
+        PollStats p;
+        portENTER_CRITICAL(&g_mux);
+        head  = g_history_head;
+        count = head < HISTORY_LEN ? head : HISTORY_LEN;
+        for (uint32_t i = 0; i < count; ++i) hist[i] = g_history[(head - count + i) % HISTORY_LEN];
+        p           = g_poll;
+        min_largest = g_min_largest_block == UINT32_MAX ? 0 : g_min_largest_block;
+        max_frag    = g_max_fragmentation;
+        portEXIT_CRITICAL(&g_mux);
+
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "memory");
+        cJSON_AddNumberToObject(root, "t_ms", (double)t_ms);
+        cJSON_AddBoolToObject(root, "hooks", hooks_enabled());
+
+        cJSON* heap = cJSON_AddObjectToObject(root, "heap");
+        if (count) {
+            const HeapSample& h = hist[count - 1];
+            cJSON_AddNumberToObject(heap, "free", h.free_bytes);
+            cJSON_AddNumberToObject(heap, "min_free", h.min_free_bytes);
+            cJSON_AddNumberToObject(heap, "largest_block", h.largest_free_block);
+            cJSON_AddNumberToObject(heap, "fragmentation_pct", h.fragmentation_pct);
+        }
+        cJSON_AddNumberToObject(heap, "min_largest_block", min_largest);
+        cJSON_AddNumberToObject(heap, "max_fragmentation_pct", max_frag);
+        cJSON_AddNumberToObject(heap, "total_allocs", g_total_allocs.load(RELAXED));
+        cJSON_AddNumberToObject(heap, "total_alloc_bytes", g_total_bytes.load(RELAXED));
+        cJSON_AddNumberToObject(heap, "total_frees", g_total_frees.load(RELAXED));
+
+        // [[t_ms, free, largest_block, fragmentation_pct], ...] oldest first
+        cJSON* h_arr = cJSON_AddArrayToObject(heap, "history");
+        for (uint32_t i = 0; i < count; ++i) {
+            cJSON* row = cJSON_CreateArray();
+            cJSON_AddItemToArray(row, cJSON_CreateNumber((double)hist[i].t_ms));
+            cJSON_AddItemToArray(row, cJSON_CreateNumber(hist[i].free_bytes));
+            cJSON_AddItemToArray(row, cJSON_CreateNumber(hist[i].largest_free_block));
+            cJSON_AddItemToArray(row, cJSON_CreateNumber(hist[i].fragmentation_pct));
+            cJSON_AddItemToArray(h_arr, row);
+        }
+
+        if (hooks_enabled()) {
+            cJSON* poll = cJSON_AddObjectToObject(root, "poll");
+            cJSON_AddNumberToObject(poll, "n", p.polls);
+            cJSON_AddNumberToObject(poll, "allocs_mean", p.polls ? (double)p.allocs_sum / p.polls : 0.0);
+            cJSON_AddNumberToObject(poll, "allocs_max", p.allocs_max);
+            cJSON_AddNumberToObject(poll, "bytes_mean", p.polls ? (double)p.bytes_sum / p.polls : 0.0);
+            cJSON_AddNumberToObject(poll, "bytes_max", p.bytes_max);
+        }
+
+        cJSON* tasks = cJSON_AddArrayToObject(root, "tasks");
+        uint32_t n = g_task_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; ++i) {
+            const TaskSlot& s = g_tasks[i];
+            cJSON* t = cJSON_CreateObject();
+            cJSON_AddStringToObject(t, "name", pcTaskGetName(s.task));
+            cJSON_AddNumberToObject(t, "stack", s.stack_bytes);
+            cJSON_AddNumberToObject(t, "stack_unused", stack_free_bytes(s));
+            if (hooks_enabled()) {
+                cJSON_AddNumberToObject(t, "allocs", s.allocs.load(RELAXED));
+                cJSON_AddNumberToObject(t, "alloc_bytes", s.bytes.load(RELAXED));
+                cJSON_AddNumberToObject(t, "frees", s.frees.load(RELAXED));
+            }
+            cJSON_AddItemToArray(tasks, t);
+        }
+
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        return json;
+    }
+}
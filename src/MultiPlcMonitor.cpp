@@ -0,0 +1,382 @@
+// MultiPlcMonitor.cpp
+// George Lake
+// Fall 2025
+//
+// Single-task scheduler over non-blocking ENIP sessions
+// Refer to MultiPlcMonitor.hpp for notes
+
+
+#include "MultiPlcMonitor.hpp"
+#include "AuditDetector.hpp"
+#include "EnipSession.hpp"
+#include "TagReads.hpp"
+#include "CipCodec.hpp"
+#include "CipStatus.hpp"
+#include "EpochTime.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "LatencyStats.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+#include "AlertChannel.hpp"
+
+#include "lwip/sockets.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+    static const char* TAG = "MULTI_PLC";
+
+    constexpr uint32_t STACK_BYTES  = 6144;
+    constexpr int64_t  MAX_SLEEP_US = 100 * 1000;
+
+    // Watchlist order; one poll cycle reads the due slots front to back
+    enum SlotId { AUDIT, AUTH, KP, KI, KD, STAMP, SLOT_COUNT };
+    const char* const SLOT_FIELDS[SLOT_COUNT] = {"AuditValue", "AuthorizedUser", "Kp", "Ki", "Kd", "ChangeStamp"};
+
+    struct Slot {
+        PreparedRead req;                   // rr empty = not watched
+        Cip::Type    type  = Cip::Type::DINT;
+        uint16_t     every = 1;
+        bool         have  = false;
+        Cip::Value   last{};
+
+        bool due(uint32_t poll) const { return !req.rr.empty() && (!have || every <= 1 || poll % every == 0); }
+    };
+
+    struct PlcState {
+        std::string           name;
+        EnipSession*          session = nullptr;
+        Slot                  slots[SLOT_COUNT];
+        std::array<int32_t,7> stamp{};
+        AuditDetector         detector;
+        uint32_t              poll_ms = 200;
+        int32_t               tz_offset_minutes = 0;
+
+        uint32_t              poll     = 0;
+        int                   cur      = -1;    // slot in flight; -1 = between cycles
+        bool                  cycle_ok = true;
+        int64_t               next_due_us = 0;
+        int64_t               cycle_start_us = 0;
+        std::vector<uint8_t>  reply;
+
+        // Read by log_summary from another task
+        std::atomic<uint32_t> polls{0};
+        std::atomic<uint32_t> failures{0};
+        std::atomic<uint32_t> changes{0};
+        std::atomic<uint32_t> cycle_us{0};
+        std::atomic<uint8_t>  state{0};
+    };
+
+    PlcState*              g_plcs[MultiPlcMonitor::MAX_PLCS] = {nullptr};
+    size_t                 g_count = 0;
+    std::atomic<bool>      g_running{false};
+
+    const char* state_name(EnipSession::State s) {
+        switch (s) {
+            case EnipSession::State::IDLE:        return "idle";
+            case EnipSession::State::CONNECTING:  return "connecting";
+            case EnipSession::State::REGISTERING: return "registering";
+            case EnipSession::State::READY:       return "ready";
+            case EnipSession::State::BUSY:        return "busy";
+            case EnipSession::State::BACKOFF:     return "backoff";
+        }
+        return "?";
+    }
+
+    int next_slot(const PlcState& p, int from) {
+        for (int i = from; i < SLOT_COUNT; ++i) {
+            if (p.slots[i].due(p.poll)) return i;
+        }
+        return SLOT_COUNT;
+    }
+
+    void emit_change(const PlcState& p, const AuditDetector::Result& r, const AuditSample& s, bool have_stamp_ms,
+                     int64_t stamp_ms) {
+        //
+        //
+        //
+        int64_t t = Experiment::timestamp_ms();
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "plc_change");
+        cJSON_AddNumberToObject(root, "t_ms", (double)t);
+        cJSON_AddStringToObject(root, "plc", p.name.c_str());
+        cJSON_AddStringToObject(root, "ip", p.session->ip().c_str());
+        cJSON_AddNumberToObject(root, "poll", p.poll);
+        cJSON_AddBoolToObject(root, "authorized", r.authorized);
+
+        cJSON* fields = cJSON_AddArrayToObject(root, "changed_fields");
+        if (r.audit_changed) cJSON_AddItemToArray(fields, cJSON_CreateString("AuditValue"));
+        if (r.kp_changed)    cJSON_AddItemToArray(fields, cJSON_CreateString("Kp"));
+        if (r.ki_changed)    cJSON_AddItemToArray(fields, cJSON_CreateString("Ki"));
+        if (r.kd_changed)    cJSON_AddItemToArray(fields, cJSON_CreateString("Kd"));
+
+        cJSON_AddStringToObject(root, "audit_prev", std::to_string((long long)r.previous.audit).c_str());
+        cJSON_AddStringToObject(root, "audit",      std::to_string((long long)s.audit).c_str());
+        cJSON_AddNumberToObject(root, "kp", s.kp);
+        cJSON_AddNumberToObject(root, "ki", s.ki);
+        cJSON_AddNumberToObject(root, "kd", s.kd);
+        if (have_stamp_ms) cJSON_AddNumberToObject(root, "plc_timestamp_ms", (double)stamp_ms);
+
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        Experiment::emit_record(json, t);
+    }
+
+    void evaluate(PlcState& p) {
+        //
+        // Same classification as audit_task, per PLC
+        //
+        AuditSample s;
+        s.audit = Cip::as_int64(p.slots[AUDIT].last);
+        s.auth  = (int32_t)Cip::as_int64(p.slots[AUTH].last);
+        s.kp    = p.slots[KP].last.v.f32;
+        s.ki    = p.slots[KI].last.v.f32;
+        s.kd    = p.slots[KD].last.v.f32;
+
+        AuditDetector::Result r = p.detector.update(s);
+        if (r.audit_baseline_set) {
+            ESP_LOGI(TAG, "[%s] Baseline AuditValue = %lld Kp=%.6f Ki=%.6f Kd=%.6f",
+                     p.name.c_str(), (long long)s.audit, s.kp, s.ki, s.kd);
+        }
+        if (!r.any_change()) return;
+
+        const int64_t t_detect = esp_timer_get_time();
+        char detail[160];      // raise() cuts it to MAX_DETAIL
+        if (r.audit_changed && !r.authorized) {
+            std::snprintf(detail, sizeof(detail), "[%s] AuditValue %lld->%lld auth=%d", p.name.c_str(),
+                          (long long)r.previous.audit, (long long)s.audit, (int)s.auth);
+            AlertChannel::raise("UNAUTHORIZED_CHANGE", detail, t_detect);
+        }
+        if (r.pid_changed() && !r.authorized) {
+            std::snprintf(detail, sizeof(detail), "[%s] Kp %g->%g Ki %g->%g Kd %g->%g auth=%d", p.name.c_str(),
+                          r.previous.kp, s.kp, r.previous.ki, s.ki, r.previous.kd, s.kd, (int)s.auth);
+            AlertChannel::raise("UNAUTHORIZED_PID_CHANGE", detail, t_detect);
+        }
+
+        if (r.audit_changed) {
+            ESP_LOGW(TAG, "[%s] %s: AuditValue %lld->%lld (auth=%d)", p.name.c_str(),
+                     r.authorized ? "AUTHORIZED_CHANGE" : "UNAUTHORIZED_CHANGE",
+                     (long long)r.previous.audit, (long long)s.audit, (int)s.auth);
+            Experiment::record_audit_change(r.authorized);
+        }
+        if (r.pid_changed()) {
+            ESP_LOGW(TAG, "[%s] %s: Kp %.6f->%.6f, Ki %.6f->%.6f, Kd %.6f->%.6f (auth=%d)", p.name.c_str(),
+                     r.authorized ? "AUTHORIZED_PID_CHANGE" : "UNAUTHORIZED_PID_CHANGE",
+                     r.previous.kp, s.kp, r.previous.ki, s.ki, r.previous.kd, s.kd, (int)s.auth);
+            Experiment::record_pid_change(r.authorized);
+        }
+        p.changes.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t stamp_ms = -1;
+        if (p.slots[STAMP].have && p.stamp[0] >= 2000) {
+            stamp_ms = EpochTime::toEpochMs(EpochTime::fromArray(p.stamp), p.tz_offset_minutes);
+        }
+        emit_change(p, r, s, stamp_ms >= 0, stamp_ms);
+    }
+
+    void end_cycle(PlcState& p, int64_t now_us) {
+        //
+        //
+        //
+        p.polls.fetch_add(1, std::memory_order_relaxed);
+        if (p.cycle_ok) {
+            p.cycle_us.store((uint32_t)(now_us - p.cycle_start_us), std::memory_order_relaxed);
+            evaluate(p);
+        } else {
+            p.failures.fetch_add(1, std::memory_order_relaxed);
+            Experiment::record_read_failure();
+        }
+        ++p.poll;
+        p.cur = -1;
+
+        // Fixed rate; a late cycle does not queue up catch-up polls
+        p.next_due_us += (int64_t)p.poll_ms * 1000;
+        if (p.next_due_us < now_us) p.next_due_us = now_us;
+    }
+
+    void submit_or_end(PlcState& p, int64_t now_us) {
+        if (p.cur >= SLOT_COUNT || !p.cycle_ok) { end_cycle(p, now_us); return; }
+        p.session->submit(p.slots[p.cur].req.rr, now_us);
+    }
+
+    void on_reply(PlcState& p, bool ok, int64_t now_us) {
+        //
+        //
+        //
+        if (p.cur < 0 || p.cur >= SLOT_COUNT) return;
+        LatencyStats::record_stage_us(LatencyStats::Stage::WAIT, p.session->stats().last_rtt_us);
+
+        Slot& sl = p.slots[p.cur];
+        const bool had_reply = ok;
+        if (ok && p.cur == STAMP) {
+            ok = parse_dint_array7_rr(p.reply, p.stamp);
+        } else if (ok) {
+            Cip::Value v{};
+            ok = parse_prepared_rr(sl.req, p.reply, v) && v.type == sl.type;
+            if (ok) sl.last = v;
+        }
+        if (ok) {
+            sl.have = true;
+        } else {
+            Cip::Status st;
+            if (had_reply) Cip::read_status(p.reply, st);
+            else           st.layer = Cip::Status::Layer::TRANSPORT;
+            char why[64];
+            Cip::describe(st, why, sizeof(why));
+            ESP_LOGW(TAG, "[%s] read failed: %s (%s): %s", p.name.c_str(), sl.req.tag, SLOT_FIELDS[p.cur], why);
+            p.cycle_ok = false;
+        }
+        p.cur = next_slot(p, p.cur + 1);
+        submit_or_end(p, now_us);
+    }
+
+    void start_cycle(PlcState& p, int64_t now_us) {
+        p.cycle_start_us = now_us;
+        if (!p.session->ready()) {          // reconnecting: the poll is missed
+            p.cycle_ok = false;
+            p.cur = 0;
+            end_cycle(p, now_us);
+            return;
+        }
+        p.cycle_ok = true;
+        p.cur = next_slot(p, 0);
+        submit_or_end(p, now_us);
+    }
+
+    void scheduler_task(void*) {
+        //
+        //
+        //
+        for (;;) {
+            int64_t now  = esp_timer_get_time();
+            int64_t wake = now + MAX_SLEEP_US;
+
+            for (size_t i = 0; i < g_count; ++i) {
+                PlcState& p = *g_plcs[i];
+                p.session->tick(now);
+
+                bool ok = false;
+                if (p.session->take_reply(p.reply, ok)) on_reply(p, ok, now);
+                if (p.cur < 0 && now >= p.next_due_us) start_cycle(p, now);
+
+                if (p.cur < 0 && p.next_due_us < wake) wake = p.next_due_us;
+                int64_t d = p.session->next_deadline_us();
+                if (d && d < wake) wake = d;
+                p.state.store((uint8_t)p.session->state(), std::memory_order_relaxed);
+            }
+
+            fd_set rd, wr;
+            FD_ZERO(&rd);
+            FD_ZERO(&wr);
+            int maxfd = -1;
+            for (size_t i = 0; i < g_count; ++i) {
+                const EnipSession& s = *g_plcs[i]->session;
+                if (s.fd() < 0) continue;
+                if (s.wants_read())  FD_SET(s.fd(), &rd);
+                if (s.wants_write()) FD_SET(s.fd(), &wr);
+                if (s.fd() > maxfd) maxfd = s.fd();
+            }
+
+            int64_t sleep_us = wake - now;
+            if (sleep_us < 0) sleep_us = 0;
+            if (maxfd < 0) {
+                vTaskDelay(pdMS_TO_TICKS(sleep_us / 1000) + 1);
+                continue;
+            }
+            timeval tv;
+            tv.tv_sec  = (long)(sleep_us / 1000000);
+            tv.tv_usec = (long)(sleep_us % 1000000);
+            int n = ::select(maxfd + 1, &rd, &wr, nullptr, &tv);
+            CpuProfiler::count_wake();
+            if (n <= 0) continue;
+
+            now = esp_timer_get_time();
+            for (size_t i = 0; i < g_count; ++i) {
+                EnipSession& s = *g_plcs[i]->session;
+                int fd = s.fd();
+                if (fd < 0) continue;
+                s.on_io(FD_ISSET(fd, &rd), FD_ISSET(fd, &wr), now);
+            }
+        }
+    }
+} // Anonymous Namespace
+
+namespace MultiPlcMonitor {
+    bool start(const Plc* plcs, size_t count, const Config& cfg) {
+        //
+        //
+        //
+        if (g_running.load()) return false;
+        if (count == 0 || count > MAX_PLCS) {
+            ESP_LOGE(TAG, "PLC count %u out of range (1..%u)", (unsigned)count, (unsigned)MAX_PLCS);
+            return false;
+        }
+
+        const int64_t now = esp_timer_get_time();
+        for (size_t i = 0; i < count; ++i) {
+            const Plc& in = plcs[i];
+            auto* p = new PlcState();
+            p->name    = in.name ? in.name : in.ip;
+            p->session = new EnipSession(in.ip, in.port, cfg.reply_timeout_ms, cfg.reconnect_ms);
+            p->poll_ms = in.tags.poll_ms ? in.tags.poll_ms : 1;
+            p->tz_offset_minutes = in.tags.tz_offset_minutes;
+
+            const AuditWatch* w[SLOT_COUNT] = {&in.tags.audit, &in.tags.authorized, &in.tags.kp,
+                                                &in.tags.ki, &in.tags.kd, &in.tags.change_stamp};
+            for (int s = 0; s < SLOT_COUNT; ++s) {
+                prepare_read(p->slots[s].req, w[s]->tag, s == STAMP ? 7 : 1, w[s]->type);
+                p->slots[s].type  = w[s]->type;
+                p->slots[s].every = w[s]->every ? w[s]->every : 1;
+            }
+            AuditDetector::Config dcfg;
+            dcfg.kp_epsilon = in.tags.kp.epsilon;
+            dcfg.ki_epsilon = in.tags.ki.epsilon;
+            dcfg.kd_epsilon = in.tags.kd.epsilon;
+            p->detector = AuditDetector(dcfg);
+
+            // Spread the first polls over one period so the PLCs are not read in lockstep
+            p->next_due_us = now + (int64_t)p->poll_ms * 1000 * (int64_t)i / (int64_t)count;
+            g_plcs[i] = p;
+            ESP_LOGI(TAG, "[%s] %s:%u every %lu ms", p->name.c_str(), in.ip, (unsigned)in.port,
+                     (unsigned long)p->poll_ms);
+        }
+        g_count = count;
+
+        TaskHandle_t task = nullptr;
+        if (xTaskCreate(scheduler_task, "multi_plc", STACK_BYTES, nullptr, cfg.priority, &task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create scheduler task");
+            return false;
+        }
+        MemStats::watch_task(task, STACK_BYTES);
+        g_running.store(true);
+        return true;
+    }
+
+    bool running() {
+        return g_running.load();
+    }
+
+    void log_summary(const char* log_tag) {
+        for (size_t i = 0; i < g_count; ++i) {
+            const PlcState& p = *g_plcs[i];
+            ESP_LOGI(log_tag, "PLC %s state=%s polls=%lu fail=%lu changes=%lu cycle=%luus",
+                     p.name.c_str(), state_name((EnipSession::State)p.state.load(std::memory_order_relaxed)),
+                     (unsigned long)p.polls.load(std::memory_order_relaxed),
+                     (unsigned long)p.failures.load(std::memory_order_relaxed),
+                     (unsigned long)p.changes.load(std::memory_order_relaxed),
+                     (unsigned long)p.cycle_us.load(std::memory_order_relaxed));
+        }
+    }
+}
@@ -0,0 +1,273 @@
+// PollSweep.cpp
+// George Lake
+// Fall 2025
+//
+// Poll-period sweep driver and per-trial summary
+// Refer to PollSweep.hpp for notes
+
+
+#include "PollSweep.hpp"
+#include "AuditMonitor.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "LatencyStats.hpp"
+#include "LatencyHistogram.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+#include "EpochTime.hpp"
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+    static const char* TAG = "POLL_SWEEP";
+
+    std::atomic<bool>     g_active{false};
+    std::atomic<bool>     g_measuring{false};     // note_* only count inside the trial window
+    std::atomic<uint32_t> g_polls_ok{0};
+    std::atomic<uint32_t> g_polls_failed{0};
+    std::atomic<uint32_t> g_neg_latency{0};       // stamp later than detection (clock error)
+
+    // Detection latency in ms (the histogram is unit-agnostic; range ~4.6 h)
+    LatencyHistogram g_detect;
+
+    // Last ChangeStamp counted; audit_task is the only writer
+    int64_t g_last_change_ms = -1;
+
+    // Everything one trial reports
+    struct Step {
+        uint32_t step;
+        uint32_t poll_ms;
+        uint32_t trial;
+        uint32_t duration_ms;
+        uint32_t polls_ok;
+        uint32_t polls_failed;
+        uint32_t changes;
+        uint32_t neg_latency;
+        MemStats::HeapSample heap_start;
+        MemStats::HeapSample heap_end;
+        bool     have_cpu;
+        bool     have_load;
+        float    load_pct;
+        float    audit_cpu_pct;
+    };
+
+    double round2(double v) { return (double)(int64_t)(v * 100.0 + (v < 0 ? -0.5 : 0.5)) / 100.0; }
+
+    cJSON* rtt_to_json(const LatencyHistogram& h) {
+        cJSON* o = cJSON_CreateObject();
+        cJSON_AddNumberToObject(o, "count",  h.count());
+        cJSON_AddNumberToObject(o, "p50_us", h.percentile(50));
+        cJSON_AddNumberToObject(o, "p95_us", h.percentile(95));
+        cJSON_AddNumberToObject(o, "p99_us", h.percentile(99));
+        cJSON_AddNumberToObject(o, "max_us", h.max());
+        return o;
+    }
+
+    std::string step_to_json(const Step& s, const LatencyHistogram& rtt, int64_t t_ms) {
+        //
+        //
+        //
+        const uint32_t polls = s.polls_ok + s.polls_failed;
+        const ExperimentMetrics m = Experiment::current();
+
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "poll_sweep_step");
+        cJSON_AddNumberToObject(root, "t_ms", (double)t_ms);
+        cJSON_AddStringToObject(root, "scenario_id", m.scenario_id ? m.scenario_id : "");
+        cJSON_AddNumberToObject(root, "step", s.step);
+        cJSON_AddNumberToObject(root, "trial_id", m.trial_id);
+        cJSON_AddNumberToObject(root, "trial", s.trial);
+        cJSON_AddNumberToObject(root, "poll_period_ms", s.poll_ms);
+        cJSON_AddNumberToObject(root, "duration_ms", s.duration_ms);
+
+        cJSON_AddNumberToObject(root, "polls", polls);
+        cJSON_AddNumberToObject(root, "read_failures", s.polls_failed);
+        cJSON_AddNumberToObject(root, "comm_faults", m.comm_fault_intervals);
+        cJSON_AddNumberToObject(root, "success_pct", polls ? round2(100.0 * s.polls_ok / polls) : 0.0);
+        cJSON_AddNumberToObject(root, "polls_per_s",
+                                s.duration_ms ? round2(1000.0 * polls / s.duration_ms) : 0.0);
+        cJSON_AddItemToObject(root, "rtt", rtt_to_json(rtt));
+
+        cJSON* det = cJSON_AddObjectToObject(root, "detection");
+        cJSON_AddNumberToObject(det, "changes", s.changes);
+        cJSON_AddNumberToObject(det, "stamped", g_detect.count());
+        if (g_detect.count()) {
+            cJSON_AddNumberToObject(det, "mean_ms", g_detect.mean());
+            cJSON_AddNumberToObject(det, "p50_ms",  g_detect.percentile(50));
+            cJSON_AddNumberToObject(det, "p95_ms",  g_detect.percentile(95));
+            cJSON_AddNumberToObject(det, "max_ms",  g_detect.max());
+        }
+        if (s.neg_latency) cJSON_AddNumberToObject(det, "negative", s.neg_latency);
+
+        if (s.have_cpu) {
+            cJSON* cpu = cJSON_AddObjectToObject(root, "cpu");
+            if (s.have_load) cJSON_AddNumberToObject(cpu, "load_pct", round2(s.load_pct));
+            cJSON_AddNumberToObject(cpu, "audit_task_pct", round2(s.audit_cpu_pct));
+        }
+
+        cJSON* heap = cJSON_AddObjectToObject(root, "heap");
+        cJSON_AddNumberToObject(heap, "free_start", s.heap_start.free_bytes);
+        cJSON_AddNumberToObject(heap, "free_end", s.heap_end.free_bytes);
+        cJSON_AddNumberToObject(heap, "min_free", s.heap_end.min_free_bytes);
+        cJSON_AddNumberToObject(heap, "fragmentation_pct", s.heap_end.fragmentation_pct);
+
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        return json;
+    }
+
+    void cpu_for_trial(Step& s, int64_t trial_start_boot_ms) {
+        //
+        // Latest profiler window, if it lies inside the trial
+        //
+        static CpuProfiler::Window w;    // ~1 KB; only the sweep calls this
+        s.have_cpu = CpuProfiler::running() && CpuProfiler::latest(w) &&
+                     w.end_ms - (int64_t)w.window_ms >= trial_start_boot_ms;
+        if (!s.have_cpu) return;
+        s.have_load = w.has_idle;
+        s.load_pct  = 100.0f - w.idle_pct;
+        for (uint32_t i = 0; i < w.task_count; ++i) {
+            if (std::strcmp(w.tasks[i].name, "audit_task") == 0) s.audit_cpu_pct = w.tasks[i].cpu_pct;
+        }
+    }
+} // Anonymous Namespace
+
+namespace PollSweep {
+    bool parse_periods(const char* list, Config& cfg) {
+        //
+        //
+        //
+        cfg.period_count = 0;
+        if (!list) return false;
+        const char* p = list;
+        while (*p) {
+            char* end = nullptr;
+            unsigned long v = std::strtoul(p, &end, 10);
+            if (end == p || v == 0 || v > 600000 || cfg.period_count >= MAX_PERIODS) {
+                ESP_LOGE(TAG, "Bad poll period list '%s'", list);
+                cfg.period_count = 0;
+                return false;
+            }
+            cfg.periods_ms[cfg.period_count++] = (uint32_t)v;
+            p = end;
+            while (*p == ',' || *p == ' ') ++p;
+        }
+        return cfg.period_count > 0;
+    }
+
+    void run(const Config& cfg) {
+        //
+        //
+        //
+        if (cfg.period_count == 0 || cfg.trials == 0) return;
+        g_active.store(true);
+
+        const uint32_t total = (uint32_t)cfg.period_count * cfg.trials;
+        ESP_LOGI(TAG, "Sweep start: %u periods x %lu trials x %lu ms",
+                 (unsigned)cfg.period_count, (unsigned long)cfg.trials, (unsigned long)cfg.trial_ms);
+
+        uint32_t step = 0;
+        for (size_t pi = 0; pi < cfg.period_count; ++pi) {
+            const uint32_t poll_ms = cfg.periods_ms[pi];
+            for (uint32_t trial = 1; trial <= cfg.trials; ++trial) {
+                ++step;
+
+                // Settle: the audit task may still be sleeping on the previous period
+                const uint32_t prev_ms = audit_poll_ms();
+                set_audit_poll_ms(poll_ms);
+                Experiment::set_trial((int)step, poll_ms);
+                uint32_t settle = cfg.settle_ms;
+                if (settle < 2 * prev_ms) settle = 2 * prev_ms;
+                vTaskDelay(pdMS_TO_TICKS(settle));
+
+                // Measured window
+                g_measuring.store(false);
+                Experiment::reset_metrics();
+                g_detect.reset();
+                g_polls_ok.store(0);
+                g_polls_failed.store(0);
+                g_neg_latency.store(0);
+
+                Step s{};
+                s.step       = step;
+                s.poll_ms    = poll_ms;
+                s.trial      = trial;
+                s.heap_start = MemStats::sample_heap(Experiment::timestamp_ms());
+                const int64_t t0 = EpochTime::espNowMs();
+                g_measuring.store(true);
+
+                vTaskDelay(pdMS_TO_TICKS(cfg.trial_ms));
+
+                g_measuring.store(false);
+                s.duration_ms  = (uint32_t)(EpochTime::espNowMs() - t0);
+                s.polls_ok     = g_polls_ok.load();
+                s.polls_failed = g_polls_failed.load();
+                s.neg_latency  = g_neg_latency.load();
+                const ExperimentMetrics m = Experiment::current();
+                s.changes = m.authorized_audit_changes + m.unauthorized_audit_changes +
+                            m.authorized_pid_changes + m.unauthorized_pid_changes;
+                cpu_for_trial(s, t0);
+
+                const int64_t t = Experiment::timestamp_ms();
+                s.heap_end = MemStats::sample_heap(t);
+
+                static const LatencyHistogram EMPTY;
+                const LatencyHistogram* rtt = LatencyStats::stage_histogram(LatencyStats::Stage::WAIT);
+                if (!rtt) rtt = &EMPTY;
+
+                const uint32_t polls = s.polls_ok + s.polls_failed;
+                ESP_LOGI(TAG,
+                         "SWEEP step=%lu/%lu poll=%lums trial=%lu polls=%lu ok=%.2f%% "
+                         "rtt p50=%luus p99=%luus det n=%lu p50=%lums p95=%lums",
+                         (unsigned long)step, (unsigned long)total, (unsigned long)poll_ms,
+                         (unsigned long)trial, (unsigned long)polls,
+                         polls ? 100.0 * s.polls_ok / polls : 0.0,
+                         (unsigned long)rtt->percentile(50), (unsigned long)rtt->percentile(99),
+                         (unsigned long)g_detect.count(), (unsigned long)g_detect.percentile(50),
+                         (unsigned long)g_detect.percentile(95));
+                Experiment::emit_record(step_to_json(s, *rtt, t), t);
+            }
+        }
+
+        set_audit_poll_ms(cfg.restore_ms);
+        Experiment::set_trial((int)step + 1, cfg.restore_ms);
+        g_active.store(false);
+        ESP_LOGI(TAG, "Sweep done: %lu trials; poll period back to %lu ms",
+                 (unsigned long)total, (unsigned long)cfg.restore_ms);
+    }
+
+    bool active() {
+        return g_active.load();
+    }
+
+    void note_poll(bool ok) {
+        if (!g_measuring.load(std::memory_order_relaxed)) return;
+        (ok ? g_polls_ok : g_polls_failed).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void note_detection(int64_t detect_ms, int64_t change_ms) {
+        //
+        // A stamp seen again (PID and AuditValue changes in later polls) is not a new change
+        //
+        if (change_ms == g_last_change_ms) return;
+        g_last_change_ms = change_ms;
+        if (!g_measuring.load(std::memory_order_relaxed)) return;
+
+        int64_t latency = detect_ms - change_ms;
+        if (latency < 0) {
+            g_neg_latency.fetch_add(1, std::memory_order_relaxed);
+            latency = 0;
+        }
+        if (latency > (int64_t)LatencyHistogram::MAX_US) latency = LatencyHistogram::MAX_US;
+        g_detect.record((uint32_t)latency);
+    }
+}
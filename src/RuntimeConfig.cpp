@@ -0,0 +1,429 @@
+// RuntimeConfig.cpp
+// George Lake
+// Fall 2025
+//
+// Boot-time JSON configuration
+// Refer to RuntimeConfig.hpp for notes
+
+
+#include "RuntimeConfig.hpp"
+#include "MultiPlcMonitor.hpp"
+
+#include "esp_log.h"
+#include "cJSON.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+    static const char* TAG = "RT_CONFIG";
+
+    constexpr size_t MAX_FILE_BYTES = 8192;
+
+    using RuntimeConfig::Role;
+
+    const char* const ROLE_NAMES[(size_t)Role::COUNT] = {
+        "audit", "authorized", "kp", "ki", "kd", "change_stamp"
+    };
+
+    struct TypeName {
+        const char* name;
+        Cip::Type   type;
+        uint16_t    elements;
+    };
+    const TypeName TYPES[] = {
+        {"BOOL", Cip::Type::BOOL, 1}, {"SINT", Cip::Type::SINT, 1}, {"INT", Cip::Type::INT, 1},
+        {"DINT", Cip::Type::DINT, 1}, {"LINT", Cip::Type::LINT, 1}, {"REAL", Cip::Type::REAL, 1},
+        {"DINT[7]", Cip::Type::DINT, 7},
+    };
+
+    const char* type_name(Cip::Type t, uint16_t elements) {
+        for (const TypeName& n : TYPES) {
+            if (n.type == t && n.elements == elements) return n.name;
+        }
+        return "?";
+    }
+
+    // Types each role can be read as (AuditMonitor converts the integers)
+    bool role_accepts(Role r, Cip::Type t, uint16_t elements) {
+        switch (r) {
+            case Role::AUDIT:
+                return elements == 1 && (t == Cip::Type::SINT || t == Cip::Type::INT ||
+                                         t == Cip::Type::DINT || t == Cip::Type::LINT);
+            case Role::AUTHORIZED:
+                return elements == 1 && (t == Cip::Type::BOOL || t == Cip::Type::SINT ||
+                                         t == Cip::Type::INT  || t == Cip::Type::DINT);
+            case Role::KP: case Role::KI: case Role::KD:
+                return elements == 1 && t == Cip::Type::REAL;
+            case Role::CHANGE_STAMP:
+                return elements == 7 && t == Cip::Type::DINT;
+            default:
+                return false;
+        }
+    }
+
+    // ".Member" -> base + ".Member"; anything else is already a full symbol
+    std::string resolve_name(const std::string& name, const std::string& base) {
+        return (!name.empty() && name[0] == '.') ? base + name : name;
+    }
+
+    void resolve(RuntimeConfig::Config& cfg) {
+        for (RuntimeConfig::TagSpec& t : cfg.tags) {
+            t.symbol = resolve_name(t.name, cfg.base);
+        }
+        for (RuntimeConfig::WriteSpec& w : cfg.containment) {
+            w.symbol = resolve_name(w.name, cfg.base);
+        }
+        for (RuntimeConfig::PlcSpec& p : cfg.plcs) {
+            const std::string& base = p.base.empty() ? cfg.base : p.base;
+            for (size_t i = 0; i < (size_t)Role::COUNT; ++i) {
+                p.symbols[i] = resolve_name(cfg.tags[i].name, base);
+            }
+        }
+    }
+
+    const cJSON* item(const cJSON* obj, const char* key) {
+        return obj ? cJSON_GetObjectItemCaseSensitive(obj, key) : nullptr;
+    }
+
+    bool get_string(const cJSON* obj, const char* key, std::string& out) {
+        const cJSON* v = item(obj, key);
+        if (!v) return true;
+        if (!cJSON_IsString(v)) { ESP_LOGE(TAG, "'%s' must be a string", key); return false; }
+        out = v->valuestring;
+        return true;
+    }
+
+    template <typename T>
+    bool get_number(const cJSON* obj, const char* key, T& out, double lo, double hi) {
+        const cJSON* v = item(obj, key);
+        if (!v) return true;
+        if (!cJSON_IsNumber(v) || v->valuedouble < lo || v->valuedouble > hi) {
+            ESP_LOGE(TAG, "'%s' must be a number in [%g, %g]", key, lo, hi);
+            return false;
+        }
+        out = (T)v->valuedouble;
+        return true;
+    }
+
+    bool get_bool(const cJSON* obj, const char* key, bool& out) {
+        const cJSON* v = item(obj, key);
+        if (!v) return true;
+        if (!cJSON_IsBool(v)) { ESP_LOGE(TAG, "'%s' must be true/false", key); return false; }
+        out = cJSON_IsTrue(v);
+        return true;
+    }
+
+    bool parse_tag(const cJSON* obj, Role role, RuntimeConfig::TagSpec& t) {
+        //
+        //
+        //
+        const char* role_name = ROLE_NAMES[(size_t)role];
+        if (!cJSON_IsObject(obj)) { ESP_LOGE(TAG, "tags.%s must be an object", role_name); return false; }
+
+        if (!get_string(obj, "name", t.name)) return false;
+        if (t.name.empty() && role != Role::CHANGE_STAMP) {
+            ESP_LOGE(TAG, "tags.%s: name is required", role_name);
+            return false;
+        }
+
+        std::string type;
+        if (!get_string(obj, "type", type)) return false;
+        if (!type.empty()) {
+            const TypeName* found = nullptr;
+            for (const TypeName& n : TYPES) {
+                if (type == n.name) found = &n;
+            }
+            if (!found || !role_accepts(role, found->type, found->elements)) {
+                ESP_LOGE(TAG, "tags.%s: type '%s' not supported for this tag", role_name, type.c_str());
+                return false;
+            }
+            t.type     = found->type;
+            t.elements = found->elements;
+        }
+
+        if (!get_number(obj, "every", t.every, 1, 1000)) return false;
+
+        std::string compare;
+        if (!get_string(obj, "compare", compare)) return false;
+        if (!compare.empty() && t.type != Cip::Type::REAL) {
+            ESP_LOGE(TAG, "tags.%s: 'compare' applies to REAL tags only", role_name);
+            return false;
+        }
+        if (compare == "exact") {
+            t.epsilon = 0.0f;
+        } else if (compare == "epsilon") {
+            if (!item(obj, "epsilon")) { ESP_LOGE(TAG, "tags.%s: 'epsilon' missing", role_name); return false; }
+        } else if (!compare.empty()) {
+            ESP_LOGE(TAG, "tags.%s: compare must be 'exact' or 'epsilon'", role_name);
+            return false;
+        }
+        if (compare != "exact" && !get_number(obj, "epsilon", t.epsilon, 0.0, 1e9)) return false;
+        return true;
+    }
+
+    bool parse_plcs(const cJSON* arr, RuntimeConfig::Config& c) {
+        //
+        //
+        //
+        if (!cJSON_IsArray(arr)) { ESP_LOGE(TAG, "'plcs' must be an array"); return false; }
+        int n = cJSON_GetArraySize(arr);
+        if (n > (int)MultiPlcMonitor::MAX_PLCS) {
+            ESP_LOGE(TAG, "'plcs' has %d entries (max %u)", n, (unsigned)MultiPlcMonitor::MAX_PLCS);
+            return false;
+        }
+        c.plcs.clear();
+        for (int i = 0; i < n; ++i) {
+            const cJSON* obj = cJSON_GetArrayItem(arr, i);
+            if (!cJSON_IsObject(obj)) { ESP_LOGE(TAG, "plcs[%d] must be an object", i); return false; }
+            RuntimeConfig::PlcSpec p;
+            if (!get_string(obj, "name", p.name)) return false;
+            if (!get_string(obj, "ip", p.ip)) return false;
+            if (!get_number(obj, "port", p.port, 1, 65535)) return false;
+            if (!get_string(obj, "base", p.base)) return false;
+            if (p.ip.empty()) { ESP_LOGE(TAG, "plcs[%d]: ip is required", i); return false; }
+            if (p.name.empty()) p.name = p.ip;
+            c.plcs.push_back(std::move(p));
+        }
+        return true;
+    }
+
+    // Numeric JSON value into v for v.type, range-checked for that type
+    bool set_write_value(const cJSON* num, Cip::Value& v) {
+        if (!cJSON_IsNumber(num)) return false;
+        const double d = num->valuedouble;
+        switch (v.type) {
+            case Cip::Type::BOOL: if (d != 0 && d != 1) return false;            v.v.b   = d != 0;     return true;
+            case Cip::Type::SINT: if (d < -128 || d > 127) return false;         v.v.i8  = (int8_t)d;  return true;
+            case Cip::Type::INT:  if (d < -32768 || d > 32767) return false;     v.v.i16 = (int16_t)d; return true;
+            case Cip::Type::DINT: if (d < -2147483648.0 || d > 2147483647.0) return false;
+                                  v.v.i32 = (int32_t)d; return true;
+            case Cip::Type::LINT: if (d < -9.2e18 || d > 9.2e18) return false;   v.v.i64 = (int64_t)d; return true;
+            case Cip::Type::REAL: v.v.f32 = (float)d; return true;
+            default:              return false;
+        }
+    }
+
+    bool parse_containment(const cJSON* arr, RuntimeConfig::Config& c) {
+        //
+        //
+        //
+        if (!cJSON_IsArray(arr)) { ESP_LOGE(TAG, "'containment' must be an array"); return false; }
+        int n = cJSON_GetArraySize(arr);
+        if (n > (int)Containment::MAX_ACTIONS) {
+            ESP_LOGE(TAG, "'containment' has %d entries (max %u)", n, (unsigned)Containment::MAX_ACTIONS);
+            return false;
+        }
+        c.containment.clear();
+        for (int i = 0; i < n; ++i) {
+            const cJSON* obj = cJSON_GetArrayItem(arr, i);
+            if (!cJSON_IsObject(obj)) { ESP_LOGE(TAG, "containment[%d] must be an object", i); return false; }
+            RuntimeConfig::WriteSpec w;
+            std::string type;
+            if (!get_string(obj, "name", w.name) || !get_string(obj, "type", type)) return false;
+            if (w.name.empty()) { ESP_LOGE(TAG, "containment[%d]: name is required", i); return false; }
+            for (const TypeName& t : TYPES) {
+                if (type == t.name && t.elements == 1) w.value.type = t.type;
+            }
+            if (w.value.type == Cip::Type::UNSUPPORTED) {
+                ESP_LOGE(TAG, "containment[%d]: type '%s' is not a scalar type", i, type.c_str());
+                return false;
+            }
+            if (!set_write_value(item(obj, "value"), w.value)) {
+                ESP_LOGE(TAG, "containment[%d]: 'value' missing or out of range for %s", i, type.c_str());
+                return false;
+            }
+            c.containment.push_back(std::move(w));
+        }
+        return true;
+    }
+
+    bool parse_into(const cJSON* root, RuntimeConfig::Config& c) {
+        //
+        //
+        //
+        if (!cJSON_IsObject(root)) { ESP_LOGE(TAG, "top level must be an object"); return false; }
+
+        const cJSON* plc = item(root, "plc");
+        if (!get_string(plc, "ip", c.plc_ip)) return false;
+        if (!get_number(plc, "port", c.plc_port, 1, 65535)) return false;
+        if (!get_number(plc, "tz_offset_minutes", c.tz_offset_minutes, -1440, 1440)) return false;
+
+        if (!get_string(root, "base", c.base)) return false;
+        if (!get_number(root, "poll_ms", c.poll_ms, 1, 600000)) return false;
+
+        const cJSON* sc = item(root, "scenario");
+        if (!get_string(sc, "id", c.scenario_id)) return false;
+        if (!get_string(sc, "variant", c.scenario_variant)) return false;
+        if (!get_number(sc, "trial_id", c.trial_id, 0, 1e9)) return false;
+        if (!get_bool(sc, "change_expected", c.change_expected)) return false;
+        if (!get_string(sc, "change_type", c.change_type)) return false;
+        if (!get_string(sc, "esp_firmware_version", c.esp_firmware_version)) return false;
+        if (!get_string(sc, "plc_firmware_version", c.plc_firmware_version)) return false;
+
+        const cJSON* tags = item(root, "tags");
+        for (size_t i = 0; i < (size_t)Role::COUNT; ++i) {
+            const cJSON* t = item(tags, ROLE_NAMES[i]);
+            if (t && !parse_tag(t, (Role)i, c.tags[i])) return false;
+        }
+
+        const cJSON* plcs = item(root, "plcs");
+        if (plcs && !parse_plcs(plcs, c)) return false;
+
+        const cJSON* containment = item(root, "containment");
+        if (containment && !parse_containment(containment, c)) return false;
+        return true;
+    }
+} // Anonymous Namespace
+
+namespace RuntimeConfig {
+    const char* role_name(Role r) {
+        size_t i = (size_t)r;
+        return i < (size_t)Role::COUNT ? ROLE_NAMES[i] : "?";
+    }
+
+    Config defaults(const char* plc_ip, uint16_t plc_port, const char* base,
+                    int32_t tz_offset_minutes, uint32_t poll_ms) {
+        //
+        //
+        //
+        Config c;
+        c.plc_ip            = plc_ip ? plc_ip : "";
+        c.plc_port          = plc_port;
+        c.tz_offset_minutes = tz_offset_minutes;
+        c.base              = base ? base : "";
+        c.poll_ms           = poll_ms;
+
+        c.tags[(size_t)Role::AUDIT]        = TagSpec{".AuditValue",     "", Cip::Type::LINT, 1};
+        c.tags[(size_t)Role::AUTHORIZED]   = TagSpec{".AuthorizedUser", "", Cip::Type::DINT, 1};
+        c.tags[(size_t)Role::KP]           = TagSpec{".WDG_Kp",         "", Cip::Type::REAL, 1};
+        c.tags[(size_t)Role::KI]           = TagSpec{".WDG_Ki",         "", Cip::Type::REAL, 1};
+        c.tags[(size_t)Role::KD]           = TagSpec{".WDG_Kd",         "", Cip::Type::REAL, 1};
+        c.tags[(size_t)Role::CHANGE_STAMP] = TagSpec{".ChangeStamp",    "", Cip::Type::DINT, 7};
+        resolve(c);
+        return c;
+    }
+
+    bool parse(const char* json, Config& cfg) {
+        //
+        // Parse into a copy so a bad file cannot leave a half-applied config
+        //
+        cJSON* root = cJSON_Parse(json);
+        if (!root) { ESP_LOGE(TAG, "Not valid JSON"); return false; }
+        Config next = cfg;
+        bool ok = parse_into(root, next);
+        cJSON_Delete(root);
+        if (!ok) return false;
+        resolve(next);
+        cfg = std::move(next);
+        return true;
+    }
+
+    bool load(const char* path, Config& cfg) {
+        //
+        //
+        //
+        FILE* f = std::fopen(path, "rb");
+        if (!f) {
+            ESP_LOGW(TAG, "%s not found; using built-in configuration", path);
+            return false;
+        }
+        std::string text(MAX_FILE_BYTES + 1, '\0');
+        size_t n = std::fread(&text[0], 1, text.size(), f);
+        std::fclose(f);
+        if (n > MAX_FILE_BYTES) {
+            ESP_LOGE(TAG, "%s is larger than %u bytes", path, (unsigned)MAX_FILE_BYTES);
+            return false;
+        }
+        text.resize(n);
+
+        if (!parse(text.c_str(), cfg)) {
+            ESP_LOGE(TAG, "%s rejected; using built-in configuration", path);
+            return false;
+        }
+        ESP_LOGI(TAG, "Loaded %s", path);
+        return true;
+    }
+
+    void log(const Config& cfg, const char* log_tag) {
+        ESP_LOGI(log_tag, "CONFIG plc=%s:%u tz=%ld poll=%lums scenario=%s/%s trial=%d change=%s(%s) fw=%s/%s",
+                 cfg.plc_ip.c_str(), (unsigned)cfg.plc_port, (long)cfg.tz_offset_minutes,
+                 (unsigned long)cfg.poll_ms, cfg.scenario_id.c_str(), cfg.scenario_variant.c_str(),
+                 cfg.trial_id, cfg.change_expected ? "expected" : "none", cfg.change_type.c_str(),
+                 cfg.esp_firmware_version.c_str(), cfg.plc_firmware_version.c_str());
+        for (size_t i = 0; i < (size_t)Role::COUNT; ++i) {
+            const TagSpec& t = cfg.tags[i];
+            if (t.symbol.empty()) {
+                ESP_LOGI(log_tag, "CONFIG tag %s: off", ROLE_NAMES[i]);
+            } else if (t.type == Cip::Type::REAL) {
+                ESP_LOGI(log_tag, "CONFIG tag %s: %s %s every=%u eps=%g", ROLE_NAMES[i], t.symbol.c_str(),
+                         type_name(t.type, t.elements), (unsigned)t.every, (double)t.epsilon);
+            } else {
+                ESP_LOGI(log_tag, "CONFIG tag %s: %s %s every=%u", ROLE_NAMES[i], t.symbol.c_str(),
+                         type_name(t.type, t.elements), (unsigned)t.every);
+            }
+        }
+        for (const PlcSpec& p : cfg.plcs) {
+            ESP_LOGI(log_tag, "CONFIG plc %s: %s:%u base=%s", p.name.c_str(), p.ip.c_str(),
+                     (unsigned)p.port, p.base.empty() ? cfg.base.c_str() : p.base.c_str());
+        }
+        for (const WriteSpec& w : cfg.containment) {
+            if (w.value.type == Cip::Type::REAL) {
+                ESP_LOGI(log_tag, "CONFIG contain %s %s := %g", w.symbol.c_str(), type_name(w.value.type, 1),
+                         (double)w.value.v.f32);
+            } else {
+                ESP_LOGI(log_tag, "CONFIG contain %s %s := %lld", w.symbol.c_str(), type_name(w.value.type, 1),
+                         (long long)Cip::as_int64(w.value));
+            }
+        }
+    }
+
+    AuditMonitorConfig audit_monitor_config(const Config& cfg) {
+        //
+        //
+        //
+        auto watch = [&](Role r) {
+            const TagSpec& t = cfg.tag(r);
+            AuditWatch w;
+            w.tag     = t.symbol.empty() ? nullptr : t.symbol.c_str();
+            w.type    = t.type;
+            w.every   = t.every;
+            w.epsilon = t.epsilon;
+            return w;
+        };
+        AuditMonitorConfig mc;
+        mc.audit        = watch(Role::AUDIT);
+        mc.authorized   = watch(Role::AUTHORIZED);
+        mc.kp           = watch(Role::KP);
+        mc.ki           = watch(Role::KI);
+        mc.kd           = watch(Role::KD);
+        mc.change_stamp = watch(Role::CHANGE_STAMP);
+        mc.poll_ms      = cfg.poll_ms;
+        mc.tz_offset_minutes = cfg.tz_offset_minutes;
+        return mc;
+    }
+
+    AuditMonitorConfig audit_monitor_config(const Config& cfg, size_t plc_index) {
+        //
+        // Shared watchlist, per-PLC symbols
+        //
+        AuditMonitorConfig mc = audit_monitor_config(cfg);
+        if (plc_index >= cfg.plcs.size()) return mc;
+        const std::string* sym = cfg.plcs[plc_index].symbols;
+        AuditWatch* w[(size_t)Role::COUNT] = {&mc.audit, &mc.authorized, &mc.kp, &mc.ki, &mc.kd, &mc.change_stamp};
+        for (size_t i = 0; i < (size_t)Role::COUNT; ++i) {
+            w[i]->tag = sym[i].empty() ? nullptr : sym[i].c_str();
+        }
+        return mc;
+    }
+
+    size_t containment_actions(const Config& cfg, Containment::Action (&out)[Containment::MAX_ACTIONS]) {
+        size_t n = 0;
+        for (const WriteSpec& w : cfg.containment) {
+            if (n == Containment::MAX_ACTIONS) break;
+            out[n++] = Containment::Action{w.symbol.c_str(), w.value};
+        }
+        return n;
+    }
+}
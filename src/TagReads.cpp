@@ -7,80 +7,151 @@
 #include <vector>
 #include <array>
 #include "CipCodec.hpp"
+#include "CipStatus.hpp"
 #include "EnipClient.hpp"
 #include "TagReads.hpp"
+#include "LatencyStats.hpp"
+
+using LatencyStats::Stage;
+
+namespace {
+    // Feeds the SEND/WAIT split measured inside EnipClient into the stage histograms
+    void record_transport(const EnipClient::RrTiming& t) {
+        LatencyStats::record_stage_us(Stage::SEND, t.send_us);
+        LatencyStats::record_stage_us(Stage::WAIT, t.wait_us);
+    }
+
+    // Send an encoded SendRRData body and parse a one-element reply
+    bool transact_scalar(EnipClient& enip, const PreparedRead& req, int64_t t_start,
+                         Cip::Value& out, EnipClient::Priority prio, Cip::Status* status) {
+        std::vector<uint8_t> rr_body;
+        EnipClient::RrTiming timing;
+        if (!enip.send_rr_data(req.rr, rr_body, &timing, prio, status)) return false;
+        record_transport(timing);
+
+        int64_t t_parse = LatencyStats::now_us();
+        bool ok = parse_prepared_rr(req, rr_body, out);
+        LatencyStats::record_stage(Stage::PARSE, t_parse);
+        if (ok) LatencyStats::record_tag(req.tag, (uint32_t)(LatencyStats::now_us() - t_start));
+        else if (status) Cip::read_status(rr_body, *status);
+        return ok;
+    }
+
+    // One-shot typed read: encode, send, fixed-layout decode
+    template<typename T>
+    bool read_typed(EnipClient& enip, const char* tag, T& out) {
+        int64_t t_start = LatencyStats::now_us();
+        Cip::TypedRead<T> req;
+        if (!req.prepare(tag)) return false;
+        LatencyStats::record_stage(Stage::ENCODE, t_start);
+
+        std::vector<uint8_t> rr_body;
+        EnipClient::RrTiming timing;
+        if (!enip.send_rr_data(req.rr, rr_body, &timing)) return false;
+        record_transport(timing);
+
+        int64_t t_parse = LatencyStats::now_us();
+        bool ok = Cip::TypedRead<T>::decode(rr_body, out);
+        LatencyStats::record_stage(Stage::PARSE, t_parse);
+        if (!ok) return false;
+        LatencyStats::record_tag(tag, (uint32_t)(LatencyStats::now_us() - t_start));
+        return true;
+    }
+
+    // Same for a DINT[7] reply (DateTime / ChangeStamp layout)
+    bool transact_dint_array7(EnipClient& enip, const char* tag, const std::vector<uint8_t>& rr,
+                              int64_t t_start, std::array<int32_t,7>& out, EnipClient::RrTiming* timing_out,
+                              EnipClient::Priority prio, Cip::Status* status = nullptr) {
+        std::vector<uint8_t> rr_body;
+        EnipClient::RrTiming timing;
+        if (!enip.send_rr_data(rr, rr_body, &timing, prio, status)) return false;
+        record_transport(timing);
+        if (timing_out) *timing_out = timing;
+
+        int64_t t_parse = LatencyStats::now_us();
+        bool ok = parse_dint_array7_rr(rr_body, out);
+        LatencyStats::record_stage(Stage::PARSE, t_parse);
+        if (!ok) {
+            if (status) Cip::read_status(rr_body, *status);
+            return false;
+        }
+        LatencyStats::record_tag(tag, (uint32_t)(LatencyStats::now_us() - t_start));
+        return true;
+    }
+}
+
+bool parse_scalar_rr(const std::vector<uint8_t>& rr_body, Cip::Value& out) {
+    std::vector<uint8_t> cip_reply;
+    return Cip::extract_cip_from_rr(rr_body, cip_reply) && Cip::parse_read_reply(cip_reply, out);
+}
+
+bool parse_prepared_rr(const PreparedRead& req, const std::vector<uint8_t>& rr_body, Cip::Value& out) {
+    return req.decode ? req.decode(rr_body, out) : parse_scalar_rr(rr_body, out);
+}
+
+bool parse_dint_array7_rr(const std::vector<uint8_t>& rr_body, std::array<int32_t,7>& out) {
+    return Cip::TypedRead<int32_t, 7>::decode(rr_body, out);
+}
 
 bool read_tag_scalar(EnipClient& enip, const char* tag, Cip::Value& out) {
     //
     //
     //
-    auto cip = Cip::build_read_request(tag, 1);
-    auto rr  = Cip::wrap_sendrr(cip);
-    std::vector<uint8_t> rr_body, cip_reply;
-    if (!enip.send_rr_data(rr, rr_body)) return false;
-    if (!Cip::extract_cip_from_rr(rr_body, cip_reply)) return false;
-    return Cip::parse_read_reply(cip_reply, out);
+    int64_t t_start = LatencyStats::now_us();
+    PreparedRead req;
+    req.tag = tag;
+    req.rr  = Cip::wrap_sendrr(Cip::build_read_request(tag, 1));
+    LatencyStats::record_stage(Stage::ENCODE, t_start);
+    return transact_scalar(enip, req, t_start, out, EnipClient::Priority::NORMAL, nullptr);
 }
 
 bool read_dint(EnipClient& enip, const char* tag, int32_t& out) {
-    //
-    //
-    //
-    Cip::Value v{};
-    if (!read_tag_scalar(enip, tag, v)) return false;
-    if (v.type != Cip::Type::DINT) return false;
-    out = v.v.i32;
-    return true;
+    return read_typed(enip, tag, out);
 }
 
 bool read_lint(EnipClient& enip, const char* tag, int64_t& out) {
-    //
-    //
-    //
-    Cip::Value v{};
-    if (!read_tag_scalar(enip, tag, v)) return false;
-    if (v.type != Cip::Type::LINT) return false;
-    out = v.v.i64;
-    return true;
+    return read_typed(enip, tag, out);
 }
 
 bool read_real(EnipClient& enip, const char* tag, float& out) {
+    return read_typed(enip, tag, out);
+}
+
+bool read_dint_array7(EnipClient& enip, const char* base, std::array<int32_t,7>& out,
+                      EnipClient::RrTiming* timing_out, EnipClient::Priority prio) {
     //
     //
     //
-    Cip::Value v{};
-    if (!read_tag_scalar(enip, tag, v)) return false;
-    if (v.type != Cip::Type::REAL) return false;
-    out = v.v.f32;
-    return true;
+    int64_t t_start = LatencyStats::now_us();
+    auto cip = Cip::build_read_request(base, /*elements*/7);
+    auto rr  = Cip::wrap_sendrr(cip);
+    LatencyStats::record_stage(Stage::ENCODE, t_start);
+    return transact_dint_array7(enip, base, rr, t_start, out, timing_out, prio);
 }
 
-bool read_dint_array7(EnipClient& enip, const char* base, std::array<int32_t,7>& out) {
+bool prepare_read(PreparedRead& req, const char* tag, uint16_t elements, Cip::Type expect) {
     //
     //
     //
-    auto cip = Cip::build_read_request(base, /*elements*/7);
-    auto rr  = Cip::wrap_sendrr(cip);
-    std::vector<uint8_t> rr_body, c;
-    if (!enip.send_rr_data(rr, rr_body)) return false;
-    if (!Cip::extract_cip_from_rr(rr_body, c)) return false;
-
-    if (c.size() < 4 || (c[0] & 0x80) == 0) return false;
-    uint8_t gen = c[2], ext = c[3];
-    if (gen != 0) return false;
-    size_t data_off = 4 + ext*2;
-    if (c.size() < data_off + 2) return false;
-
-    uint16_t type_id = c[data_off] | (c[data_off+1] << 8);
-    if (type_id != 0x00C4) return false; // DINT
-    size_t val_off = data_off + 2;
-    size_t need = 7 * 4;
-    if (c.size() < val_off + need) return false;
-
-    for (int i = 0; i < 7; ++i) {
-        size_t p = val_off + i*4;
-        uint32_t u = (uint32_t)c[p] | ((uint32_t)c[p+1] << 8) | ((uint32_t)c[p+2] << 16) | ((uint32_t)c[p+3] << 24);
-        out[i] = (int32_t)u;
-    }
+    req.tag      = tag;
+    req.elements = elements;
+    req.decode   = elements == 1 ? Cip::value_decoder(expect) : nullptr;
+    req.rr.clear();
+    if (!tag || tag[0] == '\0' || elements == 0) return false;
+    req.rr = Cip::wrap_sendrr(Cip::build_read_request(tag, elements));
     return true;
 }
+
+bool read_prepared(EnipClient& enip, const PreparedRead& req, Cip::Value& out, EnipClient::Priority prio,
+                   Cip::Status* status) {
+    if (status) *status = Cip::Status{Cip::Status::Layer::REPLY};
+    if (req.rr.empty() || req.elements != 1) return false;
+    return transact_scalar(enip, req, LatencyStats::now_us(), out, prio, status);
+}
+
+bool read_prepared_dint_array7(EnipClient& enip, const PreparedRead& req, std::array<int32_t,7>& out,
+                               EnipClient::RrTiming* timing, EnipClient::Priority prio, Cip::Status* status) {
+    if (status) *status = Cip::Status{Cip::Status::Layer::REPLY};
+    if (req.rr.empty() || req.elements != 7) return false;
+    return transact_dint_array7(enip, req.tag, req.rr, LatencyStats::now_us(), out, timing, prio, status);
+}
@@ -0,0 +1,293 @@
+// TimeSync.cpp
+// George Lake
+// Fall 2025
+//
+// PLC clock sampling, linear drift fit and slewed clock mapping
+// Refer to TimeSync.hpp for notes
+
+
+#include "TimeSync.hpp"
+#include "CipCodec.hpp"
+#include "EnipClient.hpp"
+#include "EpochTime.hpp"
+#include "CpuProfiler.hpp"
+#include "MemStats.hpp"
+#include "SeqLock.hpp"
+#include "TagReads.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <array>
+#include <cinttypes>
+#include <vector>
+
+namespace {
+    static const char* TAG = "TIME_SYNC";
+
+    // CIP Wall Clock Time object, attribute 11 = ULINT microseconds since 1970-01-01 UTC
+    constexpr uint16_t WALL_CLOCK_CLASS    = 0x8B;
+    constexpr uint16_t WALL_CLOCK_INSTANCE = 1;
+    constexpr uint16_t WALL_CLOCK_US_ATTR  = 11;
+
+    constexpr size_t   MAX_WINDOW  = 32;
+    constexpr uint32_t STACK_BYTES = 3072;
+
+    struct Sample {
+        int64_t esp_mid_us;     // midpoint of the request round trip
+        int64_t offset_us;      // plc_us - esp_mid_us
+    };
+
+    TimeSync::Config  g_cfg{};
+    EnipClient*       g_enip = nullptr;
+    SemaphoreHandle_t g_lock = nullptr;      // sampler state + status
+    TimeSync::Status  g_status{};
+
+    std::array<Sample,   MAX_WINDOW> g_samples{};
+    std::array<uint32_t, MAX_WINDOW> g_rtts{};
+    size_t g_sample_count = 0;
+    size_t g_rtt_count    = 0, g_rtt_next    = 0;
+
+    // Applied mapping, read on every now_ms():
+    //   plc(esp) = base_plc + d + d * dev / 1e9, d = esp - base_esp,
+    //   with dev = slew_ppb until slew_until, nominal_ppb afterwards
+    SeqLock      g_map_lock;
+    SeqLock::U64 g_base_esp_us, g_base_plc_us, g_slew_until_us, g_slew_ppb, g_nominal_ppb;
+    std::atomic<bool> g_synced{false};
+
+    inline int64_t scaled(int64_t d, int64_t ppb) { return d + d * ppb / 1000000000; }
+
+    int64_t map_locked(int64_t esp_us) {
+        int64_t base_esp = g_base_esp_us.load(), base_plc = g_base_plc_us.load();
+        int64_t until = g_slew_until_us.load();
+        int64_t slew = g_slew_ppb.load(), nominal = g_nominal_ppb.load();
+        if (esp_us <= until) return base_plc + scaled(esp_us - base_esp, slew);
+        return base_plc + scaled(until - base_esp, slew) + scaled(esp_us - until, nominal);
+    }
+
+    int64_t applied_at(int64_t esp_us) {
+        int64_t out = 0;
+        g_map_lock.read([&] { out = map_locked(esp_us); });
+        return out;
+    }
+
+    bool read_wall_clock(int64_t& plc_us, EnipClient::RrTiming& t) {
+        auto cip = Cip::build_get_attribute_list(WALL_CLOCK_CLASS, WALL_CLOCK_INSTANCE, WALL_CLOCK_US_ATTR);
+        auto rr  = Cip::wrap_sendrr(cip);
+        std::vector<uint8_t> rr_body, c, value;
+        if (!g_enip->send_rr_data(rr, rr_body, &t, EnipClient::Priority::LOW)) return false;
+        if (!Cip::extract_cip_from_rr(rr_body, c)) return false;
+        if (!Cip::parse_get_attribute_list_reply(c, WALL_CLOCK_US_ATTR, value) || value.size() < 8) return false;
+        uint64_t u = 0;
+        for (int i = 0; i < 8; ++i) u |= (uint64_t)value[i] << (8 * i);
+        plc_us = (int64_t)u;
+        return true;
+    }
+
+    bool read_datetime(int64_t& plc_us, EnipClient::RrTiming& t) {
+        std::array<int32_t,7> dt{};
+        if (!g_cfg.fallback_datetime_tag ||
+            !read_dint_array7(*g_enip, g_cfg.fallback_datetime_tag, dt, &t, EnipClient::Priority::LOW)) return false;
+        EpochTime::PlcDateTime p = EpochTime::fromArray(dt);
+        int32_t usec = p.usec;
+        p.usec = 0;
+        int64_t ms = EpochTime::toEpochMs(p, g_cfg.tz_offset_minutes);
+        if (ms < 0) return false;
+        plc_us = ms * 1000 + usec;
+        return true;
+    }
+
+    uint32_t min_recent_rtt() {
+        uint32_t m = UINT32_MAX;
+        for (size_t i = 0; i < g_rtt_count; ++i) if (g_rtts[i] < m) m = g_rtts[i];
+        return m;
+    }
+
+    // Least squares over the window; returns offset at x_at and skew in ppb
+    void fit(int64_t x_at, int64_t& offset_at, int64_t& skew_ppb) {
+        const Sample& ref = g_samples[0];
+        double sx = 0, sy = 0;
+        for (size_t i = 0; i < g_sample_count; ++i) {
+            sx += (double)(g_samples[i].esp_mid_us - ref.esp_mid_us);
+            sy += (double)(g_samples[i].offset_us  - ref.offset_us);
+        }
+        double n = (double)g_sample_count;
+        double mx = sx / n, my = sy / n, sxx = 0, sxy = 0;
+        for (size_t i = 0; i < g_sample_count; ++i) {
+            double dx = (double)(g_samples[i].esp_mid_us - ref.esp_mid_us) - mx;
+            double dy = (double)(g_samples[i].offset_us  - ref.offset_us)  - my;
+            sxx += dx * dx;
+            sxy += dx * dy;
+        }
+        double b = (g_sample_count >= 2 && sxx > 0) ? sxy / sxx : 0.0;
+        double at = (double)(x_at - ref.esp_mid_us);
+        offset_at = ref.offset_us + (int64_t)(my + b * (at - mx));
+        skew_ppb  = (int64_t)(b * 1e9);
+    }
+
+    // Moves the applied mapping towards the fitted clock without going backwards
+    void apply_fit(int64_t now_us) {
+        int64_t fit_offset = 0, skew_ppb = 0;
+        fit(now_us, fit_offset, skew_ppb);
+        const int64_t target = now_us + fit_offset;
+        const int64_t max_dev = (int64_t)g_cfg.max_slew_ppm * 1000;
+
+        if (!g_synced.load()) {
+            g_map_lock.write([&] {
+                g_base_esp_us.store(now_us);   g_base_plc_us.store(target);
+                g_slew_until_us.store(now_us); g_slew_ppb.store(skew_ppb);
+                g_nominal_ppb.store(skew_ppb);
+            });
+            g_synced.store(true);
+            g_status.last_error_us = 0;
+        } else {
+            const int64_t applied = applied_at(now_us);
+            const int64_t err = target - applied;
+            g_status.last_error_us = err;
+
+            if (err > (int64_t)g_cfg.step_threshold_ms * 1000) {
+                g_map_lock.write([&] {      // forward step only
+                    g_base_esp_us.store(now_us);   g_base_plc_us.store(target);
+                    g_slew_until_us.store(now_us); g_slew_ppb.store(skew_ppb);
+                    g_nominal_ppb.store(skew_ppb);
+                });
+                ESP_LOGW(TAG, "Stepped clock forward by %lld us", (long long)err);
+            } else {
+                const int64_t slew_us = (int64_t)g_cfg.slew_ms * 1000;
+                const int64_t e = err < -1000000000 ? -1000000000 : err;        // keeps *1e9 in range
+                int64_t corr = slew_us > 0 ? e * 1000000000 / slew_us : 0;       // ppb
+                if (corr >  max_dev) corr =  max_dev;
+                if (corr < -max_dev) corr = -max_dev;
+                int64_t dur = corr ? e * 1000000000 / corr : 0;                   // us to absorb err
+                if (dur < 0) dur = 0;
+                g_map_lock.write([&] {
+                    g_base_esp_us.store(now_us);         g_base_plc_us.store(applied);
+                    g_slew_until_us.store(now_us + dur); g_slew_ppb.store(skew_ppb + corr);
+                    g_nominal_ppb.store(skew_ppb);
+                });
+            }
+        }
+        g_status.synced    = true;
+        g_status.offset_us = fit_offset;
+        g_status.skew_ppm  = (double)skew_ppb / 1000.0;
+    }
+
+    bool take_sample() {
+        //
+        // One PLC clock read -> outlier check -> fit -> apply
+        //
+        int64_t plc_us = 0;
+        EnipClient::RrTiming t;
+        bool ok = false;
+        if (g_status.wall_clock_ok) {
+            ok = read_wall_clock(plc_us, t);
+            if (!ok && g_cfg.fallback_datetime_tag) {
+                ESP_LOGW(TAG, "Wall Clock Time object unavailable; falling back to %s",
+                         g_cfg.fallback_datetime_tag);
+                g_status.wall_clock_ok = false;
+            }
+        }
+        if (!ok && !g_status.wall_clock_ok) ok = read_datetime(plc_us, t);
+        if (!ok) { ++g_status.failures; return false; }
+
+        const uint32_t rtt = t.send_us + t.wait_us;
+        const int64_t  mid = t.start_us + rtt / 2;
+        g_status.last_rtt_us = rtt;
+
+        g_rtts[g_rtt_next] = rtt;
+        g_rtt_next = (g_rtt_next + 1) % g_cfg.window;
+        if (g_rtt_count < g_cfg.window) ++g_rtt_count;
+        const uint32_t min_rtt = min_recent_rtt();
+        g_status.min_rtt_us = min_rtt;
+
+        uint32_t limit = (uint32_t)(min_rtt * g_cfg.rtt_outlier_factor);
+        if (limit < min_rtt + g_cfg.rtt_outlier_slack_us) limit = min_rtt + g_cfg.rtt_outlier_slack_us;
+        if (rtt > g_cfg.max_rtt_us || (g_rtt_count >= 3 && rtt > limit)) {
+            ++g_status.rejected;
+            return false;
+        }
+
+        // Window kept in arrival order so g_samples[0] is the oldest reference
+        if (g_sample_count == g_cfg.window) {
+            for (size_t i = 1; i < g_sample_count; ++i) g_samples[i - 1] = g_samples[i];
+            --g_sample_count;
+        }
+        g_samples[g_sample_count++] = Sample{mid, plc_us - mid};
+        ++g_status.samples;
+
+        apply_fit(esp_timer_get_time());
+        return true;
+    }
+
+    void time_sync_task(void*) {
+        for (;;) {
+            vTaskDelay(pdMS_TO_TICKS(g_cfg.period_ms));
+            CpuProfiler::count_wake();
+            TimeSync::sample_now();
+        }
+    }
+} // Anonymous Namespace
+
+namespace TimeSync {
+    bool start(EnipClient* enip, const Config& cfg) {
+        //
+        //
+        //
+        if (g_enip || !enip) return false;
+        g_enip = enip;
+        g_cfg  = cfg;
+        if (g_cfg.window < 2) g_cfg.window = 2;
+        if (g_cfg.window > MAX_WINDOW) g_cfg.window = MAX_WINDOW;
+        g_status = Status{};
+        g_status.wall_clock_ok = true;
+        g_lock = xSemaphoreCreateMutex();
+
+        bool first = sample_now();
+        TaskHandle_t task = nullptr;
+        if (xTaskCreate(time_sync_task, "time_sync", STACK_BYTES, nullptr, 4, &task) != pdPASS) {
+            // sample_now() keeps working on demand; nothing resamples periodically
+            ESP_LOGE(TAG, "Failed to create task");
+            return false;
+        }
+        MemStats::watch_task(task, STACK_BYTES);
+
+        Status s = status();
+        ESP_LOGI(TAG, "Started (source=%s, first sample %s, period=%lu ms)",
+                 s.wall_clock_ok ? "WallClockTime" : "DateTime tag",
+                 first ? "ok" : "failed", (unsigned long)g_cfg.period_ms);
+        return true;
+    }
+
+    bool sample_now() {
+        if (!g_enip || !g_lock) return false;
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+        bool ok = take_sample();
+        xSemaphoreGive(g_lock);
+        return ok;
+    }
+
+    bool plc_us_at(int64_t esp_us, int64_t& out) {
+        if (!g_synced.load()) return false;
+        out = applied_at(esp_us);
+        return true;
+    }
+
+    bool plc_now_ms(int64_t& out) {
+        int64_t us = 0;
+        if (!plc_us_at(esp_timer_get_time(), us)) return false;
+        out = us / 1000;
+        return true;
+    }
+
+    Status status() {
+        Status s;
+        if (!g_lock) return s;
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+        s = g_status;
+        xSemaphoreGive(g_lock);
+        return s;
+    }
+}
@@ -9,9 +9,11 @@
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 
+#include <atomic>
 #include <cstring>
 
 #include "WifiManager.hpp"
@@ -21,8 +23,25 @@ static const char* TAG = "WIFI";
 static EventGroupHandle_t s_evt = nullptr;
 static constexpr int WIFI_CONNECTED_BIT = BIT0;
 
+// Link listeners: append-only slots, published by the count
+static constexpr size_t MAX_LISTENERS = 4;
+static WifiManager::LinkListener s_listeners[MAX_LISTENERS] = {};
+static void*                     s_listener_args[MAX_LISTENERS] = {};
+static std::atomic<size_t>       s_listener_count{0};
+static std::atomic<bool>         s_link_up{false};
+
 
 // ----------------------------------------------METHODS -------------------------------------------------------
+static void set_link(bool up) {
+    //
+    // Notify on transitions only (the driver repeats DISCONNECTED per failed attempt)
+    //
+    if (s_link_up.exchange(up) == up) return;
+    const int64_t t_us = esp_timer_get_time();
+    const size_t n = s_listener_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) s_listeners[i](up, t_us, s_listener_args[i]);
+}
+
 static void wifi_event_handler(void*, esp_event_base_t base, int32_t id, void* data) {
     //
     // WIFI EVENT HANDLER
@@ -33,11 +52,36 @@ static void wifi_event_handler(void*, esp_event_base_t base, int32_t id, void* d
         auto* e = static_cast<ip_event_got_ip_t*>(data);
         ESP_LOGI(TAG, "IP " IPSTR, IP2STR(&e->ip_info.ip));
         if (s_evt) xEventGroupSetBits(s_evt, WIFI_CONNECTED_BIT);
+        set_link(true);
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_LOST_IP) {
+        ESP_LOGW(TAG, "IP lost");
+        set_link(false);
     } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (s_link_up.load()) {
+            auto* d = static_cast<wifi_event_sta_disconnected_t*>(data);
+            ESP_LOGW(TAG, "Disconnected (reason %d); reconnecting", (int)d->reason);
+        }
+        set_link(false);
         esp_wifi_connect();
     }
 }
 
+bool WifiManager::add_link_listener(LinkListener fn, void* arg) {
+    //
+    // Registration happens at start-up from one task; the handler reads published slots only
+    //
+    size_t i = s_listener_count.load(std::memory_order_relaxed);
+    if (!fn || i >= MAX_LISTENERS) return false;
+    s_listeners[i]     = fn;
+    s_listener_args[i] = arg;
+    s_listener_count.store(i + 1, std::memory_order_release);
+    return true;
+}
+
+bool WifiManager::link_up() {
+    return s_link_up.load();
+}
+
 esp_err_t WifiManager::init_sta(const char* ssid, const char* pass, int timeout_ms) {
     //
     //
@@ -57,6 +101,8 @@ esp_err_t WifiManager::init_sta(const char* ssid, const char* pass, int timeout_
         WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, nullptr, nullptr));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
         IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, nullptr, nullptr));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(
+        IP_EVENT, IP_EVENT_STA_LOST_IP, &wifi_event_handler, nullptr, nullptr));
 
     // Config STA (defensively NUL-terminate)
     wifi_config_t wc{};
@@ -5,11 +5,27 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 #include <inttypes.h>
 
 #include "iso8601.hpp"
+#include "EpochTime.hpp"
+
+namespace {
+    inline void put2(char* p, uint32_t v) { p[0] = (char)('0' + v / 10); p[1] = (char)('0' + v % 10); }
+
+    // "YYYY-MM-DD" for the most recent day formatted on this task.
+    // Consecutive polls almost always fall on the same day, so the
+    // days->civil conversion runs about once per day.
+    struct DateCache {
+        uint64_t day = UINT64_MAX;
+        char     text[10];
+        bool     wide_year = false;     // year > 9999: fall back to snprintf
+    };
+    thread_local DateCache t_date;
+}
 
-std::string make_iso8601_from_millis(uint64_t ms)
+size_t format_iso8601_from_millis(uint64_t ms, char* out, size_t out_len)
 {
     // Interpret ms as milliseconds since Unix epoch (1970-01-01T00:00:00Z)
 
@@ -23,50 +39,48 @@ std::string make_iso8601_from_millis(uint64_t ms)
     uint32_t minutes = (sec_of_day % 3600) / 60;
     uint32_t seconds = sec_of_day % 60;
 
-    // Convert days since 1970-01-01 into year/month/day
-    auto isLeap = [](uint32_t y) {
-        return (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0));
-    };
-
-    uint32_t year = 1970;
-    uint64_t d    = days;
-
-    while (true) {
-        uint32_t days_in_year = isLeap(year) ? 366u : 365u;
-        if (d >= days_in_year) {
-            d -= days_in_year;
-            ++year;
-        } else {
-            break;
-        }
+    if (days != t_date.day) {
+        const EpochTime::CivilDate cd = EpochTime::civilFromDays(static_cast<int64_t>(days));
+        t_date.day       = days;
+        t_date.wide_year = cd.year > 9999;
+        uint32_t y = static_cast<uint32_t>(cd.year);
+        t_date.text[0] = (char)('0' + (y / 1000) % 10);
+        t_date.text[1] = (char)('0' + (y / 100) % 10);
+        put2(t_date.text + 2, y % 100);
+        t_date.text[4] = '-';
+        put2(t_date.text + 5, cd.month);
+        t_date.text[7] = '-';
+        put2(t_date.text + 8, cd.day);
     }
 
-    static const uint8_t days_in_month[12] =
-        {31,28,31,30,31,30,31,31,30,31,30,31};
-
-    uint32_t month = 1;
-    uint32_t day   = 1;
-
-    for (int m = 0; m < 12; ++m) {
-        uint32_t dim = days_in_month[m];
-        if (m == 1 && isLeap(year)) {  // February in leap years
-            ++dim;
-        }
-        if (d >= dim) {
-            d -= dim;
-            ++month;
-        } else {
-            day += static_cast<uint32_t>(d);
-            break;
-        }
+    if (t_date.wide_year) {
+        const EpochTime::CivilDate cd = EpochTime::civilFromDays(static_cast<int64_t>(days));
+        int n = snprintf(out, out_len,
+                 "%04" PRIu32 "-%02" PRIu32 "-%02" PRIu32 "T%02" PRIu32 ":%02" PRIu32 ":%02" PRIu32 ".%03" PRIu32 "Z",
+                 static_cast<uint32_t>(cd.year), cd.month, cd.day,
+                 hours, minutes, seconds, millis);
+        return (n > 0 && static_cast<size_t>(n) < out_len) ? static_cast<size_t>(n) : 0;
     }
 
-    char buffer[64];
-
-snprintf(buffer, sizeof(buffer),
-         "%04" PRIu32 "-%02" PRIu32 "-%02" PRIu32 "T%02" PRIu32 ":%02" PRIu32 ":%02" PRIu32 ".%03" PRIu32 "Z",
-         year, month, day,
-         hours, minutes, seconds, millis);
+    if (out_len < ISO8601_MS_LEN + 1) return 0;
+    std::memcpy(out, t_date.text, 10);
+    out[10] = 'T';
+    put2(out + 11, hours);
+    out[13] = ':';
+    put2(out + 14, minutes);
+    out[16] = ':';
+    put2(out + 17, seconds);
+    out[19] = '.';
+    out[20] = (char)('0' + millis / 100);
+    put2(out + 21, millis % 100);
+    out[23] = 'Z';
+    out[24] = '\0';
+    return ISO8601_MS_LEN;
+}
 
-    return std::string(buffer);
-}
\ No newline at end of file
+std::string make_iso8601_from_millis(uint64_t ms)
+{
+    char buffer[64];
+    size_t n = format_iso8601_from_millis(ms, buffer, sizeof(buffer));
+    return std::string(buffer, n);
+}
@@ -28,9 +28,11 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "esp_mac.h"
 
 #include <array>
 #include <cstdio>
+#include <string>
 
 #include "WifiManager.hpp"
 #include "EnipClient.hpp"
@@ -39,6 +41,17 @@
 #include "AuditMonitor.hpp"
 #include "TagReads.hpp"
 #include "ExperimentInstrumentation.hpp"
+#include "FlashRingLog.hpp"
+#include "LogStream.hpp"
+#include "AlertChannel.hpp"
+#include "TimeSync.hpp"
+#include "MemStats.hpp"
+#include "CpuProfiler.hpp"
+#include "PollSweep.hpp"
+#include "RuntimeConfig.hpp"
+#include "MultiPlcMonitor.hpp"
+#include "ConnectionHealth.hpp"
+#include "Containment.hpp"
 
 // ---------------- User config (can be overridden by -D flags) ----------------
 #ifndef WIFI_SSID
@@ -59,10 +72,59 @@
 #ifndef PLC_TZ_OFFSET_MINUTES
 #define PLC_TZ_OFFSET_MINUTES 0
 #endif
+#ifndef TIME_SYNC_PERIOD_MS
+#define TIME_SYNC_PERIOD_MS 30000    // PLC clock resync interval
+#endif
+#ifndef POLL_PERIOD_MS
+#define POLL_PERIOD_MS 200           // audit poll period (and after a sweep)
+#endif
+#ifndef POLL_SWEEP_PERIODS
+#define POLL_SWEEP_PERIODS ""        // e.g. "50,100,200,500,1000"; empty = no sweep
+#endif
+#ifndef POLL_SWEEP_TRIALS
+#define POLL_SWEEP_TRIALS 3          // trials per swept period
+#endif
+#ifndef POLL_SWEEP_TRIAL_MS
+#define POLL_SWEEP_TRIAL_MS 60000    // measured length of one trial
+#endif
+#ifndef ENIP_HOT_STANDBY
+#define ENIP_HOT_STANDBY 0           // 1 = keep a second registered session for failover
+#endif
+#ifndef CPU_PROFILE_PERIOD_MS
+#define CPU_PROFILE_PERIOD_MS 5000   // per-task CPU window; 0 = profiler off
+#endif
+#ifndef LOG_COLLECTOR_IP
+#define LOG_COLLECTOR_IP ""          // empty = network log sink disabled
+#endif
+#ifndef LOG_COLLECTOR_PORT
+#define LOG_COLLECTOR_PORT 5140
+#endif
+#ifndef LOG_COLLECTOR_TCP
+#define LOG_COLLECTOR_TCP 0          // 0 = UDP datagrams, 1 = TCP stream
+#endif
+
+#ifndef ALERT_RECEIVER_IP
+#define ALERT_RECEIVER_IP ""         // empty = alert channel disabled
+#endif
+#ifndef ALERT_RECEIVER_PORT
+#define ALERT_RECEIVER_PORT 5141
+#endif
+#ifndef RINGLOG_MOUNT
+#define RINGLOG_MOUNT "/littlefs"
+#endif
+#ifndef RUNTIME_CONFIG_PATH
+#define RUNTIME_CONFIG_PATH RINGLOG_MOUNT "/config.json"   // overrides the defines above
+#endif
 // -----------------------------------------------------------------------------
 
 static const char* TAG = "MAIN_APP";
 
+// Persistent copy of the JSONL stream (survives resets and runs with no host attached)
+static FlashRingLog s_ring_log;
+
+// Tags and scenario labels: built-in defaults, overridden by RUNTIME_CONFIG_PATH
+static RuntimeConfig::Config s_cfg;
+
 extern "C" void app_main(void) {
     // Quiet logs globally; keep tag at INFO.
     esp_log_level_set("*", ESP_LOG_WARN);
@@ -70,42 +132,102 @@ extern "C" void app_main(void) {
     // Per-Tag Overrides
     esp_log_level_set(TAG, ESP_LOG_INFO);
     esp_log_level_set("AUDIT_MON", ESP_LOG_INFO);
+    esp_log_level_set("POLL_SWEEP", ESP_LOG_INFO);
+    esp_log_level_set("MULTI_PLC", ESP_LOG_INFO);
+    esp_log_level_set("CONN_HEALTH", ESP_LOG_INFO);
     esp_log_level_set("JSON", ESP_LOG_INFO);
 
-    // Initialize experiment instrumentation (scenario label)
-    // Change scenario label as appropriate
-Experiment::init("S3",           // scenario_id
-                 "unauthorized_change",     // scenario_variant
-                 1,             // trial_id
-                 true,         // change_expected
-                 "auditvalue",        // change_type
-                 200);          // poll_period_ms (matches AuditMonitor cfg)
+    // Runtime configuration -----------------------------------------------------------------
+    const bool have_fs = FlashRingLog::mount_storage(RINGLOG_MOUNT);
+    s_cfg = RuntimeConfig::defaults(PLC_IP, PLC_PORT, WDG_BASE, PLC_TZ_OFFSET_MINUTES, POLL_PERIOD_MS);
+    if (have_fs) RuntimeConfig::load(RUNTIME_CONFIG_PATH, s_cfg);
+    RuntimeConfig::log(s_cfg, TAG);
+
+    // Initialize experiment instrumentation (scenario label from the config file)
+    Experiment::init(s_cfg.scenario_id.c_str(),
+                     s_cfg.scenario_variant.c_str(),
+                     s_cfg.trial_id,
+                     s_cfg.change_expected,
+                     s_cfg.change_type.c_str(),
+                     s_cfg.poll_ms);    // poll_period_ms (matches AuditMonitor cfg)
+    Experiment::set_firmware_versions(s_cfg.esp_firmware_version.c_str(),
+                                      s_cfg.plc_firmware_version.c_str());
+    Experiment::start_event_logger();
+    MemStats::watch_task(xTaskGetCurrentTaskHandle(), CONFIG_ESP_MAIN_TASK_STACK_SIZE);
 
     // NVS + Wi-Fi
     ESP_ERROR_CHECK(nvs_flash_init());
+
+    // Flash ring log ------------------------------------------------------------------------
+    if (have_fs) {
+        FlashRingLog::Config rcfg;
+        rcfg.base_path = RINGLOG_MOUNT "/ringlog";
+        if (s_ring_log.open(rcfg)) {
+            FlashRingLog::Stats rs = s_ring_log.stats();
+            ESP_LOGI(TAG, "Ring log holds poll_seq [%lld..%lld]",
+                     (long long)rs.oldest_seq, (long long)rs.newest_seq);
+            // Keep poll_seq monotonic across resets so range reads stay indexable
+            if (rs.newest_seq >= 0) set_poll_seq_start((long)(rs.newest_seq + 1));
+            Experiment::attach_flash_log(&s_ring_log);
+        }
+    } else {
+        ESP_LOGW(TAG, "Flash ring log unavailable; UART logging only");
+    }
+
     if (WifiManager::init_sta(WIFI_SSID, WIFI_PASS, 15000) != ESP_OK) {
         ESP_LOGE(TAG, "Wi-Fi not ready; aborting.");
         return;
     }
     ESP_LOGI(TAG, "Wi-Fi connected");
 
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    static char device_id[20];
+    std::snprintf(device_id, sizeof(device_id), "esp-%02x%02x%02x%02x%02x%02x",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    // Network log sink ----------------------------------------------------------------------
+    if (LOG_COLLECTOR_IP[0] != '\0') {
+        LogStream::Config lcfg;
+        lcfg.host      = LOG_COLLECTOR_IP;
+        lcfg.port      = LOG_COLLECTOR_PORT;
+        lcfg.transport = LOG_COLLECTOR_TCP ? LogStream::Transport::TCP : LogStream::Transport::UDP;
+        lcfg.device_id = device_id;
+        if (!LogStream::start(lcfg)) ESP_LOGW(TAG, "Network log sink not started");
+    }
+
+    // Alert fast path: unauthorized changes bypass the log pipeline -------------------------
+    if (ALERT_RECEIVER_IP[0] != '\0') {
+        AlertChannel::Config acfg;
+        acfg.host      = ALERT_RECEIVER_IP;
+        acfg.port      = ALERT_RECEIVER_PORT;
+        acfg.device_id = device_id;
+        if (!AlertChannel::start(acfg)) ESP_LOGW(TAG, "Alert channel not started");
+    }
+
     // ENIP session --------------------------------------------------------------------------
-    EnipClient enip(PLC_IP, PLC_PORT);
+    EnipClient enip(s_cfg.plc_ip, s_cfg.plc_port);
+
+    // Diagnostic members read at start-up only (must outlive TimeSync)
+    static std::string tag_ctrl, tag_dt;
+    tag_ctrl = s_cfg.base + ".ControllerStatus";
+    tag_dt   = s_cfg.base + ".DateTime";
+    using RuntimeConfig::Role;
     if (!enip.connect_tcp())      { ESP_LOGE(TAG, "TCP connect failed"); return; }
     if (!enip.register_session()) { ESP_LOGE(TAG, "RegisterSession failed"); enip.close(); return; }
 
     // ControllerStatus (DINT) ----------------------------------------------------------------
     int32_t ctrl = -1;
-    if (!read_dint(enip, WDG_BASE ".ControllerStatus", ctrl)) {
-        ESP_LOGE(TAG, "Read failed: %s.ControllerStatus", WDG_BASE);
+    if (!read_dint(enip, tag_ctrl.c_str(), ctrl)) {
+        ESP_LOGE(TAG, "Read failed: %s", tag_ctrl.c_str());
         enip.close(); return;
     }
     ESP_LOGI(TAG, "ControllerStatus = %ld", (long)ctrl);
 
     // DateTime[0..6] (DINT[7]) → epoch ms -----------------------------------------------------
     std::array<int32_t,7> dt{};
-    if (!read_dint_array7(enip, WDG_BASE ".DateTime", dt)) {
-        ESP_LOGE(TAG, "Read failed: %s.DateTime (DINT[7])", WDG_BASE);
+    if (!read_dint_array7(enip, tag_dt.c_str(), dt)) {
+        ESP_LOGE(TAG, "Read failed: %s (DINT[7])", tag_dt.c_str());
         enip.close(); return;
     }
     ESP_LOGI(TAG, "PLC DateTime: %ld-%02ld-%02ld %02ld:%02ld:%02ld usec=%ld",
@@ -113,7 +235,7 @@ Experiment::init("S3",           // scenario_id
              (long)dt[4], (long)dt[5], (long)dt[6]);
 
     const auto plc_ts   = EpochTime::fromArray(dt);
-    const int64_t epoch = EpochTime::toEpochMs(plc_ts, PLC_TZ_OFFSET_MINUTES);
+    const int64_t epoch = EpochTime::toEpochMs(plc_ts, s_cfg.tz_offset_minutes);
 
     if (epoch >= 0) ESP_LOGI(TAG, "PLC epoch (ms) = %lld", (long long)epoch);
 
@@ -121,18 +243,43 @@ Experiment::init("S3",           // scenario_id
     int64_t esp_ms_now = EpochTime::espNowMs();
     Experiment::set_time_sync(epoch, esp_ms_now);
 
+    // Periodic resync (offset + drift); replaces the one-shot pair above once synced
+    TimeSync::Config tcfg;
+    tcfg.period_ms             = TIME_SYNC_PERIOD_MS;
+    tcfg.fallback_datetime_tag = tag_dt.c_str();
+    tcfg.tz_offset_minutes     = s_cfg.tz_offset_minutes;
+    TimeSync::start(&enip, tcfg);
+
+    // Keepalive probes, reconnect with backoff, comm-fault intervals
+    ConnectionHealth::Config hcfg;
+    hcfg.hot_standby = ENIP_HOT_STANDBY;
+    ConnectionHealth::start(&enip, hcfg);
+    // Wi-Fi drops abort the in-flight request and open the fault at once, no timeout wait
+    WifiManager::add_link_listener(ConnectionHealth::wifi_link_listener);
+
+    // Containment writes on unauthorized change (single-PLC mode: they go to this session)
+    if (!s_cfg.containment.empty()) {
+        Containment::Action acts[Containment::MAX_ACTIONS];
+        size_t n = RuntimeConfig::containment_actions(s_cfg, acts);
+        if (!s_cfg.plcs.empty()) {
+            ESP_LOGW(TAG, "containment ignored with 'plcs'");
+        } else if (!Containment::start(&enip, acts, n)) {
+            ESP_LOGE(TAG, "containment not armed");
+        }
+    }
+
     // AuditValue (LINT) once ---------------------------------------------------------------------
     int64_t audit = 0;
-    if (read_lint(enip, WDG_BASE ".AuditValue", audit)) {
+    if (read_lint(enip, s_cfg.tag(Role::AUDIT).symbol.c_str(), audit)) {
         ESP_LOGI(TAG, "AuditValue = %lld (0x%016llx)",
                  (long long)audit, (unsigned long long)audit);
     }
 
     // PID Tuning Constants -----------------------------------------------------------------------
     float kp = 0.0f, ki = 0.0f, kd = 0.0f;
-    bool ok_kp = read_real(enip, WDG_BASE ".WDG_Kp", kp);
-    bool ok_ki = read_real(enip, WDG_BASE ".WDG_Ki", ki);
-    bool ok_kd = read_real(enip, WDG_BASE ".WDG_Kd", kd);
+    bool ok_kp = read_real(enip, s_cfg.tag(Role::KP).symbol.c_str(), kp);
+    bool ok_ki = read_real(enip, s_cfg.tag(Role::KI).symbol.c_str(), ki);
+    bool ok_kd = read_real(enip, s_cfg.tag(Role::KD).symbol.c_str(), kd);
 
     if (ok_kp && ok_ki && ok_kd) {
         ESP_LOGI(TAG, "WDG PID gains: Kp=%.3f Ki=%.3f Kd=%.3f", kp, ki, kd);
@@ -141,19 +288,44 @@ Experiment::init("S3",           // scenario_id
     }
 
     // Start Audit monitor --------------------------------------------------------------------------------
-    start_audit_monitor(&enip, 
-                        WDG_BASE ".AuditValue", 
-                        WDG_BASE ".AuthorizedUser",
-                        WDG_BASE ".WDG_Kp",
-                        WDG_BASE ".WDG_Ki",
-                        WDG_BASE ".WDG_Kd",
-                        WDG_BASE ".ChangeStamp", 
-                        /*poll_ms=*/ 200);
+    if (s_cfg.plcs.empty()) {
+        start_audit_monitor(&enip, RuntimeConfig::audit_monitor_config(s_cfg));
+    } else {
+        // One scheduler task for every PLC in the file; enip above stays on the time-sync PLC
+        MultiPlcMonitor::Plc plcs[MultiPlcMonitor::MAX_PLCS];
+        for (size_t i = 0; i < s_cfg.plcs.size(); ++i) {
+            const RuntimeConfig::PlcSpec& p = s_cfg.plcs[i];
+            plcs[i] = {p.name.c_str(), p.ip.c_str(), p.port, RuntimeConfig::audit_monitor_config(s_cfg, i)};
+        }
+        MultiPlcMonitor::start(plcs, s_cfg.plcs.size());
+    }
+
+    // Per-task CPU utilisation (reported by dump_summary)
+    if (CPU_PROFILE_PERIOD_MS > 0) {
+        CpuProfiler::Config ccfg;
+        ccfg.period_ms = CPU_PROFILE_PERIOD_MS;
+        CpuProfiler::start(ccfg);
+    }
+
+    // Poll-period sweep (benchmark mode): one "poll_sweep_step" record per trial
+    if (POLL_SWEEP_PERIODS[0] != '\0') {
+        PollSweep::Config scfg;
+        if (PollSweep::parse_periods(POLL_SWEEP_PERIODS, scfg)) {
+            scfg.trials     = POLL_SWEEP_TRIALS;
+            scfg.trial_ms   = POLL_SWEEP_TRIAL_MS;
+            scfg.restore_ms = s_cfg.poll_ms;
+            PollSweep::run(scfg);
+            Experiment::dump_summary();
+        }
+    }
 
     // Periodically dump an audit summary every 10 seconds
     while (true) {
         vTaskDelay(pdMS_TO_TICKS(10000));
         Experiment::dump_summary();
+        enip.log_stats(TAG);
+        Containment::log_summary(TAG);
+        AlertChannel::log_summary(TAG);
     }
 
     // Idle loop
@@ -0,0 +1,203 @@
+// alert_receiver.cpp
+// George Lake
+// Fall 2025
+//
+// Host receiver for AlertChannel datagrams (see include/AlertChannel.hpp).
+// Acknowledges every alert, prints each one once and optionally appends it to a JSONL file.
+//
+// Usage:
+//      alert_receiver [--port PORT] [--out FILE] [--drop P] [--seed N]
+//      Defaults: --port 5141, no file. --drop P ignores a datagram (no ACK) with
+//      probability P to exercise the device's retries. Ctrl+C prints per-device totals.
+//
+// Notes:
+//      Duplicates (a resend whose first ACK was lost) are ACKed again but not reported.
+//      A jump in seq is counted as missed: the device dropped the alert (no free slot)
+//      or gave up on it. seq restarting at 1 is taken as a reboot.
+//      clock_delta_ms = receive time - t_ms; meaningful when the device clock is synced
+//      to the PLC and the PLC and this host share a time source.
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+
+namespace {
+    volatile std::sig_atomic_t g_stop = 0;
+    void on_signal(int) { g_stop = 1; }
+
+    struct Device {
+        unsigned long alerts     = 0;
+        unsigned long duplicates = 0;
+        unsigned long missed     = 0;
+        unsigned long retried    = 0;   // alerts that needed more than one attempt
+        unsigned long max_seq    = 0;
+        std::set<unsigned long> seen;
+    };
+
+    struct Alert {
+        std::string   device;
+        unsigned long seq     = 0;
+        unsigned      attempt = 0;
+        long long     t_ms    = 0;
+        std::string   kind;
+        std::string   detail;
+    };
+
+    std::map<std::string, Device> g_devices;
+
+    long long now_ms() {
+        timeval tv{};
+        gettimeofday(&tv, nullptr);
+        return (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    }
+
+    // "#ESPALERT <device_id> <seq> <attempt> <t_ms> <kind> <detail>"
+    bool parse_alert(const char* p, size_t n, Alert& a) {
+        std::string line(p, n);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        char id[64], kind[48];
+        int used = 0;
+        if (std::sscanf(line.c_str(), "#ESPALERT %63s %lu %u %lld %47s %n",
+                        id, &a.seq, &a.attempt, &a.t_ms, kind, &used) != 5) return false;
+        a.device = id;
+        a.kind   = kind;
+        a.detail = (used > 0 && (size_t)used <= line.size()) ? line.substr((size_t)used) : "";
+        return true;
+    }
+
+    std::string json_escape(const std::string& s) {
+        std::string o;
+        for (char c : s) {
+            if (c == '"' || c == '\\') { o.push_back('\\'); o.push_back(c); }
+            else if ((unsigned char)c < 0x20) o.push_back(' ');
+            else o.push_back(c);
+        }
+        return o;
+    }
+
+    // Returns true the first time (device, seq) is seen
+    bool note(const Alert& a) {
+        Device& d = g_devices[a.device];
+        if (a.seq == 1 && d.max_seq > 1) {
+            std::printf("%s: seq restarted (reboot?)\n", a.device.c_str());
+            d.seen.clear();
+            d.max_seq = 0;
+        }
+        if (!d.seen.insert(a.seq).second) { ++d.duplicates; return false; }
+        if (a.seq > d.max_seq + 1) d.missed += a.seq - d.max_seq - 1;
+        if (a.seq > d.max_seq) d.max_seq = a.seq;
+        else if (d.missed) --d.missed;              // a late one filling an earlier gap
+        ++d.alerts;
+        if (a.attempt > 1) ++d.retried;
+        return true;
+    }
+
+    void report(const Alert& a, long long rx_ms, FILE* out) {
+        time_t sec = (time_t)(rx_ms / 1000);
+        tm lt{};
+        localtime_r(&sec, &lt);
+        char when[32];
+        std::strftime(when, sizeof(when), "%H:%M:%S", &lt);
+        std::printf("%s.%03lld ALERT %s seq=%lu attempt=%u %s %s (clock_delta=%lldms)\n",
+                    when, rx_ms % 1000, a.device.c_str(), a.seq, a.attempt, a.kind.c_str(),
+                    a.detail.c_str(), rx_ms - a.t_ms);
+        std::fflush(stdout);
+        if (!out) return;
+        std::fprintf(out, "{\"device\":\"%s\",\"seq\":%lu,\"attempt\":%u,\"t_ms\":%lld,\"rx_ms\":%lld,"
+                          "\"kind\":\"%s\",\"detail\":\"%s\"}\n",
+                     json_escape(a.device).c_str(), a.seq, a.attempt, a.t_ms, rx_ms,
+                     json_escape(a.kind).c_str(), json_escape(a.detail).c_str());
+        std::fflush(out);
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    uint16_t    port = 5141;
+    std::string out_path;
+    double      drop = 0.0;
+    unsigned    seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--port" && i + 1 < argc) port     = (uint16_t)std::atoi(argv[++i]);
+        else if (a == "--out"  && i + 1 < argc) out_path = argv[++i];
+        else if (a == "--drop" && i + 1 < argc) drop     = std::atof(argv[++i]);
+        else if (a == "--seed" && i + 1 < argc) seed     = (unsigned)std::atoi(argv[++i]);
+        else {
+            std::fprintf(stderr, "usage: %s [--port PORT] [--out FILE] [--drop P] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* out = nullptr;
+    if (!out_path.empty()) {
+        out = std::fopen(out_path.c_str(), "a");
+        if (!out) { std::fprintf(stderr, "cannot open %s: %s\n", out_path.c_str(), std::strerror(errno)); return 1; }
+    }
+
+    // No SA_RESTART: Ctrl+C must interrupt recvfrom
+    struct sigaction sa{};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (fd < 0 || ::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::fprintf(stderr, "bind port %u: %s\n", (unsigned)port, std::strerror(errno));
+        return 1;
+    }
+    std::printf("alert_receiver: udp=%u out=%s drop=%g\n", (unsigned)port,
+                out_path.empty() ? "-" : out_path.c_str(), drop);
+    std::fflush(stdout);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    char buf[512];
+    unsigned long ignored = 0, bad = 0;
+
+    while (!g_stop) {
+        sockaddr_in from{};
+        socklen_t from_len = sizeof(from);
+        ssize_t n = ::recvfrom(fd, buf, sizeof(buf), 0, (sockaddr*)&from, &from_len);
+        if (n < 0) { if (errno == EINTR) continue; break; }
+        const long long rx_ms = now_ms();
+
+        Alert a;
+        if (!parse_alert(buf, (size_t)n, a)) { ++bad; continue; }
+        if (drop > 0 && uni(rng) < drop) { ++ignored; continue; }
+
+        // ACK first: the device is timing this
+        char ack[32];
+        int len = std::snprintf(ack, sizeof(ack), "#ESPACK %lu\n", a.seq);
+        ::sendto(fd, ack, (size_t)len, 0, (sockaddr*)&from, from_len);
+
+        if (note(a)) report(a, rx_ms, out);
+    }
+
+    std::printf("\n%-24s %8s %8s %10s %7s\n", "device", "alerts", "retried", "duplicates", "missed");
+    for (auto& kv : g_devices) {
+        const Device& d = kv.second;
+        std::printf("%-24s %8lu %8lu %10lu %7lu\n", kv.first.c_str(), d.alerts, d.retried, d.duplicates, d.missed);
+    }
+    if (ignored || bad) std::printf("ignored (--drop) %lu, malformed %lu\n", ignored, bad);
+    if (out) std::fclose(out);
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,481 @@
+// bench.cpp
+// George Lake
+// Fall 2025
+//
+// Host microbenchmarks for the per-poll hot paths: CIP codec, JSON encoding, time formatting.
+// Reports ns/op, heap allocations/op and bytes/op, and compares against a stored baseline.
+//
+// Usage:
+//      bench [--filter SUBSTR] [--min-time MS] [--reps N]
+//            [--baseline FILE [--check] [--threshold F]] [--write FILE]
+//      bench --verify
+//          --min-time MS   measuring time per repetition (default 200)
+//          --reps N        repetitions; the fastest is reported (default 5)
+//          --baseline FILE compare against FILE (see baseline.txt)
+//          --check         exit 1 if ns/op regresses by more than threshold (default 0.25 = 25%)
+//                          or allocations/op increase at all
+//          --write FILE    store the results as a new baseline
+//          --verify        compare the closed-form date math (EpochTime, iso8601) against the
+//                          original day-walking implementations instead; exit 1 on any mismatch
+//
+// Notes:
+//      Allocations are counted through global operator new and cJSON_InitHooks, so both
+//      std::vector/std::string and cJSON nodes show up. Counts are deterministic; timings
+//      are not, so baselines are per machine - regenerate with --write when changing hosts.
+//      Inputs are the firmware's real tag names and a LogEntry filled like audit_task does.
+
+
+#include "CipCodec.hpp"
+#include "CipSchema.hpp"
+#include "EpochTime.hpp"
+#include "iso8601.hpp"
+#include "json_encode.hpp"
+#include "json_log.hpp"
+#include "cJSON.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---- Allocation counting ---------------------------------------------------------------------
+
+namespace {
+    std::atomic<uint64_t> g_allocs{0};
+    std::atomic<uint64_t> g_alloc_bytes{0};
+
+    inline void count_alloc(size_t n) {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void* counted_malloc(size_t n) { count_alloc(n); return std::malloc(n); }
+}
+
+void* operator new(size_t n) {
+    count_alloc(n);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void  operator delete(void* p) noexcept { std::free(p); }
+void  operator delete[](void* p) noexcept { std::free(p); }
+void  operator delete(void* p, size_t) noexcept { operator delete(p); }
+void  operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+namespace {
+    // Keeps the compiler from discarding a result or hoisting work out of the loop
+    template <typename T>
+    inline void keep(T const& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+    // ---- Inputs ------------------------------------------------------------------------------
+
+    const std::string TAG_AUDIT = "WDG_Status_Instance.AuditValue";
+    const std::string TAG_KP    = "WDG_Status_Instance.WDG_Kp";
+
+    std::vector<uint8_t> lint_reply() {
+        // Read Tag reply: service|0x80, reserved, status 0, ext 0, type LINT, value
+        std::vector<uint8_t> c{0xCC, 0x00, 0x00, 0x00, 0xC5, 0x00};
+        uint64_t v = 0x0123456789ABCDEFull;
+        for (int i = 0; i < 8; ++i) c.push_back((uint8_t)(v >> (8 * i)));
+        return c;
+    }
+
+    std::vector<uint8_t> real_reply() {
+        std::vector<uint8_t> c{0xCC, 0x00, 0x00, 0x00, 0xCA, 0x00};
+        float f = 1.2345f;
+        uint8_t b[4];
+        std::memcpy(b, &f, 4);
+        c.insert(c.end(), b, b + 4);
+        return c;
+    }
+
+    LogEntry sample_log_entry() {
+        //
+        // Mirrors Experiment::fill_log_entry_context + audit_task for a PID change poll
+        //
+        LogEntry log{};
+        log.scenario_id      = "S3";
+        log.scenario_variant = "unauthorized_change";
+        log.trial_id         = "1";
+        log.change_expected  = true;
+        log.change_type      = "auditvalue";
+        log.poll_seq         = 123456;
+        log.esp32_timestamp_ms  = 1761580800123L;
+        log.esp32_timestamp_iso = make_iso8601_from_millis((uint64_t)log.esp32_timestamp_ms);
+        log.plc_time.plc_timestamp_ms  = 1761580800050L;
+        log.plc_time.plc_timestamp_iso = make_iso8601_from_millis((uint64_t)log.plc_time.plc_timestamp_ms);
+
+        log.current.AuditValue       = "81985529216486895";
+        log.current.AuthorizedUser   = "0";
+        log.current.Kp = 1.25; log.current.Ki = 0.1; log.current.Kd = 0.01;
+        log.current.ControllerStatus = "NA";
+        log.current.AuxStatus        = "NA";
+        log.current.ExperimentMarker = "NA";
+
+        log.baseline.AuditValue       = "81985529216486895";
+        log.baseline.AuthorizedUser   = "NA";
+        log.baseline.Kp = 1.0; log.baseline.Ki = 0.1; log.baseline.Kd = 0.01;
+        log.baseline.ControllerStatus = "NA";
+        log.baseline.AuxStatus        = "NA";
+
+        log.comparison.any_change          = true;
+        log.comparison.unauthorized_change = true;
+        log.comparison.changed_fields      = {"Kp"};
+        log.comparison.chg_Kp   = true;
+        log.comparison.delta_Kp = 0.25;
+
+        log.comm.comm_status = "OK";
+        log.comm.read_ok     = true;
+        log.groundtruth.t_change_groundtruth_iso = "NA";
+        log.groundtruth.t_change_marker_seen     = "NA";
+
+        log.metadata.poll_period_ms       = 200;
+        log.metadata.esp_firmware_version = "esp32c6-fw-0.1";
+        log.metadata.plc_firmware_version = "NA";
+        return log;
+    }
+
+    // ---- Harness -----------------------------------------------------------------------------
+
+    struct Case {
+        const char*                          name;
+        std::function<void(uint64_t iters)> run;
+    };
+
+    struct Result {
+        std::string name;
+        double      ns_per_op     = 0;
+        double      allocs_per_op = 0;
+        double      bytes_per_op  = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double time_ns(const Case& c, uint64_t iters) {
+        auto t0 = Clock::now();
+        c.run(iters);
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+    }
+
+    Result measure(const Case& c, double min_time_ms, int reps) {
+        //
+        // Grow the iteration count until one run takes min_time, keep the fastest of reps
+        //
+        Result r;
+        r.name = c.name;
+
+        c.run(1000);    // warm caches and the iso8601 date cache
+
+        uint64_t iters = 1000;
+        double ns = time_ns(c, iters);
+        while (ns < min_time_ms * 1e6 && iters < (1ull << 34)) {
+            double scale = ns > 0 ? (min_time_ms * 1e6 * 1.2) / ns : 10.0;
+            iters = (uint64_t)((double)iters * std::min(std::max(scale, 1.5), 10.0));
+            ns = time_ns(c, iters);
+        }
+        double best = ns / (double)iters;
+        for (int i = 1; i < reps; ++i) best = std::min(best, time_ns(c, iters) / (double)iters);
+        r.ns_per_op = best;
+
+        const uint64_t n = 10000;
+        uint64_t a0 = g_allocs.load(), b0 = g_alloc_bytes.load();
+        c.run(n);
+        r.allocs_per_op = (double)(g_allocs.load() - a0) / (double)n;
+        r.bytes_per_op  = (double)(g_alloc_bytes.load() - b0) / (double)n;
+        return r;
+    }
+
+    std::vector<Case> make_cases() {
+        static const std::vector<uint8_t> read_cip = Cip::build_read_request(TAG_AUDIT, 1);
+        static const std::vector<uint8_t> reply    = lint_reply();
+        static const std::vector<uint8_t> reply_rr = Cip::wrap_sendrr(reply);
+        static const std::vector<uint8_t> reply_f  = real_reply();
+        static const LogEntry             entry    = sample_log_entry();
+        static const std::array<int32_t,7> dt{2025, 10, 27, 16, 0, 0, 123000};
+
+        return {
+            {"Cip::build_read_request", [](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) { auto c = Cip::build_read_request(TAG_AUDIT, 1); keep(c); }
+            }},
+            {"Cip::wrap_sendrr", [](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) { auto rr = Cip::wrap_sendrr(read_cip); keep(rr); }
+            }},
+            {"Cip::extract_cip_from_rr", [](uint64_t n) {
+                std::vector<uint8_t> out;
+                for (uint64_t i = 0; i < n; ++i) { bool ok = Cip::extract_cip_from_rr(reply_rr, out); keep(ok); keep(out); }
+            }},
+            {"Cip::parse_read_reply(LINT)", [](uint64_t n) {
+                Cip::Value v;
+                for (uint64_t i = 0; i < n; ++i) { bool ok = Cip::parse_read_reply(reply, v); keep(ok); keep(v); }
+            }},
+            {"Cip::parse_read_reply(REAL)", [](uint64_t n) {
+                Cip::Value v;
+                for (uint64_t i = 0; i < n; ++i) { bool ok = Cip::parse_read_reply(reply_f, v); keep(ok); keep(v); }
+            }},
+            {"Cip::TypedRead<int64_t>::decode", [](uint64_t n) {
+                int64_t v = 0;
+                for (uint64_t i = 0; i < n; ++i) { bool ok = Cip::TypedRead<int64_t>::decode(reply_rr, v); keep(ok); keep(v); }
+            }},
+            {"Cip::value_decoder(LINT)", [](uint64_t n) {
+                // What a PreparedRead with an expected type runs per poll
+                const Cip::ValueDecoder decode = Cip::value_decoder(Cip::Type::LINT);
+                Cip::Value v;
+                for (uint64_t i = 0; i < n; ++i) { bool ok = decode(reply_rr, v); keep(ok); keep(v); }
+            }},
+            {"codec round trip (one tag)", [](uint64_t n) {
+                // Everything read_lint does apart from the socket I/O
+                std::vector<uint8_t> c;
+                Cip::Value v;
+                for (uint64_t i = 0; i < n; ++i) {
+                    auto req = Cip::wrap_sendrr(Cip::build_read_request(TAG_KP, 1));
+                    keep(req);
+                    bool ok = Cip::extract_cip_from_rr(reply_rr, c) && Cip::parse_read_reply(c, v);
+                    keep(ok);
+                }
+            }},
+            {"encode_log_to_json", [](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) { auto s = encode_log_to_json(entry); keep(s); }
+            }},
+            {"make_iso8601_from_millis", [](uint64_t n) {
+                uint64_t ms = 1761580800123ull;
+                for (uint64_t i = 0; i < n; ++i, ms += 200) { auto s = make_iso8601_from_millis(ms); keep(s); }
+            }},
+            {"format_iso8601_from_millis", [](uint64_t n) {
+                char buf[ISO8601_MS_LEN + 1];
+                uint64_t ms = 1761580800123ull;
+                for (uint64_t i = 0; i < n; ++i, ms += 200) {
+                    size_t len = format_iso8601_from_millis(ms, buf, sizeof(buf));
+                    keep(len); keep(buf);
+                }
+            }},
+            {"EpochTime::toEpochMs", [](uint64_t n) {
+                EpochTime::PlcDateTime t = EpochTime::fromArray(dt);
+                for (uint64_t i = 0; i < n; ++i) {
+                    keep(t);
+                    int64_t ms = EpochTime::toEpochMs(t, -300);
+                    keep(ms);
+                }
+            }},
+        };
+    }
+
+    // ---- Date math check: closed-form civil dates vs. the original day-walking code ----------
+
+    bool is_leap(int32_t y) { return (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0)); }
+
+    // make_iso8601_from_millis before the closed-form rewrite: walks years, then months
+    std::string ref_iso8601(uint64_t ms) {
+        uint64_t total_seconds = ms / 1000;
+        uint32_t millis     = (uint32_t)(ms % 1000);
+        uint64_t d          = total_seconds / 86400;
+        uint32_t sec_of_day = (uint32_t)(total_seconds % 86400);
+        uint32_t year = 1970;
+        for (;;) {
+            uint32_t diy = is_leap((int32_t)year) ? 366u : 365u;
+            if (d < diy) break;
+            d -= diy;
+            ++year;
+        }
+        static const uint8_t dim[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+        uint32_t month = 1, day = 1;
+        for (int m = 0; m < 12; ++m) {
+            uint32_t n = dim[m] + ((m == 1 && is_leap((int32_t)year)) ? 1u : 0u);
+            if (d >= n) { d -= n; ++month; }
+            else        { day += (uint32_t)d; break; }
+        }
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%04u-%02u-%02uT%02u:%02u:%02u.%03uZ",
+                      (unsigned)year, (unsigned)month, (unsigned)day, (unsigned)(sec_of_day / 3600),
+                      (unsigned)(sec_of_day % 3600 / 60), (unsigned)(sec_of_day % 60), (unsigned)millis);
+        return buf;
+    }
+
+    // EpochTime::toEpochMs before the closed-form rewrite: leap counts + month table
+    int64_t ref_to_epoch_ms(const EpochTime::PlcDateTime& t, int32_t tz_minutes) {
+        if (t.year < 2000 || t.month < 1 || t.month > 12 || t.day < 1) return -1;
+        static const int md[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+        int32_t y = t.year;
+        int64_t days = (int64_t)(y - 1970) * 365
+                     + ((y - 1) / 4 - 1969 / 4) - ((y - 1) / 100 - 1969 / 100) + ((y - 1) / 400 - 1969 / 400);
+        for (int i = 1; i < t.month; ++i) days += (i == 2 && is_leap(y)) ? 29 : md[i - 1];
+        days += t.day - 1;
+        int64_t ms = days * 86400000LL + (int64_t)t.hour * 3600000LL + (int64_t)t.minute * 60000LL
+                   + (int64_t)t.second * 1000LL + (int64_t)(t.usec / 1000);
+        return ms - (int64_t)tz_minutes * 60000LL;
+    }
+
+    struct DateCheck {
+        uint64_t run = 0, failed = 0;
+
+        void expect(bool ok, const char* what, const std::string& detail) {
+            ++run;
+            if (ok) return;
+            if (++failed <= 10) std::printf("FAIL %s: %s\n", what, detail.c_str());
+        }
+    };
+
+    // Returns true when every comparison matches
+    bool verify_dates() {
+        DateCheck c;
+        char buf[64];
+        uint64_t rng = 0x2545F4914F6CDD1Dull;
+        auto next = [&]() { rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng; };
+
+        // Every day 1970-01-01 .. 2399-12-31: round trip and the formatted date
+        const int64_t last_day = EpochTime::daysFromCivil(2400, 1, 1);
+        for (int64_t z = 0; z < last_day; ++z) {
+            EpochTime::CivilDate cd = EpochTime::civilFromDays(z);
+            c.expect(EpochTime::daysFromCivil(cd.year, cd.month, cd.day) == z, "civil round trip",
+                     std::to_string(z));
+            uint64_t ms = (uint64_t)z * 86400000ull + next() % 86400000ull;
+            std::string want = ref_iso8601(ms);
+            size_t n = format_iso8601_from_millis(ms, buf, sizeof(buf));
+            c.expect(n == want.size() && want == buf, "format_iso8601_from_millis", want + " vs " + buf);
+        }
+
+        // Random instants in any order (defeats the day cache), including five-digit years
+        for (int i = 0; i < 20000; ++i) {
+            uint64_t limit = (i % 100 == 0) ? 800000000000000ull : 253402300800000ull;   // 27000 / 10000-01-01
+            uint64_t ms = next() % limit;
+            std::string want = ref_iso8601(ms);
+            c.expect(make_iso8601_from_millis(ms) == want, "make_iso8601_from_millis", want);
+        }
+
+        // Every PLC date 2000-01-01 .. 2400-12-31 at random times and time zones, plus bad fields
+        static const int32_t tz[] = {-720, -300, 0, 330, 840};
+        for (int32_t y = 2000; y <= 2400; ++y) {
+            for (int32_t m = 1; m <= 12; ++m) {
+                int32_t days = (m == 2) ? (is_leap(y) ? 29 : 28) : ((m == 4 || m == 6 || m == 9 || m == 11) ? 30 : 31);
+                for (int32_t d = 1; d <= days; ++d) {
+                    EpochTime::PlcDateTime t{y, m, d, (int32_t)(next() % 24), (int32_t)(next() % 60),
+                                             (int32_t)(next() % 60), (int32_t)(next() % 1000000)};
+                    int32_t off = tz[next() % 5];
+                    int64_t want = ref_to_epoch_ms(t, off);
+                    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d tz %d", y, m, d, off);
+                    c.expect(EpochTime::toEpochMs(t, off) == want, "toEpochMs", buf);
+                }
+            }
+        }
+        const EpochTime::PlcDateTime bad[] = {
+            {1999, 12, 31, 0, 0, 0, 0}, {2024, 0, 1, 0, 0, 0, 0}, {2024, 13, 1, 0, 0, 0, 0}, {2024, 5, 0, 0, 0, 0, 0}};
+        for (const auto& t : bad) {
+            std::snprintf(buf, sizeof(buf), "%d-%d-%d", t.year, t.month, t.day);
+            c.expect(EpochTime::toEpochMs(t, 0) == -1 && ref_to_epoch_ms(t, 0) == -1, "toEpochMs rejects", buf);
+        }
+
+        std::printf("bench: date math %llu/%llu checks passed\n",
+                    (unsigned long long)(c.run - c.failed), (unsigned long long)c.run);
+        return c.failed == 0;
+    }
+
+    // ---- Baseline file: "<ns_per_op> <allocs_per_op> <bytes_per_op> <name>" ------------------
+
+    bool load_baseline(const std::string& path, std::map<std::string, Result>& out) {
+        std::ifstream in(path);
+        if (!in) { std::fprintf(stderr, "bench: cannot open %s\n", path.c_str()); return false; }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream ss(line);
+            Result r;
+            if (!(ss >> r.ns_per_op >> r.allocs_per_op >> r.bytes_per_op)) continue;
+            std::getline(ss >> std::ws, r.name);
+            out[r.name] = r;
+        }
+        return true;
+    }
+
+    bool write_baseline(const std::string& path, const std::vector<Result>& rs) {
+        FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) { std::fprintf(stderr, "bench: cannot write %s\n", path.c_str()); return false; }
+        std::fprintf(f, "# bench baseline: ns/op allocs/op bytes/op name\n");
+        std::fprintf(f, "# regenerate with: bench --write <this file>\n");
+        for (const auto& r : rs)
+            std::fprintf(f, "%.2f %.2f %.1f %s\n", r.ns_per_op, r.allocs_per_op, r.bytes_per_op, r.name.c_str());
+        std::fclose(f);
+        return true;
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    std::string filter, baseline, write;
+    double min_time_ms = 200, threshold = 0.25;
+    int reps = 5;
+    bool check = false, verify = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if      (a == "--filter"    && more) filter      = argv[++i];
+        else if (a == "--min-time"  && more) min_time_ms = std::atof(argv[++i]);
+        else if (a == "--reps"      && more) reps        = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--baseline"  && more) baseline    = argv[++i];
+        else if (a == "--threshold" && more) threshold   = std::atof(argv[++i]);
+        else if (a == "--write"     && more) write       = argv[++i];
+        else if (a == "--check")             check       = true;
+        else if (a == "--verify")            verify      = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--filter SUBSTR] [--min-time MS] [--reps N]\n"
+                                 "          [--baseline FILE [--check] [--threshold F]] [--write FILE]\n"
+                                 "       %s --verify\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+
+    if (verify) return verify_dates() ? 0 : 1;
+
+    cJSON_Hooks hooks{counted_malloc, std::free};
+    cJSON_InitHooks(&hooks);
+
+    std::map<std::string, Result> base;
+    if (!baseline.empty() && !load_baseline(baseline, base)) return 1;
+
+    std::printf("%-30s %10s %9s %9s", "benchmark", "ns/op", "allocs/op", "bytes/op");
+    if (!base.empty()) std::printf(" %10s %8s", "base ns", "delta");
+    std::printf("\n");
+
+    std::vector<Result> results;
+    int regressions = 0;
+    for (const auto& c : make_cases()) {
+        if (!filter.empty() && std::string(c.name).find(filter) == std::string::npos) continue;
+        Result r = measure(c, min_time_ms, reps);
+        results.push_back(r);
+
+        std::printf("%-30s %10.1f %9.2f %9.1f", r.name.c_str(), r.ns_per_op, r.allocs_per_op, r.bytes_per_op);
+        auto it = base.find(r.name);
+        if (it != base.end()) {
+            const Result& b = it->second;
+            double delta = b.ns_per_op > 0 ? r.ns_per_op / b.ns_per_op - 1.0 : 0.0;
+            bool slower = delta > threshold;
+            bool more_allocs = r.allocs_per_op > b.allocs_per_op + 0.005;
+            std::printf(" %10.1f %+7.1f%%%s%s", b.ns_per_op, delta * 100.0,
+                        slower ? "  SLOWER" : "", more_allocs ? "  MORE ALLOCS" : "");
+            if (slower || more_allocs) ++regressions;
+        } else if (!base.empty()) {
+            std::printf(" %10s %8s", "-", "new");
+        }
+        std::printf("\n");
+    }
+
+    if (!write.empty() && !write_baseline(write, results)) return 1;
+
+    if (check && !base.empty()) {
+        if (regressions) {
+            std::printf("bench: %d regression(s) beyond %.0f%% / allocation count\n", regressions, threshold * 100.0);
+            return 1;
+        }
+        std::printf("bench: no regressions (threshold %.0f%%)\n", threshold * 100.0);
+    }
+    return 0;
+}
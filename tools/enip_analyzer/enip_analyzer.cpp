@@ -0,0 +1,289 @@
+// enip_analyzer.cpp
+// George Lake
+// Fall 2025
+//
+// Passive change detection: watches ENIP traffic to the PLC from a mirrored switch port
+// or a capture file and reports writes to the monitored tags, online edits, program
+// downloads and resets by any client, without sending a single request to the PLC.
+//
+// Usage:
+//      enip_analyzer [options] CAPTURE.pcap[ng] ...
+//      enip_analyzer [options] --iface eth1 [--duration S]
+//
+//      --config FILE          watch the tags of a RuntimeConfig file (tags, plcs, containment)
+//      --base B               base for the built-in tags when there is no --config
+//      --watch SYMBOL         add a symbol (repeatable)
+//      --authorized IP        engineering workstation allowed to change the PLC (repeatable)
+//      --port N               PLC TCP port (default: the config's plc port, 44818)
+//      --edit-class 0xNN,...  classes whose edit services count as online edits (0x68,0x6B,0x6C)
+//      --download-threshold N edit operations in one session reported as a download (20)
+//      --quiet                JSONL records only, no per-event log line
+//
+// Notes:
+//      Each event is a {"record_type":"passive_event"} record through Experiment::emit_record,
+//      so it lands on the same sinks and in the same format as the device's records.
+//      A successful write to the audit / authorized-user tags, an online edit or a download
+//      is counted with Experiment::record_audit_change, a write to a PID gain with
+//      record_pid_change; "authorized" is whether the client is an --authorized address
+//      (no list = nobody is). Experiment::dump_summary at exit prints the totals.
+//      Live capture uses AF_PACKET (root or CAP_NET_RAW); put the interface on the mirror
+//      port. t_ms is the analyzer's clock, capture_ms the packet time stamp.
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "CipStatus.hpp"
+#include "ExperimentInstrumentation.hpp"
+#include "RuntimeConfig.hpp"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "packet_source.hpp"
+#include "passive_analyzer.hpp"
+
+namespace {
+    static const char* TAG = "PASSIVE";
+
+    volatile std::sig_atomic_t g_stop = 0;
+    void on_signal(int) { g_stop = 1; }
+
+    struct Options {
+        std::vector<std::string> files;
+        std::string              iface;
+        uint32_t                 duration_s = 0;
+        std::string              config;
+        std::string              base = "WDG_Status_Instance";
+        std::vector<std::string> watch;
+        std::vector<uint32_t>    authorized;        // host order
+        uint16_t                 port = 0;          // 0 = cfg.plc_port
+        std::vector<uint32_t>    edit_classes;
+        uint32_t                 download_threshold = 20;
+        bool                     quiet = false;
+    };
+
+    // Why each Rules::watch entry is watched: a RuntimeConfig role, "containment" or "watch"
+    std::vector<std::string> g_watch_roles;
+    std::vector<uint32_t>    g_authorized;
+    bool                     g_quiet = false;
+
+    void usage(const char* argv0) {
+        std::fprintf(stderr,
+            "usage: %s [--config FILE] [--base B] [--watch SYMBOL] [--authorized IP] [--port N]\n"
+            "          [--edit-class 0xNN,...] [--download-threshold N] [--quiet]\n"
+            "          (CAPTURE ... | --iface NAME [--duration S])\n", argv0);
+    }
+
+    bool parse_ip(const char* s, uint32_t& out) {
+        unsigned a, b, c, d;
+        char tail;
+        if (std::sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+        if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+        out = a << 24 | b << 16 | c << 8 | d;
+        return true;
+    }
+
+    bool parse_args(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const char* a = argv[i];
+            const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!v) { usage(argv[0]); return false; } ++i; return true; };
+
+            if      (!std::strcmp(a, "--iface"))      { if (!need()) return false; o.iface = v; }
+            else if (!std::strcmp(a, "--duration"))   { if (!need()) return false; o.duration_s = (uint32_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--config"))     { if (!need()) return false; o.config = v; }
+            else if (!std::strcmp(a, "--base"))       { if (!need()) return false; o.base = v; }
+            else if (!std::strcmp(a, "--watch"))      { if (!need()) return false; o.watch.push_back(v); }
+            else if (!std::strcmp(a, "--port"))       { if (!need()) return false; o.port = (uint16_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--quiet"))      { o.quiet = true; }
+            else if (!std::strcmp(a, "--download-threshold")) { if (!need()) return false; o.download_threshold = (uint32_t)std::atoi(v); }
+            else if (!std::strcmp(a, "--authorized")) {
+                uint32_t ip;
+                if (!need() || !parse_ip(v, ip)) { usage(argv[0]); return false; }
+                o.authorized.push_back(ip);
+            }
+            else if (!std::strcmp(a, "--edit-class")) {
+                if (!need()) return false;
+                for (const char* p = v; *p; ) {
+                    char* end = nullptr;
+                    unsigned long c = std::strtoul(p, &end, 0);
+                    if (end == p) { usage(argv[0]); return false; }
+                    o.edit_classes.push_back((uint32_t)c);
+                    p = (*end == ',') ? end + 1 : end;
+                }
+            }
+            else if (a[0] == '-') { usage(argv[0]); return false; }
+            else o.files.push_back(a);
+        }
+        if (o.files.empty() == o.iface.empty()) { usage(argv[0]); return false; }
+        return true;
+    }
+
+    void add_watch(Passive::Rules& rules, const std::string& symbol, const char* role) {
+        if (symbol.empty()) return;
+        for (const std::string& w : rules.watch) if (w == symbol) return;
+        rules.watch.push_back(symbol);
+        g_watch_roles.push_back(role);
+    }
+
+    bool authorized(uint32_t ip) {
+        for (uint32_t a : g_authorized) if (a == ip) return true;
+        return false;
+    }
+
+    void on_event(const Passive::Event& e, void*) {
+        //
+        // One JSONL record per event; the counters follow the device's audit semantics
+        //
+        const char* kind   = Passive::event_name(e.kind);
+        const char* role   = e.watch >= 0 ? g_watch_roles[(size_t)e.watch].c_str() : "";
+        const bool  auth   = authorized(e.client_ip);
+        const bool  ok     = e.replied && e.status.ok();
+        std::string client = Passive::ip_to_string(e.client_ip);
+        std::string plc    = Passive::ip_to_string(e.plc_ip);
+        char status[64];
+        if (e.replied) Cip::describe(e.status, status, sizeof(status));
+        else std::snprintf(status, sizeof(status), "no reply");
+
+        int64_t now = Experiment::timestamp_ms();
+        cJSON* root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "record_type", "passive_event");
+        cJSON_AddNumberToObject(root, "t_ms", (double)now);
+        cJSON_AddNumberToObject(root, "capture_ms", (double)(e.ts_us / 1000));
+        cJSON_AddStringToObject(root, "kind", kind);
+        cJSON_AddStringToObject(root, "client", client.c_str());
+        cJSON_AddNumberToObject(root, "client_port", e.client_port);
+        cJSON_AddStringToObject(root, "plc", plc.c_str());
+        cJSON_AddBoolToObject(root, "authorized_client", auth);
+        if (e.kind != Passive::EventKind::NEW_CLIENT) {
+            cJSON_AddNumberToObject(root, "service", e.service);
+            if (e.class_id != Cip::NO_ID) cJSON_AddNumberToObject(root, "class", e.class_id);
+            if (e.instance != Cip::NO_ID) cJSON_AddNumberToObject(root, "instance", e.instance);
+            cJSON_AddBoolToObject(root, "replied", e.replied);
+            cJSON_AddBoolToObject(root, "ok", ok);
+            cJSON_AddStringToObject(root, "status", status);
+        }
+        if (e.kind == Passive::EventKind::TAG_WRITE) {
+            cJSON_AddStringToObject(root, "tag", e.tag.c_str());
+            cJSON_AddBoolToObject(root, "watched", e.watch >= 0);
+            if (e.watch >= 0) cJSON_AddStringToObject(root, "role", role);
+        }
+        if (e.kind == Passive::EventKind::PROGRAM_DOWNLOAD) cJSON_AddNumberToObject(root, "edit_ops", e.count);
+
+        char* raw = cJSON_PrintUnformatted(root);
+        std::string json(raw ? raw : "");
+        free(raw);
+        cJSON_Delete(root);
+        Experiment::emit_record(json, now);
+
+        if (ok) {
+            if (e.kind == Passive::EventKind::ONLINE_EDIT || e.kind == Passive::EventKind::PROGRAM_DOWNLOAD ||
+                (e.watch >= 0 && (!std::strcmp(role, "audit") || !std::strcmp(role, "authorized")))) {
+                Experiment::record_audit_change(auth);
+            } else if (e.watch >= 0 && (!std::strcmp(role, "kp") || !std::strcmp(role, "ki") ||
+                                        !std::strcmp(role, "kd"))) {
+                Experiment::record_pid_change(auth);
+            }
+        }
+
+        if (g_quiet) return;
+        // Unwatched writes are routine HMI traffic: log them at INFO only
+        const bool notable = e.kind != Passive::EventKind::TAG_WRITE || e.watch >= 0;
+        const char* who = auth ? " (authorized client)" : "";
+        if (e.kind == Passive::EventKind::NEW_CLIENT) {
+            ESP_LOGW(TAG, "%s %s:%u -> %s%s", kind, client.c_str(), e.client_port, plc.c_str(), who);
+        } else if (notable) {
+            ESP_LOGW(TAG, "%s %s:%u -> %s %s%s%s svc=0x%02X %s%s", kind, client.c_str(), e.client_port,
+                     plc.c_str(), e.tag.c_str(), *role ? " role=" : "", role, e.service, status, who);
+        } else {
+            ESP_LOGI(TAG, "%s %s -> %s %s %s", kind, client.c_str(), plc.c_str(), e.tag.c_str(), status);
+        }
+    }
+
+    void segment(const Passive::TcpSegment& s, void* ctx) {
+        static_cast<Passive::Analyzer*>(ctx)->segment(s);
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 2;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set(TAG, opt.quiet ? ESP_LOG_WARN : ESP_LOG_INFO);
+    esp_log_level_set("JSON", ESP_LOG_INFO);
+    esp_log_level_set("EXPERIMENT", ESP_LOG_INFO);
+
+    // Watch list ------------------------------------------------------------------------------
+    RuntimeConfig::Config cfg = RuntimeConfig::defaults("0.0.0.0", 44818, opt.base.c_str(), 0, 200);
+    if (!opt.config.empty() && !RuntimeConfig::load(opt.config.c_str(), cfg)) return 2;
+
+    Passive::Rules rules;
+    rules.port               = opt.port ? opt.port : cfg.plc_port;
+    rules.download_threshold = opt.download_threshold;
+    if (!opt.edit_classes.empty()) rules.edit_classes = opt.edit_classes;
+    for (size_t r = 0; r < (size_t)RuntimeConfig::Role::COUNT; ++r) {
+        const char* role = RuntimeConfig::role_name((RuntimeConfig::Role)r);
+        add_watch(rules, cfg.tags[r].symbol, role);
+        for (const RuntimeConfig::PlcSpec& p : cfg.plcs) add_watch(rules, p.symbols[r], role);
+    }
+    for (const RuntimeConfig::WriteSpec& w : cfg.containment) add_watch(rules, w.symbol, "containment");
+    for (const std::string& w : opt.watch) add_watch(rules, w, "watch");
+    g_authorized = opt.authorized;
+    g_quiet      = opt.quiet;
+
+    for (size_t i = 0; i < rules.watch.size(); ++i) {
+        ESP_LOGI(TAG, "watch %-12s %s", g_watch_roles[i].c_str(), rules.watch[i].c_str());
+    }
+    for (uint32_t ip : g_authorized) ESP_LOGI(TAG, "authorized client %s", Passive::ip_to_string(ip).c_str());
+
+    Experiment::init("PASSIVE", "passive_analyzer", cfg.trial_id, false, "none", 0);
+
+    // Capture ---------------------------------------------------------------------------------
+    Passive::Analyzer analyzer(rules, on_event, nullptr);
+    Passive::SourceStats src;
+    std::string error;
+    const auto t0 = std::chrono::steady_clock::now();
+    bool ok = true;
+    if (!opt.iface.empty()) {
+        struct sigaction sa{};
+        sa.sa_handler = on_signal;
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+        sigaction(SIGALRM, &sa, nullptr);
+        if (opt.duration_s) alarm(opt.duration_s);
+        ESP_LOGI(TAG, "capturing on %s, PLC port %u", opt.iface.c_str(), (unsigned)rules.port);
+        ok = Passive::capture_live(opt.iface, segment, &analyzer, src, &g_stop, error);
+    } else {
+        for (const std::string& f : opt.files) {
+            if (!Passive::read_capture_file(f, segment, &analyzer, src, error)) { ok = false; break; }
+        }
+    }
+    if (!ok) ESP_LOGE(TAG, "%s", error.c_str());
+    analyzer.finish();
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Summary ---------------------------------------------------------------------------------
+    const Passive::AnalyzerStats& a = analyzer.stats();
+    std::printf("packets %llu (%.1f MB), tcp %llu, skipped %llu in %.3f s: %.2f Mpps, %.1f MB/s\n",
+                (unsigned long long)src.packets, src.bytes / 1e6, (unsigned long long)src.tcp_segments,
+                (unsigned long long)src.skipped, secs, secs > 0 ? src.packets / secs / 1e6 : 0.0,
+                secs > 0 ? src.bytes / secs / 1e6 : 0.0);
+    std::printf("flows %llu, enip frames %llu, cip requests %llu, replies %llu, unmatched %llu, "
+                "no reply %llu, gaps %llu, resyncs %llu\n",
+                (unsigned long long)a.flows, (unsigned long long)a.enip_frames,
+                (unsigned long long)a.cip_requests, (unsigned long long)a.cip_replies,
+                (unsigned long long)a.unmatched, (unsigned long long)a.no_reply,
+                (unsigned long long)a.gaps, (unsigned long long)a.resyncs);
+    std::printf("writes %llu, edits %llu, learned symbols %llu, events %llu\n",
+                (unsigned long long)a.writes, (unsigned long long)a.edits,
+                (unsigned long long)a.learned_symbols, (unsigned long long)a.events);
+    std::fflush(stdout);
+    Experiment::dump_summary();
+    return ok ? 0 : 1;
+}
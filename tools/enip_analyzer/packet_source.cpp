@@ -0,0 +1,303 @@
+// packet_source.cpp
+// George Lake
+// Fall 2025
+//
+// pcap / pcapng reader, AF_PACKET capture, link + IPv4 + TCP decoding
+// Refer to packet_source.hpp for notes
+
+
+#include "packet_source.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // LINKTYPE_* values (tcpdump.org/linktypes.html)
+    constexpr uint32_t LINK_NULL     = 0;
+    constexpr uint32_t LINK_ETHERNET = 1;
+    constexpr uint32_t LINK_RAW      = 101;
+    constexpr uint32_t LINK_SLL      = 113;
+    constexpr uint32_t LINK_IPV4     = 228;
+    constexpr uint32_t LINK_SLL2     = 276;
+
+    constexpr uint32_t PCAP_MAGIC_US = 0xA1B2C3D4;
+    constexpr uint32_t PCAP_MAGIC_NS = 0xA1B23C4D;
+    constexpr uint32_t PCAPNG_SHB    = 0x0A0D0D0A;
+    constexpr uint32_t PCAPNG_BOM    = 0x1A2B3C4D;
+
+    inline uint16_t be16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+    inline uint32_t be32(const uint8_t* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+    inline uint32_t rd32(const uint8_t* p, bool swap) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return swap ? __builtin_bswap32(v) : v;
+    }
+    inline uint16_t rd16(const uint8_t* p, bool swap) {
+        uint16_t v;
+        std::memcpy(&v, p, 2);
+        return swap ? __builtin_bswap16(v) : v;
+    }
+
+    // IPv4 header onwards
+    bool decode_ipv4(const uint8_t* p, size_t n, Passive::TcpSegment& s) {
+        if (n < 20 || (p[0] >> 4) != 4) return false;
+        const size_t ihl   = (size_t)(p[0] & 0x0F) * 4;
+        const size_t total = be16(p + 2);
+        if (ihl < 20 || total < ihl || n < ihl) return false;
+        if (be16(p + 6) & 0x3FFF) return false;             // MF or fragment offset
+        if (p[9] != 6) return false;                        // TCP
+        if (total < n) n = total;                           // Ethernet padding
+        s.src_ip = be32(p + 12);
+        s.dst_ip = be32(p + 16);
+
+        const uint8_t* t = p + ihl;
+        const size_t   tn = n - ihl;
+        if (tn < 20) return false;
+        const size_t doff = (size_t)(t[12] >> 4) * 4;
+        if (doff < 20 || tn < doff) return false;
+        s.src_port = be16(t);
+        s.dst_port = be16(t + 2);
+        s.seq      = be32(t + 4);
+        s.flags    = t[13];
+        s.payload  = t + doff;
+        s.len      = tn - doff;
+        return true;
+    }
+
+    bool decode_frame(uint32_t link, const uint8_t* p, size_t n, Passive::TcpSegment& s) {
+        //
+        // Strip the link header down to IPv4
+        //
+        switch (link) {
+            case LINK_ETHERNET: {
+                if (n < 14) return false;
+                size_t off = 12;
+                uint16_t type = be16(p + off);
+                while ((type == 0x8100 || type == 0x88A8) && n >= off + 6) {   // VLAN tags
+                    off += 4;
+                    type = be16(p + off);
+                }
+                if (type != 0x0800) return false;
+                return decode_ipv4(p + off + 2, n - off - 2, s);
+            }
+            case LINK_RAW:
+            case LINK_IPV4:
+                return decode_ipv4(p, n, s);
+            case LINK_SLL:
+                return n >= 16 && be16(p + 14) == 0x0800 && decode_ipv4(p + 16, n - 16, s);
+            case LINK_SLL2:
+                return n >= 20 && be16(p) == 0x0800 && decode_ipv4(p + 20, n - 20, s);
+            case LINK_NULL: {
+                if (n < 4) return false;
+                uint32_t family;
+                std::memcpy(&family, p, 4);
+                return (family == 2 || family == 0x02000000) && decode_ipv4(p + 4, n - 4, s);
+            }
+            default:
+                return false;
+        }
+    }
+
+    void deliver(uint32_t link, const uint8_t* p, size_t n, int64_t ts_us, Passive::SegmentFn fn, void* ctx,
+                 Passive::SourceStats& st) {
+        st.packets++;
+        st.bytes += n;
+        Passive::TcpSegment s;
+        if (!decode_frame(link, p, n, s)) { st.skipped++; return; }
+        st.tcp_segments++;
+        s.ts_us = ts_us;
+        fn(s, ctx);
+    }
+
+    bool read_pcap(const uint8_t* d, size_t n, Passive::SegmentFn fn, void* ctx, Passive::SourceStats& st,
+                   std::string& error) {
+        //
+        // 24-byte file header, then 16-byte record header + data
+        //
+        uint32_t magic;
+        std::memcpy(&magic, d, 4);
+        const bool swap = (magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS));
+        const bool ns   = (magic == PCAP_MAGIC_NS || magic == __builtin_bswap32(PCAP_MAGIC_NS));
+        if (n < 24) { error = "truncated pcap header"; return false; }
+        const uint32_t link = rd32(d + 20, swap) & 0x0FFFFFFF;
+
+        size_t off = 24;
+        while (off + 16 <= n) {
+            const uint32_t sec  = rd32(d + off, swap);
+            const uint32_t frac = rd32(d + off + 4, swap);
+            const uint32_t incl = rd32(d + off + 8, swap);
+            off += 16;
+            if (incl > n - off) break;                      // truncated last record
+            const int64_t ts = (int64_t)sec * 1000000 + (ns ? frac / 1000 : frac);
+            deliver(link, d + off, incl, ts, fn, ctx, st);
+            off += incl;
+        }
+        return true;
+    }
+
+    bool read_pcapng(const uint8_t* d, size_t n, Passive::SegmentFn fn, void* ctx, Passive::SourceStats& st,
+                     std::string& error) {
+        //
+        // Section header, interface descriptions (link type, timestamp resolution), packets
+        //
+        struct Iface { uint32_t link; uint64_t per_sec; };
+        std::vector<Iface> ifaces;
+        bool swap = false;
+        size_t off = 0;
+        while (off + 12 <= n) {
+            uint32_t type = rd32(d + off, swap);
+            if (type == PCAPNG_SHB || __builtin_bswap32(type) == PCAPNG_SHB) {
+                uint32_t bom;
+                std::memcpy(&bom, d + off + 8, 4);
+                swap = (bom != PCAPNG_BOM);
+                ifaces.clear();
+                type = PCAPNG_SHB;
+            }
+            const uint32_t len = rd32(d + off + 4, swap);
+            if (len < 12 || len > n - off) break;
+            const uint8_t* b = d + off + 8;                 // block body
+            const size_t   bn = len - 12;
+
+            if (type == 1 && bn >= 8) {                     // Interface Description
+                Iface i{rd16(b, swap), 1000000};
+                size_t o = 8;
+                while (o + 4 <= bn) {
+                    const uint16_t code = rd16(b + o, swap), olen = rd16(b + o + 2, swap);
+                    if (code == 0) break;
+                    if (code == 9 && olen >= 1 && o + 5 <= bn) {     // if_tsresol
+                        const uint8_t r = b[o + 4];
+                        uint64_t per = 1;
+                        for (int k = 0; k < (r & 0x7F) && k < 19; ++k) per *= (r & 0x80) ? 2 : 10;
+                        i.per_sec = per;
+                    }
+                    o += 4 + ((olen + 3u) & ~3u);
+                }
+                ifaces.push_back(i);
+            } else if (type == 6 && bn >= 20) {             // Enhanced Packet
+                const uint32_t id  = rd32(b, swap);
+                const uint64_t ts  = (uint64_t)rd32(b + 4, swap) << 32 | rd32(b + 8, swap);
+                const uint32_t cap = rd32(b + 12, swap);
+                if (id < ifaces.size() && cap <= bn - 20) {
+                    const Iface& i = ifaces[id];
+                    const int64_t us = (int64_t)(ts / i.per_sec * 1000000 + ts % i.per_sec * 1000000 / i.per_sec);
+                    deliver(i.link, b + 20, cap, us, fn, ctx, st);
+                }
+            } else if (type == 3 && bn >= 4 && !ifaces.empty()) {      // Simple Packet
+                const uint32_t orig = rd32(b, swap);
+                deliver(ifaces[0].link, b + 4, orig < bn - 4 ? orig : bn - 4, 0, fn, ctx, st);
+            }
+            off += len;
+        }
+        if (ifaces.empty() && st.packets == 0) { error = "no interface in pcapng file"; return false; }
+        return true;
+    }
+} // Anonymous Namespace
+
+namespace Passive {
+    bool read_capture_file(const std::string& path, SegmentFn fn, void* ctx, SourceStats& stats,
+                           std::string& error) {
+        //
+        //
+        //
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { error = path + ": " + std::strerror(errno); return false; }
+        struct stat sb{};
+        if (::fstat(fd, &sb) != 0 || sb.st_size < 24) {
+            ::close(fd);
+            error = path + ": not a capture file";
+            return false;
+        }
+        const size_t n = (size_t)sb.st_size;
+        void* map = ::mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) { error = path + ": mmap failed"; return false; }
+        ::madvise(map, n, MADV_SEQUENTIAL);
+
+        const uint8_t* d = (const uint8_t*)map;
+        uint32_t magic;
+        std::memcpy(&magic, d, 4);
+        bool ok;
+        if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS ||
+            magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS)) {
+            ok = read_pcap(d, n, fn, ctx, stats, error);
+        } else if (magic == PCAPNG_SHB) {
+            ok = read_pcapng(d, n, fn, ctx, stats, error);
+        } else {
+            error = path + ": not a pcap or pcapng file";
+            ok = false;
+        }
+        ::munmap(map, n);
+        return ok;
+    }
+
+    bool capture_live(const std::string& iface, SegmentFn fn, void* ctx, SourceStats& stats,
+                      volatile std::sig_atomic_t* stop, std::string& error) {
+        //
+        // Raw Ethernet frames from one interface; a 1 s receive timeout lets *stop be seen
+        //
+        int fd = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+        if (fd < 0) { error = std::string("AF_PACKET socket: ") + std::strerror(errno); return false; }
+
+        ifreq ifr{};
+        std::strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+        if (::ioctl(fd, SIOCGIFINDEX, &ifr) != 0) {
+            error = iface + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        sockaddr_ll sll{};
+        sll.sll_family   = AF_PACKET;
+        sll.sll_protocol = htons(ETH_P_ALL);
+        sll.sll_ifindex  = ifr.ifr_ifindex;
+        if (::bind(fd, (sockaddr*)&sll, sizeof(sll)) != 0) {
+            error = iface + ": bind: " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        const bool loopback = ::ioctl(fd, SIOCGIFFLAGS, &ifr) == 0 && (ifr.ifr_flags & IFF_LOOPBACK);
+
+        int rcvbuf = 8 * 1024 * 1024;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        timeval tv{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        std::vector<uint8_t> buf(65536);
+        while (!*stop) {
+            sockaddr_ll from{};
+            socklen_t from_len = sizeof(from);
+            ssize_t n = ::recvfrom(fd, buf.data(), buf.size(), 0, (sockaddr*)&from, &from_len);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                error = std::string("recv: ") + std::strerror(errno);
+                break;
+            }
+            if (loopback && from.sll_pkttype == PACKET_OUTGOING) continue;
+            timeval now{};
+            ::gettimeofday(&now, nullptr);
+            deliver(LINK_ETHERNET, buf.data(), (size_t)n, (int64_t)now.tv_sec * 1000000 + now.tv_usec,
+                    fn, ctx, stats);
+        }
+        ::close(fd);
+        return error.empty();
+    }
+
+    std::string ip_to_string(uint32_t ip) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%u.%u.%u.%u", ip >> 24, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+        return buf;
+    }
+}
@@ -0,0 +1,52 @@
+// packet_source.hpp
+// George Lake
+// Fall 2025
+//
+// Packet input for enip_analyzer: pcap / pcapng files and live capture on a Linux
+// interface (AF_PACKET), reduced to IPv4 TCP segments.
+//
+// Notes:
+//      Link types: Ethernet (with 802.1Q tags), raw IPv4, Linux cooked (SLL, SLL2), BSD loopback.
+//      Files are mapped read-only and walked in place; no per-packet copy or allocation.
+//      IPv4 fragments and IPv6 are skipped (counted). Live capture needs CAP_NET_RAW;
+//      on a loopback interface the outgoing copy of each packet is skipped.
+
+#pragma once
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Passive {
+    struct TcpSegment {
+        int64_t        ts_us   = 0;         // capture time, us since the epoch
+        uint32_t       src_ip  = 0;         // host byte order
+        uint32_t       dst_ip  = 0;
+        uint16_t       src_port = 0;
+        uint16_t       dst_port = 0;
+        uint32_t       seq     = 0;
+        uint8_t        flags   = 0;         // TCP flags byte (FIN 0x01, SYN 0x02, RST 0x04)
+        const uint8_t* payload = nullptr;
+        size_t         len     = 0;
+    };
+
+    struct SourceStats {
+        uint64_t packets      = 0;
+        uint64_t bytes        = 0;
+        uint64_t tcp_segments = 0;          // IPv4 TCP, any port
+        uint64_t skipped      = 0;          // not IPv4 TCP, fragments, truncated
+    };
+
+    using SegmentFn = void (*)(const TcpSegment& seg, void* ctx);
+
+    // Reads a whole pcap or pcapng file; false if it cannot be opened or is not a capture
+    bool read_capture_file(const std::string& path, SegmentFn fn, void* ctx, SourceStats& stats,
+                           std::string& error);
+
+    // Captures on iface until *stop becomes non-zero
+    bool capture_live(const std::string& iface, SegmentFn fn, void* ctx, SourceStats& stats,
+                      volatile std::sig_atomic_t* stop, std::string& error);
+
+    // "a.b.c.d" for a host-order address
+    std::string ip_to_string(uint32_t ip);
+}
@@ -0,0 +1,492 @@
+// passive_analyzer.cpp
+// George Lake
+// Fall 2025
+//
+// ENIP/CIP session tracker for enip_analyzer (see passive_analyzer.hpp).
+
+#include "passive_analyzer.hpp"
+
+#include <strings.h>
+
+#include <cstdio>
+#include <utility>
+
+namespace Passive {
+    namespace {
+        constexpr size_t   ENCAP_HEADER   = 24;
+        constexpr size_t   MAX_OOO_BYTES  = 256 * 1024;  // per direction, then the hole is skipped
+        constexpr int64_t  HOLE_WAIT_US   = 200 * 1000;  // Linux minimum RTO
+        constexpr size_t   MAX_PENDING    = 256;         // per flow
+        constexpr size_t   MAX_SYMBOLS    = 1u << 20;
+        constexpr size_t   COMPACT_AT     = 64 * 1024;
+        constexpr uint8_t  TCP_FIN        = 0x01;
+        constexpr uint8_t  TCP_SYN        = 0x02;
+        constexpr uint8_t  TCP_RST        = 0x04;
+
+        constexpr uint16_t CMD_RR_DATA    = 0x6F;
+        constexpr uint16_t CMD_UNIT_DATA  = 0x70;
+
+        constexpr uint8_t  SVC_MULTIPLE   = 0x0A;
+        constexpr uint8_t  SVC_RESET      = 0x05;
+        constexpr uint8_t  SVC_WRITE      = 0x4D;
+        constexpr uint8_t  SVC_RMW        = 0x4E;
+        constexpr uint8_t  SVC_WRITE_FRAG = 0x53;
+        constexpr uint8_t  SVC_UNCONN_SEND = 0x52;
+        constexpr uint8_t  SVC_ATTR_LIST  = 0x55;
+        constexpr uint32_t CLASS_IDENTITY = 0x01;
+        constexpr uint32_t CLASS_ROUTER   = 0x02;
+        constexpr uint32_t CLASS_CONN_MGR = 0x06;
+        constexpr uint32_t CLASS_SYMBOL   = 0x6B;
+
+        uint16_t u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+        uint32_t u32(const uint8_t* p) { return (uint32_t)u16(p) | ((uint32_t)u16(p + 2) << 16); }
+
+        // Commands a client or PLC sends on the TCP port; used to find a frame boundary
+        bool plausible_header(const uint8_t* h) {
+            switch (u16(h)) {
+                case 0x0004: case 0x0063: case 0x0064: case 0x0065:
+                case 0x0066: case 0x006F: case 0x0070: break;
+                default: return false;
+            }
+            return u32(h + 20) == 0;                        // options
+        }
+
+        bool is_edit_service(uint8_t s) {
+            switch (s) {
+                case 0x02: case 0x04: case 0x08: case 0x09: case 0x10: return true;
+                case 0x4C: case SVC_WRITE: case SVC_RMW: case SVC_UNCONN_SEND:
+                case SVC_WRITE_FRAG: case SVC_ATTR_LIST: return false;
+                default: return s >= 0x4B && s <= 0x63;
+            }
+        }
+
+        // Get_Instance_Attribute_List value sizes for the symbol class; 0 = unknown
+        size_t symbol_attr_size(uint16_t attr, const uint8_t* p, size_t avail) {
+            switch (attr) {
+                case 1: return avail < 2 ? 0 : 2 + (size_t)u16(p);
+                case 2: case 7: return 2;
+                case 3: case 5: case 6: return 4;
+                case 8: return 12;
+                default: return 0;
+            }
+        }
+    } // Anonymous Namespace
+
+    const char* event_name(EventKind k) {
+        switch (k) {
+            case EventKind::NEW_CLIENT:       return "new_client";
+            case EventKind::TAG_WRITE:        return "tag_write";
+            case EventKind::ONLINE_EDIT:      return "online_edit";
+            case EventKind::PROGRAM_DOWNLOAD: return "program_download";
+            case EventKind::DEVICE_RESET:     return "device_reset";
+        }
+        return "?";
+    }
+
+    Analyzer::Analyzer(const Rules& rules, EventFn fn, void* ctx)
+        : rules_(rules), fn_(fn), ctx_(ctx) {}
+
+    void Analyzer::segment(const TcpSegment& s) {
+        //
+        // Direction from the PLC port; everything else on the wire is ignored
+        //
+        bool to_plc;
+        FlowKey key;
+        if (s.dst_port == rules_.port) {
+            to_plc = true;
+            key = FlowKey{s.src_ip, s.dst_ip, s.src_port, s.dst_port};
+        } else if (s.src_port == rules_.port) {
+            to_plc = false;
+            key = FlowKey{s.dst_ip, s.src_ip, s.dst_port, s.src_port};
+        } else {
+            return;
+        }
+
+        auto it = flows_.find(key);
+        if (it == flows_.end()) {
+            if (s.flags & TCP_RST) return;
+            it = flows_.emplace(key, Flow{}).first;
+            it->second.key = key;
+            ++stats_.flows;
+        }
+        Flow& f = it->second;
+        Stream& st = to_plc ? f.to_plc : f.from_plc;
+
+        if (s.flags & TCP_SYN) {
+            st = Stream{};
+            st.have_seq = true;
+            st.synced   = true;
+            st.next_seq = s.seq + 1;
+        }
+        if (s.len) feed(f, st, to_plc, s);
+        if (!f.pending.empty()) expire(f, s.ts_us, false);
+
+        if (s.flags & TCP_FIN) st.fin = true;
+        if ((s.flags & TCP_RST) || (f.to_plc.fin && f.from_plc.fin)) {
+            expire(f, s.ts_us, true);
+            flows_.erase(it);
+        }
+    }
+
+    void Analyzer::finish() {
+        //
+        //
+        //
+        for (auto& kv : flows_) expire(kv.second, 0, true);
+    }
+
+    void Analyzer::feed(Flow& f, Stream& st, bool to_plc, const TcpSegment& s) {
+        //
+        // In-order bytes go straight to the frame buffer; early ones wait in ooo until the
+        // hole is filled, or until a retransmission is overdue (capture loss: skip the hole)
+        //
+        const uint8_t* p = s.payload;
+        size_t   n   = s.len;
+        uint32_t seq = s.seq;
+        if (!st.have_seq) {                                 // joined mid-connection
+            st.have_seq = true;
+            st.synced   = false;
+            st.next_seq = seq;
+        }
+
+        int32_t d = (int32_t)(seq - st.next_seq);
+        if (d < 0) {
+            if ((size_t)-(int64_t)d >= n) return;           // retransmission
+            p += -(int64_t)d;
+            n -= (size_t)-(int64_t)d;
+            d = 0;
+        }
+        if (d > 0) {
+            if (st.ooo.empty()) st.hole_us = s.ts_us;
+            if (st.ooo.find(seq) == st.ooo.end()) {
+                st.ooo.emplace(seq, std::vector<uint8_t>(p, p + n));
+                st.ooo_bytes += n;
+            }
+            if (st.ooo_bytes <= MAX_OOO_BYTES && s.ts_us - st.hole_us < HOLE_WAIT_US) return;
+            ++stats_.gaps;
+            st.buf.clear();
+            st.rd       = 0;
+            st.synced   = false;
+            st.next_seq = st.ooo.begin()->first;
+        } else {
+            append(st, p, n);
+            st.next_seq += (uint32_t)n;
+        }
+
+        while (!st.ooo.empty()) {
+            auto it = st.ooo.begin();
+            const int32_t dd = (int32_t)(it->first - st.next_seq);
+            if (dd > 0) break;
+            const size_t skip = (size_t)-(int64_t)dd;
+            if (skip < it->second.size()) {
+                append(st, it->second.data() + skip, it->second.size() - skip);
+                st.next_seq += (uint32_t)(it->second.size() - skip);
+            }
+            st.ooo_bytes -= it->second.size();
+            st.ooo.erase(it);
+        }
+        parse_frames(f, st, to_plc, s.ts_us);
+    }
+
+    void Analyzer::append(Stream& st, const uint8_t* p, size_t n) {
+        //
+        // Out of sync, a segment is only kept if it starts like a frame
+        //
+        if (!st.synced && st.buf.size() == st.rd) {
+            if (n < ENCAP_HEADER || !plausible_header(p)) { ++stats_.resyncs; return; }
+            st.synced = true;
+        }
+        if (!st.synced) return;
+        st.buf.insert(st.buf.end(), p, p + n);
+    }
+
+    void Analyzer::parse_frames(Flow& f, Stream& st, bool to_plc, int64_t ts_us) {
+        //
+        //
+        //
+        while (st.buf.size() - st.rd >= ENCAP_HEADER) {
+            const uint8_t* h = st.buf.data() + st.rd;
+            if (!plausible_header(h)) {                     // lost the framing
+                ++stats_.resyncs;
+                st.buf.clear();
+                st.rd     = 0;
+                st.synced = false;
+                return;
+            }
+            const size_t n = ENCAP_HEADER + u16(h + 2);
+            if (st.buf.size() - st.rd < n) break;
+            frame(f, to_plc, h, n, ts_us);
+            st.rd += n;
+        }
+        if (st.rd == st.buf.size()) {
+            st.buf.clear();
+            st.rd = 0;
+        } else if (st.rd >= COMPACT_AT) {
+            st.buf.erase(st.buf.begin(), st.buf.begin() + (ptrdiff_t)st.rd);
+            st.rd = 0;
+        }
+    }
+
+    void Analyzer::frame(Flow& f, bool to_plc, const uint8_t* h, size_t n, int64_t ts_us) {
+        //
+        // header: command(2) length(2) session(4) status(4) context(8) options(4)
+        //
+        ++stats_.enip_frames;
+        const uint16_t cmd = u16(h);
+        if (to_plc) note_client(f, ts_us);
+        if (cmd != CMD_RR_DATA && cmd != CMD_UNIT_DATA) return;
+
+        uint64_t context = 0;
+        for (int i = 7; i >= 0; --i) context = context << 8 | h[12 + i];
+        Cip::Span cip;
+        bool connected = false;
+        uint16_t seq = 0;
+        const bool found = Cip::find_cpf_data(Cip::Span{h + ENCAP_HEADER, n - ENCAP_HEADER}, cip, connected, seq);
+
+        if (to_plc) {
+            if (found) request(f, cip, context, connected, seq, ts_us);
+            return;
+        }
+        if (found) {
+            reply(f, cip, context, connected, seq);
+        } else if (u32(h + 8) != 0 && cmd == CMD_RR_DATA) {
+            reply(f, Cip::Span{}, context, false, 0);      // encapsulation error, no CPF
+        }
+    }
+
+    void Analyzer::request(Flow& f, Cip::Span cip, uint64_t context, bool connected, uint16_t seq,
+                           int64_t ts_us) {
+        //
+        // Every request is queued, interesting or not, so replies stay paired
+        //
+        ++stats_.cip_requests;
+        Pending p;
+        p.ts_us     = ts_us;
+        p.context   = context;
+        p.connected = connected;
+        p.seq       = seq;
+        classify(f, cip, p, 0);
+
+        if (f.pending.size() >= MAX_PENDING) {
+            const Pending old = std::move(f.pending.front());
+            f.pending.pop_front();
+            ++stats_.no_reply;
+            for (const Op& op : old.ops) deliver(f, old, op, false, Cip::Status{});
+        }
+        f.pending.push_back(std::move(p));
+    }
+
+    void Analyzer::classify(Flow& f, Cip::Span cip, Pending& p, int depth) {
+        //
+        // Unconnected Send and MSP are unwrapped; the reply comes back unwrapped too
+        //
+        Cip::Request& r = req_[depth];
+        if (!Cip::parse_request(cip, r)) return;
+
+        Cip::Span inner;
+        if (r.service == SVC_UNCONN_SEND && r.class_id == CLASS_CONN_MGR) {
+            if (depth < 2 && Cip::unwrap_unconnected_send(r, inner)) classify(f, inner, p, depth + 1);
+            return;
+        }
+        if (r.service == SVC_MULTIPLE && r.class_id == CLASS_ROUTER) {
+            if (depth >= 2 || !Cip::split_multiple_service(r.data, parts_)) return;
+            p.msp = true;
+            Cip::Request& e = req_[depth + 1];
+            for (size_t i = 0; i < parts_.size(); ++i) {
+                if (Cip::parse_request(parts_[i], e)) add_op(f, e, (uint16_t)i, p);
+            }
+            return;
+        }
+        add_op(f, r, 0, p);
+    }
+
+    void Analyzer::add_op(Flow& f, const Cip::Request& r, uint16_t index, Pending& p) {
+        //
+        //
+        //
+        Op op{EventKind::TAG_WRITE, r.service, r.class_id, r.instance, index, -1, std::string()};
+
+        const bool write_svc = r.service == SVC_WRITE || r.service == SVC_RMW || r.service == SVC_WRITE_FRAG;
+        if (write_svc && (!r.symbol.empty() || r.class_id == CLASS_SYMBOL)) {
+            // Write Tag Fragmented: type(2) elements(2) offset(4); report the first fragment only
+            if (r.service == SVC_WRITE_FRAG && (r.data.n < 8 || u32(r.data.p + 4) != 0)) return;
+            if (!r.symbol.empty()) {
+                op.tag = r.symbol;
+            } else {
+                auto it = symbols_.find((uint64_t)f.key.plc_ip << 32 | r.instance);
+                if (it != symbols_.end()) {
+                    op.tag = it->second;
+                } else {
+                    char buf[24];
+                    std::snprintf(buf, sizeof(buf), "@6B/%lu", (unsigned long)r.instance);
+                    op.tag = buf;
+                }
+            }
+            op.watch = match_watch(op.tag);
+            ++stats_.writes;
+            p.ops.push_back(std::move(op));
+            return;
+        }
+        if (r.class_id == CLASS_IDENTITY && r.service == SVC_RESET) {
+            op.kind = EventKind::DEVICE_RESET;
+            p.ops.push_back(std::move(op));
+            return;
+        }
+        if (r.service == SVC_ATTR_LIST && r.class_id == CLASS_SYMBOL && r.symbol.empty()) {
+            // count(2) attr ids(2 each)
+            if (r.data.n < 2) return;
+            const uint16_t count = u16(r.data.p);
+            if (r.data.n < 2 + 2 * (size_t)count) return;
+            p.browse_attrs.clear();
+            for (uint16_t i = 0; i < count; ++i) p.browse_attrs.push_back(u16(r.data.p + 2 + 2 * i));
+            return;
+        }
+        if (!is_edit_service(r.service) || !r.symbol.empty()) return;
+        for (uint32_t c : rules_.edit_classes) {
+            if (c != r.class_id) continue;
+            op.kind = EventKind::ONLINE_EDIT;
+            ++stats_.edits;
+            p.ops.push_back(std::move(op));
+            return;
+        }
+    }
+
+    void Analyzer::reply(Flow& f, Cip::Span cip, uint64_t context, bool connected, uint16_t seq) {
+        //
+        // Connected replies pair on the sequence count, unconnected ones on the sender
+        // context (first match, so clients that leave it zero pair in order)
+        //
+        ++stats_.cip_replies;
+        auto it = f.pending.begin();
+        for (; it != f.pending.end(); ++it) {
+            if (it->connected != connected) continue;
+            if (connected ? it->seq == seq : it->context == context) break;
+        }
+        if (it == f.pending.end()) { ++stats_.unmatched; return; }
+        const Pending p = std::move(*it);
+        f.pending.erase(it);
+
+        if (cip.n == 0) {                                   // encapsulation error
+            Cip::Status st;
+            st.layer = Cip::Status::Layer::ENCAP;
+            for (const Op& op : p.ops) deliver(f, p, op, true, st);
+            return;
+        }
+        if (!p.browse_attrs.empty()) learn_symbols(f, p, cip);
+        if (p.ops.empty()) return;
+
+        Cip::Status top;
+        const bool per_op = p.msp && Cip::parse_multiple_service_reply(cip, statuses_);
+        if (!per_op && !Cip::parse_service_status(cip, top)) top.layer = Cip::Status::Layer::REPLY;
+        for (const Op& op : p.ops) {
+            if (!per_op) { deliver(f, p, op, true, top); continue; }
+            Cip::Status st;
+            if (op.index < statuses_.size()) st = statuses_[op.index];
+            else st.layer = Cip::Status::Layer::REPLY;
+            deliver(f, p, op, true, st);
+        }
+    }
+
+    void Analyzer::learn_symbols(const Flow& f, const Pending& p, Cip::Span cip) {
+        //
+        // Reply: header, then per instance: instance id(4) and the requested attributes in
+        // order. General status 0x06 (more to come) still carries complete entries
+        //
+        if (cip.n < 4 || cip.p[0] != (SVC_ATTR_LIST | 0x80)) return;
+        if (cip.p[2] != 0 && cip.p[2] != 0x06) return;
+        size_t o = 4 + (size_t)cip.p[3] * 2;
+        while (o + 4 <= cip.n) {
+            const uint32_t inst = u32(cip.p + o);
+            o += 4;
+            std::string name;
+            for (uint16_t a : p.browse_attrs) {
+                const size_t sz = symbol_attr_size(a, cip.p + o, cip.n - o);
+                if (sz == 0 || o + sz > cip.n) return;     // unknown layout: stop
+                if (a == 1) name.assign((const char*)cip.p + o + 2, sz - 2);
+                o += sz;
+            }
+            if (name.empty() || symbols_.size() >= MAX_SYMBOLS) continue;
+            auto& slot = symbols_[(uint64_t)f.key.plc_ip << 32 | inst];
+            if (slot.empty()) ++stats_.learned_symbols;
+            slot = std::move(name);
+        }
+    }
+
+    void Analyzer::deliver(Flow& f, const Pending& p, const Op& op, bool replied, const Cip::Status& st) {
+        //
+        // Past download_threshold edits the session is reported once as a download
+        //
+        Event e;
+        e.kind        = op.kind;
+        e.ts_us       = p.ts_us;
+        e.client_ip   = f.key.client_ip;
+        e.client_port = f.key.client_port;
+        e.plc_ip      = f.key.plc_ip;
+        e.plc_port    = f.key.plc_port;
+        e.service     = op.service;
+        e.class_id    = op.class_id;
+        e.instance    = op.instance;
+        e.tag         = op.tag;
+        e.watch       = op.watch;
+        e.replied     = replied;
+        e.status      = st;
+
+        if (op.kind == EventKind::ONLINE_EDIT) {
+            ++f.edit_ops;
+            if (f.download) return;
+            if (rules_.download_threshold && f.edit_ops >= rules_.download_threshold) {
+                f.download = true;
+                e.kind  = EventKind::PROGRAM_DOWNLOAD;
+                e.count = f.edit_ops;
+            }
+        }
+        ++stats_.events;
+        fn_(e, ctx_);
+    }
+
+    void Analyzer::expire(Flow& f, int64_t now_us, bool all) {
+        //
+        //
+        //
+        const int64_t limit = (int64_t)rules_.reply_timeout_ms * 1000;
+        while (!f.pending.empty()) {
+            if (!all && now_us - f.pending.front().ts_us < limit) return;
+            const Pending p = std::move(f.pending.front());
+            f.pending.pop_front();
+            ++stats_.no_reply;
+            for (const Op& op : p.ops) deliver(f, p, op, false, Cip::Status{});
+        }
+    }
+
+    void Analyzer::note_client(const Flow& f, int64_t ts_us) {
+        //
+        //
+        //
+        if (!clients_.insert((uint64_t)f.key.client_ip << 32 | f.key.plc_ip).second) return;
+        Event e;
+        e.kind        = EventKind::NEW_CLIENT;
+        e.ts_us       = ts_us;
+        e.client_ip   = f.key.client_ip;
+        e.client_port = f.key.client_port;
+        e.plc_ip      = f.key.plc_ip;
+        e.plc_port    = f.key.plc_port;
+        ++stats_.events;
+        fn_(e, ctx_);
+    }
+
+    int Analyzer::match_watch(const std::string& tag) const {
+        //
+        // Logix names are case-insensitive; "Tag" matches "Tag.Member" / "Tag[2]" and back
+        //
+        for (size_t i = 0; i < rules_.watch.size(); ++i) {
+            const std::string& w = rules_.watch[i];
+            const std::string& shorter = w.size() <= tag.size() ? w : tag;
+            const std::string& longer  = w.size() <= tag.size() ? tag : w;
+            if (strncasecmp(shorter.c_str(), longer.c_str(), shorter.size()) != 0) continue;
+            if (shorter.size() == longer.size()) return (int)i;
+            const char next = longer[shorter.size()];
+            if (next == '.' || next == '[') return (int)i;
+        }
+        return -1;
+    }
+}
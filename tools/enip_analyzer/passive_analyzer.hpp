@@ -0,0 +1,187 @@
+// passive_analyzer.hpp
+// George Lake
+// Fall 2025
+//
+// ENIP/CIP session tracker for enip_analyzer: reassembles each TCP connection to the PLC
+// port, splits it into encapsulation frames, decodes the CIP requests with CipCodec and
+// pairs them with their replies.
+//
+// Events:
+//      NEW_CLIENT        first ENIP traffic between a client IP and a PLC
+//      TAG_WRITE         Write Tag / Write Tag Fragmented (first fragment) / Read Modify
+//                        Write, by symbol or by symbol instance (class 0x6B)
+//      ONLINE_EDIT       Create / Delete / Set_Attribute* or a vendor service on an edit
+//                        class (default 0x68 program, 0x6B symbol, 0x6C template)
+//      PROGRAM_DOWNLOAD  download_threshold edit operations in one TCP session; later edits
+//                        in that session are only counted
+//      DEVICE_RESET      Identity (class 0x01) Reset
+//
+// Notes:
+//      Requests inside Unconnected Send and Multiple Service Packet are unwrapped; each
+//      embedded write gets its own event with its own reply status.
+//      Replies are matched on the sender context (SendRRData) or the connected sequence
+//      count (SendUnitData). Events are delivered when the reply arrives, or without a
+//      status after reply_timeout_ms / at finish().
+//      Symbol instance writes are named from Get_Instance_Attribute_List (0x55) browse
+//      replies seen earlier in the capture; otherwise the tag is "@6B/<instance>".
+//      The edit classes and service set are a heuristic for Logix traffic; confirm them
+//      against captures of your own engineering tool before relying on them.
+//      Capture starting mid-connection: frames are resynchronised on the first segment
+//      that starts with a plausible encapsulation header. A sequence hole is waited on for
+//      one minimum TCP RTO (200 ms of capture time) or 256 KB of later data; after that it
+//      is taken as capture loss, the partial frame is dropped and framing resynchronises
+//      the same way.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "CipCodec.hpp"
+#include "packet_source.hpp"
+
+namespace Passive {
+    enum class EventKind : uint8_t { NEW_CLIENT, TAG_WRITE, ONLINE_EDIT, PROGRAM_DOWNLOAD, DEVICE_RESET };
+    const char* event_name(EventKind k);
+
+    struct Event {
+        EventKind   kind        = EventKind::NEW_CLIENT;
+        int64_t     ts_us       = 0;        // capture time of the request
+        uint32_t    client_ip   = 0;
+        uint16_t    client_port = 0;
+        uint32_t    plc_ip      = 0;
+        uint16_t    plc_port    = 0;
+        uint8_t     service     = 0;
+        uint32_t    class_id    = Cip::NO_ID;
+        uint32_t    instance    = Cip::NO_ID;
+        std::string tag;                    // TAG_WRITE
+        int         watch       = -1;       // index into Rules::watch; -1 = not watched
+        bool        replied     = false;
+        Cip::Status status;                 // reply status (replied only)
+        uint32_t    count       = 0;        // PROGRAM_DOWNLOAD: edit operations so far
+    };
+
+    struct Rules {
+        uint16_t                 port = 44818;
+        std::vector<std::string> watch;     // symbols; writes to a member, element or parent match
+        std::vector<uint32_t>    edit_classes{0x68, 0x6B, 0x6C};
+        uint32_t                 download_threshold = 20;
+        uint32_t                 reply_timeout_ms   = 5000;
+    };
+
+    struct AnalyzerStats {
+        uint64_t flows            = 0;
+        uint64_t enip_frames      = 0;
+        uint64_t cip_requests     = 0;      // top level, before unwrapping
+        uint64_t cip_replies      = 0;
+        uint64_t unmatched        = 0;      // replies with no pending request
+        uint64_t no_reply         = 0;      // requests given up on (timeout, reset, finish)
+        uint64_t gaps             = 0;      // TCP sequence holes skipped
+        uint64_t resyncs          = 0;      // data dropped looking for a frame boundary
+        uint64_t writes           = 0;
+        uint64_t edits            = 0;
+        uint64_t learned_symbols  = 0;
+        uint64_t events           = 0;
+    };
+
+    using EventFn = void (*)(const Event& e, void* ctx);
+
+    class Analyzer {
+    public:
+        Analyzer(const Rules& rules, EventFn fn, void* ctx);
+
+        void segment(const TcpSegment& s);
+        // Delivers everything still waiting for a reply
+        void finish();
+
+        const AnalyzerStats& stats() const { return stats_; }
+
+    private:
+        struct FlowKey {
+            uint32_t client_ip, plc_ip;
+            uint16_t client_port, plc_port;
+            bool operator==(const FlowKey& o) const {
+                return client_ip == o.client_ip && plc_ip == o.plc_ip &&
+                       client_port == o.client_port && plc_port == o.plc_port;
+            }
+        };
+        struct FlowHash {
+            size_t operator()(const FlowKey& k) const {
+                uint64_t h = ((uint64_t)k.client_ip << 32 | k.plc_ip) * 0x9E3779B97F4A7C15ull;
+                return (size_t)(h ^ ((uint64_t)k.client_port << 16 | k.plc_port));
+            }
+        };
+
+        struct Stream {
+            bool                 have_seq = false;
+            bool                 synced   = false;
+            bool                 fin      = false;
+            uint32_t             next_seq = 0;
+            std::vector<uint8_t> buf;
+            size_t               rd       = 0;
+            std::map<uint32_t, std::vector<uint8_t>> ooo;      // out-of-order segments
+            size_t               ooo_bytes = 0;
+            int64_t              hole_us   = 0;        // capture time the current hole opened
+        };
+
+        struct Op {
+            EventKind   kind;
+            uint8_t     service;
+            uint32_t    class_id;
+            uint32_t    instance;
+            uint16_t    index;                  // position in a Multiple Service Packet
+            int         watch;
+            std::string tag;
+        };
+
+        struct Pending {
+            int64_t               ts_us     = 0;
+            uint64_t              context   = 0;
+            bool                  connected = false;
+            uint16_t              seq       = 0;
+            bool                  msp       = false;
+            std::vector<Op>       ops;
+            std::vector<uint16_t> browse_attrs;     // non-empty: symbol browse, learn names
+        };
+
+        struct Flow {
+            FlowKey             key{};
+            Stream              to_plc, from_plc;
+            std::deque<Pending> pending;
+            uint32_t            edit_ops = 0;
+            bool                download = false;
+        };
+
+        void feed(Flow& f, Stream& st, bool to_plc, const TcpSegment& s);
+        void append(Stream& st, const uint8_t* p, size_t n);
+        void parse_frames(Flow& f, Stream& st, bool to_plc, int64_t ts_us);
+        void frame(Flow& f, bool to_plc, const uint8_t* h, size_t n, int64_t ts_us);
+        void request(Flow& f, Cip::Span cip, uint64_t context, bool connected, uint16_t seq, int64_t ts_us);
+        void classify(Flow& f, Cip::Span cip, Pending& p, int depth);
+        void add_op(Flow& f, const Cip::Request& r, uint16_t index, Pending& p);
+        void reply(Flow& f, Cip::Span cip, uint64_t context, bool connected, uint16_t seq);
+        void learn_symbols(const Flow& f, const Pending& p, Cip::Span cip);
+        void deliver(Flow& f, const Pending& p, const Op& op, bool replied, const Cip::Status& st);
+        void expire(Flow& f, int64_t now_us, bool all);
+        void note_client(const Flow& f, int64_t ts_us);
+        int  match_watch(const std::string& tag) const;
+
+        Rules         rules_;
+        EventFn       fn_;
+        void*         ctx_;
+        AnalyzerStats stats_;
+
+        std::unordered_map<FlowKey, Flow, FlowHash> flows_;
+        std::unordered_set<uint64_t>                clients_;   // client_ip << 32 | plc_ip
+        std::unordered_map<uint64_t, std::string>   symbols_;   // plc_ip << 32 | instance
+
+        Cip::Request           req_[3];     // per unwrap depth, keeps string capacity
+        std::vector<Cip::Span> parts_;
+        std::vector<Cip::Status> statuses_;
+    };
+}
@@ -0,0 +1,262 @@
+// log_collector.cpp
+// George Lake
+// Fall 2025
+//
+// Host collector for LogStream batches (see include/LogStream.hpp).
+// Listens on UDP and TCP, writes one <out>/<device_id>.jsonl per monitor.
+//
+// Usage:
+//      log_collector [--udp PORT] [--tcp PORT] [--out DIR]
+//      Defaults: --udp 5140 --tcp 5140 --out logs
+//      A port of 0 disables that transport. Ctrl+C prints per-device totals.
+//      Continuation lines ("+<record_id> <offset> <total> <bytes>") are joined per device;
+//      a record missing a piece (lost batch, reboot) is discarded and counted as "split".
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+    volatile std::sig_atomic_t g_stop = 0;
+    void on_signal(int) { g_stop = 1; }
+
+    struct Device {
+        FILE*         out          = nullptr;
+        unsigned long records      = 0;
+        unsigned long batches      = 0;
+        unsigned long lost_batches = 0;    // gaps in batch_seq (UDP loss or reboot)
+        unsigned long dev_dropped  = 0;    // drop counter reported by the firmware
+        unsigned long split_lost   = 0;    // continued records discarded incomplete
+        long long     last_seq     = -1;
+        unsigned long frag_id      = 0;
+        size_t        frag_total   = 0;
+        std::string   frag;                // continued record being joined
+    };
+
+    struct TcpClient {
+        int         fd = -1;
+        std::string pending;    // partial line carried between reads
+        std::string device;     // from the most recent header line
+    };
+
+    std::string g_out_dir = "logs";
+    std::map<std::string, Device> g_devices;
+
+    std::string sanitize(const std::string& id) {
+        std::string s;
+        for (char c : id) {
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                (c >= '0' && c <= '9') || c == '-' || c == '_') s.push_back(c);
+        }
+        return s.empty() ? "unknown" : s;
+    }
+
+    Device& device(const std::string& id) {
+        Device& d = g_devices[id];
+        if (!d.out) {
+            std::string path = g_out_dir + "/" + id + ".jsonl";
+            d.out = std::fopen(path.c_str(), "a");
+            if (!d.out) {
+                std::fprintf(stderr, "cannot open %s: %s\n", path.c_str(), std::strerror(errno));
+                std::exit(1);
+            }
+            std::printf("new device %s -> %s\n", id.c_str(), path.c_str());
+        }
+        return d;
+    }
+
+    // Header: "#ESPLOG <device_id> <batch_seq> <dropped_total>". Returns the device id.
+    bool parse_header(const std::string& line, std::string& id_out) {
+        char id[64];
+        unsigned long seq = 0, dropped = 0;
+        if (std::sscanf(line.c_str(), "#ESPLOG %63s %lu %lu", id, &seq, &dropped) != 3) return false;
+        id_out = sanitize(id);
+        Device& d = device(id_out);
+        if (d.last_seq >= 0 && (long long)seq > d.last_seq + 1) {
+            d.lost_batches += (unsigned long)((long long)seq - d.last_seq - 1);
+        }
+        d.last_seq    = (long long)seq;
+        d.dev_dropped = dropped;
+        ++d.batches;
+        return true;
+    }
+
+    void write_record(const std::string& id, const char* p, size_t n) {
+        if (id.empty() || n == 0) return;
+        Device& d = device(id);
+        std::fwrite(p, 1, n, d.out);
+        std::fputc('\n', d.out);
+        ++d.records;
+    }
+
+    // Continuation: "+<record_id> <offset> <total> <bytes>"
+    void add_fragment(const std::string& id, const char* p, size_t n) {
+        if (id.empty()) return;
+        Device& d = device(id);
+        std::string head(p, std::min<size_t>(n, 40));
+        unsigned long rid = 0, off = 0, total = 0;
+        int used = 0;
+        // No trailing space in the format: %n must not skip spaces that belong to the body
+        if (std::sscanf(head.c_str(), "+%lu %lu %lu%n", &rid, &off, &total, &used) != 3 ||
+            used <= 0 || (size_t)used >= n || p[used] != ' ') {
+            return;
+        }
+        const char* body = p + used + 1;
+        size_t      len  = n - (size_t)used - 1;
+
+        if (off == 0) {
+            if (!d.frag.empty()) ++d.split_lost;
+            d.frag.clear();
+            d.frag_id    = rid;
+            d.frag_total = total;
+        } else if (rid != d.frag_id || off != d.frag.size() || total != d.frag_total) {
+            if (!d.frag.empty()) ++d.split_lost;
+            d.frag.clear();
+            return;
+        }
+        d.frag.append(body, len);
+        if (d.frag.size() >= d.frag_total) {
+            if (d.frag.size() == d.frag_total) write_record(id, d.frag.data(), d.frag.size());
+            else ++d.split_lost;
+            d.frag.clear();
+        }
+    }
+
+    // Processes complete lines; returns the number of bytes consumed.
+    size_t consume_lines(const char* buf, size_t len, std::string& current_device) {
+        size_t start = 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (buf[i] != '\n') continue;
+            size_t n = i - start;
+            if (n && buf[start] == '#') {
+                std::string hdr(buf + start, n);
+                std::string id;
+                if (parse_header(hdr, id)) current_device = id;
+            } else if (n && buf[start] == '+') {
+                add_fragment(current_device, buf + start, n);
+            } else {
+                write_record(current_device, buf + start, n);
+            }
+            start = i + 1;
+        }
+        return start;
+    }
+
+    int listen_socket(int type, uint16_t port) {
+        int fd = ::socket(AF_INET, type, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in a{};
+        a.sin_family      = AF_INET;
+        a.sin_port        = htons(port);
+        a.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (::bind(fd, (sockaddr*)&a, sizeof(a)) != 0 ||
+            (type == SOCK_STREAM && ::listen(fd, 16) != 0)) {
+            std::fprintf(stderr, "bind/listen port %u: %s\n", (unsigned)port, std::strerror(errno));
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void flush_all() {
+        for (auto& kv : g_devices) if (kv.second.out) std::fflush(kv.second.out);
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    uint16_t udp_port = 5140, tcp_port = 5140;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--udp" && i + 1 < argc) udp_port  = (uint16_t)std::atoi(argv[++i]);
+        else if (a == "--tcp" && i + 1 < argc) tcp_port  = (uint16_t)std::atoi(argv[++i]);
+        else if (a == "--out" && i + 1 < argc) g_out_dir = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: %s [--udp PORT] [--tcp PORT] [--out DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+    ::mkdir(g_out_dir.c_str(), 0755);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    int udp = udp_port ? listen_socket(SOCK_DGRAM,  udp_port) : -1;
+    int tcp = tcp_port ? listen_socket(SOCK_STREAM, tcp_port) : -1;
+    if (udp < 0 && tcp < 0) return 1;
+    std::printf("log_collector: udp=%u tcp=%u out=%s\n",
+                udp >= 0 ? (unsigned)udp_port : 0u, tcp >= 0 ? (unsigned)tcp_port : 0u, g_out_dir.c_str());
+
+    std::vector<TcpClient> clients;
+    std::vector<char> buf(65536);
+
+    while (!g_stop) {
+        std::vector<pollfd> fds;
+        if (udp >= 0) fds.push_back({udp, POLLIN, 0});
+        if (tcp >= 0) fds.push_back({tcp, POLLIN, 0});
+        for (auto& c : clients) fds.push_back({c.fd, POLLIN, 0});
+
+        int r = ::poll(fds.data(), fds.size(), 1000);
+        if (r < 0) { if (errno == EINTR) continue; break; }
+        if (r == 0) { flush_all(); continue; }
+
+        size_t k = 0;
+        if (udp >= 0) {
+            if (fds[k].revents & POLLIN) {
+                ssize_t n = ::recv(udp, buf.data(), buf.size(), 0);
+                if (n > 0) {
+                    std::string dev;
+                    size_t used = consume_lines(buf.data(), (size_t)n, dev);
+                    if (used < (size_t)n) write_record(dev, buf.data() + used, (size_t)n - used);
+                }
+            }
+            ++k;
+        }
+        if (tcp >= 0) {
+            if (fds[k].revents & POLLIN) {
+                int fd = ::accept(tcp, nullptr, nullptr);
+                if (fd >= 0) clients.push_back(TcpClient{fd, {}, {}});
+            }
+            ++k;
+        }
+        for (size_t ci = 0; ci < clients.size() && k < fds.size(); ++ci, ++k) {
+            if (!(fds[k].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            TcpClient& c = clients[ci];
+            ssize_t n = ::recv(c.fd, buf.data(), buf.size(), 0);
+            if (n <= 0) { ::close(c.fd); c.fd = -1; continue; }
+            c.pending.append(buf.data(), (size_t)n);
+            size_t used = consume_lines(c.pending.data(), c.pending.size(), c.device);
+            c.pending.erase(0, used);
+        }
+        std::vector<TcpClient> alive;
+        for (auto& c : clients) if (c.fd >= 0) alive.push_back(std::move(c));
+        clients.swap(alive);
+    }
+
+    flush_all();
+    std::printf("\n%-24s %10s %8s %6s %8s %6s\n", "device", "records", "batches", "lost", "dropped", "split");
+    for (auto& kv : g_devices) {
+        const Device& d = kv.second;
+        std::printf("%-24s %10lu %8lu %6lu %8lu %6lu\n",
+                    kv.first.c_str(), d.records, d.batches, d.lost_batches, d.dev_dropped, d.split_lost);
+        std::fclose(d.out);
+    }
+    for (auto& c : clients) ::close(c.fd);
+    if (udp >= 0) ::close(udp);
+    if (tcp >= 0) ::close(tcp);
+    return 0;
+}
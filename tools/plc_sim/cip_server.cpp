@@ -0,0 +1,308 @@
+// cip_server.cpp
+// George Lake
+// Fall 2025
+//
+// Request path decoding and service handlers for cip_server.hpp
+
+
+#include "cip_server.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace {
+    constexpr uint8_t SVC_GET_ATTR_LIST   = 0x03;
+    constexpr uint8_t SVC_MULTIPLE        = 0x0A;
+    constexpr uint8_t SVC_GET_ATTR_SINGLE = 0x0E;
+    constexpr uint8_t SVC_FORWARD_CLOSE   = 0x4E;
+    constexpr uint8_t SVC_READ_TAG        = 0x4C;
+    constexpr uint8_t SVC_WRITE_TAG       = 0x4D;
+    constexpr uint8_t SVC_READ_FRAG       = 0x52;   // also Unconnected Send on class 0x06
+    constexpr uint8_t SVC_WRITE_FRAG      = 0x53;
+    constexpr uint8_t SVC_FORWARD_OPEN    = 0x54;
+    constexpr uint8_t SVC_LARGE_FWD_OPEN  = 0x5B;
+
+    constexpr uint16_t CLASS_MESSAGE_ROUTER = 0x02;
+    constexpr uint16_t CLASS_CONN_MANAGER   = 0x06;
+    constexpr uint16_t CLASS_WALL_CLOCK     = 0x8B;
+    constexpr uint16_t WALL_CLOCK_US_ATTR   = 11;
+
+    constexpr size_t REPLY_HDR = 4;                 // service, reserved, status, ext size
+
+    uint16_t u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    uint32_t u32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+    void put16(std::vector<uint8_t>& b, uint16_t v) { b.push_back((uint8_t)v); b.push_back((uint8_t)(v >> 8)); }
+    void put32(std::vector<uint8_t>& b, uint32_t v) { put16(b, (uint16_t)v); put16(b, (uint16_t)(v >> 16)); }
+    void put64(std::vector<uint8_t>& b, uint64_t v) { put32(b, (uint32_t)v); put32(b, (uint32_t)(v >> 32)); }
+} // Anonymous Namespace
+
+namespace PlcSim {
+    // Decoded request path: either a symbolic tag (+ element) or a logical class/instance/attribute
+    struct CipServer::Path {
+        std::string symbol;
+        uint32_t    element   = 0;
+        bool        logical   = false;
+        uint16_t    class_id  = 0;
+        uint16_t    instance  = 0;
+        uint16_t    attribute = 0;
+        bool        has_attr  = false;
+
+        // Returns false on a malformed or unsupported segment
+        bool parse(const uint8_t* p, size_t n) {
+            size_t i = 0;
+            bool after_element = false;
+            while (i < n) {
+                uint8_t seg = p[i];
+                if (seg == 0x91) {                              // ANSI extended symbol
+                    if (after_element || i + 2 > n) return false;
+                    size_t len = p[i + 1];
+                    if (i + 2 + len > n) return false;
+                    if (!symbol.empty()) symbol += '.';
+                    symbol.append((const char*)p + i + 2, len);
+                    i += 2 + len + (len & 1);
+                } else if (seg == 0x28 && i + 2 <= n) { element = p[i + 1];        i += 2; after_element = true; }
+                else if (seg == 0x29 && i + 4 <= n)   { element = u16(p + i + 2);  i += 4; after_element = true; }
+                else if (seg == 0x2A && i + 6 <= n)   { element = u32(p + i + 2);  i += 6; after_element = true; }
+                else if (seg == 0x20 && i + 2 <= n)   { class_id = p[i + 1];       i += 2; logical = true; }
+                else if (seg == 0x21 && i + 4 <= n)   { class_id = u16(p + i + 2); i += 4; logical = true; }
+                else if (seg == 0x24 && i + 2 <= n)   { instance = p[i + 1];       i += 2; }
+                else if (seg == 0x25 && i + 4 <= n)   { instance = u16(p + i + 2); i += 4; }
+                else if (seg == 0x30 && i + 2 <= n)   { attribute = p[i + 1];       i += 2; has_attr = true; }
+                else if (seg == 0x31 && i + 4 <= n)   { attribute = u16(p + i + 2); i += 4; has_attr = true; }
+                else return false;
+            }
+            return logical ? symbol.empty() : !symbol.empty();
+        }
+    };
+
+    CipServer::CipServer(TagDb& db, const SimClock& clock, const ServerConfig& cfg)
+        : db_(db), clock_(clock), cfg_(cfg) {}
+
+    std::vector<uint8_t> CipServer::reply(uint8_t service, Status st) {
+        std::vector<uint8_t> r = {(uint8_t)(service | 0x80), 0x00, st.general, 0x00};
+        if (st.general == ST_GENERAL && st.ext) { r[3] = 1; put16(r, st.ext); }
+        if (st.general != ST_OK && st.general != ST_PARTIAL) ++errors_;
+        return r;
+    }
+
+    std::vector<uint8_t> CipServer::handle(const uint8_t* req, size_t len, Session& s, size_t max_reply) {
+        if (len < 2) return reply(0, {ST_NOT_ENOUGH, 0});
+        const uint8_t service = req[0] & 0x7F;
+        const size_t  path_len = (size_t)req[1] * 2;
+        ++by_service_[service];
+        if (2 + path_len > len) return reply(service, {ST_PATH_SEGMENT, 0});
+
+        Path p;
+        if (!p.parse(req + 2, path_len)) return reply(service, {ST_PATH_SEGMENT, 0});
+        const uint8_t* d = req + 2 + path_len;
+        const size_t   n = len - 2 - path_len;
+
+        if (p.logical) {
+            if (p.class_id == CLASS_MESSAGE_ROUTER && service == SVC_MULTIPLE) return multiple_service(d, n, s, max_reply);
+            if (p.class_id == CLASS_CONN_MANAGER) {
+                switch (service) {
+                    case SVC_READ_FRAG:      return unconnected_send(d, n, s, max_reply);
+                    case SVC_FORWARD_OPEN:   return forward_open(d, n, s, false);
+                    case SVC_LARGE_FWD_OPEN: return forward_open(d, n, s, true);
+                    case SVC_FORWARD_CLOSE:  return forward_close(d, n, s);
+                    default: break;
+                }
+            }
+            if (p.class_id == CLASS_WALL_CLOCK && cfg_.wall_clock) {
+                if (service == SVC_GET_ATTR_LIST)   return get_attributes(p, d, n, true);
+                if (service == SVC_GET_ATTR_SINGLE) return get_attributes(p, d, n, false);
+                return reply(service, {ST_NOT_SUPPORTED, 0});
+            }
+            return reply(service, {ST_PATH_UNKNOWN, 0});
+        }
+
+        switch (service) {
+            case SVC_READ_TAG:   return read_tag(p, d, n, max_reply, false);
+            case SVC_READ_FRAG:  return read_tag(p, d, n, max_reply, true);
+            case SVC_WRITE_TAG:  return write_tag(p, d, n, false);
+            case SVC_WRITE_FRAG: return write_tag(p, d, n, true);
+            default:             return reply(service, {ST_NOT_SUPPORTED, 0});
+        }
+    }
+
+    std::vector<uint8_t> CipServer::read_tag(const Path& p, const uint8_t* d, size_t n, size_t max_reply, bool fragmented) {
+        //
+        // elements(2) [offset(4)] -> type(2) data
+        //
+        const uint8_t service = fragmented ? SVC_READ_FRAG : SVC_READ_TAG;
+        if (n < (fragmented ? 6u : 2u)) return reply(service, {ST_NOT_ENOUGH, 0});
+        const uint16_t elements = u16(d);
+        const uint32_t offset   = fragmented ? u32(d + 2) : 0;
+
+        uint16_t type = 0;
+        std::vector<uint8_t> bytes;
+        Status st = db_.read(p.symbol, p.element, elements, type, bytes);
+        if (st.general != ST_OK) return reply(service, st);
+        if (offset > bytes.size()) return reply(service, {ST_GENERAL, EXT_OUT_OF_RANGE});
+
+        const size_t esz  = type_size(type);
+        size_t room = max_reply > REPLY_HDR + 2 ? max_reply - REPLY_HDR - 2 : 0;
+        room -= room % esz;
+        size_t take = bytes.size() - offset;
+        if (take > room) { take = room; st.general = ST_PARTIAL; }
+
+        std::vector<uint8_t> r = reply(service, st);
+        put16(r, type);
+        r.insert(r.end(), bytes.begin() + offset, bytes.begin() + offset + take);
+        return r;
+    }
+
+    std::vector<uint8_t> CipServer::write_tag(const Path& p, const uint8_t* d, size_t n, bool fragmented) {
+        //
+        // type(2) elements(2) [offset(4)] data
+        //
+        const uint8_t service = fragmented ? SVC_WRITE_FRAG : SVC_WRITE_TAG;
+        const size_t  hdr = fragmented ? 8 : 4;
+        if (n < hdr) return reply(service, {ST_NOT_ENOUGH, 0});
+        const uint16_t type     = u16(d);
+        const uint16_t elements = u16(d + 2);
+        const uint32_t offset   = fragmented ? u32(d + 4) : 0;
+        const size_t   esz      = type_size(type);
+        if (!esz) return reply(service, {ST_GENERAL, EXT_TYPE_MISMATCH});
+        const size_t data_len = n - hdr;
+        if (!fragmented) {
+            if (data_len < (size_t)elements * esz) return reply(service, {ST_NOT_ENOUGH, 0});
+            if (data_len > (size_t)elements * esz) return reply(service, {ST_TOO_MUCH, 0});
+        }
+        return reply(service, db_.write(p.symbol, p.element, type, elements, offset, d + hdr, data_len));
+    }
+
+    std::vector<uint8_t> CipServer::multiple_service(const uint8_t* d, size_t n, Session& s, size_t max_reply) {
+        //
+        // count(2) offsets(2*count) requests... ; offsets are from the count field
+        //
+        if (n < 2) return reply(SVC_MULTIPLE, {ST_NOT_ENOUGH, 0});
+        const uint16_t count = u16(d);
+        if (n < 2 + 2 * (size_t)count) return reply(SVC_MULTIPLE, {ST_NOT_ENOUGH, 0});
+
+        std::vector<std::vector<uint8_t>> replies;
+        bool embedded_error = false;
+        size_t total = REPLY_HDR + 2 + 2 * (size_t)count;
+        for (uint16_t i = 0; i < count; ++i) {
+            size_t start = u16(d + 2 + 2 * i);
+            size_t end   = (i + 1 < count) ? u16(d + 2 + 2 * (i + 1)) : n;
+            if (start > end || end > n) return reply(SVC_MULTIPLE, {ST_PATH_SEGMENT, 0});
+            size_t budget = max_reply > total ? max_reply - total : 0;
+            replies.push_back(handle(d + start, end - start, s, budget));
+            uint8_t gen = replies.back().size() > 2 ? replies.back()[2] : ST_GENERAL;
+            if (gen != ST_OK && gen != ST_PARTIAL) embedded_error = true;
+            total += replies.back().size();
+        }
+        if (total > max_reply) return reply(SVC_MULTIPLE, {ST_REPLY_TOO_BIG, 0});
+
+        std::vector<uint8_t> r = reply(SVC_MULTIPLE, {embedded_error ? ST_EMBEDDED : ST_OK, 0});
+        put16(r, count);
+        size_t off = 2 + 2 * (size_t)count;
+        for (auto& e : replies) { put16(r, (uint16_t)off); off += e.size(); }
+        for (auto& e : replies) r.insert(r.end(), e.begin(), e.end());
+        return r;
+    }
+
+    std::vector<uint8_t> CipServer::unconnected_send(const uint8_t* d, size_t n, Session& s, size_t max_reply) {
+        //
+        // priority(1) timeout(1) size(2) request [pad] route_size(1) reserved(1) route...
+        // The target's reply is returned as-is, as a ControlLogix does.
+        //
+        if (n < 4) return reply(SVC_READ_FRAG, {ST_NOT_ENOUGH, 0});
+        const size_t msg_len = u16(d + 2);
+        if (4 + msg_len > n) return reply(SVC_READ_FRAG, {ST_NOT_ENOUGH, 0});
+        return handle(d + 4, msg_len, s, max_reply);
+    }
+
+    std::vector<uint8_t> CipServer::forward_open(const uint8_t* d, size_t n, Session& s, bool large) {
+        //
+        // prio/tick(1) timeout(1) O->T id(4) T->O id(4) serial(2) vendor(2) orig_serial(4)
+        // multiplier(1) reserved(3) O->T RPI(4) O->T params(2|4) T->O RPI(4) T->O params(2|4)
+        // transport(1) path_size(1) path
+        //
+        const uint8_t service = large ? SVC_LARGE_FWD_OPEN : SVC_FORWARD_OPEN;
+        const size_t  psz = large ? 4 : 2;
+        const size_t  need = 2 + 4 + 4 + 2 + 2 + 4 + 1 + 3 + 4 + psz + 4 + psz + 1 + 1;
+        if (n < need) return reply(service, {ST_NOT_ENOUGH, 0});
+
+        Connection c;
+        c.o2t_id      = next_conn_id_++;
+        c.t2o_id      = u32(d + 6);
+        c.serial      = u16(d + 10);
+        c.vendor      = u16(d + 12);
+        c.orig_serial = u32(d + 14);
+        const size_t   t2o_rpi_off = 2 + 4 + 4 + 2 + 2 + 4 + 1 + 3 + 4 + psz;
+        const uint32_t o2t_rpi = u32(d + 22);
+        const uint32_t t2o_rpi = u32(d + t2o_rpi_off);
+        const uint32_t t2o_params = large ? u32(d + t2o_rpi_off + 4) : u16(d + t2o_rpi_off + 4);
+        c.max_size    = large ? (t2o_params & 0xFFFF) : (t2o_params & 0x01FF);
+        s.conns.push_back(c);
+
+        std::vector<uint8_t> r = reply(service, {});
+        put32(r, c.o2t_id);
+        put32(r, c.t2o_id);
+        put16(r, c.serial);
+        put16(r, c.vendor);
+        put32(r, c.orig_serial);
+        put32(r, o2t_rpi);          // actual packet intervals = requested
+        put32(r, t2o_rpi);
+        r.push_back(0x00);          // application reply size
+        r.push_back(0x00);
+        return r;
+    }
+
+    std::vector<uint8_t> CipServer::forward_close(const uint8_t* d, size_t n, Session& s) {
+        //
+        // prio/tick(1) timeout(1) serial(2) vendor(2) orig_serial(4) path_size(1) reserved(1) path
+        //
+        if (n < 10) return reply(SVC_FORWARD_CLOSE, {ST_NOT_ENOUGH, 0});
+        const uint16_t serial = u16(d + 2), vendor = u16(d + 4);
+        const uint32_t orig   = u32(d + 6);
+        for (auto it = s.conns.begin(); it != s.conns.end(); ++it) {
+            if (it->serial == serial && it->vendor == vendor && it->orig_serial == orig) {
+                s.conns.erase(it);
+                std::vector<uint8_t> r = reply(SVC_FORWARD_CLOSE, {});
+                put16(r, serial);
+                put16(r, vendor);
+                put32(r, orig);
+                r.push_back(0x00);
+                r.push_back(0x00);
+                return r;
+            }
+        }
+        return reply(SVC_FORWARD_CLOSE, {0x01, 0});     // connection failure (not found)
+    }
+
+    std::vector<uint8_t> CipServer::get_attributes(const Path& p, const uint8_t* d, size_t n, bool list) {
+        //
+        // Wall Clock Time instance 1; attribute 11 = ULINT microseconds since 1970 (UTC)
+        //
+        const uint8_t service = list ? SVC_GET_ATTR_LIST : SVC_GET_ATTR_SINGLE;
+        if (p.instance != 1) return reply(service, {ST_OBJ_MISSING, 0});
+        const uint64_t now = (uint64_t)clock_.now_us();
+
+        if (!list) {
+            if (!p.has_attr || p.attribute != WALL_CLOCK_US_ATTR) return reply(service, {ST_ATTR_UNSUPP, 0});
+            std::vector<uint8_t> r = reply(service, {});
+            put64(r, now);
+            return r;
+        }
+
+        if (n < 2) return reply(service, {ST_NOT_ENOUGH, 0});
+        const uint16_t count = u16(d);
+        if (n < 2 + 2 * (size_t)count) return reply(service, {ST_NOT_ENOUGH, 0});
+        std::vector<uint8_t> body;
+        bool any_error = false;
+        put16(body, count);
+        for (uint16_t i = 0; i < count; ++i) {
+            uint16_t id = u16(d + 2 + 2 * i);
+            put16(body, id);
+            if (id == WALL_CLOCK_US_ATTR) { put16(body, 0); put64(body, now); }
+            else                          { put16(body, ST_ATTR_UNSUPP); any_error = true; }
+        }
+        std::vector<uint8_t> r = reply(service, {any_error ? (uint8_t)0x0A : ST_OK, 0});   // 0x0A attribute list error
+        r.insert(r.end(), body.begin(), body.end());
+        return r;
+    }
+}
@@ -0,0 +1,80 @@
+// cip_server.hpp
+// George Lake
+// Fall 2025
+//
+// CIP Message Router for plc_sim: turns one request into one reply.
+//
+// Services:
+//      0x4C Read Tag               0x52 Read Tag Fragmented
+//      0x4D Write Tag              0x53 Write Tag Fragmented
+//      0x0A Multiple Service Packet (Message Router, class 0x02)
+//      0x52 Unconnected Send, 0x54/0x5B Forward Open, 0x4E Forward Close (Connection Manager, class 0x06)
+//      0x03 Get_Attribute_List, 0x0E Get_Attribute_Single (Wall Clock Time, class 0x8B, attribute 11)
+//
+// Notes:
+//      Replies larger than the transport allows are truncated on an element boundary
+//      with status 0x06 (partial transfer), which is the cue for Read Tag Fragmented.
+
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sim_clock.hpp"
+#include "tag_db.hpp"
+
+namespace PlcSim {
+    // Class 3 connection opened with Forward Open (used with SendUnitData)
+    struct Connection {
+        uint32_t o2t_id      = 0;   // chosen by us; the client addresses requests with it
+        uint32_t t2o_id      = 0;   // chosen by the client; we address replies with it
+        uint16_t serial      = 0;
+        uint16_t vendor      = 0;
+        uint32_t orig_serial = 0;
+        size_t   max_size    = 0;   // negotiated T->O connection size
+    };
+
+    // Per-TCP-connection encapsulation state
+    struct Session {
+        uint32_t                handle = 0;
+        std::vector<Connection> conns;
+    };
+
+    struct ServerConfig {
+        size_t unconnected_max = 504;   // UCMM reply limit, as on a ControlLogix
+        bool   wall_clock      = true;  // false = reject class 0x8B (forces the DateTime fallback)
+    };
+
+    class CipServer {
+    public:
+        CipServer(TagDb& db, const SimClock& clock, const ServerConfig& cfg);
+
+        // One Message Router request -> reply, never larger than max_reply bytes
+        std::vector<uint8_t> handle(const uint8_t* req, size_t len, Session& s, size_t max_reply);
+
+        uint64_t service_count(uint8_t service) const { return by_service_[service].load(); }
+        uint64_t error_count() const { return errors_.load(); }
+
+    private:
+        struct Path;
+
+        std::vector<uint8_t> read_tag(const Path& p, const uint8_t* d, size_t n, size_t max_reply, bool fragmented);
+        std::vector<uint8_t> write_tag(const Path& p, const uint8_t* d, size_t n, bool fragmented);
+        std::vector<uint8_t> multiple_service(const uint8_t* d, size_t n, Session& s, size_t max_reply);
+        std::vector<uint8_t> unconnected_send(const uint8_t* d, size_t n, Session& s, size_t max_reply);
+        std::vector<uint8_t> forward_open(const uint8_t* d, size_t n, Session& s, bool large);
+        std::vector<uint8_t> forward_close(const uint8_t* d, size_t n, Session& s);
+        std::vector<uint8_t> get_attributes(const Path& p, const uint8_t* d, size_t n, bool list);
+
+        std::vector<uint8_t> reply(uint8_t service, Status st);
+
+        TagDb&                db_;
+        const SimClock&       clock_;
+        ServerConfig          cfg_;
+        std::atomic<uint32_t> next_conn_id_{0x10000000};
+        std::atomic<uint64_t> by_service_[256] = {};
+        std::atomic<uint64_t> errors_{0};
+    };
+}
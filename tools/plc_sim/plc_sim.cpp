@@ -0,0 +1,532 @@
+// plc_sim.cpp
+// George Lake
+// Fall 2025
+//
+// Local EtherNet/IP + CIP controller simulator, for exercising EnipClient, the audit
+// monitor and the benchmarks without plant hardware.
+//
+// Usage:
+//      plc_sim [--bind IP] [--port PORT] [--tags FILE] [--script FILE]
+//              [--delay MS] [--jitter MS] [--drop P] [--busy P] [--reset-after N]
+//              [--clock-offset MS] [--clock-skew PPM] [--tz MIN] [--no-wall-clock]
+//              [--max-reply BYTES] [--seed N] [--verbose]
+//      Defaults: --bind 127.0.0.1 --port 44818, tags from tags.example format (see tag_db.hpp)
+//
+// Encapsulation commands:
+//      RegisterSession, UnRegisterSession, ListIdentity, ListServices,
+//      SendRRData (UCMM) and SendUnitData (class 3, after Forward Open)
+//
+// Faults (command line or script, applied per SendRRData/SendUnitData request):
+//      delay / jitter      reply after delay + uniform[0, jitter] ms
+//      drop                probability of never answering a request
+//      busy                probability of answering a SendRRData request with CIP general
+//                          status 0x02 (resource unavailable) instead of serving it
+//      reset-after         close the TCP connection instead of answering the Nth request
+//
+// Script (one command per line, '#' comments):
+//      at <ms> <command>       run once, <ms> after start
+//      every <ms> <command>    run every <ms>
+//   Commands:
+//      set <tag> <v...>   add <tag> <n>   stamp <tag>   show <tag>
+//      delay <ms>   jitter <ms>   drop <p>   busy <p>   reset-after <n>   reset
+//      clock-offset <ms>   clock-skew <ppm>   say <text...>   stats   quit
+//
+// Ctrl+C prints request totals.
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cip_server.hpp"
+#include "sim_clock.hpp"
+#include "tag_db.hpp"
+
+namespace {
+    using namespace PlcSim;
+
+    volatile std::sig_atomic_t g_stop = 0;
+    void on_signal(int) { g_stop = 1; }
+
+    constexpr size_t   ENCAP_HDR = 24;
+    constexpr uint16_t CMD_LIST_SERVICES  = 0x0004;
+    constexpr uint16_t CMD_LIST_IDENTITY  = 0x0063;
+    constexpr uint16_t CMD_REGISTER       = 0x0065;
+    constexpr uint16_t CMD_UNREGISTER     = 0x0066;
+    constexpr uint16_t CMD_SEND_RR_DATA   = 0x006F;
+    constexpr uint16_t CMD_SEND_UNIT_DATA = 0x0070;
+
+    constexpr uint32_t ENCAP_INVALID_CMD     = 0x0001;
+    constexpr uint32_t ENCAP_INCORRECT_DATA  = 0x0003;
+    constexpr uint32_t ENCAP_INVALID_SESSION = 0x0064;
+
+    constexpr uint16_t ITEM_NULL_ADDR  = 0x0000;
+    constexpr uint16_t ITEM_CONN_ADDR  = 0x00A1;
+    constexpr uint16_t ITEM_CONN_DATA  = 0x00B1;
+    constexpr uint16_t ITEM_UNCONN     = 0x00B2;
+
+    struct Faults {
+        std::atomic<uint32_t> delay_ms{0};
+        std::atomic<uint32_t> jitter_ms{0};
+        std::atomic<uint32_t> drop_ppm{0};          // probability * 1e6
+        std::atomic<uint32_t> busy_ppm{0};
+        std::atomic<uint32_t> reset_after{0};       // 0 = never
+    };
+
+    struct Totals {
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> sessions{0};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> busy{0};
+        std::atomic<uint64_t> resets{0};
+    };
+
+    struct Options {
+        std::string  bind_ip = "127.0.0.1";
+        uint16_t     port    = 44818;
+        std::string  tags_file;
+        std::string  script_file;
+        ServerConfig server;
+        uint32_t     seed    = 0;
+        bool         verbose = false;
+    };
+
+    SimClock         g_clock;
+    TagDb            g_db(g_clock);
+    Faults           g_faults;
+    Totals           g_totals;
+    Options          g_opt;
+    CipServer*       g_server = nullptr;
+    std::atomic<uint32_t> g_next_session{0x00010001};
+
+    std::mutex    g_fds_mu;                          // open client sockets, for "reset"
+    std::set<int> g_fds;
+
+    uint16_t u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    uint32_t u32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+    void put16(std::vector<uint8_t>& b, uint16_t v) { b.push_back((uint8_t)v); b.push_back((uint8_t)(v >> 8)); }
+    void put32(std::vector<uint8_t>& b, uint32_t v) { put16(b, (uint16_t)v); put16(b, (uint16_t)(v >> 16)); }
+
+    bool recv_all(int fd, uint8_t* p, size_t n) {
+        while (n) {
+            ssize_t r = ::recv(fd, p, n, 0);
+            if (r <= 0) return false;
+            p += r; n -= (size_t)r;
+        }
+        return true;
+    }
+
+    bool send_all(int fd, const uint8_t* p, size_t n) {
+        while (n) {
+            ssize_t r = ::send(fd, p, n, MSG_NOSIGNAL);
+            if (r <= 0) return false;
+            p += r; n -= (size_t)r;
+        }
+        return true;
+    }
+
+    // Reply header echoes command, session and sender context from the request
+    std::vector<uint8_t> encap(const uint8_t* req_hdr, uint32_t session, uint32_t status,
+                               const std::vector<uint8_t>& body) {
+        std::vector<uint8_t> out;
+        out.reserve(ENCAP_HDR + body.size());
+        put16(out, u16(req_hdr));
+        put16(out, (uint16_t)body.size());
+        put32(out, session);
+        put32(out, status);
+        out.insert(out.end(), req_hdr + 12, req_hdr + 20);     // sender context
+        put32(out, 0);                                          // options
+        out.insert(out.end(), body.begin(), body.end());
+        return out;
+    }
+
+    std::vector<uint8_t> list_identity() {
+        static const char name[] = "plc_sim";
+        std::vector<uint8_t> item;
+        put16(item, 1);                                         // encapsulation protocol version
+        item.insert(item.end(), 16, 0);                         // socket address (unused)
+        put16(item, 1);                                         // vendor
+        put16(item, 0x0E);                                      // device type: PLC
+        put16(item, 0x0001);                                    // product code
+        item.push_back(32); item.push_back(11);                 // revision
+        put16(item, 0x0030);                                    // status
+        put32(item, 0x12345678);                                // serial
+        item.push_back((uint8_t)(sizeof(name) - 1));
+        item.insert(item.end(), name, name + sizeof(name) - 1);
+        item.push_back(0x03);                                   // state
+        std::vector<uint8_t> body;
+        put16(body, 1);
+        put16(body, 0x000C);
+        put16(body, (uint16_t)item.size());
+        body.insert(body.end(), item.begin(), item.end());
+        return body;
+    }
+
+    std::vector<uint8_t> list_services() {
+        static const char name[16] = "Communications";
+        std::vector<uint8_t> body;
+        put16(body, 1);
+        put16(body, 0x0100);
+        put16(body, 20);
+        put16(body, 1);                                         // version
+        put16(body, 0x0120);                                    // CIP over TCP
+        body.insert(body.end(), name, name + 16);
+        return body;
+    }
+
+    // CPF item list: finds the first item of `type`
+    bool find_item(const uint8_t* p, size_t n, uint16_t type, const uint8_t*& data, size_t& len) {
+        if (n < 2) return false;
+        uint16_t count = u16(p);
+        size_t off = 2;
+        for (uint16_t i = 0; i < count; ++i) {
+            if (off + 4 > n) return false;
+            uint16_t t = u16(p + off), l = u16(p + off + 2);
+            off += 4;
+            if (off + l > n) return false;
+            if (t == type) { data = p + off; len = l; return true; }
+            off += l;
+        }
+        return false;
+    }
+
+    // SendRRData body: if_handle(4) timeout(2) items. busy: answer "resource unavailable"
+    bool handle_rr(const std::vector<uint8_t>& body, Session& s, std::vector<uint8_t>& out, bool busy) {
+        if (body.size() < 6) return false;
+        const uint8_t* cip; size_t cip_len;
+        if (!find_item(body.data() + 6, body.size() - 6, ITEM_UNCONN, cip, cip_len) || !cip_len) return false;
+        std::vector<uint8_t> r = busy ? std::vector<uint8_t>{(uint8_t)(cip[0] | 0x80), 0x00, 0x02, 0x00}
+                                      : g_server->handle(cip, cip_len, s, g_opt.server.unconnected_max);
+        out.assign(body.begin(), body.begin() + 6);
+        put16(out, 2);
+        put16(out, ITEM_NULL_ADDR); put16(out, 0);
+        put16(out, ITEM_UNCONN);    put16(out, (uint16_t)r.size());
+        out.insert(out.end(), r.begin(), r.end());
+        return true;
+    }
+
+    // SendUnitData body: if_handle(4) timeout(2) items {A1 conn id, B1 seq + CIP}
+    bool handle_unit(const std::vector<uint8_t>& body, Session& s, std::vector<uint8_t>& out) {
+        if (body.size() < 6) return false;
+        const uint8_t* items = body.data() + 6;
+        const size_t   n     = body.size() - 6;
+        const uint8_t *addr, *data; size_t addr_len, data_len;
+        if (!find_item(items, n, ITEM_CONN_ADDR, addr, addr_len) || addr_len != 4) return false;
+        if (!find_item(items, n, ITEM_CONN_DATA, data, data_len) || data_len < 2) return false;
+
+        const uint32_t o2t = u32(addr);
+        auto c = std::find_if(s.conns.begin(), s.conns.end(), [&](const Connection& k) { return k.o2t_id == o2t; });
+        if (c == s.conns.end()) return false;
+        const uint32_t t2o = c->t2o_id;
+        const size_t   max = c->max_size > 2 ? c->max_size - 2 : 0;
+
+        std::vector<uint8_t> r = g_server->handle(data + 2, data_len - 2, s, max);
+        out.assign(body.begin(), body.begin() + 6);
+        put16(out, 2);
+        put16(out, ITEM_CONN_ADDR); put16(out, 4); put32(out, t2o);
+        put16(out, ITEM_CONN_DATA); put16(out, (uint16_t)(r.size() + 2));
+        put16(out, u16(data));                                  // echo sequence count
+        out.insert(out.end(), r.begin(), r.end());
+        return true;
+    }
+
+    void serve(int fd) {
+        thread_local std::mt19937 rng(g_opt.seed ? g_opt.seed + (uint32_t)fd : std::random_device{}());
+        Session s;
+        uint64_t data_requests = 0;
+        std::vector<uint8_t> body;
+        uint8_t hdr[ENCAP_HDR];
+
+        while (!g_stop && recv_all(fd, hdr, ENCAP_HDR)) {
+            const uint16_t cmd     = u16(hdr);
+            const uint16_t len     = u16(hdr + 2);
+            const uint32_t session = u32(hdr + 4);
+            body.resize(len);
+            if (len && !recv_all(fd, body.data(), len)) break;
+            ++g_totals.requests;
+
+            std::vector<uint8_t> out;
+            uint32_t status = 0;
+            bool is_data = false;
+            switch (cmd) {
+                case CMD_REGISTER:
+                    s.handle = g_next_session++;
+                    ++g_totals.sessions;
+                    out.assign(body.begin(), body.end());
+                    if (out.size() != 4) { out.clear(); status = ENCAP_INCORRECT_DATA; }
+                    break;
+                case CMD_UNREGISTER:
+                    goto done;
+                case CMD_LIST_IDENTITY: out = list_identity(); break;
+                case CMD_LIST_SERVICES: out = list_services(); break;
+                case CMD_SEND_RR_DATA:
+                case CMD_SEND_UNIT_DATA:
+                    is_data = true;
+                    if (!s.handle || session != s.handle) { status = ENCAP_INVALID_SESSION; break; }
+                    if (cmd == CMD_SEND_RR_DATA) {
+                        uint32_t busy = g_faults.busy_ppm.load();
+                        bool b = busy && (rng() % 1000000) < busy;
+                        if (b) ++g_totals.busy;
+                        if (!handle_rr(body, s, out, b)) { out.clear(); status = ENCAP_INCORRECT_DATA; }
+                    } else if (!handle_unit(body, s, out)) {
+                        out.clear();
+                        status = ENCAP_INCORRECT_DATA;
+                    }
+                    break;
+                default:
+                    status = ENCAP_INVALID_CMD;
+                    break;
+            }
+
+            if (is_data) {
+                ++data_requests;
+                uint32_t reset_after = g_faults.reset_after.load();
+                if (reset_after && data_requests % reset_after == 0) {
+                    ++g_totals.resets;
+                    if (g_opt.verbose) std::printf("fd %d: reset after %llu requests\n", fd, (unsigned long long)data_requests);
+                    break;
+                }
+                uint32_t drop = g_faults.drop_ppm.load();
+                if (drop && (rng() % 1000000) < drop) { ++g_totals.dropped; continue; }
+                uint32_t delay  = g_faults.delay_ms.load();
+                uint32_t jitter = g_faults.jitter_ms.load();
+                if (jitter) delay += rng() % (jitter + 1);
+                if (delay) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            }
+
+            std::vector<uint8_t> pkt = encap(hdr, cmd == CMD_REGISTER ? s.handle : session, status, out);
+            if (!send_all(fd, pkt.data(), pkt.size())) break;
+        }
+    done:
+        {
+            std::lock_guard<std::mutex> lk(g_fds_mu);
+            g_fds.erase(fd);
+        }
+        ::close(fd);
+        if (g_opt.verbose) std::printf("fd %d: closed\n", fd);
+    }
+
+    void print_stats() {
+        static const struct { uint8_t svc; const char* name; } names[] = {
+            {0x4C, "read_tag"}, {0x52, "read_frag/unconnected_send"}, {0x4D, "write_tag"},
+            {0x53, "write_frag"}, {0x0A, "multiple_service"}, {0x54, "forward_open"},
+            {0x5B, "large_forward_open"}, {0x4E, "forward_close"}, {0x03, "get_attribute_list"},
+            {0x0E, "get_attribute_single"},
+        };
+        std::printf("connections=%llu sessions=%llu encap_requests=%llu dropped=%llu busy=%llu resets=%llu cip_errors=%llu\n",
+                    (unsigned long long)g_totals.connections.load(), (unsigned long long)g_totals.sessions.load(),
+                    (unsigned long long)g_totals.requests.load(), (unsigned long long)g_totals.dropped.load(),
+                    (unsigned long long)g_totals.busy.load(), (unsigned long long)g_totals.resets.load(),
+                    (unsigned long long)g_server->error_count());
+        for (auto& n : names) {
+            uint64_t c = g_server->service_count(n.svc);
+            if (c) std::printf("  %-28s %llu\n", n.name, (unsigned long long)c);
+        }
+        std::fflush(stdout);
+    }
+
+    void reset_all() {
+        std::lock_guard<std::mutex> lk(g_fds_mu);
+        for (int fd : g_fds) ::shutdown(fd, SHUT_RDWR);
+        g_totals.resets += g_fds.size();
+    }
+
+    bool run_command(const std::string& line, std::string& err) {
+        std::istringstream ss(line);
+        std::string cmd, a;
+        ss >> cmd;
+        if (cmd == "set") {
+            std::string tag; std::vector<std::string> vals;
+            ss >> tag;
+            while (ss >> a) vals.push_back(a);
+            return g_db.set(tag, vals, err);
+        }
+        if (cmd == "add")   { std::string tag; double d = 0; ss >> tag >> d; return g_db.add(tag, d, err); }
+        if (cmd == "stamp") { ss >> a; return g_db.stamp(a, err); }
+        if (cmd == "show")  { ss >> a; std::printf("%s\n", g_db.dump(a).c_str()); return true; }
+        if (cmd == "delay")        { uint32_t v = 0; ss >> v; g_faults.delay_ms    = v; return true; }
+        if (cmd == "jitter")       { uint32_t v = 0; ss >> v; g_faults.jitter_ms   = v; return true; }
+        if (cmd == "reset-after")  { uint32_t v = 0; ss >> v; g_faults.reset_after = v; return true; }
+        if (cmd == "drop")         { double p = 0; ss >> p; g_faults.drop_ppm = (uint32_t)(std::min(std::max(p, 0.0), 1.0) * 1e6); return true; }
+        if (cmd == "busy")         { double p = 0; ss >> p; g_faults.busy_ppm = (uint32_t)(std::min(std::max(p, 0.0), 1.0) * 1e6); return true; }
+        if (cmd == "reset")        { reset_all(); return true; }
+        if (cmd == "clock-offset") { long long ms = 0; ss >> ms; g_clock.set_offset_ms(ms); return true; }
+        if (cmd == "clock-skew")   { double ppm = 0; ss >> ppm; g_clock.set_skew_ppm(ppm); return true; }
+        if (cmd == "say")          { std::getline(ss, a); std::printf("script:%s\n", a.c_str()); std::fflush(stdout); return true; }
+        if (cmd == "stats")        { print_stats(); return true; }
+        if (cmd == "quit")         { g_stop = 1; return true; }
+        err = "unknown command '" + cmd + "'";
+        return false;
+    }
+
+    struct ScriptEntry {
+        int64_t     due_ms;
+        int64_t     period_ms;      // 0 = once
+        std::string command;
+    };
+
+    bool load_script(const std::string& path, std::vector<ScriptEntry>& out, std::string& err) {
+        std::ifstream in(path);
+        if (!in) { err = path + ": " + std::strerror(errno); return false; }
+        std::string line;
+        for (int n = 1; std::getline(in, line); ++n) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            std::istringstream ss(line);
+            std::string kind, rest;
+            long long ms = 0;
+            if (!(ss >> kind)) continue;
+            if ((kind != "at" && kind != "every") || !(ss >> ms) || ms < 0 || (kind == "every" && ms == 0)) {
+                err = path + ":" + std::to_string(n) + ": expected 'at|every <ms> <command>'";
+                return false;
+            }
+            std::getline(ss, rest);
+            rest.erase(0, rest.find_first_not_of(" \t"));
+            out.push_back({ms, kind == "every" ? ms : 0, rest});
+        }
+        return true;
+    }
+
+    void script_task(std::vector<ScriptEntry> entries) {
+        const auto t0 = std::chrono::steady_clock::now();
+        while (!g_stop && !entries.empty()) {
+            auto next = std::min_element(entries.begin(), entries.end(),
+                                         [](const ScriptEntry& a, const ScriptEntry& b) { return a.due_ms < b.due_ms; });
+            auto due = t0 + std::chrono::milliseconds(next->due_ms);
+            while (!g_stop && std::chrono::steady_clock::now() < due) {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                    due - std::chrono::steady_clock::now(), std::chrono::milliseconds(100)));
+            }
+            if (g_stop) break;
+            std::string err;
+            if (g_opt.verbose) std::printf("script @%lldms: %s\n", (long long)next->due_ms, next->command.c_str());
+            if (!run_command(next->command, err)) std::fprintf(stderr, "script: %s\n", err.c_str());
+            if (next->period_ms) next->due_ms += next->period_ms;
+            else entries.erase(next);
+        }
+    }
+
+    // Default tag set: the WDG_Status_Instance members the firmware reads
+    const char* const DEFAULT_TAGS[] = {
+        "DINT     WDG_Status_Instance.ControllerStatus 1",
+        "DINT[7]  WDG_Status_Instance.DateTime         @clock",
+        "LINT     WDG_Status_Instance.AuditValue       0",
+        "DINT     WDG_Status_Instance.AuthorizedUser   0",
+        "REAL     WDG_Status_Instance.WDG_Kp           1.0",
+        "REAL     WDG_Status_Instance.WDG_Ki           0.1",
+        "REAL     WDG_Status_Instance.WDG_Kd           0.01",
+        "DINT[7]  WDG_Status_Instance.ChangeStamp",
+    };
+
+    void usage(const char* argv0) {
+        std::fprintf(stderr,
+            "usage: %s [--bind IP] [--port PORT] [--tags FILE] [--script FILE]\n"
+            "          [--delay MS] [--jitter MS] [--drop P] [--busy P] [--reset-after N]\n"
+            "          [--clock-offset MS] [--clock-skew PPM] [--tz MIN] [--no-wall-clock]\n"
+            "          [--max-reply BYTES] [--seed N] [--verbose]\n", argv0);
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto next = [&]() { ++i; return v; };
+        if      (a == "--bind" && v)         g_opt.bind_ip = next();
+        else if (a == "--port" && v)         g_opt.port = (uint16_t)std::atoi(next());
+        else if (a == "--tags" && v)         g_opt.tags_file = next();
+        else if (a == "--script" && v)       g_opt.script_file = next();
+        else if (a == "--delay" && v)        g_faults.delay_ms = (uint32_t)std::atoi(next());
+        else if (a == "--jitter" && v)       g_faults.jitter_ms = (uint32_t)std::atoi(next());
+        else if (a == "--drop" && v)         g_faults.drop_ppm = (uint32_t)(std::atof(next()) * 1e6);
+        else if (a == "--busy" && v)         g_faults.busy_ppm = (uint32_t)(std::atof(next()) * 1e6);
+        else if (a == "--reset-after" && v)  g_faults.reset_after = (uint32_t)std::atoi(next());
+        else if (a == "--clock-offset" && v) g_clock.set_offset_ms(std::atoll(next()));
+        else if (a == "--clock-skew" && v)   g_clock.set_skew_ppm(std::atof(next()));
+        else if (a == "--tz" && v)           g_clock.set_tz_minutes(std::atoi(next()));
+        else if (a == "--no-wall-clock")     g_opt.server.wall_clock = false;
+        else if (a == "--max-reply" && v)    g_opt.server.unconnected_max = (size_t)std::atoi(next());
+        else if (a == "--seed" && v)         g_opt.seed = (uint32_t)std::strtoul(next(), nullptr, 0);
+        else if (a == "--verbose")           g_opt.verbose = true;
+        else { usage(argv[0]); return 2; }
+    }
+
+    std::string err;
+    if (!g_opt.tags_file.empty()) {
+        if (!g_db.load_file(g_opt.tags_file, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    } else {
+        for (const char* t : DEFAULT_TAGS) g_db.define(t, err);
+    }
+    std::vector<ScriptEntry> script;
+    if (!g_opt.script_file.empty() && !load_script(g_opt.script_file, script, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+
+    CipServer server(g_db, g_clock, g_opt.server);
+    g_server = &server;
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int lfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(g_opt.port);
+    addr.sin_addr.s_addr = inet_addr(g_opt.bind_ip.c_str());
+    if (::bind(lfd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(lfd, 16) != 0) {
+        std::fprintf(stderr, "bind/listen %s:%u: %s\n", g_opt.bind_ip.c_str(), (unsigned)g_opt.port, std::strerror(errno));
+        return 1;
+    }
+    std::printf("plc_sim: listening on %s:%u, %zu tags, %zu script entries\n",
+                g_opt.bind_ip.c_str(), (unsigned)g_opt.port, g_db.size(), script.size());
+    std::fflush(stdout);
+
+    std::thread(script_task, std::move(script)).detach();
+
+    while (!g_stop) {
+        pollfd p{lfd, POLLIN, 0};
+        int r = ::poll(&p, 1, 200);
+        if (r <= 0) continue;
+        int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0) continue;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        {
+            std::lock_guard<std::mutex> lk(g_fds_mu);
+            g_fds.insert(fd);
+        }
+        ++g_totals.connections;
+        if (g_opt.verbose) std::printf("fd %d: connected\n", fd);
+        std::thread(serve, fd).detach();
+    }
+
+    reset_all();
+    ::close(lfd);
+    std::printf("\n");
+    print_stats();
+    return 0;
+}
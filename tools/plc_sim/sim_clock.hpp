@@ -0,0 +1,42 @@
+// sim_clock.hpp
+// George Lake
+// Fall 2025
+//
+// Simulated controller clock: host UTC plus a settable offset and rate error,
+// so TimeSync can be exercised against a PLC that drifts.
+
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace PlcSim {
+    class SimClock {
+    public:
+        // Microseconds since 1970-01-01 UTC as seen by the simulated PLC
+        int64_t now_us() const {
+            int64_t real = real_us();
+            double  ppm  = skew_ppm_.load(std::memory_order_relaxed);
+            int64_t drift = (int64_t)((double)(real - start_us_) * ppm * 1e-6);
+            return real + offset_us_.load(std::memory_order_relaxed) + drift;
+        }
+
+        void set_offset_ms(int64_t ms) { offset_us_.store(ms * 1000, std::memory_order_relaxed); }
+        void set_skew_ppm(double ppm)  { skew_ppm_.store(ppm, std::memory_order_relaxed); }
+        void set_tz_minutes(int32_t m) { tz_minutes_.store(m, std::memory_order_relaxed); }
+        int32_t tz_minutes() const     { return tz_minutes_.load(std::memory_order_relaxed); }
+
+        static int64_t real_us() {
+            timespec ts{};
+            clock_gettime(CLOCK_REALTIME, &ts);
+            return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+
+    private:
+        const int64_t        start_us_ = real_us();
+        std::atomic<int64_t> offset_us_{0};
+        std::atomic<double>  skew_ppm_{0.0};
+        std::atomic<int32_t> tz_minutes_{0};      // DateTime tags are PLC local time
+    };
+}
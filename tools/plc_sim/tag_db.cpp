@@ -0,0 +1,245 @@
+// tag_db.cpp
+// George Lake
+// Fall 2025
+//
+// Tag table storage, tag file parsing and script mutations
+
+
+#include "tag_db.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    std::string lower(const std::string& s) {
+        std::string out(s);
+        for (char& c : out) c = (char)std::tolower((unsigned char)c);
+        return out;
+    }
+
+    void put_le(uint8_t* p, uint64_t v, size_t n) {
+        for (size_t i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+    }
+
+    uint64_t get_le(const uint8_t* p, size_t n) {
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; ++i) v |= (uint64_t)p[i] << (8 * i);
+        return v;
+    }
+
+    bool is_float(uint16_t type) { return type == PlcSim::T_REAL || type == PlcSim::T_LREAL; }
+} // Anonymous Namespace
+
+namespace PlcSim {
+    size_t type_size(uint16_t type) {
+        switch (type) {
+            case T_BOOL: case T_SINT: case T_USINT:  return 1;
+            case T_INT:  case T_UINT:                return 2;
+            case T_DINT: case T_UDINT: case T_REAL:  return 4;
+            case T_LINT: case T_ULINT: case T_LREAL: return 8;
+            default:                                 return 0;
+        }
+    }
+
+    const char* type_name(uint16_t type) {
+        switch (type) {
+            case T_BOOL:  return "BOOL";  case T_SINT:  return "SINT";  case T_INT:   return "INT";
+            case T_DINT:  return "DINT";  case T_LINT:  return "LINT";  case T_USINT: return "USINT";
+            case T_UINT:  return "UINT";  case T_UDINT: return "UDINT"; case T_ULINT: return "ULINT";
+            case T_REAL:  return "REAL";  case T_LREAL: return "LREAL";
+            default:      return "?";
+        }
+    }
+
+    static bool type_from_name(const std::string& s, uint16_t& out) {
+        static const uint16_t all[] = {T_BOOL, T_SINT, T_INT, T_DINT, T_LINT, T_USINT,
+                                       T_UINT, T_UDINT, T_ULINT, T_REAL, T_LREAL};
+        for (uint16_t t : all) {
+            if (lower(s) == lower(type_name(t))) { out = t; return true; }
+        }
+        return false;
+    }
+
+    bool TagDb::load_file(const std::string& path, std::string& err) {
+        std::ifstream in(path);
+        if (!in) { err = path + ": " + std::strerror(errno); return false; }
+        std::string line;
+        for (int n = 1; std::getline(in, line); ++n) {
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            if (!define(line, err)) { err = path + ":" + std::to_string(n) + ": " + err; return false; }
+        }
+        return true;
+    }
+
+    bool TagDb::define(const std::string& line, std::string& err) {
+        std::istringstream ss(line);
+        std::string decl, name, v;
+        if (!(ss >> decl >> name)) { err = "expected: TYPE[N] name [values]"; return false; }
+
+        Tag t;
+        t.name = name;
+        std::string tname = decl;
+        size_t br = decl.find('[');
+        if (br != std::string::npos) {
+            tname   = decl.substr(0, br);
+            t.count = (uint32_t)std::strtoul(decl.c_str() + br + 1, nullptr, 10);
+            if (t.count == 0) { err = "bad array size in " + decl; return false; }
+        }
+        if (!type_from_name(tname, t.type)) { err = "unknown type " + tname; return false; }
+        t.data.assign(type_size(t.type) * t.count, 0);
+
+        for (uint32_t i = 0; ss >> v; ++i) {
+            if (v == "@clock") {
+                if (t.type != T_DINT || t.count != 7) { err = "@clock needs DINT[7]"; return false; }
+                t.clock = true;
+                break;
+            }
+            if (i >= t.count) { err = "too many values for " + name; return false; }
+            if (!parse_value(t, v, i, err)) return false;
+        }
+
+        std::lock_guard<std::mutex> lk(mu_);
+        tags_[lower(name)] = std::move(t);
+        return true;
+    }
+
+    bool TagDb::parse_value(Tag& t, const std::string& s, uint32_t index, std::string& err) {
+        const size_t sz = type_size(t.type);
+        uint8_t* p = t.data.data() + (size_t)index * sz;
+        char* end = nullptr;
+        if (is_float(t.type)) {
+            double d = std::strtod(s.c_str(), &end);
+            if (*end) { err = "bad number '" + s + "'"; return false; }
+            if (t.type == T_REAL) { float f = (float)d; std::memcpy(p, &f, 4); }
+            else                  { std::memcpy(p, &d, 8); }
+            return true;
+        }
+        if (t.type == T_BOOL && (lower(s) == "true" || lower(s) == "false")) {
+            p[0] = lower(s) == "true" ? 1 : 0;
+            return true;
+        }
+        long long ll = std::strtoll(s.c_str(), &end, 0);
+        if (*end) {
+            unsigned long long ull = std::strtoull(s.c_str(), &end, 0);   // large ULINT / hex LINT
+            if (*end) { err = "bad integer '" + s + "'"; return false; }
+            ll = (long long)ull;
+        }
+        put_le(p, (uint64_t)ll, sz);
+        if (t.type == T_BOOL) p[0] = ll ? 1 : 0;
+        return true;
+    }
+
+    void TagDb::fill_clock(Tag& t) {
+        int64_t us  = clock_.now_us() + (int64_t)clock_.tz_minutes() * 60000000LL;
+        time_t  sec = (time_t)(us / 1000000);
+        struct tm tm{};
+        gmtime_r(&sec, &tm);
+        const int32_t v[7] = {tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                              tm.tm_hour, tm.tm_min, tm.tm_sec, (int32_t)(us % 1000000)};
+        for (int i = 0; i < 7; ++i) put_le(t.data.data() + i * 4, (uint32_t)v[i], 4);
+    }
+
+    TagDb::Tag* TagDb::find(const std::string& name) {
+        auto it = tags_.find(lower(name));
+        return it == tags_.end() ? nullptr : &it->second;
+    }
+
+    Status TagDb::read(const std::string& name, uint32_t first, uint16_t elements,
+                       uint16_t& type, std::vector<uint8_t>& out) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Tag* t = find(name);
+        if (!t) return {ST_PATH_UNKNOWN, 0};
+        if (elements == 0 || (uint64_t)first + elements > t->count) return {ST_GENERAL, EXT_OUT_OF_RANGE};
+        if (t->clock) fill_clock(*t);
+        const size_t sz = type_size(t->type);
+        type = t->type;
+        out.assign(t->data.begin() + first * sz, t->data.begin() + (first + elements) * sz);
+        return {};
+    }
+
+    Status TagDb::write(const std::string& name, uint32_t first, uint16_t type, uint16_t elements,
+                        uint32_t byte_offset, const uint8_t* data, size_t len) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Tag* t = find(name);
+        if (!t) return {ST_PATH_UNKNOWN, 0};
+        if (type != t->type) return {ST_GENERAL, EXT_TYPE_MISMATCH};
+        const size_t sz = type_size(t->type);
+        if (elements == 0 || (uint64_t)first + elements > t->count) return {ST_GENERAL, EXT_OUT_OF_RANGE};
+        const size_t span = (size_t)elements * sz;
+        if ((size_t)byte_offset + len > span) return {ST_TOO_MUCH, 0};
+        std::memcpy(t->data.data() + first * sz + byte_offset, data, len);
+        t->clock = false;       // an explicit write stops the live clock
+        return {};
+    }
+
+    bool TagDb::set(const std::string& name, const std::vector<std::string>& values, std::string& err) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Tag* t = find(name);
+        if (!t) { err = "no tag " + name; return false; }
+        if (values.size() > t->count) { err = "too many values for " + name; return false; }
+        Tag tmp = *t;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (!parse_value(tmp, values[i], (uint32_t)i, err)) return false;
+        }
+        tmp.clock = false;
+        *t = std::move(tmp);
+        return true;
+    }
+
+    bool TagDb::add(const std::string& name, double delta, std::string& err) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Tag* t = find(name);
+        if (!t) { err = "no tag " + name; return false; }
+        const size_t sz = type_size(t->type);
+        uint8_t* p = t->data.data();
+        if (t->type == T_REAL)       { float f;  std::memcpy(&f, p, 4); f += (float)delta; std::memcpy(p, &f, 4); }
+        else if (t->type == T_LREAL) { double d; std::memcpy(&d, p, 8); d += delta;        std::memcpy(p, &d, 8); }
+        else put_le(p, get_le(p, sz) + (uint64_t)(int64_t)delta, sz);
+        return true;
+    }
+
+    bool TagDb::stamp(const std::string& name, std::string& err) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Tag* t = find(name);
+        if (!t || t->type != T_DINT || t->count != 7) { err = name + " is not a DINT[7] tag"; return false; }
+        fill_clock(*t);
+        return true;
+    }
+
+    std::string TagDb::dump(const std::string& name) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Tag* t = find(name);
+        if (!t) return "no tag " + name;
+        if (t->clock) fill_clock(*t);
+        std::string s = t->name + " " + type_name(t->type);
+        if (t->count > 1) s += "[" + std::to_string(t->count) + "]";
+        const size_t sz = type_size(t->type);
+        char buf[48];
+        for (uint32_t i = 0; i < t->count; ++i) {
+            const uint8_t* p = t->data.data() + i * sz;
+            if (t->type == T_REAL)       { float f;  std::memcpy(&f, p, 4); std::snprintf(buf, sizeof(buf), " %g", f); }
+            else if (t->type == T_LREAL) { double d; std::memcpy(&d, p, 8); std::snprintf(buf, sizeof(buf), " %g", d); }
+            else if (t->type >= T_USINT && t->type <= T_ULINT) {
+                std::snprintf(buf, sizeof(buf), " %llu", (unsigned long long)get_le(p, sz));
+            } else {
+                uint64_t u = get_le(p, sz);
+                int64_t  v = (int64_t)(u << (64 - 8 * sz)) >> (64 - 8 * sz);    // sign-extend
+                std::snprintf(buf, sizeof(buf), " %lld", (long long)v);
+            }
+            s += buf;
+        }
+        return s;
+    }
+
+    size_t TagDb::size() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return tags_.size();
+    }
+}
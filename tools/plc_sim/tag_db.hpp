@@ -0,0 +1,103 @@
+// tag_db.hpp
+// George Lake
+// Fall 2025
+//
+// In-memory Logix-style tag table for plc_sim.
+//
+// Tag file format (one tag per line, '#' starts a comment):
+//      TYPE[N]  name  [value ...]
+//
+//      DINT     WDG_Status_Instance.ControllerStatus   1
+//      LINT     WDG_Status_Instance.AuditValue         0x1234
+//      REAL     WDG_Status_Instance.WDG_Kp             1.25
+//      DINT[7]  WDG_Status_Instance.DateTime           @clock
+//
+// Notes:
+//      Types: BOOL SINT INT DINT LINT USINT UINT UDINT ULINT REAL LREAL.
+//      Missing values are zero. "@clock" (DINT[7] only) makes the tag the live
+//      controller clock: year, month, day, hour, minute, second, microsecond.
+//      Names are matched case-insensitively, as Logix does.
+
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sim_clock.hpp"
+
+namespace PlcSim {
+    // CIP elementary data type codes
+    enum CipType : uint16_t {
+        T_BOOL = 0xC1, T_SINT = 0xC2, T_INT  = 0xC3, T_DINT  = 0xC4, T_LINT = 0xC5,
+        T_USINT = 0xC6, T_UINT = 0xC7, T_UDINT = 0xC8, T_ULINT = 0xC9,
+        T_REAL = 0xCA, T_LREAL = 0xCB,
+    };
+
+    size_t      type_size(uint16_t type);               // 0 = unknown type
+    const char* type_name(uint16_t type);
+
+    // CIP general status (+ optional extended status) for a tag access
+    struct Status {
+        uint8_t  general = 0;
+        uint16_t ext     = 0;          // only meaningful when general == 0xFF
+    };
+
+    constexpr uint8_t  ST_OK             = 0x00;
+    constexpr uint8_t  ST_PATH_SEGMENT   = 0x04;
+    constexpr uint8_t  ST_PATH_UNKNOWN   = 0x05;
+    constexpr uint8_t  ST_PARTIAL        = 0x06;
+    constexpr uint8_t  ST_NOT_SUPPORTED  = 0x08;
+    constexpr uint8_t  ST_REPLY_TOO_BIG  = 0x11;
+    constexpr uint8_t  ST_NOT_ENOUGH     = 0x13;
+    constexpr uint8_t  ST_ATTR_UNSUPP    = 0x14;
+    constexpr uint8_t  ST_TOO_MUCH       = 0x15;
+    constexpr uint8_t  ST_OBJ_MISSING    = 0x16;
+    constexpr uint8_t  ST_EMBEDDED       = 0x1E;
+    constexpr uint8_t  ST_GENERAL        = 0xFF;
+    constexpr uint16_t EXT_OUT_OF_RANGE  = 0x2105;
+    constexpr uint16_t EXT_TYPE_MISMATCH = 0x2107;
+
+    class TagDb {
+    public:
+        explicit TagDb(const SimClock& clock) : clock_(clock) {}
+
+        bool load_file(const std::string& path, std::string& err);
+        bool define(const std::string& line, std::string& err);
+
+        // Bytes of `elements` elements starting at element `first`
+        Status read(const std::string& name, uint32_t first, uint16_t elements,
+                    uint16_t& type, std::vector<uint8_t>& out);
+
+        // Writes `len` bytes at byte_offset within the element range starting at `first`
+        Status write(const std::string& name, uint32_t first, uint16_t type, uint16_t elements,
+                     uint32_t byte_offset, const uint8_t* data, size_t len);
+
+        // Script helpers (text values, same syntax as the tag file)
+        bool set(const std::string& name, const std::vector<std::string>& values, std::string& err);
+        bool add(const std::string& name, double delta, std::string& err);
+        bool stamp(const std::string& name, std::string& err);     // DINT[7] <- clock now
+        std::string dump(const std::string& name);
+
+        size_t size();
+
+    private:
+        struct Tag {
+            std::string          name;
+            uint16_t             type  = T_DINT;
+            uint32_t             count = 1;
+            bool                 clock = false;
+            std::vector<uint8_t> data;
+        };
+
+        Tag* find(const std::string& name);
+        bool parse_value(Tag& t, const std::string& s, uint32_t index, std::string& err);
+        void fill_clock(Tag& t);
+
+        const SimClock&            clock_;
+        std::mutex                 mu_;
+        std::map<std::string, Tag> tags_;      // key: lower-case name
+    };
+}
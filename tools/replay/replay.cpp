@@ -0,0 +1,470 @@
+// replay.cpp
+// George Lake
+// Fall 2025
+//
+// Offline replay of the audit detection logic (AuditDetector, shared with the firmware).
+// Drives recorded JSONL or synthetic traces through simulated polling as fast as the CPU
+// allows, over a sweep of poll periods / PID epsilons / read failure rates, and reports
+// detections, misses, false positives and detection latency per configuration.
+//
+// Usage:
+//      replay [options] [logs/*.jsonl ...]
+//          --synthetic N       add N generated traces (default 0; 8 if no files are given)
+//          --duration S        synthetic trace length in seconds (default 600)
+//          --rate R            synthetic changes per minute (default 2)
+//          --auth-frac F       fraction of synthetic changes made by an authorized user (0.5)
+//          --noise SIGMA       gaussian noise added to each PID read (default 0)
+//          --truth values|stamp  recorded ground truth: exact value changes (default),
+//                              or a new plc_timestamp_ms (ChangeStamp) per change
+//          --poll LIST         poll periods in ms, comma separated (default 200)
+//          --eps LIST          PID epsilons (default 1e-6)
+//          --fail LIST         per-poll read failure probabilities (default 0)
+//          --read-cost MS      time spent reading per poll, added to the period (default 0)
+//          --trials N          trials per configuration, each with a new poll phase (default 100)
+//          --threads N         worker threads (default: hardware concurrency)
+//          --seed S            RNG seed (default 1)
+//          --csv FILE          also write the results table as CSV
+//
+// Notes:
+//      A trace is the piecewise-constant value history of AuditValue, AuthorizedUser and the
+//      PID gains. Recorded files are split by (scenario_id, trial_id) and keyed on
+//      esp32_timestamp_ms, so they only resolve changes to their own poll period: replaying
+//      at a shorter period than the recording does not add information.
+//      A detection is matched to the oldest undetected true change at or before that poll;
+//      extra changes inside the same poll window are "merged", changes that are no longer
+//      visible at the next poll (reverted, or below epsilon) are "missed", and detections
+//      with no true change pending are false positives.
+
+
+#include "AuditDetector.hpp"
+#include "cJSON.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct Point {
+        int64_t     t_ms;
+        AuditSample s;
+    };
+
+    struct Truth {
+        int64_t t_ms;
+        bool    authorized;
+    };
+
+    struct Trace {
+        std::string        name;
+        std::vector<Point> points;      // sorted, first point = initial state
+        std::vector<Truth> events;      // sorted true changes
+        int64_t            end_ms = 0;
+    };
+
+    struct Params {
+        uint32_t poll_ms   = 200;
+        float    epsilon   = 1e-6f;
+        double   fail_prob = 0.0;
+    };
+
+    struct Options {
+        int         synthetic   = -1;
+        double      duration_s  = 600;
+        double      rate_per_min = 2;
+        double      auth_frac   = 0.5;
+        double      noise       = 0;
+        bool        truth_stamp = false;
+        std::vector<uint32_t> polls{200};
+        std::vector<float>    eps{1e-6f};
+        std::vector<double>   fails{0.0};
+        uint32_t    read_cost_ms = 0;
+        int         trials      = 100;
+        unsigned    threads     = 0;
+        uint64_t    seed        = 1;
+        std::string csv;
+        std::vector<std::string> files;
+    };
+
+    struct Counts {
+        uint64_t events = 0, detected = 0, missed = 0, merged = 0;
+        uint64_t false_pos = 0, false_pos_unauth = 0, misclassified = 0;
+        uint64_t polls = 0, failed_polls = 0;
+        std::vector<uint32_t> latency_ms;
+
+        void add(const Counts& o) {
+            events += o.events;       detected += o.detected;
+            missed += o.missed;       merged += o.merged;
+            false_pos += o.false_pos; false_pos_unauth += o.false_pos_unauth;
+            misclassified += o.misclassified;
+            polls += o.polls;         failed_polls += o.failed_polls;
+            latency_ms.insert(latency_ms.end(), o.latency_ms.begin(), o.latency_ms.end());
+        }
+    };
+
+    bool same_values(const AuditSample& a, const AuditSample& b) {
+        return a.audit == b.audit && a.auth == b.auth &&
+               a.kp == b.kp && a.ki == b.ki && a.kd == b.kd;
+    }
+
+    bool same_watched(const AuditSample& a, const AuditSample& b) {
+        return a.audit == b.audit && a.kp == b.kp && a.ki == b.ki && a.kd == b.kd;
+    }
+
+    // ---- Recorded traces -------------------------------------------------------------------
+
+    double num_field(const cJSON* o, const char* k, double dflt) {
+        const cJSON* v = cJSON_GetObjectItemCaseSensitive(o, k);
+        if (cJSON_IsNumber(v)) return v->valuedouble;
+        if (cJSON_IsString(v) && v->valuestring) return std::strtod(v->valuestring, nullptr);
+        return dflt;
+    }
+
+    std::string str_field(const cJSON* o, const char* k) {
+        const cJSON* v = cJSON_GetObjectItemCaseSensitive(o, k);
+        return (cJSON_IsString(v) && v->valuestring) ? v->valuestring : "";
+    }
+
+    bool load_jsonl(const std::string& path, bool truth_stamp, std::vector<Trace>& out) {
+        //
+        // One trace per (scenario_id, trial_id); aux records and unparsable lines are skipped
+        //
+        std::ifstream in(path);
+        if (!in) { std::fprintf(stderr, "replay: cannot open %s\n", path.c_str()); return false; }
+
+        std::map<std::string, Trace> by_key;
+        std::map<std::string, int64_t> last_stamp;
+        std::string line;
+        size_t records = 0, skipped = 0;
+
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            cJSON* root = cJSON_Parse(line.c_str());
+            const cJSON* cur = root ? cJSON_GetObjectItemCaseSensitive(root, "current") : nullptr;
+            if (!cJSON_IsObject(cur)) { ++skipped; cJSON_Delete(root); continue; }
+
+            std::string key = str_field(root, "scenario_id") + "/" + str_field(root, "trial_id");
+            int64_t t = (int64_t)num_field(root, "esp32_timestamp_ms", -1);
+            int64_t stamp = (int64_t)num_field(root, "plc_timestamp_ms", 0);
+
+            AuditSample s;
+            s.audit = std::strtoll(str_field(cur, "AuditValue").c_str(), nullptr, 10);
+            s.auth  = (int32_t)num_field(cur, "AuthorizedUser", 0);
+            s.kp    = (float)num_field(cur, "Kp", 0);
+            s.ki    = (float)num_field(cur, "Ki", 0);
+            s.kd    = (float)num_field(cur, "Kd", 0);
+            cJSON_Delete(root);
+            if (t < 0) { ++skipped; continue; }
+            ++records;
+
+            Trace& tr = by_key[key];
+            if (tr.name.empty()) tr.name = path + ":" + key;
+            if (!tr.points.empty() && t < tr.points.back().t_ms) { ++skipped; continue; }
+
+            bool first = tr.points.empty();
+            int64_t t_point = t;
+            if (!truth_stamp && !first && !same_watched(s, tr.points.back().s)) {
+                tr.events.push_back(Truth{t, s.auth != 0});
+            }
+            if (truth_stamp) {
+                auto it = last_stamp.find(key);
+                if (it == last_stamp.end()) {
+                    last_stamp[key] = stamp;     // stamp present at the start = before the trace
+                } else if (stamp > 0 && stamp != it->second) {
+                    it->second = stamp;
+                    if (stamp <= t) {
+                        tr.events.push_back(Truth{stamp, s.auth != 0});
+                        // The stamp is when the value really changed; the record only saw it later
+                        t_point = std::max(stamp, first ? t : tr.points.back().t_ms);
+                    }
+                }
+            }
+            if (first || !same_values(s, tr.points.back().s)) tr.points.push_back(Point{t_point, s});
+            tr.end_ms = t;
+        }
+
+        for (auto& kv : by_key) {
+            std::sort(kv.second.events.begin(), kv.second.events.end(),
+                      [](const Truth& a, const Truth& b) { return a.t_ms < b.t_ms; });
+            out.push_back(std::move(kv.second));
+        }
+        std::printf("%s: %zu records, %zu traces, %zu skipped lines\n",
+                    path.c_str(), records, by_key.size(), skipped);
+        return true;
+    }
+
+    // ---- Synthetic traces ------------------------------------------------------------------
+
+    Trace make_synthetic(int index, const Options& o) {
+        //
+        // Poisson changes; half AuditValue (logic download), half a PID gain edit.
+        // Authorized changes raise AuthorizedUser for 2 s around the edit.
+        //
+        std::mt19937_64 rng(o.seed * 0x9E3779B97F4A7C15ull + (uint64_t)index);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        const int64_t end = (int64_t)(o.duration_s * 1000);
+        const double mean_gap_ms = o.rate_per_min > 0 ? 60000.0 / o.rate_per_min : 1e18;
+
+        Trace tr;
+        tr.name   = "synthetic#" + std::to_string(index);
+        tr.end_ms = end;
+
+        AuditSample s;
+        s.audit = (int64_t)(rng() & 0x7FFFFFFFFFFFull);
+        s.kp = 1.0f; s.ki = 0.1f; s.kd = 0.01f;
+        tr.points.push_back(Point{0, s});
+
+        int64_t t = 0;
+        for (;;) {
+            t += (int64_t)(-std::log(1.0 - u(rng)) * mean_gap_ms) + 1;
+            bool authorized = u(rng) < o.auth_frac;
+            // Keep the authorized window clear of the previous edit so truth stays unambiguous
+            if (authorized) t = std::max<int64_t>(t, tr.points.back().t_ms + 2000);
+            if (t >= end) break;
+            if (authorized) {
+                AuditSample a = tr.points.back().s;
+                a.auth = 1;
+                tr.points.push_back(Point{t - 1000, a});
+            }
+
+            AuditSample c = tr.points.back().s;
+            if (u(rng) < 0.5) {
+                c.audit += 1 + (int64_t)(rng() % 1000);
+            } else {
+                float* g = (&c.kp) + (rng() % 3);
+                *g *= (float)(0.5 + u(rng));
+            }
+            tr.points.push_back(Point{t, c});
+            tr.events.push_back(Truth{t, authorized});
+
+            if (authorized) {
+                AuditSample a = c;
+                a.auth = 0;
+                t += 1000;
+                tr.points.push_back(Point{t, a});
+            }
+        }
+        return tr;
+    }
+
+    // ---- Simulation ------------------------------------------------------------------------
+
+    void run_trial(const Trace& tr, const Params& p, const Options& o, uint64_t seed, Counts& c) {
+        //
+        // Polls the trace like audit_task: read, compare, then wait poll_ms
+        //
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        std::normal_distribution<float> noise(0.0f, (float)o.noise);
+
+        AuditDetector::Config dcfg;
+        dcfg.pid_epsilon = p.epsilon;
+        AuditDetector det(dcfg);
+
+        const int64_t step = (int64_t)p.poll_ms + o.read_cost_ms;
+        int64_t t = tr.points.front().t_ms + (int64_t)(u(rng) * (double)p.poll_ms);
+        size_t cursor = 0, next_event = 0;
+        std::vector<Truth> pending;
+
+        // Changes before the first successful poll are part of the baseline
+        bool have_baseline = false;
+
+        for (; t <= tr.end_ms; t += step) {
+            ++c.polls;
+            if (p.fail_prob > 0 && u(rng) < p.fail_prob) { ++c.failed_polls; continue; }
+
+            while (cursor + 1 < tr.points.size() && tr.points[cursor + 1].t_ms <= t) ++cursor;
+            AuditSample s = tr.points[cursor].s;
+            if (o.noise > 0) { s.kp += noise(rng); s.ki += noise(rng); s.kd += noise(rng); }
+
+            while (next_event < tr.events.size() && tr.events[next_event].t_ms <= t) {
+                if (have_baseline) pending.push_back(tr.events[next_event]);
+                ++next_event;
+            }
+            have_baseline = true;
+
+            AuditDetector::Result r = det.update(s);
+            const int64_t t_detect = t + o.read_cost_ms;
+
+            if (r.any_change()) {
+                if (pending.empty()) {
+                    ++c.false_pos;
+                    if (!r.authorized) ++c.false_pos_unauth;
+                } else {
+                    const Truth& e = pending.front();
+                    ++c.detected;
+                    if (e.authorized != r.authorized) ++c.misclassified;
+                    c.latency_ms.push_back((uint32_t)(t_detect - e.t_ms));
+                    c.merged += pending.size() - 1;
+                }
+            } else {
+                c.missed += pending.size();
+            }
+            c.events += pending.size();
+            pending.clear();
+        }
+    }
+
+    uint32_t percentile(const std::vector<uint32_t>& sorted, double q) {
+        if (sorted.empty()) return 0;
+        size_t i = (size_t)(q * (double)(sorted.size() - 1) + 0.5);
+        return sorted[std::min(i, sorted.size() - 1)];
+    }
+
+    // ---- Command line ----------------------------------------------------------------------
+
+    template <typename T>
+    bool parse_list(const char* s, std::vector<T>& out) {
+        out.clear();
+        std::stringstream ss(s);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item.empty()) continue;
+            char* end = nullptr;
+            double v = std::strtod(item.c_str(), &end);
+            if (end == item.c_str() || *end != '\0') return false;
+            out.push_back((T)v);
+        }
+        return !out.empty();
+    }
+
+    void usage(const char* argv0) {
+        std::fprintf(stderr,
+            "usage: %s [--synthetic N] [--duration S] [--rate R] [--auth-frac F] [--noise SIGMA]\n"
+            "          [--truth values|stamp] [--poll LIST] [--eps LIST] [--fail LIST]\n"
+            "          [--read-cost MS] [--trials N] [--threads N] [--seed S] [--csv FILE]\n"
+            "          [file.jsonl ...]\n", argv0);
+    }
+
+    bool parse_args(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            std::string a = argv[i];
+            bool more = i + 1 < argc;
+            if      (a == "--synthetic" && more) o.synthetic    = std::atoi(argv[++i]);
+            else if (a == "--duration"  && more) o.duration_s   = std::atof(argv[++i]);
+            else if (a == "--rate"      && more) o.rate_per_min = std::atof(argv[++i]);
+            else if (a == "--auth-frac" && more) o.auth_frac    = std::atof(argv[++i]);
+            else if (a == "--noise"     && more) o.noise        = std::atof(argv[++i]);
+            else if (a == "--read-cost" && more) o.read_cost_ms = (uint32_t)std::atoi(argv[++i]);
+            else if (a == "--trials"    && more) o.trials       = std::atoi(argv[++i]);
+            else if (a == "--threads"   && more) o.threads      = (unsigned)std::atoi(argv[++i]);
+            else if (a == "--seed"      && more) o.seed         = std::strtoull(argv[++i], nullptr, 10);
+            else if (a == "--csv"       && more) o.csv          = argv[++i];
+            else if (a == "--truth"     && more) {
+                std::string v = argv[++i];
+                if (v != "values" && v != "stamp") return false;
+                o.truth_stamp = v == "stamp";
+            }
+            else if (a == "--poll" && more) { if (!parse_list(argv[++i], o.polls)) return false; }
+            else if (a == "--eps"  && more) { if (!parse_list(argv[++i], o.eps))   return false; }
+            else if (a == "--fail" && more) { if (!parse_list(argv[++i], o.fails)) return false; }
+            else if (!a.empty() && a[0] != '-') o.files.push_back(a);
+            else return false;
+        }
+        if (o.synthetic < 0) o.synthetic = o.files.empty() ? 8 : 0;
+        for (uint32_t p : o.polls) if (p == 0) return false;
+        return o.trials > 0;
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parse_args(argc, argv, o)) { usage(argv[0]); return 2; }
+
+    std::vector<Trace> traces;
+    for (const auto& f : o.files) {
+        if (!load_jsonl(f, o.truth_stamp, traces)) return 1;
+    }
+    for (int i = 0; i < o.synthetic; ++i) traces.push_back(make_synthetic(i, o));
+    traces.erase(std::remove_if(traces.begin(), traces.end(),
+                                [](const Trace& t) { return t.points.empty(); }), traces.end());
+    if (traces.empty()) { std::fprintf(stderr, "replay: no traces\n"); return 1; }
+
+    size_t true_changes = 0;
+    for (const auto& t : traces) true_changes += t.events.size();
+
+    std::vector<Params> grid;
+    for (uint32_t p : o.polls)
+        for (float e : o.eps)
+            for (double f : o.fails) grid.push_back(Params{p, e, f});
+
+    // One job = one (configuration, trial) over every trace; results reduced per configuration
+    const size_t jobs = grid.size() * (size_t)o.trials;
+    std::vector<Counts> results(jobs);
+    std::atomic<size_t> next{0};
+    unsigned nthreads = o.threads ? o.threads : std::max(1u, std::thread::hardware_concurrency());
+    nthreads = (unsigned)std::min<size_t>(nthreads, jobs);
+
+    std::printf("replay: %zu traces (%zu true changes), %zu configurations x %d trials, %u threads\n",
+                traces.size(), true_changes, grid.size(), o.trials, nthreads);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < nthreads; ++w) {
+        workers.emplace_back([&] {
+            for (size_t j; (j = next.fetch_add(1)) < jobs; ) {
+                const size_t cfg = j / (size_t)o.trials, trial = j % (size_t)o.trials;
+                for (size_t ti = 0; ti < traces.size(); ++ti) {
+                    uint64_t seed = o.seed ^ (trial * 0x9E3779B97F4A7C15ull) ^ (ti << 32) ^ (cfg << 48);
+                    run_trial(traces[ti], grid[cfg], o, seed, results[j]);
+                }
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    FILE* csv = o.csv.empty() ? nullptr : std::fopen(o.csv.c_str(), "w");
+    if (!o.csv.empty() && !csv) std::fprintf(stderr, "replay: cannot write %s\n", o.csv.c_str());
+    if (csv) std::fprintf(csv, "poll_ms,epsilon,fail_prob,events,detected,missed,merged,false_pos,"
+                               "false_pos_unauth,misclassified,polls,failed_polls,"
+                               "lat_mean_ms,lat_p50_ms,lat_p95_ms,lat_max_ms\n");
+
+    std::printf("%7s %9s %6s %8s %8s %7s %7s %7s %7s %7s %8s %7s %7s %7s\n",
+                "poll", "eps", "fail", "events", "detect", "missed", "merged", "FP", "FP_un",
+                "miscls", "lat_mean", "p50", "p95", "max");
+    uint64_t total_polls = 0;
+    for (size_t g = 0; g < grid.size(); ++g) {
+        Counts c;
+        for (int t = 0; t < o.trials; ++t) c.add(results[g * (size_t)o.trials + (size_t)t]);
+        total_polls += c.polls;
+
+        std::sort(c.latency_ms.begin(), c.latency_ms.end());
+        double mean = 0;
+        for (uint32_t v : c.latency_ms) mean += v;
+        if (!c.latency_ms.empty()) mean /= (double)c.latency_ms.size();
+        uint32_t p50 = percentile(c.latency_ms, 0.50), p95 = percentile(c.latency_ms, 0.95);
+        uint32_t mx  = c.latency_ms.empty() ? 0 : c.latency_ms.back();
+
+        const Params& p = grid[g];
+        std::printf("%7u %9.2g %6.3f %8llu %8llu %7llu %7llu %7llu %7llu %7llu %8.1f %7u %7u %7u\n",
+                    (unsigned)p.poll_ms, (double)p.epsilon, p.fail_prob,
+                    (unsigned long long)c.events, (unsigned long long)c.detected,
+                    (unsigned long long)c.missed, (unsigned long long)c.merged,
+                    (unsigned long long)c.false_pos, (unsigned long long)c.false_pos_unauth,
+                    (unsigned long long)c.misclassified, mean, p50, p95, mx);
+        if (csv) std::fprintf(csv, "%u,%g,%g,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%u,%u,%u\n",
+                              (unsigned)p.poll_ms, (double)p.epsilon, p.fail_prob,
+                              (unsigned long long)c.events, (unsigned long long)c.detected,
+                              (unsigned long long)c.missed, (unsigned long long)c.merged,
+                              (unsigned long long)c.false_pos, (unsigned long long)c.false_pos_unauth,
+                              (unsigned long long)c.misclassified, (unsigned long long)c.polls,
+                              (unsigned long long)c.failed_polls, mean, p50, p95, mx);
+    }
+    if (csv) std::fclose(csv);
+
+    std::printf("replay: %llu simulated polls in %.3f s (%.1f M polls/s)\n",
+                (unsigned long long)total_polls, secs, secs > 0 ? (double)total_polls / secs / 1e6 : 0.0);
+    return 0;
+}
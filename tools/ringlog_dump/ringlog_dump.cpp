@@ -0,0 +1,300 @@
+// ringlog_dump.cpp
+// George Lake
+// Fall 2025
+//
+// Host reader for a FlashRingLog directory (see include/FlashRingLog.hpp): prints the stored
+// JSONL records of a poll_seq or time range, and a self-check of the ring's read path.
+//
+// Usage:
+//      ringlog_dump [--seq LO:HI | --time LO_MS:HI_MS] [--segments N] [--pages N] [--page-bytes N] DIR
+//      ringlog_dump --check
+//          DIR         the ring's base_path (plc_reader_host --ringlog D writes D/ringlog;
+//                      on the ESP copy /littlefs/ringlog off the partition)
+//          --seq / --time  inclusive range, either bound may be empty ("100:", ":1761580800000")
+//          geometry    must match the writer (defaults = FlashRingLog::Config defaults;
+//                      --page-bytes defaults to the value stamped in seg_00.bin)
+//          --check     appends across several segment rotations in a temporary directory and
+//                      reads back by seq and by time, before and after reopening, across a
+//                      simulated reset (t_ms restarts), then with a corrupted record; exit 1
+//                      on any mismatch
+//
+// Notes:
+//      Records go to stdout one per line; the ring statistics go to stderr.
+
+
+#include "FlashRingLog.hpp"
+#include "esp_log.h"
+
+#include <cinttypes>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    // ---- Self-check --------------------------------------------------------------------------
+
+    constexpr int64_t FIRST_SEQ  = 1000;
+    constexpr int64_t FIRST_T_MS = 1761580800000LL;
+
+    int g_failures = 0;
+    int g_checks   = 0;
+
+    void expect(bool ok, const char* what) {
+        ++g_checks;
+        if (ok) return;
+        ++g_failures;
+        std::printf("FAIL: %s\n", what);
+    }
+
+    // From g_reboot_seq on, t_ms restarts near zero as after a reset before time sync
+    constexpr int64_t BOOT_T_MS = 5000;
+    int64_t g_reboot_seq = INT64_MAX;
+
+    // Strictly increasing within a boot, irregular spacing so a time bound can fall between records
+    int64_t t_of(int64_t seq) {
+        if (seq >= g_reboot_seq) return BOOT_T_MS + (seq - g_reboot_seq) * 200;
+        const int64_t i = seq - FIRST_SEQ;
+        return FIRST_T_MS + i * 200 + (i % 3) * 7;
+    }
+
+    // Variable length so records pack unevenly into pages
+    std::string payload_of(int64_t seq) {
+        char buf[160];
+        int n = std::snprintf(buf, sizeof(buf), "{\"record_type\":\"poll\",\"poll_seq\":%" PRId64 ",\"pad\":\"", seq);
+        std::string s(buf, (size_t)n);
+        s.append((size_t)(seq % 37), 'x');
+        s += "\"}";
+        return s;
+    }
+
+    // Reads [lo, hi] and checks it is exactly seqs first..last with the expected payloads
+    void expect_range(FlashRingLog& ring, bool by_time, int64_t lo, int64_t hi,
+                      int64_t first, int64_t last, const char* what) {
+        std::vector<int64_t> seqs;
+        bool payload_ok = true;
+        auto fn = [&](const FlashRingLog::Record& r) {
+            seqs.push_back(r.poll_seq);
+            const std::string want = payload_of(r.poll_seq);
+            if (r.t_ms != t_of(r.poll_seq) || r.len != want.size() ||
+                std::memcmp(r.data, want.data(), r.len) != 0) payload_ok = false;
+        };
+        const size_t n = by_time ? ring.read_by_time(lo, hi, fn) : ring.read_by_seq(lo, hi, fn);
+
+        bool order_ok = n == seqs.size() && seqs.size() == (size_t)(last < first ? 0 : last - first + 1);
+        for (size_t i = 0; order_ok && i < seqs.size(); ++i) order_ok = seqs[i] == first + (int64_t)i;
+        char msg[160];
+        std::snprintf(msg, sizeof(msg), "%s: %s [%" PRId64 ", %" PRId64 "] -> %zu records", what,
+                      by_time ? "time" : "seq", lo, hi, seqs.size());
+        expect(order_ok, msg);
+        expect(payload_ok, msg);
+    }
+
+    void check_reads(FlashRingLog& ring, int64_t oldest, int64_t newest, const char* what) {
+        //
+        // Whole ring, an interior range, bounds between records, and ranges outside the ring
+        //
+        const int64_t a = oldest + 5, b = newest - 9;
+        expect_range(ring, false, INT64_MIN, INT64_MAX, oldest, newest, what);
+        expect_range(ring, false, a, b, a, b, what);
+        expect_range(ring, false, newest, newest, newest, newest, what);
+        expect_range(ring, false, FIRST_SEQ, oldest - 1, 0, -1, what);       // evicted
+        expect_range(ring, false, newest + 1, INT64_MAX, 0, -1, what);
+
+        expect_range(ring, true, t_of(a), t_of(b), a, b, what);
+        expect_range(ring, true, t_of(a) + 1, t_of(b) - 1, a + 1, b - 1, what);
+        expect_range(ring, true, t_of(oldest), INT64_MAX, oldest, newest, what);
+        expect_range(ring, true, INT64_MIN, t_of(oldest) - 1, 0, -1, what);
+    }
+
+    bool corrupt_one_record(const std::string& path) {
+        //
+        // Flip a payload byte of the first record in the segment's first page
+        //
+        FILE* f = std::fopen(path.c_str(), "r+b");
+        if (!f) return false;
+        const long off = 16 + 24 + 4;      // segment header + record header + 4 bytes in
+        int c = (std::fseek(f, off, SEEK_SET) == 0) ? std::fgetc(f) : EOF;
+        bool ok = c != EOF && std::fseek(f, off, SEEK_SET) == 0 && std::fputc(c ^ 0x20, f) != EOF;
+        return (std::fclose(f) == 0) && ok;
+    }
+
+    int run_check() {
+        char dir[] = "/tmp/ringlog_check.XXXXXX";
+        if (!mkdtemp(dir)) { std::perror("mkdtemp"); return 1; }
+
+        FlashRingLog::Config cfg;
+        cfg.base_path         = std::string(dir) + "/ringlog";
+        cfg.segment_count     = 3;
+        cfg.pages_per_seg     = 4;
+        cfg.page_bytes        = 512;
+        cfg.flush_interval_ms = INT64_MAX;     // pages are written when full or on flush()
+
+        FlashRingLog ring;
+        expect(ring.open(cfg), "open empty ring");
+        const int64_t last = FIRST_SEQ + 299;
+        for (int64_t s = FIRST_SEQ; s <= last; ++s) {
+            const std::string p = payload_of(s);
+            if (!ring.append(s, t_of(s), p.data(), p.size())) { expect(false, "append"); break; }
+        }
+
+        // A partial page still in RAM must be readable before and after flush()
+        FlashRingLog::Stats st = ring.stats();
+        std::printf("appended %u records: %u pages, %u rotations, seq %" PRId64 "..%" PRId64 "\n",
+                    (unsigned)st.records_appended, (unsigned)st.pages_written,
+                    (unsigned)st.segment_rotations, st.oldest_seq, st.newest_seq);
+        expect(st.segment_rotations >= 3, "several segment rotations");
+        expect(st.newest_seq == last, "newest_seq is the last append");
+        expect(st.oldest_seq > FIRST_SEQ, "oldest records evicted");
+        const int64_t oldest = st.oldest_seq;
+        check_reads(ring, oldest, last, "open ring");
+        ring.flush();
+        check_reads(ring, oldest, last, "after flush");
+
+        // The page index is rebuilt from disk on open
+        ring.close();
+        expect(ring.open(cfg), "reopen");
+        st = ring.stats();
+        expect(st.oldest_seq == oldest && st.newest_seq == last, "reopened ring keeps its range");
+        check_reads(ring, oldest, last, "reopened");
+
+        // Appends continue on a fresh page after a reopen
+        for (int64_t s = last + 1; s <= last + 20; ++s) {
+            const std::string p = payload_of(s);
+            ring.append(s, t_of(s), p.data(), p.size());
+        }
+        st = ring.stats();
+        check_reads(ring, st.oldest_seq, last + 20, "appended after reopen");
+        ring.close();
+
+        // A reset: poll_seq continues, t_ms starts over. Time reads must find both boots
+        expect(ring.open(cfg), "reopen after reset");
+        g_reboot_seq = last + 21;
+        for (int64_t s = g_reboot_seq; s < g_reboot_seq + 20; ++s) {
+            const std::string p = payload_of(s);
+            ring.append(s, t_of(s), p.data(), p.size());
+        }
+        st = ring.stats();
+        const int64_t newest = g_reboot_seq + 19;
+        expect_range(ring, false, st.oldest_seq, newest, st.oldest_seq, newest, "after reset");
+        expect_range(ring, true, t_of(st.oldest_seq), INT64_MAX, st.oldest_seq, g_reboot_seq - 1, "after reset");
+        expect_range(ring, true, INT64_MIN, t_of(newest), g_reboot_seq, newest, "after reset");
+        expect_range(ring, true, t_of(g_reboot_seq + 3), t_of(g_reboot_seq + 8),
+                     g_reboot_seq + 3, g_reboot_seq + 8, "after reset");
+        ring.close();
+
+        // A damaged record stops the walk of its page and is counted, nothing bad is delivered
+        char seg[24];
+        std::string victim;
+        for (unsigned i = 0; i < cfg.segment_count && victim.empty(); ++i) {
+            std::snprintf(seg, sizeof(seg), "/seg_%02u.bin", i);
+            struct stat sb{};
+            if (::stat((cfg.base_path + seg).c_str(), &sb) == 0 && sb.st_size > 16 + 512) victim = cfg.base_path + seg;
+        }
+        expect(!victim.empty() && corrupt_one_record(victim), "corrupt a record");
+        expect(ring.open(cfg), "open damaged ring");
+        size_t bad = 0, n = ring.read_by_seq(INT64_MIN, INT64_MAX, [&](const FlashRingLog::Record& r) {
+            const std::string want = payload_of(r.poll_seq);
+            if (r.len != want.size() || std::memcmp(r.data, want.data(), r.len) != 0) ++bad;
+        });
+        st = ring.stats();
+        std::printf("damaged ring: %zu records read, %u crc errors\n", n, (unsigned)st.crc_errors);
+        expect(bad == 0, "no damaged payload delivered");
+        expect(st.crc_errors > 0, "crc error counted");
+        ring.close();
+
+        for (unsigned i = 0; i < cfg.segment_count; ++i) {
+            std::snprintf(seg, sizeof(seg), "/seg_%02u.bin", i);
+            ::unlink((cfg.base_path + seg).c_str());
+        }
+        ::rmdir(cfg.base_path.c_str());
+        ::rmdir(dir);
+
+        std::printf("ringlog_dump: %d/%d checks passed\n", g_checks - g_failures, g_checks);
+        return g_failures ? 1 : 0;
+    }
+
+    // ---- Dump --------------------------------------------------------------------------------
+
+    // "LO:HI" with either side optional
+    bool parse_range(const char* s, int64_t& lo, int64_t& hi) {
+        const char* colon = std::strchr(s, ':');
+        if (!colon) return false;
+        lo = (colon == s) ? INT64_MIN : std::strtoll(s, nullptr, 10);
+        hi = colon[1] ? std::strtoll(colon + 1, nullptr, 10) : INT64_MAX;
+        return true;
+    }
+
+    // page_bytes from a segment header (magic(4) version(2) page_bytes(2) ...); 0 if unreadable.
+    // open() starts a fresh segment 0 when no segment matches, so a wrong guess would erase it
+    uint32_t stamped_page_bytes(const std::string& base) {
+        FILE* f = std::fopen((base + "/seg_00.bin").c_str(), "rb");
+        if (!f) return 0;
+        uint8_t hdr[8];
+        const bool ok = std::fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+        std::fclose(f);
+        return ok ? (uint32_t)(hdr[6] | (hdr[7] << 8)) : 0;
+    }
+
+    void usage(const char* argv0) {
+        std::fprintf(stderr,
+            "usage: %s [--seq LO:HI | --time LO_MS:HI_MS] [--segments N] [--pages N] [--page-bytes N] DIR\n"
+            "       %s --check\n", argv0, argv0);
+    }
+} // Anonymous Namespace
+
+int main(int argc, char** argv) {
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    FlashRingLog::Config cfg;
+    bool    page_bytes_set = false;
+    bool    by_time = false, check = false;
+    int64_t lo = INT64_MIN, hi = INT64_MAX;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if      (a == "--check")                { check = true; }
+        else if (a == "--seq"        && more)   { if (!parse_range(argv[++i], lo, hi)) { usage(argv[0]); return 2; } by_time = false; }
+        else if (a == "--time"       && more)   { if (!parse_range(argv[++i], lo, hi)) { usage(argv[0]); return 2; } by_time = true; }
+        else if (a == "--segments"   && more)   cfg.segment_count = (uint32_t)std::atoi(argv[++i]);
+        else if (a == "--pages"      && more)   cfg.pages_per_seg = (uint32_t)std::atoi(argv[++i]);
+        else if (a == "--page-bytes" && more)   { cfg.page_bytes = (uint32_t)std::atoi(argv[++i]); page_bytes_set = true; }
+        else if (a[0] != '-' && cfg.base_path == FlashRingLog::Config{}.base_path) cfg.base_path = a;
+        else { usage(argv[0]); return 2; }
+    }
+    if (check) return run_check();
+    if (cfg.base_path == FlashRingLog::Config{}.base_path) { usage(argv[0]); return 2; }
+
+    struct stat sb{};
+    if (::stat(cfg.base_path.c_str(), &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+        std::fprintf(stderr, "ringlog_dump: %s is not a directory\n", cfg.base_path.c_str());
+        return 1;
+    }
+    const uint32_t stamped = stamped_page_bytes(cfg.base_path);
+    if (stamped == 0) {
+        std::fprintf(stderr, "ringlog_dump: no readable %s/seg_00.bin\n", cfg.base_path.c_str());
+        return 1;
+    }
+    if (!page_bytes_set) cfg.page_bytes = stamped;
+    if (cfg.page_bytes != stamped) {
+        std::fprintf(stderr, "ringlog_dump: ring was written with %u-byte pages\n", (unsigned)stamped);
+        return 1;
+    }
+    FlashRingLog ring;
+    if (!ring.open(cfg)) return 1;
+
+    auto print = [](const FlashRingLog::Record& r) {
+        std::fwrite(r.data, 1, r.len, stdout);
+        std::fputc('\n', stdout);
+    };
+    size_t n = by_time ? ring.read_by_time(lo, hi, print) : ring.read_by_seq(lo, hi, print);
+
+    FlashRingLog::Stats st = ring.stats();
+    std::fprintf(stderr, "%zu records; ring holds seq %" PRId64 "..%" PRId64 ", %u crc errors\n",
+                 n, st.oldest_seq, st.newest_seq, (unsigned)st.crc_errors);
+    return 0;
+}